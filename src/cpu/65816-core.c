@@ -0,0 +1,364 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ *
+ * Embedding API: a CPU and its memory behind one handle (lib816core)
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "65816-core.h"
+#include "65816-util.h"
+
+
+struct Core816_t
+{
+    CPU_t cpu;
+    memory_t *mem;
+    CPU_Decode_Cache_t *dcache; // NULL unless built with CPU_DISPATCH_TABLE
+};
+
+
+/**
+ * Create a CPU with its own (all RAM, zeroed) memory. The CPU starts
+ * out like a CPU which has just been reset (see resetCore816()), with
+ * memory access flag tracking turned off.
+ *
+ * @return The new instance, or NULL if it could not be allocated
+ */
+Core816_t *createCore816(void)
+{
+    Core816_t *core = calloc(1, sizeof(Core816_t));
+
+    if (!core)
+    {
+        return NULL;
+    }
+
+    core->mem = _alloc_mem();
+    if (!core->mem)
+    {
+        free(core);
+        return NULL;
+    }
+
+    initCPU(&core->cpu);
+    core->cpu.setacc = false;
+
+#ifdef CPU_DISPATCH_TABLE
+    core->dcache = malloc(sizeof(CPU_Decode_Cache_t));
+    if (!core->dcache)
+    {
+        _free_mem(core->mem);
+        free(core);
+        return NULL;
+    }
+    setDecodeCacheCPU(&core->cpu, core->dcache);
+#endif
+
+    return core;
+}
+
+
+/**
+ * Free an instance created with createCore816()
+ *
+ * @param *core The instance to free (may be NULL)
+ */
+void freeCore816(Core816_t *core)
+{
+    if (!core)
+    {
+        return;
+    }
+
+    disableJITCPU(&core->cpu);
+    free(core->dcache);
+    _free_mem(core->mem);
+    free(core);
+}
+
+
+/**
+ * Reset the CPU. The reset sequence (loading the PC from the reset
+ * vector) runs at the start of the next runCore816(). Memory, mapped
+ * ROM and devices are left as they are.
+ *
+ * @param *core The instance to reset
+ * @return CPU_ERR_OK
+ */
+CPU_Error_Code_t resetCore816(Core816_t *core)
+{
+    return resetCPU(&core->cpu);
+}
+
+
+/**
+ * Get the CPU's registers and cycle count
+ *
+ * @param *core The instance to read
+ * @param *regs Filled in with the registers
+ */
+void getRegsCore816(Core816_t *core, Core816_Regs_t *regs)
+{
+    CPU_t *cpu = &core->cpu;
+
+    regs->C = cpu->C;
+    regs->X = cpu->X;
+    regs->Y = cpu->Y;
+    regs->D = cpu->D;
+    regs->SP = cpu->SP;
+    regs->PC = cpu->PC;
+    regs->DBR = cpu->DBR;
+    regs->PBR = cpu->PBR;
+    regs->P = _cpu_get_sr(cpu);
+    regs->E = cpu->P.E;
+    regs->cycles = cpu->cycles;
+}
+
+
+/**
+ * Set the CPU's registers and cycle count. This also cancels a
+ * pending reset sequence, so the CPU starts running at the given PC.
+ *
+ * @note In emulation mode, X and B are both read from bit 4 of P
+ * @param *core The instance to modify
+ * @param *regs The new registers
+ */
+void setRegsCore816(Core816_t *core, const Core816_Regs_t *regs)
+{
+    CPU_t *cpu = &core->cpu;
+
+    cpu->C = regs->C;
+    cpu->X = regs->X;
+    cpu->Y = regs->Y;
+    cpu->D = regs->D;
+    cpu->SP = regs->SP;
+    cpu->PC = regs->PC;
+    cpu->DBR = regs->DBR;
+    cpu->PBR = regs->PBR;
+    cpu->P.E = regs->E;
+    _cpu_set_sr(cpu, regs->P);
+    cpu->cycles = regs->cycles;
+    cpu->P.RST = 0;
+}
+
+
+/**
+ * Set the level of the CPU's IRQ input
+ *
+ * @param *core The instance to modify
+ * @param asserted True to request an interrupt
+ */
+void setIRQCore816(Core816_t *core, bool asserted)
+{
+    core->cpu.P.IRQ = asserted;
+}
+
+
+/**
+ * Set the level of the CPU's NMI input
+ *
+ * @param *core The instance to modify
+ * @param asserted True to request a non-maskable interrupt
+ */
+void setNMICore816(Core816_t *core, bool asserted)
+{
+    core->cpu.P.NMI = asserted;
+}
+
+
+/**
+ * Copy data into memory (ROM included), wrapping around the end of the
+ * 24-bit address space. Decoded instructions which are written over are
+ * dropped. Devices do not see the writes.
+ *
+ * @param *core The instance to modify
+ * @param addr The address to start writing at
+ * @param *src The bytes to write
+ * @param count The number of bytes to write (at most MEMORY_SIZE)
+ */
+void writeMemCore816(Core816_t *core, uint32_t addr, const uint8_t *src, uint32_t count)
+{
+    uint32_t first;
+
+    addr &= MEMORY_SIZE - 1;
+    count = (count > MEMORY_SIZE) ? MEMORY_SIZE : count;
+    first = (count > MEMORY_SIZE - addr) ? MEMORY_SIZE - addr : count;
+
+    _init_mem_arr(core->mem, (uint8_t *) src, addr, first);
+    if (count > first)
+    {
+        _init_mem_arr(core->mem, (uint8_t *) src + first, 0, count - first);
+    }
+}
+
+
+/**
+ * Copy data out of memory, wrapping around the end of the 24-bit
+ * address space. Devices do not see the reads.
+ *
+ * @param *core The instance to read
+ * @param addr The address to start reading at
+ * @param *dst The buffer to copy the bytes to
+ * @param count The number of bytes to read (at most MEMORY_SIZE)
+ */
+void readMemCore816(Core816_t *core, uint32_t addr, uint8_t *dst, uint32_t count)
+{
+    uint32_t first;
+
+    addr &= MEMORY_SIZE - 1;
+    count = (count > MEMORY_SIZE) ? MEMORY_SIZE : count;
+    first = (count > MEMORY_SIZE - addr) ? MEMORY_SIZE - addr : count;
+
+    _save_mem_arr(core->mem, dst, addr, first);
+    if (count > first)
+    {
+        _save_mem_arr(core->mem, dst + first, 0, count - first);
+    }
+}
+
+
+/**
+ * Zero all of memory and clear its flags (see _reset_mem()). ROM and
+ * devices stay mapped. With a sparse memory (CPU_MEM_SPARSE), this only
+ * takes as long as the number of pages which have been written to.
+ * Otherwise, on Linux, the pages are given back to the host.
+ *
+ * @param *core The instance to modify
+ */
+void clearMemCore816(Core816_t *core)
+{
+    _reset_mem(core->mem);
+}
+
+
+/**
+ * Tell the core that a range of memory (such as the RAM a program runs
+ * in) will be used densely, so that the host backs it with huge pages
+ * where it can (see _advise_mem_dense()). Memory is otherwise only backed
+ * a host page at a time as it is written to.
+ *
+ * @param *core The instance to modify
+ * @param addr The first address of the range
+ * @param count The number of bytes in the range
+ */
+void adviseMemCore816(Core816_t *core, uint32_t addr, uint32_t count)
+{
+    _advise_mem_dense(core->mem, addr, count);
+}
+
+
+/**
+ * List the pages of memory which have been written to (see _get_mem_pages())
+ *
+ * @param *core The instance to look at
+ * @param *pages Filled in with the page numbers (addresses >> MEM_PAGE_BITS, may be NULL)
+ * @param max The most page numbers to put in pages
+ * @return The number of pages which have been written to (can be more than max)
+ */
+uint32_t getMemPagesCore816(Core816_t *core, uint32_t *pages, uint32_t max)
+{
+    return _get_mem_pages(core->mem, pages, max);
+}
+
+
+/**
+ * Make a range of memory read-only (see _map_mem_rom())
+ *
+ * @param *core The instance to modify
+ * @param addr The first address of the ROM
+ * @param count The number of bytes of ROM
+ * @return True if the pages were mapped, false if one of them
+ *         already belongs to a device
+ */
+bool mapROMCore816(Core816_t *core, uint32_t addr, uint32_t count)
+{
+    return _map_mem_rom(core->mem, addr, count);
+}
+
+
+/**
+ * Map a device's registers into memory (see _map_mem_io())
+ *
+ * @param *core The instance to modify
+ * @param *dev The device to map
+ * @return True if the device was mapped
+ */
+bool mapDeviceCore816(Core816_t *core, const mem_device_t *dev)
+{
+    return _map_mem_io(core->mem, dev);
+}
+
+
+/**
+ * Run the CPU until its budget is used up or a stop condition is
+ * reached (see runCPU()). This never allocates memory.
+ *
+ * @param *core The instance to run
+ * @param budget The maximum number of instructions (or cycles if
+ *               CPU_RUN_BUDGET_CYCLES is set in stop_mask) to run for
+ * @param stop_mask CPU_RUN_BREAK, CPU_RUN_WAI and/or CPU_RUN_INT to stop on
+ *                  (plus CPU_RUN_BUDGET_CYCLES)
+ * @return The reason for stopping
+ */
+CPU_Run_Status_t runCore816(Core816_t *core, uint64_t budget, uint32_t stop_mask)
+{
+    return runCPU(&core->cpu, core->mem, budget, stop_mask);
+}
+
+
+/**
+ * Compile hot blocks to native code (see enableJITCPU()). The code
+ * arena is allocated here, not while the CPU runs.
+ *
+ * @param *core The instance to modify
+ * @param threshold The number of times a block is entered before it is compiled
+ * @return CPU_ERR_OK, or CPU_ERR_NO_JIT if the JIT is not available
+ */
+CPU_Error_Code_t enableJITCore816(Core816_t *core, uint16_t threshold)
+{
+    return enableJITCPU(&core->cpu, threshold);
+}
+
+
+/**
+ * Get the number of instructions the CPU has skipped over in loops which
+ * only read memory instead of running them (see _cpu_skip_idle()). They
+ * are still counted against the budget and their cycles are still added.
+ *
+ * @param *core The instance
+ * @return The instructions skipped since the instance was created
+ */
+uint64_t getSkippedCore816(Core816_t *core)
+{
+    return core->cpu.idle.skipped;
+}
+
+
+/**
+ * Get the instance's CPU, for use with the rest of the CPU core's API
+ * (events, saving the CPU state, etc.)
+ *
+ * @param *core The instance
+ * @return The CPU, which is owned by the instance
+ */
+CPU_t *getCPUCore816(Core816_t *core)
+{
+    return &core->cpu;
+}
+
+
+/**
+ * Get the instance's memory, for use with the memory functions in
+ * 65816-util.h
+ *
+ * @param *core The instance
+ * @return The memory, which is owned by the instance
+ */
+memory_t *getMemCore816(Core816_t *core)
+{
+    return core->mem;
+}
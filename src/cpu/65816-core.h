@@ -0,0 +1,62 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+#ifndef CORE_65816_H
+#define CORE_65816_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "65816.h"
+
+// Embedding API (lib816core)
+//
+// A Core816_t is a CPU together with its own 24-bit address space (and
+// predecoded instruction cache when built with CPU_DISPATCH_TABLE). Every
+// allocation happens in createCore816() and enableJITCore816() (and, when
+// built with CPU_MEM_SPARSE, the first write to each page of memory):
+// nothing else allocates memory, and the core keeps no global state, so
+// any number of instances can be used at once (one thread per instance).
+// Instances are meant to be reused: put back the bytes that were written
+// with writeMemCore816() (or clearMemCore816()) instead of creating a new
+// one for every test.
+typedef struct Core816_t Core816_t;
+
+// CPU registers as seen by the program, plus the cycle count
+typedef struct Core816_Regs_t {
+    uint16_t C;
+    uint16_t X;
+    uint16_t Y;
+    uint16_t D;
+    uint16_t SP;
+    uint16_t PC;
+    uint8_t DBR;
+    uint8_t PBR;
+    uint8_t P; // Status register (NVMXDIZC)
+    bool E;    // Emulation mode
+    uint64_t cycles;
+} Core816_Regs_t;
+
+Core816_t *createCore816(void);
+void freeCore816(Core816_t *);
+CPU_Error_Code_t resetCore816(Core816_t *);
+void getRegsCore816(Core816_t *, Core816_Regs_t *);
+void setRegsCore816(Core816_t *, const Core816_Regs_t *);
+void setIRQCore816(Core816_t *, bool);
+void setNMICore816(Core816_t *, bool);
+void writeMemCore816(Core816_t *, uint32_t, const uint8_t *, uint32_t);
+void readMemCore816(Core816_t *, uint32_t, uint8_t *, uint32_t);
+void clearMemCore816(Core816_t *);
+void adviseMemCore816(Core816_t *, uint32_t, uint32_t);
+uint32_t getMemPagesCore816(Core816_t *, uint32_t *, uint32_t);
+bool mapROMCore816(Core816_t *, uint32_t, uint32_t);
+bool mapDeviceCore816(Core816_t *, const mem_device_t *);
+CPU_Run_Status_t runCore816(Core816_t *, uint64_t, uint32_t);
+CPU_Error_Code_t enableJITCore816(Core816_t *, uint16_t);
+uint64_t getSkippedCore816(Core816_t *);
+CPU_t *getCPUCore816(Core816_t *);
+memory_t *getMemCore816(Core816_t *);
+
+#endif
@@ -0,0 +1,773 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ *
+ * Table-driven opcode dispatcher. This is an alternative to the
+ * switch in stepCPU() which is selected by defining CPU_DISPATCH_TABLE.
+ * When compiled with GCC (or anything claiming to be GCC), the
+ * handlers are threaded together with computed gotos. Otherwise,
+ * a table of function pointers is used.
+ *
+ * The handlers in 65816-ops.c are instantiated here once for each
+ * combination of accumulator/index register widths with the width tests
+ * (CPU_M8/CPU_X8) replaced by constants. The dispatcher picks the set
+ * of handlers for the current widths and only looks at the widths again
+ * at the start of a block (instructions which can change them end one).
+ * Each width combination is instantiated twice: once with memory access
+ * flag tracking (CPU_SETACC) compiled in and once with it compiled out.
+ * The set is picked from the CPU's setacc at the start of each block, so
+ * runs which do not need the flags do not pay for them.
+ *
+ * Instructions are decoded (opcode and operand bytes fetched) before they
+ * are dispatched. If the CPU has a predecoded instruction cache attached
+ * (see setDecodeCacheCPU()), they are decoded a basic block at a time
+ * and the blocks are kept in the cache and reused until something writes
+ * to their bytes. Otherwise, each block is a single instruction.
+ *
+ * When built with CPU_JIT, cached blocks can also be compiled to native
+ * code once they are hot (see 65816-jit.c and enableJITCPU()).
+ *
+ * Without CPU_DISPATCH_TABLE, this file compiles to nothing.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include "65816.h"
+#include "65816-ops.h"
+#include "65816-util.h"
+#include "65816-dispatch.h"
+#include "65816-jit.h"
+
+// The switch in stepCPU() only uses the inline helpers in 65816-dispatch.h,
+// so nothing here is compiled unless the dispatcher is selected
+#ifdef CPU_DISPATCH_TABLE
+
+#if defined(__GNUC__) && !defined(CPU_DISPATCH_NO_GOTO)
+#define CPU_DISPATCH_GOTO
+#endif
+
+#define CPU_CAT_(a, b) a##b
+#define CPU_CAT(a, b) CPU_CAT_(a, b)
+
+// Register width variant index bits
+#define CPU_W_M8 0x1
+#define CPU_W_X8 0x2
+
+// Handler variant index bit for access flag tracking (not part of the
+// width, since decoding does not depend on it)
+#define CPU_W_ACC 0x4
+#define CPU_VARIANTS 8
+
+// Opcodes which end a decoded block (see CPU_Decode_Block_t)
+#define CPU_OP_ENDS_BLOCK(op) [op] = true,
+static const bool op_ends_block[256] = {
+    CPU_OP_ENDS_BLOCK(0x00) // BRK
+    CPU_OP_ENDS_BLOCK(0x02) // COP
+    CPU_OP_ENDS_BLOCK(0x10) // BPL
+    CPU_OP_ENDS_BLOCK(0x20) // JSR abs
+    CPU_OP_ENDS_BLOCK(0x22) // JSL
+    CPU_OP_ENDS_BLOCK(0x28) // PLP
+    CPU_OP_ENDS_BLOCK(0x30) // BMI
+    CPU_OP_ENDS_BLOCK(0x40) // RTI
+    CPU_OP_ENDS_BLOCK(0x44) // MVP
+    CPU_OP_ENDS_BLOCK(0x4c) // JMP abs
+    CPU_OP_ENDS_BLOCK(0x50) // BVC
+    CPU_OP_ENDS_BLOCK(0x54) // MVN
+    CPU_OP_ENDS_BLOCK(0x58) // CLI
+    CPU_OP_ENDS_BLOCK(0x5c) // JML
+    CPU_OP_ENDS_BLOCK(0x60) // RTS
+    CPU_OP_ENDS_BLOCK(0x6b) // RTL
+    CPU_OP_ENDS_BLOCK(0x6c) // JMP (abs)
+    CPU_OP_ENDS_BLOCK(0x70) // BVS
+    CPU_OP_ENDS_BLOCK(0x7c) // JMP (abs,X)
+    CPU_OP_ENDS_BLOCK(0x80) // BRA
+    CPU_OP_ENDS_BLOCK(0x82) // BRL
+    CPU_OP_ENDS_BLOCK(0x90) // BCC
+    CPU_OP_ENDS_BLOCK(0xb0) // BCS
+    CPU_OP_ENDS_BLOCK(0xc2) // REP
+    CPU_OP_ENDS_BLOCK(0xcb) // WAI
+    CPU_OP_ENDS_BLOCK(0xd0) // BNE
+    CPU_OP_ENDS_BLOCK(0xdb) // STP
+    CPU_OP_ENDS_BLOCK(0xdc) // JML [abs]
+    CPU_OP_ENDS_BLOCK(0xe2) // SEP
+    CPU_OP_ENDS_BLOCK(0xf0) // BEQ
+    CPU_OP_ENDS_BLOCK(0xfb) // XCE
+    CPU_OP_ENDS_BLOCK(0xfc) // JSR (abs,X)
+};
+#undef CPU_OP_ENDS_BLOCK
+
+// Decoded block key bits
+#define CPU_DECODE_VALID 0x80000000
+#define CPU_DECODE_WIDTH_SHIFT 24
+
+// Number of bytes the dispatcher fetches to decode each opcode
+#define CPU_OP_LEN(op, fn, kind, size, cycles, mode, res, mn, reg, acc) [op] = 1 + CPU_OPERAND_##res,
+static const uint8_t op_len[256] = { CPU_OPCODE_TABLE(CPU_OP_LEN) };
+#undef CPU_OP_LEN
+
+// Instruction length for each opcode (with an 8-bit immediate operand)
+#define CPU_OP_SIZE(op, fn, kind, size, cycles, mode, res, mn, reg, acc) [op] = size,
+static const uint8_t op_size[256] = { CPU_OPCODE_TABLE(CPU_OP_SIZE) };
+#undef CPU_OP_SIZE
+
+// The width variant bit which selects an 8-bit immediate operand for
+// each opcode (0 if the opcode does not have a variable size immediate)
+#define CPU_OP_IMMD_WIDTH_A CPU_W_M8
+#define CPU_OP_IMMD_WIDTH_X CPU_W_X8
+#define CPU_OP_IMMD_WIDTH__ 0
+#define CPU_OP_IMMD(op, fn, kind, size, cycles, mode, res, mn, reg, acc) \
+    [op] = (CPU_ADDR_##mode == CPU_ADDR_IMMD) ? CPU_OP_IMMD_WIDTH_##reg : 0,
+static const uint8_t op_immd[256] = { CPU_OPCODE_TABLE(CPU_OP_IMMD) };
+#undef CPU_OP_IMMD
+#undef CPU_OP_IMMD_WIDTH_A
+#undef CPU_OP_IMMD_WIDTH_X
+#undef CPU_OP_IMMD_WIDTH__
+
+// True for the 8-bit relative branches. Their handlers fetch the offset
+// themselves, but it is decoded into the operand for _cpu_dispatch_idle()
+// (see CPU_BRANCH_BACK())
+#define CPU_OP_PCR(op, fn, kind, size, cycles, mode, res, mn, reg, acc) \
+    [op] = (CPU_ADDR_##mode == CPU_ADDR_PCR),
+static const bool op_pcr[256] = { CPU_OPCODE_TABLE(CPU_OP_PCR) };
+#undef CPU_OP_PCR
+
+
+/**
+ * Get the register width variant index for the current CPU state
+ *
+ * @param *cpu The CPU to check
+ * @return The variant index (CPU_W_* bits)
+ */
+static inline int _cpu_width(CPU_t *cpu)
+{
+    return (CPU_M8(cpu) ? CPU_W_M8 : 0) | (CPU_X8(cpu) ? CPU_W_X8 : 0);
+}
+
+
+/**
+ * Decode instructions starting at an address into a block. When the
+ * block is for a cache, the decoded bytes are marked in memory so that
+ * writing to them drops the block.
+ *
+ * @param *mem The memory array which is connected to the CPU
+ * @param *b The block to decode into
+ * @param pc The 24-bit address of the first instruction
+ * @param width The register width variant index to decode for
+ * @param cache True if the block is in a cache (false decodes a single instruction)
+ */
+static void _cpu_decode_block(memory_t *mem, CPU_Decode_Block_t *b, uint32_t pc, int width, bool cache)
+{
+    uint32_t addr = pc;
+    uint32_t span = 0;
+    uint8_t op;
+
+    b->count = 0;
+    do
+    {
+        CPU_Decode_Entry_t *e = &b->insn[b->count++];
+        op = _get_mem_byte(mem, addr, false);
+
+        uint32_t size = op_size[op];
+        if (op_immd[op] && !(width & op_immd[op])) // 16-bit immediate
+        {
+            size += 1;
+        }
+
+        e->opcode = op;
+        e->len = op_len[op];
+        e->size = size;
+        e->operand = 0;
+        for (uint32_t i = 1; i < e->len; ++i)
+        {
+            e->operand |= (uint32_t)_get_mem_byte(mem, _addr_add_val_bank_wrap(addr, i), false) << (8 * (i - 1));
+        }
+        if (op_pcr[op])
+        {
+            e->operand = _get_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), false);
+        }
+
+        if (cache)
+        {
+            for (uint32_t i = 0; i < size; ++i)
+            {
+                _mem_set_flag(mem, MEM_PLANE_C, _addr_add_val_bank_wrap(addr, i));
+            }
+        }
+
+        span += size;
+        addr = _addr_add_val_bank_wrap(addr, size);
+    } while (cache && !op_ends_block[op] &&
+        b->count < CPU_DECODE_BLOCK_LEN &&
+        span + 4 <= CPU_DECODE_BLOCK_BYTES && // Room for another instruction
+        !_mem_get_flag(mem, MEM_PLANE_B, addr) &&
+        !_test_mem_io(mem, addr));
+
+    if (cache)
+    {
+        _mem_set_flag(mem, MEM_PLANE_X, pc);
+    }
+}
+
+
+/**
+ * Get the decoded block which starts at the CPU's PC. The block comes
+ * from the CPU's predecoded instruction cache when possible. Without a
+ * cache, or for code on a device page, the block holds just the next
+ * instruction and is decoded into scratch (with a key of 0).
+ *
+ * @param *cpu The CPU to get the next block for
+ * @param *mem The memory array which is connected to the CPU
+ * @param *scratch The block to decode into if the CPU has no cache
+ * @param width The register width variant index for the current CPU state
+ * @return The decoded block
+ */
+static inline CPU_Decode_Block_t *_cpu_get_block(CPU_t *cpu, memory_t *mem, CPU_Decode_Block_t *scratch, int width)
+{
+    CPU_Decode_Cache_t *cache = cpu->dcache;
+    uint32_t pc = _cpu_get_effective_pc(cpu);
+    uint32_t key = CPU_DECODE_VALID | ((uint32_t)width << CPU_DECODE_WIDTH_SHIFT) | pc;
+    CPU_Decode_Block_t *b;
+
+    // Device registers can change without being written, so
+    // instructions on device pages are decoded every time
+    if (!cache || MEM_SLOW_PATH(_test_mem_io(mem, pc)))
+    {
+        _cpu_decode_block(mem, scratch, pc, width, false);
+        scratch->key = 0;
+        return scratch;
+    }
+
+    b = &cache->blocks[pc & (CPU_DECODE_CACHE_BLOCKS - 1)];
+
+    // A block which has been written to no longer has the X flag on its first byte
+    if (b->key != key || !_mem_get_flag(mem, MEM_PLANE_X, pc))
+    {
+        _cpu_decode_block(mem, b, pc, width, true);
+        b->key = key;
+        b->hits = 0;
+        b->native = NULL;
+    }
+    return b;
+}
+
+
+/**
+ * Set the read flags on the bytes of the instruction at the CPU's PC
+ * which the dispatcher fetched to decode it (as if they were just read).
+ *
+ * @param *cpu The CPU which is about to execute the instruction
+ * @param *mem The memory array which is connected to the CPU
+ * @param *e The decoded instruction
+ */
+static inline void _cpu_fetch_flags(CPU_t *cpu, memory_t *mem, const CPU_Decode_Entry_t *e)
+{
+    uint32_t pc = _cpu_get_effective_pc(cpu);
+    for (uint32_t i = 0; i < e->len; ++i)
+    {
+        _mem_set_flag(mem, MEM_PLANE_R, _addr_add_val_bank_wrap(pc, i));
+    }
+}
+
+// Instantiate the handlers for each register width combination,
+// with access flag tracking compiled out and then compiled in
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+#undef CPU_OP_DEF
+#define CPU_OP_DEF(name) static inline void CPU_CAT(name, CPU_OPS_SUFFIX)
+
+#define CPU_OPS_SUFFIX _m16x16
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 0
+#define CPU_SETACC(cpu) 0
+#include "65816-ops.c"
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+#define CPU_OPS_SUFFIX _m8x16
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 0
+#define CPU_SETACC(cpu) 0
+#include "65816-ops.c"
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+#define CPU_OPS_SUFFIX _m16x8
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 1
+#define CPU_SETACC(cpu) 0
+#include "65816-ops.c"
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+#define CPU_OPS_SUFFIX _m8x8
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 1
+#define CPU_SETACC(cpu) 0
+#include "65816-ops.c"
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+#define CPU_OPS_SUFFIX _m16x16_acc
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 0
+#define CPU_SETACC(cpu) 1
+#include "65816-ops.c"
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+#define CPU_OPS_SUFFIX _m8x16_acc
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 0
+#define CPU_SETACC(cpu) 1
+#include "65816-ops.c"
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+#define CPU_OPS_SUFFIX _m16x8_acc
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 1
+#define CPU_SETACC(cpu) 1
+#include "65816-ops.c"
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+#define CPU_OPS_SUFFIX _m8x8_acc
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 1
+#define CPU_SETACC(cpu) 1
+#include "65816-ops.c"
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+#undef CPU_OP_DEF
+
+
+#if !defined(CPU_DISPATCH_GOTO) || defined(CPU_JIT)
+
+// One small function per opcode and width which binds the handler to its resolver
+#define CPU_OP_FUNC(op, fn, kind, size, cycles, mode, res, mn, reg, acc)                      \
+    static void CPU_CAT(_op_##op, CPU_OPS_SUFFIX)(CPU_t *cpu, memory_t *mem, uint32_t operand) \
+    {                                                                                         \
+        CPU_OP_CALL_##kind(CPU_CAT(i_##fn, CPU_OPS_SUFFIX), size, cycles, mode, res,          \
+                           CPU_OP_PENALTIES(mode, reg, acc));                                 \
+    }
+#define CPU_OP_PTR(op, fn, kind, size, cycles, mode, res, mn, reg, acc) [op] = CPU_CAT(_op_##op, CPU_OPS_SUFFIX),
+
+#define CPU_SETACC(cpu) 0
+#define CPU_OPS_SUFFIX _m16x16
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 0
+CPU_OPCODE_TABLE(CPU_OP_FUNC)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m8x16
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 0
+CPU_OPCODE_TABLE(CPU_OP_FUNC)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m16x8
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 1
+CPU_OPCODE_TABLE(CPU_OP_FUNC)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m8x8
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 1
+CPU_OPCODE_TABLE(CPU_OP_FUNC)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+#define CPU_SETACC(cpu) 1
+#define CPU_OPS_SUFFIX _m16x16_acc
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 0
+CPU_OPCODE_TABLE(CPU_OP_FUNC)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m8x16_acc
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 0
+CPU_OPCODE_TABLE(CPU_OP_FUNC)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m16x8_acc
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 1
+CPU_OPCODE_TABLE(CPU_OP_FUNC)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m8x8_acc
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 1
+CPU_OPCODE_TABLE(CPU_OP_FUNC)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+static void (*const op_table[CPU_VARIANTS][256])(CPU_t *, memory_t *, uint32_t) = {
+#define CPU_OPS_SUFFIX _m16x16
+    [0] = { CPU_OPCODE_TABLE(CPU_OP_PTR) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m8x16
+    [CPU_W_M8] = { CPU_OPCODE_TABLE(CPU_OP_PTR) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m16x8
+    [CPU_W_X8] = { CPU_OPCODE_TABLE(CPU_OP_PTR) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m8x8
+    [CPU_W_M8 | CPU_W_X8] = { CPU_OPCODE_TABLE(CPU_OP_PTR) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m16x16_acc
+    [CPU_W_ACC] = { CPU_OPCODE_TABLE(CPU_OP_PTR) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m8x16_acc
+    [CPU_W_ACC | CPU_W_M8] = { CPU_OPCODE_TABLE(CPU_OP_PTR) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m16x8_acc
+    [CPU_W_ACC | CPU_W_X8] = { CPU_OPCODE_TABLE(CPU_OP_PTR) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m8x8_acc
+    [CPU_W_ACC | CPU_W_M8 | CPU_W_X8] = { CPU_OPCODE_TABLE(CPU_OP_PTR) },
+#undef CPU_OPS_SUFFIX
+};
+
+#undef CPU_OP_FUNC
+#undef CPU_OP_PTR
+
+#endif
+
+
+#ifdef CPU_JIT
+
+/**
+ * Run a decoded block as native code if the CPU has a JIT attached (see
+ * enableJITCPU()). The block is compiled once it has been entered often
+ * enough. Blocks are not run as native code while the CPU sets memory
+ * access flags.
+ *
+ * @param *cpu The CPU to run
+ * @param *mem The memory array which is connected to the CPU
+ * @param *b The block at the CPU's PC
+ * @param width The register width variant index the block was decoded for
+ * @param budget The maximum number of instructions to execute
+ * @param cycle_end Stop once the CPU's cycle count reaches this
+ * @return The number of instructions which were executed (0 if the block has to be interpreted)
+ */
+static inline uint64_t _cpu_jit_run(CPU_t *cpu, memory_t *mem, CPU_Decode_Block_t *b, int width, uint64_t budget, uint64_t cycle_end)
+{
+    CPU_JIT_t *jit = cpu->jit;
+
+    // Blocks which are not in the cache (see _cpu_get_block()) are never compiled
+    if (!jit || !cpu->dcache || cpu->setacc || !(b->key & CPU_DECODE_VALID))
+    {
+        return 0;
+    }
+    if (!b->native)
+    {
+        if (b->hits < jit->threshold)
+        {
+            ++b->hits;
+            return 0;
+        }
+        b->native = _cpu_jit_compile(jit, cpu->dcache, mem, b, width & CPU_W_M8, width & CPU_W_X8, op_table[width]);
+        if (!b->native)
+        {
+            return 0;
+        }
+    }
+    return b->native(cpu, mem, budget, cycle_end);
+}
+
+#endif
+
+
+/**
+ * Execute instructions until either the count is reached, the
+ * CPU enters a state which requires handling by stepCPU()/runCPU()
+ * (CRASH, STP, or a pending interrupt) or a stop condition is hit.
+ *
+ * Instructions are run a decoded block at a time. Within a block,
+ * only _cpu_dispatch_pending() is checked between instructions (blocks
+ * end before breakpoints and at WAI) and the block is left early if
+ * it is written to.
+ *
+ * @note This does not check for reset or handle any interrupts.
+ *       The first instruction is always executed if count > 0.
+ * @param *cpu The CPU to run
+ * @param *mem The memory array which is connected to the CPU
+ * @param count The maximum number of instructions to execute
+ * @param cycle_end Stop once the CPU's cycle count reaches this
+ * @param stop_mask The runCPU() stop conditions to check for
+ * @return The number of instructions which were executed
+ */
+uint64_t _cpu_dispatch_run(CPU_t *cpu, memory_t *mem, uint64_t count, uint64_t cycle_end, uint32_t stop_mask)
+{
+    uint64_t n = 0;
+    int width;
+    CPU_Decode_Block_t scratch;
+    CPU_Decode_Block_t *b;
+    const CPU_Decode_Entry_t *ip;
+    const CPU_Decode_Entry_t *end;
+    uint32_t block_pc;
+    uint32_t operand;
+#ifdef CPU_JIT
+    uint64_t k;
+#endif
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    // The cached blocks are only valid for the memory they were decoded from
+    if (cpu->dcache && cpu->dcache->mem != mem)
+    {
+        memset(cpu->dcache->blocks, 0, sizeof(cpu->dcache->blocks));
+        cpu->dcache->mem = mem;
+    }
+
+#ifdef CPU_DISPATCH_GOTO
+
+// Computed gotos are a GNU extension
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+#define CPU_OP_LABEL(op, fn, kind, size, cycles, mode, res, mn, reg, acc) [op] = &&CPU_CAT(_op_##op, CPU_OPS_SUFFIX),
+    static void *const op_labels[CPU_VARIANTS][256] = {
+#define CPU_OPS_SUFFIX _m16x16
+        [0] = { CPU_OPCODE_TABLE(CPU_OP_LABEL) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m8x16
+        [CPU_W_M8] = { CPU_OPCODE_TABLE(CPU_OP_LABEL) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m16x8
+        [CPU_W_X8] = { CPU_OPCODE_TABLE(CPU_OP_LABEL) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m8x8
+        [CPU_W_M8 | CPU_W_X8] = { CPU_OPCODE_TABLE(CPU_OP_LABEL) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m16x16_acc
+        [CPU_W_ACC] = { CPU_OPCODE_TABLE(CPU_OP_LABEL) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m8x16_acc
+        [CPU_W_ACC | CPU_W_M8] = { CPU_OPCODE_TABLE(CPU_OP_LABEL) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m16x8_acc
+        [CPU_W_ACC | CPU_W_X8] = { CPU_OPCODE_TABLE(CPU_OP_LABEL) },
+#undef CPU_OPS_SUFFIX
+#define CPU_OPS_SUFFIX _m8x8_acc
+        [CPU_W_ACC | CPU_W_M8 | CPU_W_X8] = { CPU_OPCODE_TABLE(CPU_OP_LABEL) },
+#undef CPU_OPS_SUFFIX
+    };
+#undef CPU_OP_LABEL
+
+    void *const *labels;
+
+#define CPU_DISPATCH_NEXT(setacc)          \
+    if (setacc)                            \
+    {                                      \
+        _cpu_fetch_flags(cpu, mem, ip);    \
+    }                                      \
+    operand = ip->operand;                 \
+    goto *labels[ip->opcode]
+
+next_block:
+    width = _cpu_width(cpu);
+    labels = op_labels[width | (cpu->setacc ? CPU_W_ACC : 0)];
+    b = _cpu_get_block(cpu, mem, &scratch, width);
+#ifdef CPU_JIT
+    if ((k = _cpu_jit_run(cpu, mem, b, width, count - n, cycle_end)) != 0)
+    {
+        n += k;
+        n += _cpu_dispatch_move(cpu, mem, b->insn[k - 1].opcode, count - n, cycle_end, stop_mask);
+        n += _cpu_dispatch_idle(cpu, mem, b->insn[k - 1].opcode, CPU_BRANCH_BACK(b->insn[k - 1].operand),
+                                n, count, cycle_end, stop_mask);
+        if (n == count || _cpu_dispatch_stop(cpu, mem, b->insn[k - 1].opcode, cycle_end, stop_mask))
+        {
+            return n;
+        }
+        goto next_block;
+    }
+#endif
+    block_pc = _cpu_get_effective_pc(cpu);
+    ip = b->insn;
+    end = ip + b->count;
+    CPU_DISPATCH_NEXT(cpu->setacc);
+
+    // Each handler jumps directly to the next one in its block
+#define CPU_OP_BODY(op, fn, kind, size, cycles, mode, res, mn, reg, acc)          \
+    CPU_CAT(_op_##op, CPU_OPS_SUFFIX):                                            \
+    CPU_OP_CALL_##kind(CPU_CAT(i_##fn, CPU_OPS_SUFFIX), size, cycles, mode, res,  \
+                       CPU_OP_PENALTIES(mode, reg, acc));                         \
+    n += _cpu_dispatch_move(cpu, mem, op, count - n - 1, cycle_end, stop_mask);   \
+    n += _cpu_dispatch_idle(cpu, mem, op, CPU_BRANCH_BACK(operand), n + 1,        \
+                            count, cycle_end, stop_mask);                         \
+    if (++n == count)                                                             \
+    {                                                                             \
+        return n;                                                                 \
+    }                                                                             \
+    if (++ip != end && !_cpu_dispatch_pending(cpu, cycle_end) &&                  \
+        _mem_get_flag(mem, MEM_PLANE_X, block_pc))                                \
+    {                                                                             \
+        CPU_DISPATCH_NEXT(CPU_SETACC(cpu));                                       \
+    }                                                                             \
+    if (_cpu_dispatch_stop(cpu, mem, op, cycle_end, stop_mask))                   \
+    {                                                                             \
+        return n;                                                                 \
+    }                                                                             \
+    goto next_block;
+
+#define CPU_SETACC(cpu) 0
+#define CPU_OPS_SUFFIX _m16x16
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 0
+    CPU_OPCODE_TABLE(CPU_OP_BODY)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m8x16
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 0
+    CPU_OPCODE_TABLE(CPU_OP_BODY)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m16x8
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 1
+    CPU_OPCODE_TABLE(CPU_OP_BODY)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m8x8
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 1
+    CPU_OPCODE_TABLE(CPU_OP_BODY)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+#define CPU_SETACC(cpu) 1
+#define CPU_OPS_SUFFIX _m16x16_acc
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 0
+    CPU_OPCODE_TABLE(CPU_OP_BODY)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m8x16_acc
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 0
+    CPU_OPCODE_TABLE(CPU_OP_BODY)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m16x8_acc
+#define CPU_M8(cpu) 0
+#define CPU_X8(cpu) 1
+    CPU_OPCODE_TABLE(CPU_OP_BODY)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#define CPU_OPS_SUFFIX _m8x8_acc
+#define CPU_M8(cpu) 1
+#define CPU_X8(cpu) 1
+    CPU_OPCODE_TABLE(CPU_OP_BODY)
+#undef CPU_OPS_SUFFIX
+#undef CPU_M8
+#undef CPU_X8
+#undef CPU_SETACC
+
+#undef CPU_OP_BODY
+#undef CPU_DISPATCH_NEXT
+
+#pragma GCC diagnostic pop
+
+#else
+
+    void (*const *table)(CPU_t *, memory_t *, uint32_t);
+    bool setacc;
+    uint8_t op;
+
+    while (true)
+    {
+        width = _cpu_width(cpu);
+        setacc = cpu->setacc;
+        table = op_table[width | (setacc ? CPU_W_ACC : 0)];
+        b = _cpu_get_block(cpu, mem, &scratch, width);
+#ifdef CPU_JIT
+        if ((k = _cpu_jit_run(cpu, mem, b, width, count - n, cycle_end)) != 0)
+        {
+            n += k;
+            n += _cpu_dispatch_move(cpu, mem, b->insn[k - 1].opcode, count - n, cycle_end, stop_mask);
+            n += _cpu_dispatch_idle(cpu, mem, b->insn[k - 1].opcode, CPU_BRANCH_BACK(b->insn[k - 1].operand),
+                                    n, count, cycle_end, stop_mask);
+            if (n == count || _cpu_dispatch_stop(cpu, mem, b->insn[k - 1].opcode, cycle_end, stop_mask))
+            {
+                return n;
+            }
+            continue;
+        }
+#endif
+        block_pc = _cpu_get_effective_pc(cpu);
+        ip = b->insn;
+        end = ip + b->count;
+
+        do
+        {
+            if (setacc)
+            {
+                _cpu_fetch_flags(cpu, mem, ip);
+            }
+            op = ip->opcode;
+            operand = ip->operand;
+            table[op](cpu, mem, operand);
+            n += _cpu_dispatch_move(cpu, mem, op, count - n - 1, cycle_end, stop_mask);
+            n += _cpu_dispatch_idle(cpu, mem, op, CPU_BRANCH_BACK(operand), n + 1, count, cycle_end, stop_mask);
+
+            if (++n == count)
+            {
+                return n;
+            }
+        } while (++ip != end && !_cpu_dispatch_pending(cpu, cycle_end) &&
+            _mem_get_flag(mem, MEM_PLANE_X, block_pc));
+
+        if (_cpu_dispatch_stop(cpu, mem, op, cycle_end, stop_mask))
+        {
+            return n;
+        }
+    }
+
+#endif
+}
+
+#endif /* CPU_DISPATCH_TABLE */
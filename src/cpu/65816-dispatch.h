@@ -0,0 +1,181 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+#ifndef DISPATCH_65816_H
+#define DISPATCH_65816_H
+
+#include "65816.h"
+#include "65816-ops.h"
+#include "65816-util.h"
+#include "65816-opcodes.h"
+
+// Number of operand bytes fetched by each resolver
+#define CPU_OPERAND_None 0
+#define CPU_OPERAND_Immediate 0 // The handler reads the immediate value itself
+#define CPU_OPERAND_Absolute 2
+#define CPU_OPERAND_AbsoluteIndexedX 2
+#define CPU_OPERAND_AbsoluteIndexedY 2
+#define CPU_OPERAND_AbsoluteIndexedIndirectX 2
+#define CPU_OPERAND_AbsoluteIndirect 2
+#define CPU_OPERAND_AbsoluteIndirectLong 2
+#define CPU_OPERAND_Long 3
+#define CPU_OPERAND_LongIndexedX 3
+#define CPU_OPERAND_DirectPage 1
+#define CPU_OPERAND_DirectPageIndexedX 1
+#define CPU_OPERAND_DirectPageIndexedY 1
+#define CPU_OPERAND_DirectPageIndexedIndirectX 1
+#define CPU_OPERAND_DirectPageIndirect 1
+#define CPU_OPERAND_DirectPageIndirectIndexedY 1
+#define CPU_OPERAND_DirectPageIndirectLong 1
+#define CPU_OPERAND_DirectPageIndirectLongIndexedY 1
+#define CPU_OPERAND_StackRelative 1
+#define CPU_OPERAND_StackRelativeIndirectIndexedY 1
+
+// Handler call for each opcode kind (expanded inside a function
+// which has `cpu`, `mem` and the fetched `operand` in scope, with
+// CPU_M8(), CPU_X8() and CPU_SETACC() defined for the handler variant).
+// pen is the opcode's CPU_OP_PENALTIES(), which ALU handlers take on top
+// of their base cycle count
+#define _addrCPU_resolveNone(cpu, mem, operand, setacc) ((void) operand, 0)
+#define CPU_OP_CALL_ALU(fn, size, base, mode, res, pen)                            \
+    do                                                                              \
+    {                                                                               \
+        uint32_t ea = _addrCPU_resolve##res(cpu, mem, operand, CPU_SETACC(cpu));    \
+        cpu->cycles += _cpu_penalty_cycles(cpu, pen, ea, CPU_M8(cpu), CPU_X8(cpu)); \
+        fn(cpu, mem, size, base, CPU_ADDR_##mode, ea);                              \
+    } while (0)
+#define CPU_OP_CALL_JMP(fn, size, cycles, mode, res, pen) \
+    fn(cpu, cycles, CPU_ADDR_##mode, _addrCPU_resolve##res(cpu, mem, operand, CPU_SETACC(cpu)))
+#define CPU_OP_CALL_JSR(fn, size, cycles, mode, res, pen) \
+    fn(cpu, mem, cycles, _addrCPU_resolve##res(cpu, mem, operand, CPU_SETACC(cpu)))
+#define CPU_OP_CALL_REL(fn, size, cycles, mode, res, pen) \
+    ((void) operand, fn(cpu, mem))
+#define CPU_OP_CALL_MEM(fn, size, cycles, mode, res, pen) \
+    ((void) operand, fn(cpu, mem))
+#define CPU_OP_CALL_IMP(fn, size, cycles, mode, res, pen) \
+    ((void) mem, (void) operand, fn(cpu))
+
+#define CPU_OP_MVP 0x44
+#define CPU_OP_MVN 0x54
+#define CPU_OP_BRA 0x80
+#define CPU_OP_WAI 0xcb
+
+// The checks made between instructions are expanded into every handler
+// body of the threaded dispatcher, which is far past the size where the
+// compiler stops inlining on its own
+#ifdef __GNUC__
+#define CPU_DISPATCH_INLINE static inline __attribute__((always_inline))
+#else
+#define CPU_DISPATCH_INLINE static inline
+#endif
+
+/**
+ * Determine if the CPU is in a state that stepCPU()/runCPU() has to
+ * handle (CRASH, STP, or a pending interrupt) or has used up its cycles.
+ * These are the only stop conditions which can be reached in the middle
+ * of a decoded block.
+ *
+ * @param *cpu The CPU to check
+ * @param cycle_end Stop once the CPU's cycle count reaches this
+ * @return True if the engine should stop
+ */
+CPU_DISPATCH_INLINE bool _cpu_dispatch_pending(CPU_t *cpu, uint64_t cycle_end)
+{
+    return cpu->P.CRASH || cpu->P.STP || cpu->P.NMI || (cpu->P.IRQ && !cpu->P.I) ||
+        cpu->cycles >= cycle_end;
+}
+
+/**
+ * Determine if an execution engine has to hand control back to its
+ * caller after an instruction, either because of _cpu_dispatch_pending()
+ * or because an optional stop condition was reached.
+ *
+ * @param *cpu The CPU to check
+ * @param *mem The memory array which is connected to the CPU
+ * @param opcode The opcode of the instruction which was just executed
+ * @param cycle_end Stop once the CPU's cycle count reaches this
+ * @param stop_mask The runCPU() stop conditions which are enabled
+ * @return True if the engine should stop
+ */
+static inline bool _cpu_dispatch_stop(CPU_t *cpu, memory_t *mem, uint8_t opcode, uint64_t cycle_end, uint32_t stop_mask)
+{
+    return _cpu_dispatch_pending(cpu, cycle_end) ||
+        (opcode == CPU_OP_WAI && (stop_mask & CPU_RUN_WAI) && !cpu->P.IRQ) ||
+        ((stop_mask & CPU_RUN_BREAK) && _test_mem_flags(mem, _cpu_get_effective_pc(cpu)).B);
+}
+
+uint64_t _cpu_move_block(CPU_t *, memory_t *, uint64_t, uint64_t);
+
+/**
+ * Continue a block move (MVN/MVP) which an execution engine just ran a
+ * byte of in bulk, as long as the engine would have kept running it
+ * (see _cpu_dispatch_stop()). Nothing happens for any other opcode.
+ *
+ * @param *cpu The CPU to run
+ * @param *mem The memory array which is connected to the CPU
+ * @param opcode The opcode of the instruction which was just executed
+ * @param count The maximum number of instructions to execute
+ * @param cycle_end Stop once the CPU's cycle count reaches this
+ * @param stop_mask The runCPU() stop conditions which are enabled
+ * @return The number of instructions (bytes moved) which were executed
+ */
+CPU_DISPATCH_INLINE uint64_t _cpu_dispatch_move(CPU_t *cpu, memory_t *mem, uint8_t opcode, uint64_t count, uint64_t cycle_end, uint32_t stop_mask)
+{
+    if ((opcode != CPU_OP_MVN && opcode != CPU_OP_MVP) || count == 0 ||
+        _cpu_dispatch_stop(cpu, mem, opcode, cycle_end, stop_mask))
+    {
+        return 0;
+    }
+    return _cpu_move_block(cpu, mem, count, cycle_end);
+}
+
+uint64_t _cpu_skip_idle(CPU_t *, memory_t *, uint64_t, uint64_t, uint64_t);
+
+// Number of bytes from the start of a loop to the branch at its end,
+// given the branch's operand (only meaningful for short loops)
+#define CPU_BRANCH_BACK(operand) ((uint16_t)(-2 - (int8_t)(operand)))
+
+/**
+ * Skip ahead through a loop which only reads memory (see _cpu_skip_idle())
+ * after an execution engine ran a branch back to the start of a short loop,
+ * as long as the engine would have kept running (see _cpu_dispatch_stop()).
+ * Nothing happens for any other instruction.
+ *
+ * @param *cpu The CPU to run
+ * @param *mem The memory array which is connected to the CPU
+ * @param opcode The opcode of the instruction which was just executed
+ * @param back The number of bytes the branch jumps back from its own address
+ *             (see CPU_BRANCH_BACK())
+ * @param done The number of instructions the engine has executed so far
+ *             (including the branch)
+ * @param count The maximum number of instructions the engine can execute
+ * @param cycle_end Stop once the CPU's cycle count reaches this
+ * @param stop_mask The runCPU() stop conditions which are enabled
+ * @return The number of instructions which were skipped
+ */
+CPU_DISPATCH_INLINE uint64_t _cpu_dispatch_idle(CPU_t *cpu, memory_t *mem, uint8_t opcode, uint16_t back, uint64_t done, uint64_t count, uint64_t cycle_end, uint32_t stop_mask)
+{
+    if (((opcode & 0x1f) != 0x10 && opcode != CPU_OP_BRA) || back >= CPU_IDLE_LOOP_BYTES ||
+        done >= count)
+    {
+        return 0;
+    }
+    // Already found not to be such a loop
+    if (cpu->idle.len == 0 && cpu->idle.pc == _cpu_get_effective_pc(cpu))
+    {
+        return 0;
+    }
+    if (_cpu_dispatch_stop(cpu, mem, opcode, cycle_end, stop_mask))
+    {
+        return 0;
+    }
+    return _cpu_skip_idle(cpu, mem, done, count, cycle_end);
+}
+
+#ifdef CPU_DISPATCH_TABLE
+uint64_t _cpu_dispatch_run(CPU_t *, memory_t *, uint64_t, uint64_t, uint32_t);
+#endif
+
+#endif
@@ -0,0 +1,899 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ *
+ * Native code compiler (JIT) for the table-driven dispatcher. This is
+ * only built in when CPU_JIT is defined (and needs CPU_DISPATCH_TABLE)
+ * and currently only produces x86-64 code (System V ABI).
+ *
+ * Decoded blocks which have been entered often enough (see
+ * enableJITCPU()) are compiled into a single native function. The
+ * register/flag instructions and immediate loads/compares are emitted
+ * directly, with A, X and Y kept in host registers. Everything else
+ * calls the same handler the dispatcher would. Between instructions,
+ * the compiled code makes the same checks as the dispatcher (instruction
+ * budget, pending interrupts, cycle budget and writes to the block) and
+ * returns to it early if one of them fails.
+ */
+
+#ifdef CPU_JIT
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS
+#endif
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "65816.h"
+#include "65816-util.h"
+#include "65816-jit.h"
+
+#if defined(CPU_JIT) && !defined(CPU_DISPATCH_TABLE)
+#error "CPU_JIT requires CPU_DISPATCH_TABLE"
+#endif
+
+#if defined(CPU_JIT) && defined(__x86_64__) && (defined(__unix__) || defined(__APPLE__))
+#define CPU_JIT_X86_64
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+#ifdef CPU_JIT_X86_64
+
+// Host registers
+#define JIT_RAX 0
+#define JIT_RCX 1
+#define JIT_RDX 2
+#define JIT_RBX 3 // CPU_t *
+#define JIT_RBP 5 // Instructions executed
+#define JIT_R12 12 // memory_t *
+#define JIT_R13 13 // A (C)
+#define JIT_R14 14 // X
+#define JIT_R15 15 // Y
+
+// Condition codes (for jcc)
+#define JIT_CC_AE 0x3
+#define JIT_CC_E 0x4
+#define JIT_CC_NE 0x5
+
+// CPU registers which can be held in host registers
+#define JIT_REG_A 0
+#define JIT_REG_X 1
+#define JIT_REG_Y 2
+
+// Most exits (jumps to the epilogue) a block can have
+#define JIT_MAX_EXITS (CPU_DECODE_BLOCK_LEN * 7)
+
+// Code being emitted for a block
+typedef struct JIT_Emit_t {
+    uint8_t *p;                    // Next byte to emit
+    uint8_t *exits[JIT_MAX_EXITS]; // rel32 fields which jump to the epilogue
+    int exit_count;
+    bool loaded[3]; // True if the CPU register is in its host register
+#ifdef CPU_MEM_SPARSE
+    const uint8_t *block_x; // Byte of the X flag plane which holds the block's flag
+#endif
+} JIT_Emit_t;
+
+static const uint8_t jit_host_reg[3] = { JIT_R13, JIT_R14, JIT_R15 };
+static const size_t jit_reg_offset[3] = { offsetof(CPU_t, C), offsetof(CPU_t, X), offsetof(CPU_t, Y) };
+
+
+/**
+ * Emit a byte
+ *
+ * @param *e The code being emitted
+ * @param val The byte
+ */
+static void _jit_byte(JIT_Emit_t *e, uint8_t val)
+{
+    *e->p++ = val;
+}
+
+/**
+ * Emit a 16-bit value
+ *
+ * @param *e The code being emitted
+ * @param val The value
+ */
+static void _jit_word(JIT_Emit_t *e, uint16_t val)
+{
+    _jit_byte(e, val & 0xff);
+    _jit_byte(e, val >> 8);
+}
+
+/**
+ * Emit a 32-bit value
+ *
+ * @param *e The code being emitted
+ * @param val The value
+ */
+static void _jit_dword(JIT_Emit_t *e, uint32_t val)
+{
+    _jit_word(e, val & 0xffff);
+    _jit_word(e, val >> 16);
+}
+
+/**
+ * Emit a 64-bit value
+ *
+ * @param *e The code being emitted
+ * @param val The value
+ */
+static void _jit_qword(JIT_Emit_t *e, uint64_t val)
+{
+    _jit_dword(e, val & 0xffffffff);
+    _jit_dword(e, val >> 32);
+}
+
+/**
+ * Emit a REX prefix (if one is needed)
+ *
+ * @param *e The code being emitted
+ * @param w True for a 64-bit operand
+ * @param reg The register in the ModRM reg field
+ * @param rm The register in the ModRM r/m field
+ * @param force True to emit the prefix even if it has no bits set (byte registers)
+ */
+static void _jit_rex(JIT_Emit_t *e, bool w, int reg, int rm, bool force)
+{
+    uint8_t rex = 0x40 | (w ? 0x08 : 0) | ((reg & 0x8) ? 0x04 : 0) | ((rm & 0x8) ? 0x01 : 0);
+    if (rex != 0x40 || force)
+    {
+        _jit_byte(e, rex);
+    }
+}
+
+/**
+ * Emit a ModRM byte for a register-register operation
+ *
+ * @param *e The code being emitted
+ * @param reg The register (or opcode extension) in the reg field
+ * @param rm The register in the r/m field
+ */
+static void _jit_modrm_reg(JIT_Emit_t *e, int reg, int rm)
+{
+    _jit_byte(e, 0xc0 | ((reg & 0x7) << 3) | (rm & 0x7));
+}
+
+/**
+ * Emit a ModRM byte and displacement for a field of the CPU struct ([rbx+disp32])
+ *
+ * @param *e The code being emitted
+ * @param reg The register (or opcode extension) in the reg field
+ * @param offset The offset of the field in CPU_t
+ */
+static void _jit_modrm_cpu(JIT_Emit_t *e, int reg, size_t offset)
+{
+    _jit_byte(e, 0x80 | ((reg & 0x7) << 3) | JIT_RBX);
+    _jit_dword(e, (uint32_t) offset);
+}
+
+/**
+ * Emit a conditional jump to the epilogue
+ *
+ * @param *e The code being emitted
+ * @param cc The condition code
+ */
+static void _jit_exit_if(JIT_Emit_t *e, uint8_t cc)
+{
+    _jit_byte(e, 0x0f);
+    _jit_byte(e, 0x80 | cc);
+    e->exits[e->exit_count++] = e->p;
+    _jit_dword(e, 0);
+}
+
+/**
+ * Make sure a CPU register is in its host register
+ *
+ * @param *e The code being emitted
+ * @param reg The CPU register (JIT_REG_*)
+ * @return The host register
+ */
+static int _jit_load(JIT_Emit_t *e, int reg)
+{
+    int h = jit_host_reg[reg];
+    if (!e->loaded[reg])
+    {
+        // movzx h32, word [rbx+offset]
+        _jit_rex(e, false, h, JIT_RBX, false);
+        _jit_byte(e, 0x0f);
+        _jit_byte(e, 0xb7);
+        _jit_modrm_cpu(e, h, jit_reg_offset[reg]);
+        e->loaded[reg] = true;
+    }
+    return h;
+}
+
+/**
+ * Write a CPU register back from its host register
+ *
+ * @param *e The code being emitted
+ * @param reg The CPU register (JIT_REG_*)
+ */
+static void _jit_store(JIT_Emit_t *e, int reg)
+{
+    int h = jit_host_reg[reg];
+
+    // mov word [rbx+offset], h16
+    _jit_byte(e, 0x66);
+    _jit_rex(e, false, h, JIT_RBX, false);
+    _jit_byte(e, 0x89);
+    _jit_modrm_cpu(e, h, jit_reg_offset[reg]);
+}
+
+/**
+ * Increment or decrement a host register
+ *
+ * @param *e The code being emitted
+ * @param h The host register
+ * @param wide True for 16 bits, false for 8 bits (the other bits are kept)
+ * @param dec True to decrement
+ */
+static void _jit_inc(JIT_Emit_t *e, int h, bool wide, bool dec)
+{
+    if (wide)
+    {
+        _jit_byte(e, 0x66);
+    }
+    _jit_rex(e, false, 0, h, !wide);
+    _jit_byte(e, wide ? 0xff : 0xfe);
+    _jit_modrm_reg(e, dec ? 1 : 0, h);
+}
+
+/**
+ * Copy a host register to another
+ *
+ * @param *e The code being emitted
+ * @param dst The destination host register
+ * @param src The source host register
+ * @param width 8 to copy the low byte (keeping the rest of dst),
+ *              0 to zero extend the low byte, 16 to copy all of it
+ */
+static void _jit_mov(JIT_Emit_t *e, int dst, int src, int width)
+{
+    switch (width)
+    {
+    case 8: // mov dst8, src8
+        _jit_rex(e, false, src, dst, true);
+        _jit_byte(e, 0x88);
+        _jit_modrm_reg(e, src, dst);
+        break;
+    case 0: // movzx dst32, src8
+        _jit_rex(e, false, dst, src, true);
+        _jit_byte(e, 0x0f);
+        _jit_byte(e, 0xb6);
+        _jit_modrm_reg(e, dst, src);
+        break;
+    default: // mov dst32, src32
+        _jit_rex(e, false, src, dst, false);
+        _jit_byte(e, 0x89);
+        _jit_modrm_reg(e, src, dst);
+        break;
+    }
+}
+
+/**
+ * Record a result for the N and Z flags (see _cpu_set_nz8()/_cpu_set_nz16())
+ *
+ * @param *e The code being emitted
+ * @param h The host register which holds the result (RAX is used as scratch)
+ * @param wide True for 16 bits, false for 8 bits
+ */
+static void _jit_set_nz(JIT_Emit_t *e, int h, bool wide)
+{
+    if (h != JIT_RAX)
+    {
+        _jit_mov(e, JIT_RAX, h, 16);
+    }
+    if (wide)
+    {
+        // mov byte [rbx+NZ_N], ah
+        _jit_byte(e, 0x88);
+        _jit_modrm_cpu(e, 4, offsetof(CPU_t, P.NZ_N));
+    }
+    else
+    {
+        // mov byte [rbx+NZ_N], al ; movzx eax, al
+        _jit_byte(e, 0x88);
+        _jit_modrm_cpu(e, JIT_RAX, offsetof(CPU_t, P.NZ_N));
+        _jit_mov(e, JIT_RAX, JIT_RAX, 0);
+    }
+
+    // mov word [rbx+NZ_Z], ax
+    _jit_byte(e, 0x66);
+    _jit_byte(e, 0x89);
+    _jit_modrm_cpu(e, JIT_RAX, offsetof(CPU_t, P.NZ_Z));
+}
+
+/**
+ * Load a constant into a host register
+ *
+ * @param *e The code being emitted
+ * @param h The host register
+ * @param val The value
+ * @param keep True to only set the low byte (keeping the rest of the register)
+ */
+static void _jit_mov_imm(JIT_Emit_t *e, int h, uint16_t val, bool keep)
+{
+    _jit_rex(e, false, 0, h, keep);
+    if (keep) // mov h8, imm8
+    {
+        _jit_byte(e, 0xb0 | (h & 0x7));
+        _jit_byte(e, val & 0xff);
+    }
+    else // mov h32, imm32
+    {
+        _jit_byte(e, 0xb8 | (h & 0x7));
+        _jit_dword(e, val);
+    }
+}
+
+/**
+ * Compare a host register with a constant
+ *
+ * @param *e The code being emitted
+ * @param h The host register
+ * @param val The value
+ * @param wide True for 16 bits, false for 8 bits
+ */
+static void _jit_cmp_imm(JIT_Emit_t *e, int h, uint16_t val, bool wide)
+{
+    if (wide)
+    {
+        _jit_byte(e, 0x66);
+    }
+    _jit_rex(e, false, 0, h, !wide);
+    _jit_byte(e, wide ? 0x81 : 0x80);
+    _jit_modrm_reg(e, 7, h);
+    if (wide)
+    {
+        _jit_word(e, val);
+    }
+    else
+    {
+        _jit_byte(e, val & 0xff);
+    }
+}
+
+/**
+ * Set or clear a flag in the CPU's status register
+ *
+ * @param *e The code being emitted
+ * @param offset The offset of the flag in CPU_t
+ * @param set True to set it, false to clear it
+ */
+static void _jit_flag(JIT_Emit_t *e, size_t offset, bool set)
+{
+    // mov byte [rbx+offset], imm8
+    _jit_byte(e, 0xc6);
+    _jit_modrm_cpu(e, 0, offset);
+    _jit_byte(e, set ? 1 : 0);
+}
+
+/**
+ * Compare a byte in the CPU struct with 0
+ *
+ * @param *e The code being emitted
+ * @param offset The offset of the byte in CPU_t
+ */
+static void _jit_test_cpu_byte(JIT_Emit_t *e, size_t offset)
+{
+    // cmp byte [rbx+offset], 0
+    _jit_byte(e, 0x80);
+    _jit_modrm_cpu(e, 7, offset);
+    _jit_byte(e, 0);
+}
+
+/**
+ * Step the CPU's PC over an instruction and add its cycles
+ *
+ * @param *e The code being emitted
+ * @param size The instruction length
+ * @param cycles The cycles the instruction took
+ */
+static void _jit_retire(JIT_Emit_t *e, uint8_t size, uint8_t cycles)
+{
+    // add word [rbx+PC], imm8
+    _jit_byte(e, 0x66);
+    _jit_byte(e, 0x83);
+    _jit_modrm_cpu(e, 0, offsetof(CPU_t, PC));
+    _jit_byte(e, size);
+
+    // add qword [rbx+cycles], imm8
+    _jit_byte(e, 0x48);
+    _jit_byte(e, 0x83);
+    _jit_modrm_cpu(e, 0, offsetof(CPU_t, cycles));
+    _jit_byte(e, cycles);
+}
+
+/**
+ * Emit the code for an index register increment/decrement or transfer
+ * (INX, DEX, INY, DEY, TAX, TAY, TXY, TYX)
+ *
+ * @param *e The code being emitted
+ * @param dst The CPU register which is written
+ * @param src The CPU register which is read (same as dst to increment/decrement)
+ * @param x8 True if the index registers are 8 bits
+ * @param dec True to decrement
+ */
+static void _jit_index_op(JIT_Emit_t *e, int dst, int src, bool x8, bool dec)
+{
+    int s = _jit_load(e, src);
+    int d = jit_host_reg[dst];
+
+    if (src == dst)
+    {
+        _jit_inc(e, d, !x8, dec);
+        if (x8)
+        {
+            _jit_mov(e, d, d, 0);
+        }
+    }
+    else
+    {
+        _jit_mov(e, d, s, x8 ? 0 : 16);
+        e->loaded[dst] = true;
+    }
+    _jit_store(e, dst);
+    _jit_set_nz(e, d, !x8);
+    _jit_retire(e, 1, 2);
+}
+
+/**
+ * Emit native code for an instruction if it is one which the JIT handles
+ * itself (mirrors the i_* handler for the given register widths)
+ *
+ * @param *e The code being emitted
+ * @param *mem The memory the block was decoded from (for immediate operands)
+ * @param op The opcode
+ * @param pc The 24-bit address of the instruction
+ * @param m8 True if the accumulator is 8 bits
+ * @param x8 True if the index registers are 8 bits
+ * @return True if code was emitted, false if the handler has to be called
+ */
+static bool _jit_emit_insn(JIT_Emit_t *e, memory_t *mem, uint8_t op, uint32_t pc, bool m8, bool x8)
+{
+    uint32_t immd_addr = _addr_add_val_bank_wrap(pc, 1);
+    bool wide;
+    uint16_t immd;
+    int h;
+
+    switch (op)
+    {
+    case 0x18: // CLC
+    case 0x38: // SEC
+        _jit_flag(e, offsetof(CPU_t, P.C), op == 0x38);
+        break;
+    case 0xd8: // CLD
+    case 0xf8: // SED
+        _jit_flag(e, offsetof(CPU_t, P.D), op == 0xf8);
+        break;
+    case 0x78: // SEI
+        _jit_flag(e, offsetof(CPU_t, P.I), true);
+        break;
+    case 0xb8: // CLV
+        _jit_flag(e, offsetof(CPU_t, P.V), false);
+        break;
+    case 0xea: // NOP
+        break;
+
+    case 0xe8: // INX
+    case 0xca: // DEX
+        _jit_index_op(e, JIT_REG_X, JIT_REG_X, x8, op == 0xca);
+        return true;
+    case 0xc8: // INY
+    case 0x88: // DEY
+        _jit_index_op(e, JIT_REG_Y, JIT_REG_Y, x8, op == 0x88);
+        return true;
+    case 0xaa: // TAX
+        _jit_index_op(e, JIT_REG_X, JIT_REG_A, x8, false);
+        return true;
+    case 0xa8: // TAY
+        _jit_index_op(e, JIT_REG_Y, JIT_REG_A, x8, false);
+        return true;
+    case 0x9b: // TXY
+        _jit_index_op(e, JIT_REG_Y, JIT_REG_X, x8, false);
+        return true;
+    case 0xbb: // TYX
+        _jit_index_op(e, JIT_REG_X, JIT_REG_Y, x8, false);
+        return true;
+
+    case 0x1a: // INA
+    case 0x3a: // DEA
+        h = _jit_load(e, JIT_REG_A);
+        _jit_inc(e, h, !m8, op == 0x3a);
+        _jit_store(e, JIT_REG_A);
+        _jit_set_nz(e, h, !m8);
+        break;
+    case 0x8a: // TXA
+    case 0x98: // TYA
+        h = _jit_load(e, JIT_REG_A);
+        _jit_mov(e, h, _jit_load(e, op == 0x8a ? JIT_REG_X : JIT_REG_Y), m8 ? 8 : (x8 ? 0 : 16));
+        _jit_store(e, JIT_REG_A);
+        _jit_set_nz(e, h, !m8);
+        break;
+
+    case 0xa9: // LDA #
+        wide = !m8;
+        immd = wide ? _get_mem_word_bank_wrap(mem, immd_addr, false) : _get_mem_byte(mem, immd_addr, false);
+        h = wide ? jit_host_reg[JIT_REG_A] : _jit_load(e, JIT_REG_A);
+        _jit_mov_imm(e, h, immd, !wide);
+        e->loaded[JIT_REG_A] = true;
+        _jit_store(e, JIT_REG_A);
+        _jit_set_nz(e, h, wide);
+        _jit_retire(e, wide ? 3 : 2, wide ? 3 : 2);
+        return true;
+    case 0xa2: // LDX #
+    case 0xa0: // LDY #
+        wide = !x8;
+        immd = wide ? _get_mem_word_bank_wrap(mem, immd_addr, false) : _get_mem_byte(mem, immd_addr, false);
+        h = jit_host_reg[op == 0xa2 ? JIT_REG_X : JIT_REG_Y];
+        _jit_mov_imm(e, h, immd, false);
+        e->loaded[op == 0xa2 ? JIT_REG_X : JIT_REG_Y] = true;
+        _jit_store(e, op == 0xa2 ? JIT_REG_X : JIT_REG_Y);
+        _jit_set_nz(e, h, wide);
+        _jit_retire(e, wide ? 3 : 2, wide ? 3 : 2);
+        return true;
+    case 0xc9: // CMP #
+    case 0xe0: // CPX #
+    case 0xc0: // CPY #
+        wide = (op == 0xc9) ? !m8 : !x8;
+        immd = wide ? _get_mem_word_bank_wrap(mem, immd_addr, false) : _get_mem_byte(mem, immd_addr, false);
+        h = _jit_load(e, (op == 0xc9) ? JIT_REG_A : ((op == 0xe0) ? JIT_REG_X : JIT_REG_Y));
+        _jit_cmp_imm(e, h, immd, wide);
+
+        // setae byte [rbx+C] (carry is not borrow)
+        _jit_byte(e, 0x0f);
+        _jit_byte(e, 0x93);
+        _jit_modrm_cpu(e, 0, offsetof(CPU_t, P.C));
+
+        // eax = h - immd for N and Z
+        _jit_mov(e, JIT_RAX, h, 16);
+        _jit_byte(e, 0x2d);
+        _jit_dword(e, immd);
+        _jit_set_nz(e, JIT_RAX, wide);
+        _jit_retire(e, wide ? 3 : 2, wide ? 3 : 2);
+        return true;
+
+    default:
+        return false;
+    }
+
+    _jit_retire(e, 1, 2);
+    return true;
+}
+
+/**
+ * Emit a call to an instruction's handler
+ *
+ * @param *e The code being emitted
+ * @param handler The handler to call
+ * @param operand The decoded operand bytes of the instruction
+ */
+static void _jit_emit_call(JIT_Emit_t *e, CPU_JIT_Handler_t handler, uint32_t operand)
+{
+    _jit_byte(e, 0x48); _jit_byte(e, 0x89); _jit_byte(e, 0xdf); // mov rdi, rbx
+    _jit_byte(e, 0x4c); _jit_byte(e, 0x89); _jit_byte(e, 0xe6); // mov rsi, r12
+    _jit_byte(e, 0xba); _jit_dword(e, operand);                 // mov edx, operand
+    _jit_byte(e, 0x48); _jit_byte(e, 0xb8);                     // mov rax, handler
+    _jit_qword(e, (uint64_t)(uintptr_t) handler);
+    _jit_byte(e, 0xff); _jit_byte(e, 0xd0);                     // call rax
+
+    // The handler can change any register
+    memset(e->loaded, 0, sizeof(e->loaded));
+}
+
+/**
+ * Emit the checks which are made after each instruction (except the last
+ * in the block). Mirrors the dispatcher's checks between instructions.
+ *
+ * @param *e The code being emitted
+ * @param pending True to check for interrupts/STP/CRASH as well as the cycle budget
+ * @param written True to check if the block has been written to
+ * @param pc The 24-bit address of the block
+ */
+static void _jit_emit_checks(JIT_Emit_t *e, bool pending, bool written, uint32_t pc)
+{
+    if (pending)
+    {
+        // NMI, STP or CRASH set ; jne exit
+        _jit_test_cpu_byte(e, offsetof(CPU_t, P.NMI));
+        _jit_exit_if(e, JIT_CC_NE);
+        _jit_test_cpu_byte(e, offsetof(CPU_t, P.STP));
+        _jit_exit_if(e, JIT_CC_NE);
+        _jit_test_cpu_byte(e, offsetof(CPU_t, P.CRASH));
+        _jit_exit_if(e, JIT_CC_NE);
+
+        // IRQ clear ; je +13 (over the I check) ; I clear ; je exit
+        _jit_test_cpu_byte(e, offsetof(CPU_t, P.IRQ));
+        _jit_byte(e, 0x74);
+        _jit_byte(e, 13);
+        _jit_test_cpu_byte(e, offsetof(CPU_t, P.I));
+        _jit_exit_if(e, JIT_CC_E);
+    }
+
+    // mov rax, [rbx+cycles] ; cmp rax, [rsp+8] ; jae exit
+    _jit_byte(e, 0x48);
+    _jit_byte(e, 0x8b);
+    _jit_modrm_cpu(e, JIT_RAX, offsetof(CPU_t, cycles));
+    _jit_byte(e, 0x48); _jit_byte(e, 0x3b); _jit_byte(e, 0x44); _jit_byte(e, 0x24); _jit_byte(e, 0x08);
+    _jit_exit_if(e, JIT_CC_AE);
+
+    if (written)
+    {
+#ifdef CPU_MEM_SPARSE
+        // The flag is on the block's page, which stays allocated as long as the memory does
+        // mov rax, block_x ; test byte [rax], 1 << (pc & 7) ; jz exit
+        _jit_byte(e, 0x48); _jit_byte(e, 0xb8);
+        _jit_qword(e, (uint64_t)(uintptr_t) e->block_x);
+        _jit_byte(e, 0xf6); _jit_byte(e, 0x00);
+#else
+        // test byte [r12+flag[X]+pc/8], 1 << (pc & 7) ; jz exit
+        _jit_byte(e, 0x41); _jit_byte(e, 0xf6); _jit_byte(e, 0x84); _jit_byte(e, 0x24);
+        _jit_dword(e, (uint32_t)(offsetof(memory_t, flag[MEM_PLANE_X]) + (pc >> 3)));
+#endif
+        _jit_byte(e, 1u << (pc & 7));
+        _jit_exit_if(e, JIT_CC_E);
+    }
+}
+
+
+/**
+ * Create a JIT (allocates the executable code arena). The arena is never
+ * writable and executable at once: it starts out read/execute only, and
+ * the pages a block is compiled into are only made writable while it is
+ * being emitted (see _cpu_jit_compile()).
+ *
+ * @param threshold Number of times a block is entered before it is compiled
+ * @return The JIT or NULL if it can not be used on this host
+ */
+CPU_JIT_t *_cpu_jit_create(uint16_t threshold)
+{
+    CPU_JIT_t *jit;
+    long page = sysconf(_SC_PAGESIZE);
+
+    if (page <= 0 || CPU_JIT_ARENA_BYTES % page != 0)
+    {
+        return NULL;
+    }
+
+    jit = malloc(sizeof(*jit));
+    if (!jit)
+    {
+        return NULL;
+    }
+
+    jit->code = mmap(NULL, CPU_JIT_ARENA_BYTES, PROT_READ | PROT_EXEC,
+                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (jit->code == MAP_FAILED)
+    {
+        free(jit);
+        return NULL;
+    }
+    jit->used = 0;
+    jit->page_bytes = (size_t)page;
+    jit->disabled = false;
+    jit->threshold = threshold;
+    return jit;
+}
+
+/**
+ * Free a JIT and its code arena
+ *
+ * @param *jit The JIT to free
+ */
+void _cpu_jit_destroy(CPU_JIT_t *jit)
+{
+    munmap(jit->code, CPU_JIT_ARENA_BYTES);
+    free(jit);
+}
+
+/**
+ * Stop using a JIT whose code arena could not be protected. Pages of the
+ * arena may be left without execute permission, so every compiled block
+ * is dropped and nothing is compiled from then on (the dispatcher
+ * interprets everything instead).
+ *
+ * @param *jit The JIT to disable
+ * @param *cache The cache which holds the JIT's compiled blocks
+ */
+static void _jit_disable(CPU_JIT_t *jit, CPU_Decode_Cache_t *cache)
+{
+    _cpu_jit_flush(jit, cache);
+    jit->disabled = true;
+}
+
+/**
+ * Compile a decoded block to native code
+ *
+ * @param *jit The JIT to compile with
+ * @param *cache The cache the block is in (flushed if the arena is full)
+ * @param *mem The memory the block was decoded from
+ * @param *b The block to compile
+ * @param m8 True if the block was decoded for an 8-bit accumulator
+ * @param x8 True if the block was decoded for 8-bit index registers
+ * @param *handlers The dispatcher's handlers for the block's register widths
+ * @return The compiled block or NULL if it could not be compiled
+ */
+CPU_JIT_Block_Fn _cpu_jit_compile(CPU_JIT_t *jit, CPU_Decode_Cache_t *cache, memory_t *mem,
+                                  const CPU_Decode_Block_t *b, bool m8, bool x8, CPU_JIT_Handler_t const *handlers)
+{
+    static const uint8_t prologue[] = {
+        0x53,                         // push rbx
+        0x55,                         // push rbp
+        0x41, 0x54,                   // push r12
+        0x41, 0x55,                   // push r13
+        0x41, 0x56,                   // push r14
+        0x41, 0x57,                   // push r15
+        0x48, 0x83, 0xec, 0x18,       // sub rsp, 24
+        0x48, 0x89, 0xfb,             // mov rbx, rdi (cpu)
+        0x49, 0x89, 0xf4,             // mov r12, rsi (mem)
+        0x48, 0x89, 0x14, 0x24,       // mov [rsp], rdx (budget)
+        0x48, 0x89, 0x4c, 0x24, 0x08, // mov [rsp+8], rcx (cycle_end)
+        0x31, 0xed,                   // xor ebp, ebp
+    };
+    static const uint8_t epilogue[] = {
+        0x48, 0x89, 0xe8,       // mov rax, rbp
+        0x48, 0x83, 0xc4, 0x18, // add rsp, 24
+        0x41, 0x5f,             // pop r15
+        0x41, 0x5e,             // pop r14
+        0x41, 0x5d,             // pop r13
+        0x41, 0x5c,             // pop r12
+        0x5d,                   // pop rbp
+        0x5b,                   // pop rbx
+        0xc3,                   // ret
+    };
+    JIT_Emit_t e;
+    CPU_JIT_Block_Fn fn;
+    uint8_t *start;
+    uint32_t block_pc = b->key & 0xffffff;
+    uint32_t pc = block_pc;
+    bool clean = false; // True once nothing can be pending except the cycle budget
+
+    if (jit->disabled)
+    {
+        return NULL;
+    }
+    if (jit->used + CPU_JIT_BLOCK_MAX_BYTES > CPU_JIT_ARENA_BYTES)
+    {
+        _cpu_jit_flush(jit, cache);
+    }
+
+    start = jit->code + jit->used;
+
+    // Only the pages which the block can be emitted into are writable,
+    // and only until it has been emitted. Blocks which share these pages
+    // can not be running while the dispatcher is compiling.
+    size_t prot_start = jit->used & ~(jit->page_bytes - 1);
+    size_t prot_end = jit->used + CPU_JIT_BLOCK_MAX_BYTES;
+    prot_end = (prot_end + jit->page_bytes - 1) & ~(jit->page_bytes - 1);
+    prot_end = (prot_end < CPU_JIT_ARENA_BYTES) ? prot_end : CPU_JIT_ARENA_BYTES;
+    if (mprotect(jit->code + prot_start, prot_end - prot_start, PROT_READ | PROT_WRITE))
+    {
+        _jit_disable(jit, cache);
+        return NULL;
+    }
+
+    memset(&e, 0, sizeof(e));
+    e.p = start;
+#ifdef CPU_MEM_SPARSE
+    // The block's X flag is set, so its page has been allocated
+    e.block_x = _mem_flag_rptr(mem, MEM_PLANE_X, block_pc);
+#endif
+    memcpy(e.p, prologue, sizeof(prologue));
+    e.p += sizeof(prologue);
+
+    for (int i = 0; i < b->count; ++i)
+    {
+        const CPU_Decode_Entry_t *ent = &b->insn[i];
+        bool called = !_jit_emit_insn(&e, mem, ent->opcode, pc, m8, x8);
+        if (called)
+        {
+            _jit_emit_call(&e, handlers[ent->opcode], ent->operand);
+        }
+
+        // inc rbp ; cmp rbp, [rsp] ; je exit
+        _jit_byte(&e, 0x48); _jit_byte(&e, 0xff); _jit_byte(&e, 0xc5);
+        _jit_byte(&e, 0x48); _jit_byte(&e, 0x3b); _jit_byte(&e, 0x2c); _jit_byte(&e, 0x24);
+        _jit_exit_if(&e, JIT_CC_E);
+
+        if (i + 1 < b->count)
+        {
+            _jit_emit_checks(&e, called || !clean, called, block_pc);
+            clean = true;
+        }
+        pc = _addr_add_val_bank_wrap(pc, ent->size);
+    }
+
+    // Every exit lands on the epilogue
+    for (int i = 0; i < e.exit_count; ++i)
+    {
+        uint32_t rel = (uint32_t)(e.p - (e.exits[i] + 4));
+        memcpy(e.exits[i], &rel, sizeof(rel));
+    }
+    memcpy(e.p, epilogue, sizeof(epilogue));
+    e.p += sizeof(epilogue);
+
+    if (mprotect(jit->code + prot_start, prot_end - prot_start, PROT_READ | PROT_EXEC))
+    {
+        _jit_disable(jit, cache);
+        return NULL;
+    }
+    jit->used += (size_t)(e.p - start);
+
+    // Function pointers can't be cast from object pointers in ISO C
+    memcpy(&fn, &start, sizeof(fn));
+    return fn;
+}
+
+#else
+
+/**
+ * Create a JIT (not available in this build)
+ *
+ * @param threshold Unused
+ * @return NULL
+ */
+CPU_JIT_t *_cpu_jit_create(uint16_t threshold)
+{
+    (void) threshold;
+    return NULL;
+}
+
+/**
+ * Free a JIT (never created in this build)
+ *
+ * @param *jit Unused
+ */
+void _cpu_jit_destroy(CPU_JIT_t *jit)
+{
+    (void) jit;
+}
+
+/**
+ * Compile a decoded block (not available in this build)
+ *
+ * @return NULL
+ */
+CPU_JIT_Block_Fn _cpu_jit_compile(CPU_JIT_t *jit, CPU_Decode_Cache_t *cache, memory_t *mem,
+                                  const CPU_Decode_Block_t *b, bool m8, bool x8, CPU_JIT_Handler_t const *handlers)
+{
+    (void) jit;
+    (void) cache;
+    (void) mem;
+    (void) b;
+    (void) m8;
+    (void) x8;
+    (void) handlers;
+    return NULL;
+}
+
+#endif
+
+
+/**
+ * Throw away all compiled code. Compiled blocks in the cache are
+ * dropped (they will be compiled again once they are hot).
+ *
+ * @param *jit The JIT to flush
+ * @param *cache The cache which holds the JIT's compiled blocks (may be NULL)
+ */
+void _cpu_jit_flush(CPU_JIT_t *jit, CPU_Decode_Cache_t *cache)
+{
+    if (cache)
+    {
+        for (int i = 0; i < CPU_DECODE_CACHE_BLOCKS; ++i)
+        {
+            cache->blocks[i].native = NULL;
+            cache->blocks[i].hits = 0;
+        }
+    }
+    if (jit)
+    {
+        jit->used = 0;
+    }
+}
@@ -0,0 +1,38 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+#ifndef JIT_65816_H
+#define JIT_65816_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "65816.h"
+
+// Size of the executable code arena (flushed when full)
+#define CPU_JIT_ARENA_BYTES 0x400000
+
+// Most code a single compiled block can take up
+#define CPU_JIT_BLOCK_MAX_BYTES 0x1000
+
+// Native code compiler state (attached to a CPU with enableJITCPU())
+struct CPU_JIT_t {
+    uint8_t *code;      // Executable code arena
+    size_t used;        // Bytes of the arena in use
+    size_t page_bytes;  // Host page size (the arena is made writable a page at a time)
+    bool disabled;      // Set if the arena could not be protected (nothing is compiled)
+    uint16_t threshold; // Times a block is entered before it is compiled
+};
+
+// Handler for a decoded instruction (see the dispatcher's op_table)
+typedef void (*CPU_JIT_Handler_t)(CPU_t *, memory_t *, uint32_t);
+
+CPU_JIT_t *_cpu_jit_create(uint16_t);
+void _cpu_jit_destroy(CPU_JIT_t *);
+void _cpu_jit_flush(CPU_JIT_t *, CPU_Decode_Cache_t *);
+CPU_JIT_Block_Fn _cpu_jit_compile(CPU_JIT_t *, CPU_Decode_Cache_t *, memory_t *, const CPU_Decode_Block_t *, bool, bool, CPU_JIT_Handler_t const *);
+
+#endif
@@ -0,0 +1,256 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ *
+ * Lockstep checking of an execution engine against the switch decoder
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <inttypes.h>
+
+#include "65816.h"
+#include "65816-util.h"
+#include "65816-dispatch.h"
+#include "65816-lockstep.h"
+
+
+/**
+ * Set up a CPU to be run in lockstep with a reference CPU (see
+ * CPU_Lockstep_t). Nothing is copied to the reference here: use
+ * syncLockstepCPU(), or set both CPUs and memories up the same way.
+ *
+ * @param *ls The lockstep state to set up
+ * @param *cpu The CPU to check
+ * @param *mem The CPU's memory
+ * @param *ref The reference CPU
+ * @param *ref_mem The reference's memory
+ * @param interval Instructions between comparisons (0 is taken as 1)
+ * @return CPU_ERR_OK
+ */
+CPU_Error_Code_t initLockstepCPU(CPU_Lockstep_t *ls, CPU_t *cpu, memory_t *mem, CPU_t *ref, memory_t *ref_mem, uint64_t interval)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (cpu == NULL || ref == NULL)
+    {
+        return CPU_ERR_NULL_CPU;
+    }
+#endif
+
+    memset(ls, 0, sizeof(*ls));
+    ls->cpu = cpu;
+    ls->mem = mem;
+    ls->ref = ref;
+    ls->ref_mem = ref_mem;
+    ls->interval = interval ? interval : 1;
+    ls->check_mem = true;
+    ls->addr = CPU_LOCKSTEP_NO_ADDR;
+
+    return CPU_ERR_OK;
+}
+
+
+/**
+ * Make the reference a copy of the CPU and its memory (see _copy_mem()).
+ * The reference keeps its own predecoded instruction cache and JIT
+ * (which stepRefCPU() does not use), and none of the CPU's events.
+ *
+ * @param *ls The lockstep state
+ * @return True if the reference was copied, false if its memory
+ *         could not be allocated
+ */
+bool syncLockstepCPU(CPU_Lockstep_t *ls)
+{
+    CPU_t *ref = ls->ref;
+    CPU_Decode_Cache_t *dcache = ref->dcache;
+    CPU_JIT_t *jit = ref->jit;
+
+    *ref = *ls->cpu;
+    ref->setacc = false;
+    ref->dcache = dcache;
+    ref->jit = jit;
+    ref->idle.pc = CPU_IDLE_NONE;
+    ref->events.count = 0;
+
+    if (!_copy_mem(ls->ref_mem, ls->mem))
+    {
+        return false;
+    }
+    // Both start out the same, so only what is written from here on
+    // has to be compared (see _cmp_mem_dirty())
+    _clear_mem_dirty(ls->mem);
+    _clear_mem_dirty(ls->ref_mem);
+    return true;
+}
+
+
+/**
+ * Step the reference CPU through up to count instructions, stopping
+ * where runCPU() would for the same stop conditions
+ *
+ * @param *ls The lockstep state
+ * @param count The maximum number of instructions to run
+ * @param stop_mask CPU_RUN_BREAK and/or CPU_RUN_WAI
+ * @return The number of instructions which were run
+ */
+static uint64_t _lockstep_run_ref(CPU_Lockstep_t *ls, uint64_t count, uint32_t stop_mask)
+{
+    CPU_t *ref = ls->ref;
+    memory_t *mem = ls->ref_mem;
+    uint64_t n = 0;
+
+    while (n < count && !ref->P.CRASH && !ref->P.STP)
+    {
+        stepRefCPU(ref, mem);
+        ++n;
+
+        uint32_t pc = _cpu_get_effective_pc(ref);
+        if ((stop_mask & CPU_RUN_BREAK) && _mem_get_flag(mem, MEM_PLANE_B, pc))
+        {
+            break;
+        }
+        // runCPU() runs the WAI once before it stops, which does not
+        // change anything while no interrupt is pending
+        if ((stop_mask & CPU_RUN_WAI) && !ref->P.NMI && !ref->P.IRQ &&
+            _peek_mem_byte(mem, pc) == CPU_OP_WAI)
+        {
+            break;
+        }
+    }
+    return n;
+}
+
+
+/**
+ * Compare the CPU with its reference. Only the pages of memory which
+ * were written to since the last comparison are compared, unless they
+ * differ, in which case all of memory is searched for the lowest
+ * address which differs.
+ *
+ * @param *ls The lockstep state (addr is set to the lowest address
+ *            which differs, if the memories are compared)
+ * @return True if they match
+ */
+static bool _lockstep_match(CPU_Lockstep_t *ls)
+{
+    char ref_state[CPU_LOCKSTEP_STATE_LEN];
+    char cpu_state[CPU_LOCKSTEP_STATE_LEN];
+
+    tostrCPU(ls->ref, ref_state);
+    tostrCPU(ls->cpu, cpu_state);
+    ls->addr = CPU_LOCKSTEP_NO_ADDR;
+    if (ls->check_mem && _cmp_mem_dirty(ls->ref_mem, ls->mem) != CPU_LOCKSTEP_NO_ADDR)
+    {
+        ls->addr = _cmp_mem(ls->ref_mem, ls->mem);
+    }
+
+    return strcmp(ref_state, cpu_state) == 0 && ls->addr == CPU_LOCKSTEP_NO_ADDR;
+}
+
+
+/**
+ * Run a CPU and its reference in lockstep until the budget is used up,
+ * a stop condition is reached (as for runCPU()) or they diverge. They
+ * are compared every interval instructions and once they stop.
+ *
+ * @note A cycle budget is only checked between comparisons, so it can be
+ *       overrun by up to interval instructions. CPU_RUN_INT is not
+ *       supported.
+ * @param *ls The lockstep state (see initLockstepCPU())
+ * @param budget The maximum number of instructions (or cycles if
+ *               CPU_RUN_BUDGET_CYCLES is set in stop_mask) to run for
+ * @param stop_mask CPU_RUN_BREAK and/or CPU_RUN_WAI to stop on
+ *                  (plus CPU_RUN_BUDGET_CYCLES)
+ * @return The reason for stopping, or CPU_RUN_DIVERGED if the CPU no
+ *         longer matches its reference (see dumpLockstepCPU())
+ */
+CPU_Run_Status_t runLockstepCPU(CPU_Lockstep_t *ls, uint64_t budget, uint32_t stop_mask)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (ls->cpu == NULL || ls->ref == NULL)
+    {
+        return CPU_RUN_NULL_CPU;
+    }
+#endif
+
+    CPU_t *cpu = ls->cpu;
+    uint64_t count = budget;
+    uint64_t cycle_end = UINT64_MAX;
+    CPU_Run_Status_t stat = CPU_RUN_BUDGET;
+
+    if (stop_mask & CPU_RUN_BUDGET_CYCLES)
+    {
+        if (budget < UINT64_MAX - cpu->cycles)
+        {
+            cycle_end = cpu->cycles + budget;
+        }
+        count = UINT64_MAX;
+        stop_mask |= CPU_RUN_WAI;
+    }
+    stop_mask &= CPU_RUN_BREAK | CPU_RUN_WAI;
+
+    // runCPU() runs a pending reset sequence without counting it
+    if (ls->ref->P.RST && !ls->ref->P.CRASH)
+    {
+        stepRefCPU(ls->ref, ls->ref_mem);
+    }
+
+    while (stat == CPU_RUN_BUDGET && count > 0 && cpu->cycles < cycle_end)
+    {
+        uint64_t n = (count < ls->interval) ? count : ls->interval;
+
+        ls->before = *ls->ref;
+        ls->before_insns = ls->insns;
+
+        stat = runCPU(cpu, ls->mem, n, stop_mask);
+        ls->insns += _lockstep_run_ref(ls, n, stop_mask);
+        count -= n;
+
+        if (!_lockstep_match(ls))
+        {
+            return CPU_RUN_DIVERGED;
+        }
+    }
+
+    return stat;
+}
+
+
+/**
+ * Print what runLockstepCPU() found when the CPU diverged from its
+ * reference: the reference's state at the last comparison which matched
+ * and the bytes at its PC, followed by the state of both CPUs (each in
+ * the tostrCPU() format) and the lowest address in memory which differs.
+ * Loading the first state with the same memory and running the
+ * instructions between the two counts given reproduces the divergence.
+ *
+ * @param *ls The lockstep state
+ * @param *fp The file to print to
+ */
+void dumpLockstepCPU(CPU_Lockstep_t *ls, FILE *fp)
+{
+    char cpu_state[CPU_LOCKSTEP_STATE_LEN];
+    uint32_t pc = _cpu_get_effective_pc(&ls->before);
+
+    fprintf(fp, "Diverged between instructions %" PRIu64 " and %" PRIu64 "\n",
+            ls->before_insns, ls->insns);
+    tostrCPU(&ls->before, cpu_state);
+    fprintf(fp, "BEFORE    CPU: '%s'\n", cpu_state);
+    fprintf(fp, "CODE     %02x:%04x:", pc >> 16, pc & 0xffff);
+    for (uint32_t i = 0; i < CPU_LOCKSTEP_CODE_BYTES; ++i)
+    {
+        fprintf(fp, " %02x", _peek_mem_byte(ls->ref_mem, _addr_add_val_bank_wrap(pc, i)));
+    }
+    fprintf(fp, "\n");
+    tostrCPU(ls->ref, cpu_state);
+    fprintf(fp, "REFERENCE CPU: '%s'\n", cpu_state);
+    tostrCPU(ls->cpu, cpu_state);
+    fprintf(fp, "ENGINE    CPU: '%s'\n", cpu_state);
+    if (ls->addr != CPU_LOCKSTEP_NO_ADDR)
+    {
+        fprintf(fp, "MEMORY   %06x: reference %02x engine %02x\n", ls->addr,
+                _peek_mem_byte(ls->ref_mem, ls->addr), _peek_mem_byte(ls->mem, ls->addr));
+    }
+}
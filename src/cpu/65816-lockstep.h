@@ -0,0 +1,58 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+#ifndef LOCKSTEP_65816_H
+#define LOCKSTEP_65816_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "65816.h"
+
+// Room for the output of tostrCPU()
+#define CPU_LOCKSTEP_STATE_LEN 256
+
+// Bytes of the instruction printed with a divergence (see dumpLockstepCPU())
+#define CPU_LOCKSTEP_CODE_BYTES 4
+
+// No address differs between the two memories
+#define CPU_LOCKSTEP_NO_ADDR 0xffffffffu
+
+// A CPU which is checked against a reference copy of itself as it runs.
+// The CPU runs with runCPU() on whichever execution engine the core was
+// built with (including the predecoded blocks, the JIT and everything
+// runCPU() does in bulk), while the reference is stepped one instruction
+// at a time with the switch decoder (stepRefCPU()). Every `interval`
+// instructions, the registers and flags (everything tostrCPU() prints)
+// and, if check_mem is set, the values in memory are compared. Only the
+// pages which either CPU wrote to since the last comparison are compared
+// (see _cmp_mem_dirty()), so the memories have to match to start with
+// (syncLockstepCPU() makes sure of that).
+//
+// The reference has its own memory. Devices can not be run in lockstep
+// (they would see every access twice), so neither memory should have any
+// mapped and the reference does not run the CPU's events.
+typedef struct CPU_Lockstep_t {
+    CPU_t *cpu;        // The CPU which is checked, and its memory
+    memory_t *mem;
+    CPU_t *ref;        // The reference, and its memory
+    memory_t *ref_mem;
+    uint64_t interval; // Instructions between comparisons (at least 1)
+    bool check_mem;    // Compare the memories as well as the CPUs
+    uint64_t insns;    // Instructions the reference has run so far
+
+    // Set once the CPUs have diverged (see dumpLockstepCPU())
+    CPU_t before;          // The reference at the last comparison which matched
+    uint64_t before_insns; // insns at that comparison
+    uint32_t addr;         // Lowest address which differs (or CPU_LOCKSTEP_NO_ADDR)
+} CPU_Lockstep_t;
+
+CPU_Error_Code_t initLockstepCPU(CPU_Lockstep_t *, CPU_t *, memory_t *, CPU_t *, memory_t *, uint64_t);
+bool syncLockstepCPU(CPU_Lockstep_t *);
+CPU_Run_Status_t runLockstepCPU(CPU_Lockstep_t *, uint64_t, uint32_t);
+void dumpLockstepCPU(CPU_Lockstep_t *, FILE *);
+
+#endif
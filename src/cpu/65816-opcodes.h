@@ -0,0 +1,337 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+#ifndef OPCODES_65816_H
+#define OPCODES_65816_H
+
+// Opcode description table
+// This is the only place where the opcodes are described: the switch in
+// stepCPU(), the table-driven dispatcher (65816-dispatch.c) and the
+// debugger's disassembler are all expanded from it. Each row is
+//   OP(opcode, handler, kind, size, cycles, addr mode, _addrCPU_get* resolver,
+//      mnemonic, reg, access)
+// where kind selects the i_* handler's signature:
+//   ALU - i_xxx(cpu, mem, size, cycles, mode, addr)
+//   JMP - i_jmp(cpu, cycles, mode, addr)
+//   JSR - i_jsr/i_jsl(cpu, mem, cycles, addr)
+//   REL - i_xxx(cpu, mem) for a branch with an 8-bit offset
+//   MEM - i_xxx(cpu, mem)
+//   IMP - i_xxx(cpu)
+// size is the instruction length in bytes (with an 8-bit immediate operand)
+// cycles is the base cycle count (8-bit registers, DL = 0, no page crossed)
+// size and cycles are only passed on to ALU/JMP/JSR handlers
+// (the others account for their own size and cycles)
+// addr mode is how the operand is written (a CPU_ADDR_* value which is
+// also passed on to ALU/JMP handlers)
+// mnemonic is the instruction's name (an I_* value in the disassembler)
+// reg is the register whose width sets the width of an immediate
+// operand: A (M flag), X (X flag) or _ (always 8 bits). For ALU rows
+// it is also the register whose width sets the width of the memory access
+// access is how an ALU row touches memory: R (read), W (write),
+// RW (read-modify-write) or _ (no memory operand). Together with the
+// addressing mode and reg it picks the cycle penalties which are added to
+// the base cycle count (see CPU_OP_PENALTIES())
+#define CPU_OPCODE_TABLE(OP) \
+    OP(0x00, brk, MEM, 2, 0, DP,      None,                           BRK, _, _) \
+    OP(0x01, ora, ALU, 2, 6, DPINDX,  DirectPageIndexedIndirectX,     ORA, A, R) \
+    OP(0x02, cop, MEM, 2, 0, DP,      None,                           COP, _, _) \
+    OP(0x03, ora, ALU, 2, 4, SR,      StackRelative,                  ORA, A, R) \
+    OP(0x04, tsb, ALU, 2, 5, DP,      DirectPage,                     TSB, A, RW) \
+    OP(0x05, ora, ALU, 2, 3, DP,      DirectPage,                     ORA, A, R) \
+    OP(0x06, asl, ALU, 2, 5, DP,      DirectPage,                     ASL, A, RW) \
+    OP(0x07, ora, ALU, 2, 6, DPINDL,  DirectPageIndirectLong,         ORA, A, R) \
+    OP(0x08, php, MEM, 1, 0, IMPD,    None,                           PHP, _, _) \
+    OP(0x09, ora, ALU, 2, 2, IMMD,    Immediate,                      ORA, A, R) \
+    OP(0x0a, asl, ALU, 1, 2, IMPD,    None,                           ASL, A, _) \
+    OP(0x0b, phd, MEM, 1, 0, IMPD,    None,                           PHD, _, _) \
+    OP(0x0c, tsb, ALU, 3, 6, ABS,     Absolute,                       TSB, A, RW) \
+    OP(0x0d, ora, ALU, 3, 4, ABS,     Absolute,                       ORA, A, R) \
+    OP(0x0e, asl, ALU, 3, 6, ABS,     Absolute,                       ASL, A, RW) \
+    OP(0x0f, ora, ALU, 4, 5, ABSL,    Long,                           ORA, A, R) \
+    OP(0x10, bpl, REL, 2, 0, PCR,     None,                           BPL, _, _) \
+    OP(0x11, ora, ALU, 2, 5, INDDPY,  DirectPageIndirectIndexedY,     ORA, A, R) \
+    OP(0x12, ora, ALU, 2, 5, DPIND,   DirectPageIndirect,             ORA, A, R) \
+    OP(0x13, ora, ALU, 2, 7, SRINDY,  StackRelativeIndirectIndexedY,  ORA, A, R) \
+    OP(0x14, trb, ALU, 2, 5, DP,      DirectPage,                     TRB, A, RW) \
+    OP(0x15, ora, ALU, 2, 4, DPX,     DirectPageIndexedX,             ORA, A, R) \
+    OP(0x16, asl, ALU, 2, 6, DPX,     DirectPageIndexedX,             ASL, A, RW) \
+    OP(0x17, ora, ALU, 2, 6, INDDPLY, DirectPageIndirectLongIndexedY, ORA, A, R) \
+    OP(0x18, clc, IMP, 1, 0, IMPD,    None,                           CLC, _, _) \
+    OP(0x19, ora, ALU, 3, 4, ABSY,    AbsoluteIndexedY,               ORA, A, R) \
+    OP(0x1a, ina, IMP, 1, 0, IMPD,    None,                           INC, A, _) \
+    OP(0x1b, tcs, IMP, 1, 0, IMPD,    None,                           TCS, A, _) \
+    OP(0x1c, trb, ALU, 3, 6, ABS,     Absolute,                       TRB, A, RW) \
+    OP(0x1d, ora, ALU, 3, 4, ABSX,    AbsoluteIndexedX,               ORA, A, R) \
+    OP(0x1e, asl, ALU, 3, 7, ABSX,    AbsoluteIndexedX,               ASL, A, RW) \
+    OP(0x1f, ora, ALU, 4, 5, ABSLX,   LongIndexedX,                   ORA, A, R) \
+    OP(0x20, jsr, JSR, 3, 6, ABS,     Absolute,                       JSR, _, _) \
+    OP(0x21, and, ALU, 2, 6, DPINDX,  DirectPageIndexedIndirectX,     AND, A, R) \
+    OP(0x22, jsl, JSR, 4, 8, ABSL,    Long,                           JSL, _, _) \
+    OP(0x23, and, ALU, 2, 4, SR,      StackRelative,                  AND, A, R) \
+    OP(0x24, bit, ALU, 2, 3, DP,      DirectPage,                     BIT, A, R) \
+    OP(0x25, and, ALU, 2, 3, DP,      DirectPage,                     AND, A, R) \
+    OP(0x26, rol, ALU, 2, 5, DP,      DirectPage,                     ROL, A, RW) \
+    OP(0x27, and, ALU, 2, 6, DPINDL,  DirectPageIndirectLong,         AND, A, R) \
+    OP(0x28, plp, MEM, 1, 0, IMPD,    None,                           PLP, _, _) \
+    OP(0x29, and, ALU, 2, 2, IMMD,    Immediate,                      AND, A, R) \
+    OP(0x2a, rol, ALU, 1, 2, IMPD,    None,                           ROL, A, _) \
+    OP(0x2b, pld, MEM, 1, 0, IMPD,    None,                           PLD, _, _) \
+    OP(0x2c, bit, ALU, 3, 4, ABS,     Absolute,                       BIT, A, R) \
+    OP(0x2d, and, ALU, 3, 4, ABS,     Absolute,                       AND, A, R) \
+    OP(0x2e, rol, ALU, 3, 6, ABS,     Absolute,                       ROL, A, RW) \
+    OP(0x2f, and, ALU, 4, 5, ABSL,    Long,                           AND, A, R) \
+    OP(0x30, bmi, REL, 2, 0, PCR,     None,                           BMI, _, _) \
+    OP(0x31, and, ALU, 2, 5, INDDPY,  DirectPageIndirectIndexedY,     AND, A, R) \
+    OP(0x32, and, ALU, 2, 5, DPIND,   DirectPageIndirect,             AND, A, R) \
+    OP(0x33, and, ALU, 2, 7, SRINDY,  StackRelativeIndirectIndexedY,  AND, A, R) \
+    OP(0x34, bit, ALU, 2, 4, DPX,     DirectPageIndexedX,             BIT, A, R) \
+    OP(0x35, and, ALU, 2, 4, DPX,     DirectPageIndexedX,             AND, A, R) \
+    OP(0x36, rol, ALU, 2, 6, DPX,     DirectPageIndexedX,             ROL, A, RW) \
+    OP(0x37, and, ALU, 2, 6, INDDPLY, DirectPageIndirectLongIndexedY, AND, A, R) \
+    OP(0x38, sec, IMP, 1, 0, IMPD,    None,                           SEC, _, _) \
+    OP(0x39, and, ALU, 3, 4, ABSY,    AbsoluteIndexedY,               AND, A, R) \
+    OP(0x3a, dea, IMP, 1, 0, IMPD,    None,                           DEC, A, _) \
+    OP(0x3b, tsc, IMP, 1, 0, IMPD,    None,                           TSC, A, _) \
+    OP(0x3c, bit, ALU, 3, 4, ABSX,    AbsoluteIndexedX,               BIT, A, R) \
+    OP(0x3d, and, ALU, 3, 4, ABSX,    AbsoluteIndexedX,               AND, A, R) \
+    OP(0x3e, rol, ALU, 3, 7, ABSX,    AbsoluteIndexedX,               ROL, A, RW) \
+    OP(0x3f, and, ALU, 4, 5, ABSLX,   LongIndexedX,                   AND, A, R) \
+    OP(0x40, rti, MEM, 1, 0, IMPD,    None,                           RTI, _, _) \
+    OP(0x41, eor, ALU, 2, 6, DPINDX,  DirectPageIndexedIndirectX,     EOR, A, R) \
+    OP(0x42, wdm, IMP, 2, 0, IMMD,    None,                           WDM, _, _) \
+    OP(0x43, eor, ALU, 2, 4, SR,      StackRelative,                  EOR, A, R) \
+    OP(0x44, mvp, MEM, 3, 0, BMV,     None,                           MVP, _, _) \
+    OP(0x45, eor, ALU, 2, 3, DP,      DirectPage,                     EOR, A, R) \
+    OP(0x46, lsr, ALU, 2, 5, DP,      DirectPage,                     LSR, A, RW) \
+    OP(0x47, eor, ALU, 2, 6, DPINDL,  DirectPageIndirectLong,         EOR, A, R) \
+    OP(0x48, pha, MEM, 1, 0, IMPD,    None,                           PHA, A, _) \
+    OP(0x49, eor, ALU, 2, 2, IMMD,    Immediate,                      EOR, A, R) \
+    OP(0x4a, lsr, ALU, 1, 2, IMPD,    None,                           LSR, A, _) \
+    OP(0x4b, phk, MEM, 1, 0, IMPD,    None,                           PHK, _, _) \
+    OP(0x4c, jmp, JMP, 3, 3, ABS,     Absolute,                       JMP, _, _) \
+    OP(0x4d, eor, ALU, 3, 4, ABS,     Absolute,                       EOR, A, R) \
+    OP(0x4e, lsr, ALU, 3, 6, ABS,     Absolute,                       LSR, A, RW) \
+    OP(0x4f, eor, ALU, 4, 5, ABSL,    Long,                           EOR, A, R) \
+    OP(0x50, bvc, REL, 2, 0, PCR,     None,                           BVC, _, _) \
+    OP(0x51, eor, ALU, 2, 5, INDDPY,  DirectPageIndirectIndexedY,     EOR, A, R) \
+    OP(0x52, eor, ALU, 2, 5, DPIND,   DirectPageIndirect,             EOR, A, R) \
+    OP(0x53, eor, ALU, 2, 7, SRINDY,  StackRelativeIndirectIndexedY,  EOR, A, R) \
+    OP(0x54, mvn, MEM, 3, 0, BMV,     None,                           MVN, _, _) \
+    OP(0x55, eor, ALU, 2, 4, DPX,     DirectPageIndexedX,             EOR, A, R) \
+    OP(0x56, lsr, ALU, 2, 6, DPX,     DirectPageIndexedX,             LSR, A, RW) \
+    OP(0x57, eor, ALU, 2, 6, INDDPLY, DirectPageIndirectLongIndexedY, EOR, A, R) \
+    OP(0x58, cli, IMP, 1, 0, IMPD,    None,                           CLI, _, _) \
+    OP(0x59, eor, ALU, 3, 4, ABSY,    AbsoluteIndexedY,               EOR, A, R) \
+    OP(0x5a, phy, MEM, 1, 0, IMPD,    None,                           PHY, X, _) \
+    OP(0x5b, tcd, IMP, 1, 0, IMPD,    None,                           TCD, A, _) \
+    OP(0x5c, jmp, JMP, 4, 4, ABSL,    Long,                           JMP, _, _) \
+    OP(0x5d, eor, ALU, 3, 4, ABSX,    AbsoluteIndexedX,               EOR, A, R) \
+    OP(0x5e, lsr, ALU, 3, 7, ABSX,    AbsoluteIndexedX,               LSR, A, RW) \
+    OP(0x5f, eor, ALU, 4, 5, ABSLX,   LongIndexedX,                   EOR, A, R) \
+    OP(0x60, rts, MEM, 1, 0, IMPD,    None,                           RTS, _, _) \
+    OP(0x61, adc, ALU, 2, 6, DPINDX,  DirectPageIndexedIndirectX,     ADC, A, R) \
+    OP(0x62, per, MEM, 3, 0, ABS,     None,                           PER, _, _) \
+    OP(0x63, adc, ALU, 2, 4, SR,      StackRelative,                  ADC, A, R) \
+    OP(0x64, stz, ALU, 2, 3, DP,      DirectPage,                     STZ, A, W) \
+    OP(0x65, adc, ALU, 2, 3, DP,      DirectPage,                     ADC, A, R) \
+    OP(0x66, ror, ALU, 2, 5, DP,      DirectPage,                     ROR, A, RW) \
+    OP(0x67, adc, ALU, 2, 6, DPINDL,  DirectPageIndirectLong,         ADC, A, R) \
+    OP(0x68, pla, MEM, 1, 0, IMPD,    None,                           PLA, A, _) \
+    OP(0x69, adc, ALU, 2, 2, IMMD,    Immediate,                      ADC, A, R) \
+    OP(0x6a, ror, ALU, 1, 2, IMPD,    None,                           ROR, A, _) \
+    OP(0x6b, rtl, MEM, 1, 0, IMPD,    None,                           RTL, _, _) \
+    OP(0x6c, jmp, JMP, 3, 5, INDABS,  AbsoluteIndirect,               JMP, _, _) \
+    OP(0x6d, adc, ALU, 3, 4, ABS,     Absolute,                       ADC, A, R) \
+    OP(0x6e, ror, ALU, 3, 6, ABS,     Absolute,                       ROR, A, RW) \
+    OP(0x6f, adc, ALU, 4, 5, ABSL,    Long,                           ADC, A, R) \
+    OP(0x70, bvs, REL, 2, 0, PCR,     None,                           BVS, _, _) \
+    OP(0x71, adc, ALU, 2, 5, INDDPY,  DirectPageIndirectIndexedY,     ADC, A, R) \
+    OP(0x72, adc, ALU, 2, 5, DPIND,   DirectPageIndirect,             ADC, A, R) \
+    OP(0x73, adc, ALU, 2, 7, SRINDY,  StackRelativeIndirectIndexedY,  ADC, A, R) \
+    OP(0x74, stz, ALU, 2, 4, DPX,     DirectPageIndexedX,             STZ, A, W) \
+    OP(0x75, adc, ALU, 2, 4, DPX,     DirectPageIndexedX,             ADC, A, R) \
+    OP(0x76, ror, ALU, 2, 6, DPX,     DirectPageIndexedX,             ROR, A, RW) \
+    OP(0x77, adc, ALU, 2, 6, INDDPLY, DirectPageIndirectLongIndexedY, ADC, A, R) \
+    OP(0x78, sei, IMP, 1, 0, IMPD,    None,                           SEI, _, _) \
+    OP(0x79, adc, ALU, 3, 4, ABSY,    AbsoluteIndexedY,               ADC, A, R) \
+    OP(0x7a, ply, MEM, 1, 0, IMPD,    None,                           PLY, X, _) \
+    OP(0x7b, tdc, IMP, 1, 0, IMPD,    None,                           TDC, A, _) \
+    OP(0x7c, jmp, JMP, 3, 6, ABSINDX, AbsoluteIndexedIndirectX,       JMP, _, _) \
+    OP(0x7d, adc, ALU, 3, 4, ABSX,    AbsoluteIndexedX,               ADC, A, R) \
+    OP(0x7e, ror, ALU, 3, 7, ABSX,    AbsoluteIndexedX,               ROR, A, RW) \
+    OP(0x7f, adc, ALU, 4, 5, ABSLX,   LongIndexedX,                   ADC, A, R) \
+    OP(0x80, bra, REL, 2, 0, PCR,     None,                           BRA, _, _) \
+    OP(0x81, sta, ALU, 2, 6, DPINDX,  DirectPageIndexedIndirectX,     STA, A, W) \
+    OP(0x82, brl, MEM, 3, 0, PCRL,    None,                           BRL, _, _) \
+    OP(0x83, sta, ALU, 2, 4, SR,      StackRelative,                  STA, A, W) \
+    OP(0x84, sty, ALU, 2, 3, DP,      DirectPage,                     STY, X, W) \
+    OP(0x85, sta, ALU, 2, 3, DP,      DirectPage,                     STA, A, W) \
+    OP(0x86, stx, ALU, 2, 3, DP,      DirectPage,                     STX, X, W) \
+    OP(0x87, sta, ALU, 2, 6, DPINDL,  DirectPageIndirectLong,         STA, A, W) \
+    OP(0x88, dey, IMP, 1, 0, IMPD,    None,                           DEY, X, _) \
+    OP(0x89, bit, ALU, 2, 2, IMMD,    Immediate,                      BIT, A, R) \
+    OP(0x8a, txa, IMP, 1, 0, IMPD,    None,                           TXA, A, _) \
+    OP(0x8b, phb, MEM, 1, 0, IMPD,    None,                           PHB, _, _) \
+    OP(0x8c, sty, ALU, 3, 4, ABS,     Absolute,                       STY, X, W) \
+    OP(0x8d, sta, ALU, 3, 4, ABS,     Absolute,                       STA, A, W) \
+    OP(0x8e, stx, ALU, 3, 4, ABS,     Absolute,                       STX, X, W) \
+    OP(0x8f, sta, ALU, 4, 5, ABSL,    Long,                           STA, A, W) \
+    OP(0x90, bcc, REL, 2, 0, PCR,     None,                           BCC, _, _) \
+    OP(0x91, sta, ALU, 2, 6, INDDPY,  DirectPageIndirectIndexedY,     STA, A, W) \
+    OP(0x92, sta, ALU, 2, 5, DPIND,   DirectPageIndirect,             STA, A, W) \
+    OP(0x93, sta, ALU, 2, 7, SRINDY,  StackRelativeIndirectIndexedY,  STA, A, W) \
+    OP(0x94, sty, ALU, 2, 4, DPX,     DirectPageIndexedX,             STY, X, W) \
+    OP(0x95, sta, ALU, 2, 4, DPX,     DirectPageIndexedX,             STA, A, W) \
+    OP(0x96, stx, ALU, 2, 4, DPY,     DirectPageIndexedY,             STX, X, W) \
+    OP(0x97, sta, ALU, 2, 6, INDDPLY, DirectPageIndirectLongIndexedY, STA, A, W) \
+    OP(0x98, tya, IMP, 1, 0, IMPD,    None,                           TYA, A, _) \
+    OP(0x99, sta, ALU, 3, 5, ABSY,    AbsoluteIndexedY,               STA, A, W) \
+    OP(0x9a, txs, IMP, 1, 0, IMPD,    None,                           TXS, X, _) \
+    OP(0x9b, txy, IMP, 1, 0, IMPD,    None,                           TXY, X, _) \
+    OP(0x9c, stz, ALU, 3, 4, ABS,     Absolute,                       STZ, A, W) \
+    OP(0x9d, sta, ALU, 3, 5, ABSX,    AbsoluteIndexedX,               STA, A, W) \
+    OP(0x9e, stz, ALU, 3, 5, ABSX,    AbsoluteIndexedX,               STZ, A, W) \
+    OP(0x9f, sta, ALU, 4, 5, ABSLX,   LongIndexedX,                   STA, A, W) \
+    OP(0xa0, ldy, ALU, 2, 2, IMMD,    Immediate,                      LDY, X, R) \
+    OP(0xa1, lda, ALU, 2, 6, DPINDX,  DirectPageIndexedIndirectX,     LDA, A, R) \
+    OP(0xa2, ldx, ALU, 2, 2, IMMD,    Immediate,                      LDX, X, R) \
+    OP(0xa3, lda, ALU, 2, 4, SR,      StackRelative,                  LDA, A, R) \
+    OP(0xa4, ldy, ALU, 2, 3, DP,      DirectPage,                     LDY, X, R) \
+    OP(0xa5, lda, ALU, 2, 3, DP,      DirectPage,                     LDA, A, R) \
+    OP(0xa6, ldx, ALU, 2, 3, DP,      DirectPage,                     LDX, X, R) \
+    OP(0xa7, lda, ALU, 2, 6, DPINDL,  DirectPageIndirectLong,         LDA, A, R) \
+    OP(0xa8, tay, IMP, 1, 0, IMPD,    None,                           TAY, X, _) \
+    OP(0xa9, lda, ALU, 2, 2, IMMD,    Immediate,                      LDA, A, R) \
+    OP(0xaa, tax, IMP, 1, 0, IMPD,    None,                           TAX, X, _) \
+    OP(0xab, plb, MEM, 1, 0, IMPD,    None,                           PLB, _, _) \
+    OP(0xac, ldy, ALU, 3, 4, ABS,     Absolute,                       LDY, X, R) \
+    OP(0xad, lda, ALU, 3, 4, ABS,     Absolute,                       LDA, A, R) \
+    OP(0xae, ldx, ALU, 3, 4, ABS,     Absolute,                       LDX, X, R) \
+    OP(0xaf, lda, ALU, 4, 5, ABSL,    Long,                           LDA, A, R) \
+    OP(0xb0, bcs, REL, 2, 0, PCR,     None,                           BCS, _, _) \
+    OP(0xb1, lda, ALU, 2, 5, INDDPY,  DirectPageIndirectIndexedY,     LDA, A, R) \
+    OP(0xb2, lda, ALU, 2, 5, DPIND,   DirectPageIndirect,             LDA, A, R) \
+    OP(0xb3, lda, ALU, 2, 7, SRINDY,  StackRelativeIndirectIndexedY,  LDA, A, R) \
+    OP(0xb4, ldy, ALU, 2, 4, DPX,     DirectPageIndexedX,             LDY, X, R) \
+    OP(0xb5, lda, ALU, 2, 4, DPX,     DirectPageIndexedX,             LDA, A, R) \
+    OP(0xb6, ldx, ALU, 2, 4, DPY,     DirectPageIndexedY,             LDX, X, R) \
+    OP(0xb7, lda, ALU, 2, 6, INDDPLY, DirectPageIndirectLongIndexedY, LDA, A, R) \
+    OP(0xb8, clv, IMP, 1, 0, IMPD,    None,                           CLV, _, _) \
+    OP(0xb9, lda, ALU, 3, 4, ABSY,    AbsoluteIndexedY,               LDA, A, R) \
+    OP(0xba, tsx, IMP, 1, 0, IMPD,    None,                           TSX, X, _) \
+    OP(0xbb, tyx, IMP, 1, 0, IMPD,    None,                           TYX, X, _) \
+    OP(0xbc, ldy, ALU, 3, 4, ABSX,    AbsoluteIndexedX,               LDY, X, R) \
+    OP(0xbd, lda, ALU, 3, 4, ABSX,    AbsoluteIndexedX,               LDA, A, R) \
+    OP(0xbe, ldx, ALU, 3, 4, ABSY,    AbsoluteIndexedY,               LDX, X, R) \
+    OP(0xbf, lda, ALU, 4, 5, ABSLX,   LongIndexedX,                   LDA, A, R) \
+    OP(0xc0, cpy, ALU, 2, 2, IMMD,    Immediate,                      CPY, X, R) \
+    OP(0xc1, cmp, ALU, 2, 6, DPINDX,  DirectPageIndexedIndirectX,     CMP, A, R) \
+    OP(0xc2, rep, MEM, 2, 0, IMMD,    None,                           REP, _, _) \
+    OP(0xc3, cmp, ALU, 2, 4, SR,      StackRelative,                  CMP, A, R) \
+    OP(0xc4, cpy, ALU, 2, 3, DP,      DirectPage,                     CPY, X, R) \
+    OP(0xc5, cmp, ALU, 2, 3, DP,      DirectPage,                     CMP, A, R) \
+    OP(0xc6, dec, ALU, 2, 5, DP,      DirectPage,                     DEC, A, RW) \
+    OP(0xc7, cmp, ALU, 2, 6, DPINDL,  DirectPageIndirectLong,         CMP, A, R) \
+    OP(0xc8, iny, IMP, 1, 0, IMPD,    None,                           INY, X, _) \
+    OP(0xc9, cmp, ALU, 2, 2, IMMD,    Immediate,                      CMP, A, R) \
+    OP(0xca, dex, IMP, 1, 0, IMPD,    None,                           DEX, X, _) \
+    OP(0xcb, wai, IMP, 1, 0, IMPD,    None,                           WAI, _, _) \
+    OP(0xcc, cpy, ALU, 3, 4, ABS,     Absolute,                       CPY, X, R) \
+    OP(0xcd, cmp, ALU, 3, 4, ABS,     Absolute,                       CMP, A, R) \
+    OP(0xce, dec, ALU, 3, 6, ABS,     Absolute,                       DEC, A, RW) \
+    OP(0xcf, cmp, ALU, 4, 5, ABSL,    Long,                           CMP, A, R) \
+    OP(0xd0, bne, REL, 2, 0, PCR,     None,                           BNE, _, _) \
+    OP(0xd1, cmp, ALU, 2, 5, INDDPY,  DirectPageIndirectIndexedY,     CMP, A, R) \
+    OP(0xd2, cmp, ALU, 2, 5, DPIND,   DirectPageIndirect,             CMP, A, R) \
+    OP(0xd3, cmp, ALU, 2, 7, SRINDY,  StackRelativeIndirectIndexedY,  CMP, A, R) \
+    OP(0xd4, pei, MEM, 2, 0, DPIND,   None,                           PEI, _, _) \
+    OP(0xd5, cmp, ALU, 2, 4, DPX,     DirectPageIndexedX,             CMP, A, R) \
+    OP(0xd6, dec, ALU, 2, 6, DPX,     DirectPageIndexedX,             DEC, A, RW) \
+    OP(0xd7, cmp, ALU, 2, 6, INDDPLY, DirectPageIndirectLongIndexedY, CMP, A, R) \
+    OP(0xd8, cld, IMP, 1, 0, IMPD,    None,                           CLD, _, _) \
+    OP(0xd9, cmp, ALU, 3, 4, ABSY,    AbsoluteIndexedY,               CMP, A, R) \
+    OP(0xda, phx, MEM, 1, 0, IMPD,    None,                           PHX, X, _) \
+    OP(0xdb, stp, IMP, 1, 0, IMPD,    None,                           STP, _, _) \
+    OP(0xdc, jmp, JMP, 3, 6, ABSINDL, AbsoluteIndirectLong,           JMP, _, _) \
+    OP(0xdd, cmp, ALU, 3, 4, ABSX,    AbsoluteIndexedX,               CMP, A, R) \
+    OP(0xde, dec, ALU, 3, 7, ABSX,    AbsoluteIndexedX,               DEC, A, RW) \
+    OP(0xdf, cmp, ALU, 4, 5, ABSLX,   LongIndexedX,                   CMP, A, R) \
+    OP(0xe0, cpx, ALU, 2, 2, IMMD,    Immediate,                      CPX, X, R) \
+    OP(0xe1, sbc, ALU, 2, 6, DPINDX,  DirectPageIndexedIndirectX,     SBC, A, R) \
+    OP(0xe2, sep, MEM, 2, 0, IMMD,    None,                           SEP, _, _) \
+    OP(0xe3, sbc, ALU, 2, 4, SR,      StackRelative,                  SBC, A, R) \
+    OP(0xe4, cpx, ALU, 2, 3, DP,      DirectPage,                     CPX, X, R) \
+    OP(0xe5, sbc, ALU, 2, 3, DP,      DirectPage,                     SBC, A, R) \
+    OP(0xe6, inc, ALU, 2, 5, DP,      DirectPage,                     INC, A, RW) \
+    OP(0xe7, sbc, ALU, 2, 6, DPINDL,  DirectPageIndirectLong,         SBC, A, R) \
+    OP(0xe8, inx, IMP, 1, 0, IMPD,    None,                           INX, X, _) \
+    OP(0xe9, sbc, ALU, 2, 2, IMMD,    Immediate,                      SBC, A, R) \
+    OP(0xea, nop, IMP, 1, 0, IMPD,    None,                           NOP, _, _) \
+    OP(0xeb, xba, IMP, 1, 0, IMPD,    None,                           XBA, _, _) \
+    OP(0xec, cpx, ALU, 3, 4, ABS,     Absolute,                       CPX, X, R) \
+    OP(0xed, sbc, ALU, 3, 4, ABS,     Absolute,                       SBC, A, R) \
+    OP(0xee, inc, ALU, 3, 6, ABS,     Absolute,                       INC, A, RW) \
+    OP(0xef, sbc, ALU, 4, 5, ABSL,    Long,                           SBC, A, R) \
+    OP(0xf0, beq, REL, 2, 0, PCR,     None,                           BEQ, _, _) \
+    OP(0xf1, sbc, ALU, 2, 5, INDDPY,  DirectPageIndirectIndexedY,     SBC, A, R) \
+    OP(0xf2, sbc, ALU, 2, 5, DPIND,   DirectPageIndirect,             SBC, A, R) \
+    OP(0xf3, sbc, ALU, 2, 7, SRINDY,  StackRelativeIndirectIndexedY,  SBC, A, R) \
+    OP(0xf4, pea, MEM, 3, 0, ABS,     None,                           PEA, _, _) \
+    OP(0xf5, sbc, ALU, 2, 4, DPX,     DirectPageIndexedX,             SBC, A, R) \
+    OP(0xf6, inc, ALU, 2, 6, DPX,     DirectPageIndexedX,             INC, A, RW) \
+    OP(0xf7, sbc, ALU, 2, 6, INDDPLY, DirectPageIndirectLongIndexedY, SBC, A, R) \
+    OP(0xf8, sed, IMP, 1, 0, IMPD,    None,                           SED, _, _) \
+    OP(0xf9, sbc, ALU, 3, 4, ABSY,    AbsoluteIndexedY,               SBC, A, R) \
+    OP(0xfa, plx, MEM, 1, 0, IMPD,    None,                           PLX, X, _) \
+    OP(0xfb, xce, IMP, 1, 0, IMPD,    None,                           XCE, _, _) \
+    OP(0xfc, jsr, JSR, 3, 8, ABSINDX, AbsoluteIndexedIndirectX,       JSR, _, _) \
+    OP(0xfd, sbc, ALU, 3, 4, ABSX,    AbsoluteIndexedX,               SBC, A, R) \
+    OP(0xfe, inc, ALU, 3, 7, ABSX,    AbsoluteIndexedX,               INC, A, RW) \
+    OP(0xff, sbc, ALU, 4, 5, ABSLX,   LongIndexedX,                   SBC, A, R)
+
+// Cycle penalties (from the W65C816S datasheet's cycle table)
+#define CPU_CYC_DL 0x01 // +1 if the low byte of D is not 0
+#define CPU_CYC_M  0x02 // +1 if the accumulator is 16 bits wide
+#define CPU_CYC_M2 0x04 // +2 if the accumulator is 16 bits wide (read-modify-write)
+#define CPU_CYC_X  0x08 // +1 if the index registers are 16 bits wide
+#define CPU_CYC_IX 0x10 // +1 if X is 16 bits wide or indexing by X crosses a page
+#define CPU_CYC_IY 0x20 // +1 if Y is 16 bits wide or indexing by Y crosses a page
+
+// Penalties for each addressing mode used by ALU rows. The indexing
+// penalties only apply to reads: writes and read-modify-writes always
+// take the extra cycle, so it is part of their base cycle count
+#define CPU_CYC_MODE_ABS 0
+#define CPU_CYC_MODE_ABSX CPU_CYC_IX
+#define CPU_CYC_MODE_ABSY CPU_CYC_IY
+#define CPU_CYC_MODE_ABSL 0
+#define CPU_CYC_MODE_ABSLX 0
+#define CPU_CYC_MODE_DP CPU_CYC_DL
+#define CPU_CYC_MODE_DPX CPU_CYC_DL
+#define CPU_CYC_MODE_DPY CPU_CYC_DL
+#define CPU_CYC_MODE_DPIND CPU_CYC_DL
+#define CPU_CYC_MODE_DPINDL CPU_CYC_DL
+#define CPU_CYC_MODE_DPINDX CPU_CYC_DL
+#define CPU_CYC_MODE_INDDPY (CPU_CYC_DL | CPU_CYC_IY)
+#define CPU_CYC_MODE_INDDPLY CPU_CYC_DL
+#define CPU_CYC_MODE_SR 0
+#define CPU_CYC_MODE_SRINDY 0
+#define CPU_CYC_MODE_IMMD 0
+
+#define CPU_CYC_REG_A CPU_CYC_M
+#define CPU_CYC_REG_X CPU_CYC_X
+
+#define CPU_CYC_ACCESS_R(mode, reg) (CPU_CYC_MODE_##mode | CPU_CYC_REG_##reg)
+#define CPU_CYC_ACCESS_W(mode, reg) \
+    ((CPU_CYC_MODE_##mode & ~(CPU_CYC_IX | CPU_CYC_IY)) | CPU_CYC_REG_##reg)
+#define CPU_CYC_ACCESS_RW(mode, reg) \
+    ((CPU_CYC_MODE_##mode & ~(CPU_CYC_IX | CPU_CYC_IY)) | CPU_CYC_M2)
+#define CPU_CYC_ACCESS__(mode, reg) 0
+
+// The CPU_CYC_* penalties which apply to a row of the opcode table
+// (a constant, so the checks for penalties which cannot apply to an
+// opcode are compiled out of its handler call)
+#define CPU_OP_PENALTIES(mode, reg, access) CPU_CYC_ACCESS_##access(mode, reg)
+
+#endif
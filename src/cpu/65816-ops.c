@@ -6,11 +6,11 @@
 #include "65816-ops.h"
 
 
-void i_adc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_adc)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
-        uint8_t val = _get_mem_byte(mem, addr, cpu->setacc);
+        uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
         uint16_t al;
         if (cpu->P.D) // BCD mode
         {
@@ -40,8 +40,7 @@ void i_adc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         // 1f
         cpu->C = (cpu->C & 0xff00) | (al & 0xff);
         cpu->P.C = (al >= 0x100) ? 1 : 0;
-        cpu->P.N = (al & 0x80) ? 1 : 0;
-        cpu->P.Z = ((al & 0xff) == 0) ? 1 : 0;
+        _cpu_set_nz8(cpu, al);
     }
     else // 16-bit
     {
@@ -51,11 +50,11 @@ void i_adc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         if (mode == CPU_ADDR_DP || mode == CPU_ADDR_DPX ||
             mode == CPU_ADDR_IMMD || mode == CPU_ADDR_SR)
         {
-            val = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            val = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
         }
         else
         {
-            val = _get_mem_word(mem, addr, cpu->setacc);
+            val = _get_mem_word(mem, addr, CPU_SETACC(cpu));
         }
         if (cpu->P.D)
         {
@@ -98,73 +97,33 @@ void i_adc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         // 1f
         cpu->C = al & 0xffff;
         cpu->P.C = (al >= 0x10000) ? 1 : 0;
-        cpu->P.N = (al & 0x8000) ? 1 : 0;
-        cpu->P.Z = ((al & 0xffff) == 0) ? 1 : 0;
+        _cpu_set_nz16(cpu, al);
 
-        cpu->cycles += 1;
         if (mode == CPU_ADDR_IMMD)
         {
             size += 1; // One extra byte in operand
         }
     }
 
-    if (mode == CPU_ADDR_ABSX)
-    {
-        // Check if index crosses a page boundary
-        if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-            (!cpu->P.E && !cpu->P.XB))
-        {
-            cpu->cycles += 1;
-        }
-    }
-    else if (mode == CPU_ADDR_ABSY || mode == CPU_ADDR_INDDPY)
-    {
-        // Check if index crosses a page boundary
-        if ((addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00) ||
-            (!cpu->P.E && !cpu->P.XB))
-        {
-            cpu->cycles += 1;
-        }
-    }
-
-    // If DL != 0, add a cycle
-    if ((mode == CPU_ADDR_DPIND || mode == CPU_ADDR_DPINDL ||
-         mode == CPU_ADDR_INDDPY || mode == CPU_ADDR_DPINDX ||
-         mode == CPU_ADDR_DP || mode == CPU_ADDR_DPX ||
-         mode == CPU_ADDR_INDDPLY) &&
-        (cpu->D & 0xff) != 0)
-    {
-        cpu->cycles += 1;
-    }
-
     _cpu_update_pc(cpu, size);
     cpu->cycles += cycles;
 }
 
-void i_and(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_and)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) & _get_mem_byte(mem, addr, cpu->setacc));
-            cpu->P.N = (cpu->C & 0x80) ? 1 : 0;
-            cpu->P.Z = (cpu->C & 0xff) ? 0 : 1;
+            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) & _get_mem_byte(mem, addr, CPU_SETACC(cpu)));
+            _cpu_set_nz8(cpu, cpu->C);
         }
         else // 16-bit
         {
-            cpu->C = cpu->C & _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-            cpu->P.N = (cpu->C & 0x8000) ? 1 : 0;
-            cpu->P.Z = cpu->C ? 0 : 1;
-            cpu->cycles += 1;
-        }
-    
-        // If DL != 0, add a cycle
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            cpu->C = cpu->C & _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, cpu->C);
         }
         break;
     case CPU_ADDR_DPIND:
@@ -178,63 +137,28 @@ void i_and(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     case CPU_ADDR_INDDPY:
     case CPU_ADDR_INDDPLY:
     case CPU_ADDR_SRINDY:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) & _get_mem_byte(mem, addr, cpu->setacc));
-            cpu->P.N = (cpu->C & 0x80) ? 1 : 0;
-            cpu->P.Z = (cpu->C & 0xff) ? 0 : 1;
+            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) & _get_mem_byte(mem, addr, CPU_SETACC(cpu)));
+            _cpu_set_nz8(cpu, cpu->C);
         }
         else // 16-bit
         {
-            cpu->C = cpu->C & _get_mem_word(mem, addr, cpu->setacc);
-            cpu->P.N = (cpu->C & 0x8000) ? 1 : 0;
-            cpu->P.Z = cpu->C ? 0 : 1;
-            cpu->cycles += 1;
-        }
-    
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
-        }
-        else if (mode == CPU_ADDR_ABSY || mode == CPU_ADDR_INDDPY)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
-        }
-        if (mode == CPU_ADDR_DPIND || mode == CPU_ADDR_DPINDL ||
-            mode == CPU_ADDR_DPINDX || mode == CPU_ADDR_INDDPY ||
-            mode == CPU_ADDR_INDDPLY)
-        {
-            // If DL != 0, add a cycle
-            if (cpu->D & 0xff)
-            {
-                cpu->cycles += 1;
-            }
+            cpu->C = cpu->C & _get_mem_word(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, cpu->C);
         }
         break;
     case CPU_ADDR_IMMD:
     case CPU_ADDR_SR:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) & _get_mem_byte(mem, addr, cpu->setacc));
-            cpu->P.N = (cpu->C & 0x80) ? 1 : 0;
-            cpu->P.Z = (cpu->C & 0xff) ? 0 : 1;
+            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) & _get_mem_byte(mem, addr, CPU_SETACC(cpu)));
+            _cpu_set_nz8(cpu, cpu->C);
         }
         else // 16-bit
         {
-            cpu->C = cpu->C & _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-            cpu->P.N = (cpu->C & 0x8000) ? 1 : 0;
-            cpu->P.Z = cpu->C ? 0 : 1;
-            cpu->cycles += 1;
+            cpu->C = cpu->C & _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, cpu->C);
             if (mode == CPU_ADDR_IMMD) {
                 size += 1; // One extra byte in operand
             }
@@ -247,7 +171,7 @@ void i_and(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     _cpu_update_pc(cpu, size);
 }
 
-void i_asl(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_asl)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     uint16_t post_data = 0;
     uint16_t pre_data = 0;
@@ -255,46 +179,38 @@ void i_asl(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        pre_data = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+        pre_data = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data << 1) & 0xff);
-            _set_mem_byte(mem, addr, (uint8_t)post_data, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)post_data, CPU_SETACC(cpu));
         }
         else // 16-bit
         {
             post_data = pre_data << 1;
-            _set_mem_word_bank_wrap(mem, addr, post_data, cpu->setacc);
-            cpu->cycles += 2;
-        }
-
-        // If DL != 0, add a cycle
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            _set_mem_word_bank_wrap(mem, addr, post_data, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSX:
-        pre_data = _get_mem_word(mem, addr, cpu->setacc);
+        pre_data = _get_mem_word(mem, addr, CPU_SETACC(cpu));
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data << 1) & 0xff);
-            _set_mem_byte(mem, addr, (uint8_t)post_data, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)post_data, CPU_SETACC(cpu));
         }
         else // 16-bit
         {
             post_data = pre_data << 1;
-            _set_mem_word(mem, addr, post_data, cpu->setacc);
-            cpu->cycles += 2;
+            _set_mem_word(mem, addr, post_data, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_IMPD:
         pre_data = cpu->C;
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data << 1) & 0xff);
             cpu->C = (cpu->C & 0xff00) | post_data;
@@ -310,32 +226,31 @@ void i_asl(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         break;
     }
 
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
         cpu->P.C = (pre_data & 0x80) ? 1 : 0;
-        cpu->P.N = (post_data & 0x80) ? 1 : 0;
-        cpu->P.Z = (post_data & 0xff) ? 0 : 1;
+        _cpu_set_nz8(cpu, post_data);
     }
     else // 16-bit
     {
         cpu->P.C = (pre_data & 0x8000) ? 1 : 0;
-        cpu->P.N = (post_data & 0x8000) ? 1 : 0;
-        cpu->P.Z = post_data ? 0 : 1;
+        _cpu_set_nz16(cpu, post_data);
     }
 
     cpu->cycles += cycles;
     _cpu_update_pc(cpu, size);
 }
 
-void i_bcc(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_bcc)(CPU_t *cpu, memory_t *mem)
 {
     if (!cpu->P.C)
     {
-        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, cpu->setacc);
+        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, CPU_SETACC(cpu));
         cpu->cycles += 1;
 
         // Add a cycle if page boundary crossed in emulation mode
-        if (cpu->P.E && ((new_PC & 0xff00) != (cpu->PC & 0xff00)))
+        // (from the address of the next instruction)
+        if (cpu->P.E && ((new_PC & 0xff00) != ((cpu->PC + 2) & 0xff00)))
         {
             cpu->cycles += 1;
         }
@@ -348,15 +263,16 @@ void i_bcc(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 2;
 }
 
-void i_bcs(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_bcs)(CPU_t *cpu, memory_t *mem)
 {
     if (cpu->P.C)
     {
-        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, cpu->setacc);
+        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, CPU_SETACC(cpu));
         cpu->cycles += 1;
 
         // Add a cycle if page boundary crossed in emulation mode
-        if (cpu->P.E && ((new_PC & 0xff00) != (cpu->PC & 0xff00)))
+        // (from the address of the next instruction)
+        if (cpu->P.E && ((new_PC & 0xff00) != ((cpu->PC + 2) & 0xff00)))
         {
             cpu->cycles += 1;
         }
@@ -369,15 +285,16 @@ void i_bcs(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 2;
 }
 
-void i_beq(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_beq)(CPU_t *cpu, memory_t *mem)
 {
-    if (cpu->P.Z)
+    if (_cpu_get_z(cpu))
     {
-        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, cpu->setacc);
+        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, CPU_SETACC(cpu));
         cpu->cycles += 1;
 
         // Add a cycle if page boundary crossed in emulation mode
-        if (cpu->P.E && ((new_PC & 0xff00) != (cpu->PC & 0xff00)))
+        // (from the address of the next instruction)
+        if (cpu->P.E && ((new_PC & 0xff00) != ((cpu->PC + 2) & 0xff00)))
         {
             cpu->cycles += 1;
         }
@@ -390,72 +307,53 @@ void i_beq(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 2;
 }
 
-void i_bit(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_bit)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     if (mode == CPU_ADDR_DP || mode == CPU_ADDR_DPX)
     {
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            uint8_t val = _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.Z = ((cpu->C & 0xff) & val) ? 0 : 1;
-            cpu->P.N = (val & 0x80) ? 1 : 0;
+            uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            cpu->P.NZ_Z = (cpu->C & 0xff) & val;
+            cpu->P.NZ_N = val; // N is bit 7 of the operand
             cpu->P.V = (val & 0x40) ? 1 : 0;
         }
         else // 16-bit
         {
-            uint16_t val = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-            cpu->P.Z = (cpu->C & val) ? 0 : 1;
-            cpu->P.N = (val & 0x8000) ? 1 : 0;
+            uint16_t val = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
+            cpu->P.NZ_Z = cpu->C & val;
+            cpu->P.NZ_N = val >> 8; // N is bit 15 of the operand
             cpu->P.V = (val & 0x4000) ? 1 : 0;
-            cpu->cycles += 1;
-        }
-
-        // If DL != 0, add a cycle
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
         }
     }
     else if (mode == CPU_ADDR_ABS || mode == CPU_ADDR_ABSX)
     {
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            uint8_t val = _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.Z = ((cpu->C & 0xff) & val) ? 0 : 1;
-            cpu->P.N = (val & 0x80) ? 1 : 0;
+            uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            cpu->P.NZ_Z = (cpu->C & 0xff) & val;
+            cpu->P.NZ_N = val; // N is bit 7 of the operand
             cpu->P.V = (val & 0x40) ? 1 : 0;
         }
         else // 16-bit
         {
-            uint16_t val = _get_mem_word(mem, addr, cpu->setacc);
-            cpu->P.Z = (cpu->C & val) ? 0 : 1;
-            cpu->P.N = (val & 0x8000) ? 1 : 0;
+            uint16_t val = _get_mem_word(mem, addr, CPU_SETACC(cpu));
+            cpu->P.NZ_Z = cpu->C & val;
+            cpu->P.NZ_N = val >> 8; // N is bit 15 of the operand
             cpu->P.V = (val & 0x4000) ? 1 : 0;
-            cpu->cycles += 1;
-        }
-
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
         }
     }
     else if (mode == CPU_ADDR_IMMD)
     {
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            uint8_t val = _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.Z = ((cpu->C & 0xff) & val) ? 0 : 1; // Only Z for immediate addressing
+            uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            cpu->P.NZ_Z = (cpu->C & 0xff) & val; // Only Z for immediate addressing
         }
         else // 16-bit
         {
-            uint16_t val = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-            cpu->P.Z = (cpu->C & val) ? 0 : 1;
-            cpu->cycles += 1;
+            uint16_t val = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
+            cpu->P.NZ_Z = cpu->C & val;
             size += 1;
         }
     }
@@ -463,15 +361,16 @@ void i_bit(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     _cpu_update_pc(cpu, size);
 }
 
-void i_bmi(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_bmi)(CPU_t *cpu, memory_t *mem)
 {
-    if (cpu->P.N)
+    if (_cpu_get_n(cpu))
     {
-        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, cpu->setacc);
+        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, CPU_SETACC(cpu));
         cpu->cycles += 1;
 
         // Add a cycle if page boundary crossed in emulation mode
-        if (cpu->P.E && ((new_PC & 0xff00) != (cpu->PC & 0xff00)))
+        // (from the address of the next instruction)
+        if (cpu->P.E && ((new_PC & 0xff00) != ((cpu->PC + 2) & 0xff00)))
         {
             cpu->cycles += 1;
         }
@@ -484,15 +383,16 @@ void i_bmi(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 2;
 }
 
-void i_bne(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_bne)(CPU_t *cpu, memory_t *mem)
 {
-    if (!cpu->P.Z)
+    if (!_cpu_get_z(cpu))
     {
-        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, cpu->setacc);
+        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, CPU_SETACC(cpu));
         cpu->cycles += 1;
 
         // Add a cycle if page boundary crossed in emulation mode
-        if (cpu->P.E && ((new_PC & 0xff00) != (cpu->PC & 0xff00)))
+        // (from the address of the next instruction)
+        if (cpu->P.E && ((new_PC & 0xff00) != ((cpu->PC + 2) & 0xff00)))
         {
             cpu->cycles += 1;
         }
@@ -505,15 +405,16 @@ void i_bne(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 2;
 }
 
-void i_bpl(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_bpl)(CPU_t *cpu, memory_t *mem)
 {
-    if (!cpu->P.N)
+    if (!_cpu_get_n(cpu))
     {
-        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, cpu->setacc);
+        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, CPU_SETACC(cpu));
         cpu->cycles += 1;
 
         // Add a cycle if page boundary crossed in emulation mode
-        if (cpu->P.E && ((new_PC & 0xff00) != (cpu->PC & 0xff00)))
+        // (from the address of the next instruction)
+        if (cpu->P.E && ((new_PC & 0xff00) != ((cpu->PC + 2) & 0xff00)))
         {
             cpu->cycles += 1;
         }
@@ -526,38 +427,39 @@ void i_bpl(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 2;
 }
 
-void i_bra(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_bra)(CPU_t *cpu, memory_t *mem)
 {
-    uint16_t new_PC = _addrCPU_getRelative8(cpu, mem, cpu->setacc);
+    uint16_t new_PC = _addrCPU_getRelative8(cpu, mem, CPU_SETACC(cpu));
     cpu->cycles += 3;
 
     // Add a cycle if page boundary crossed in emulation mode
-    if (cpu->P.E && ((new_PC & 0xff00) != (cpu->PC & 0xff00)))
+    // (from the address of the next instruction)
+    if (cpu->P.E && ((new_PC & 0xff00) != ((cpu->PC + 2) & 0xff00)))
     {
         cpu->cycles += 1;
     }
     cpu->PC = new_PC;
 }
 
-void i_brk(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_brk)(CPU_t *cpu, memory_t *mem)
 {
     _cpu_update_pc(cpu, 2);
 
     if (cpu->P.E)
     {
-        _stackCPU_pushWord(cpu, mem, cpu->PC, CPU_ESTACK_ENABLE, cpu->setacc);
-        _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu) | 0x10, cpu->setacc); // B flag is set for BRK in emulation mode
-        cpu->PC = _get_mem_byte(mem, CPU_VEC_EMU_IRQ, cpu->setacc);
-        cpu->PC |= _get_mem_byte(mem, CPU_VEC_EMU_IRQ + 1, cpu->setacc) << 8;
+        _stackCPU_pushWord(cpu, mem, cpu->PC, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
+        _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu) | 0x10, CPU_SETACC(cpu)); // B flag is set for BRK in emulation mode
+        cpu->PC = _get_mem_byte(mem, CPU_VEC_EMU_IRQ, CPU_SETACC(cpu));
+        cpu->PC |= _get_mem_byte(mem, CPU_VEC_EMU_IRQ + 1, CPU_SETACC(cpu)) << 8;
         cpu->PBR = 0;
         cpu->cycles += 7;
     }
     else
     {
-        _stackCPU_push24(cpu, mem, _cpu_get_effective_pc(cpu), cpu->setacc);
-        _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu), cpu->setacc);
-        cpu->PC = _get_mem_byte(mem, CPU_VEC_NATIVE_BRK, cpu->setacc);
-        cpu->PC |= _get_mem_byte(mem, CPU_VEC_NATIVE_BRK + 1, cpu->setacc) << 8;
+        _stackCPU_push24(cpu, mem, _cpu_get_effective_pc(cpu), CPU_SETACC(cpu));
+        _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu), CPU_SETACC(cpu));
+        cpu->PC = _get_mem_byte(mem, CPU_VEC_NATIVE_BRK, CPU_SETACC(cpu));
+        cpu->PC |= _get_mem_byte(mem, CPU_VEC_NATIVE_BRK + 1, CPU_SETACC(cpu)) << 8;
         cpu->PBR = 0;
         cpu->cycles += 8;
     }
@@ -566,21 +468,22 @@ void i_brk(CPU_t *cpu, memory_t *mem)
     cpu->P.I = 1;
 }
 
-void i_brl(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_brl)(CPU_t *cpu, memory_t *mem)
 {
-    cpu->PC = _addrCPU_getRelative16(cpu, mem, cpu->setacc);
+    cpu->PC = _addrCPU_getRelative16(cpu, mem, CPU_SETACC(cpu));
     cpu->cycles += 4;
 }
 
-void i_bvc(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_bvc)(CPU_t *cpu, memory_t *mem)
 {
     if (!cpu->P.V)
     {
-        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, cpu->setacc);
+        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, CPU_SETACC(cpu));
         cpu->cycles += 1;
 
         // Add a cycle if page boundary crossed in emulation mode
-        if (cpu->P.E && ((new_PC & 0xff00) != (cpu->PC & 0xff00)))
+        // (from the address of the next instruction)
+        if (cpu->P.E && ((new_PC & 0xff00) != ((cpu->PC + 2) & 0xff00)))
         {
             cpu->cycles += 1;
         }
@@ -593,15 +496,16 @@ void i_bvc(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 2;
 }
 
-void i_bvs(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_bvs)(CPU_t *cpu, memory_t *mem)
 {
     if (cpu->P.V)
     {
-        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, cpu->setacc);
+        int32_t new_PC = _addrCPU_getRelative8(cpu, mem, CPU_SETACC(cpu));
         cpu->cycles += 1;
 
         // Add a cycle if page boundary crossed in emulation mode
-        if (cpu->P.E && ((new_PC & 0xff00) != (cpu->PC & 0xff00)))
+        // (from the address of the next instruction)
+        if (cpu->P.E && ((new_PC & 0xff00) != ((cpu->PC + 2) & 0xff00)))
         {
             cpu->cycles += 1;
         }
@@ -614,35 +518,35 @@ void i_bvs(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 2;
 }
 
-void i_clc(CPU_t *cpu)
+CPU_OP_DEF(i_clc)(CPU_t *cpu)
 {
     cpu->P.C = 0;
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_cld(CPU_t *cpu)
+CPU_OP_DEF(i_cld)(CPU_t *cpu)
 {
     cpu->P.D = 0;
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_cli(CPU_t *cpu)
+CPU_OP_DEF(i_cli)(CPU_t *cpu)
 {
     cpu->P.I = 0;
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_clv(CPU_t *cpu)
+CPU_OP_DEF(i_clv)(CPU_t *cpu)
 {
     cpu->P.V = 0;
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_cmp(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_cmp)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
@@ -650,34 +554,24 @@ void i_cmp(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     case CPU_ADDR_DPX:
     case CPU_ADDR_IMMD:
     case CPU_ADDR_SR:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            uint8_t res = (cpu->C & 0xff) - _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.N = (res & 0x80) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            uint8_t res = (cpu->C & 0xff) - _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, res);
             cpu->P.C = ((cpu->C & 0xff) < res) ? 0 : 1;
                 
         }
         else // 16-bit
         {
-            uint16_t res = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            uint16_t res = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
             res = cpu->C - res;
-            cpu->P.N = (res & 0x8000) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            _cpu_set_nz16(cpu, res);
             cpu->P.C = (cpu->C < res) ? 0 : 1;
-            cpu->cycles += 1;
             if (mode == CPU_ADDR_IMMD)
             {
                 size += 1; // One extra byte in operand
             }
         }
-    
-        // If DL != 0, add a cycle
-        if ((mode == CPU_ADDR_DP || mode == CPU_ADDR_DPX) &&
-            (cpu->D & 0xff) != 0)
-        {
-            cpu->cycles += 1;
-        }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSL:
@@ -690,49 +584,18 @@ void i_cmp(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     case CPU_ADDR_DPINDX:
     case CPU_ADDR_INDDPLY:
     case CPU_ADDR_SRINDY:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            uint8_t res = (cpu->C & 0xff) - _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.N = (res & 0x80) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            uint8_t res = (cpu->C & 0xff) - _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, res);
             cpu->P.C = ((cpu->C & 0xff) < res) ? 0 : 1;
                 
         }
         else // 16-bit
         {
-            uint16_t res = cpu->C - _get_mem_word(mem, addr, cpu->setacc);
-            cpu->P.N = (res & 0x8000) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            uint16_t res = cpu->C - _get_mem_word(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, res);
             cpu->P.C = (cpu->C < res) ? 0 : 1;
-            cpu->cycles += 1;
-        }
-    
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00)||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
-        }
-        else if (mode == CPU_ADDR_ABSY || mode == CPU_ADDR_INDDPY)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00)||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
-        }
-    
-        // If DL != 0, add a cycle
-        if ((mode == CPU_ADDR_DPIND || mode == CPU_ADDR_DPINDL ||
-             mode == CPU_ADDR_INDDPY || mode == CPU_ADDR_DPINDX ||
-             mode == CPU_ADDR_INDDPLY) &&
-            (cpu->D & 0xff) != 0)
-        {
-            cpu->cycles += 1;
         }
         break;
     default:
@@ -742,29 +605,29 @@ void i_cmp(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     cpu->cycles += cycles;
 }
 
-void i_cop(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_cop)(CPU_t *cpu, memory_t *mem)
 {
     // Only needed with cop_vect_enable optional feature
-    uint8_t immd = _cpu_get_immd_byte(cpu, mem, cpu->setacc);
+    uint8_t immd = _cpu_get_immd_byte(cpu, mem, CPU_SETACC(cpu));
 
     // We will push the return address
     _cpu_update_pc(cpu, 2);
 
     if (cpu->P.E)
     {
-        _stackCPU_pushWord(cpu, mem, cpu->PC, CPU_ESTACK_ENABLE, cpu->setacc);
-        _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu) & 0xef, cpu->setacc); // ??? Unknown: the state of the B flag in ISR for COP (assumed to be 0)
-        cpu->PC = _get_mem_byte(mem, CPU_VEC_EMU_COP, cpu->setacc);
-        cpu->PC |= _get_mem_byte(mem, CPU_VEC_EMU_COP + 1, cpu->setacc) << 8;
+        _stackCPU_pushWord(cpu, mem, cpu->PC, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
+        _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu) & 0xef, CPU_SETACC(cpu)); // ??? Unknown: the state of the B flag in ISR for COP (assumed to be 0)
+        cpu->PC = _get_mem_byte(mem, CPU_VEC_EMU_COP, CPU_SETACC(cpu));
+        cpu->PC |= _get_mem_byte(mem, CPU_VEC_EMU_COP + 1, CPU_SETACC(cpu)) << 8;
         cpu->PBR = 0;
         cpu->cycles += 7;
     }
     else
     {
-        _stackCPU_push24(cpu, mem, _cpu_get_effective_pc(cpu), cpu->setacc);
-        _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu), cpu->setacc);
-        cpu->PC = _get_mem_byte(mem, CPU_VEC_NATIVE_COP, cpu->setacc);
-        cpu->PC |= _get_mem_byte(mem, CPU_VEC_NATIVE_COP + 1, cpu->setacc) << 8;
+        _stackCPU_push24(cpu, mem, _cpu_get_effective_pc(cpu), CPU_SETACC(cpu));
+        _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu), CPU_SETACC(cpu));
+        cpu->PC = _get_mem_byte(mem, CPU_VEC_NATIVE_COP, CPU_SETACC(cpu));
+        cpu->PC |= _get_mem_byte(mem, CPU_VEC_NATIVE_COP + 1, CPU_SETACC(cpu)) << 8;
         cpu->PBR = 0;
         cpu->cycles += 8;
     }
@@ -781,55 +644,44 @@ void i_cop(CPU_t *cpu, memory_t *mem)
     }
 }
 
-void i_cpx(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_cpx)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_IMMD:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit
+        if (CPU_X8(cpu)) // 8-bit
         {
-            uint8_t res = (cpu->X & 0xff) - _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.N = (res & 0x80) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            uint8_t res = (cpu->X & 0xff) - _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, res);
             cpu->P.C = ((cpu->X & 0xff) < res) ? 0 : 1;
             
         }
         else // 16-bit
         {
-            uint16_t res = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            uint16_t res = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
             res = cpu->X - res;
-            cpu->P.N = (res & 0x8000) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            _cpu_set_nz16(cpu, res);
             cpu->P.C = (cpu->X < res) ? 0 : 1;
-            cpu->cycles += 1;
             if (mode == CPU_ADDR_IMMD)
             {
                 size += 1; // One extra byte in operand
             }
         }
-        // If DL != 0, add a cycle
-        if (mode == CPU_ADDR_DP && cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
-        }
         break;
     case CPU_ADDR_ABS:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit
+        if (CPU_X8(cpu)) // 8-bit
         {
-            uint8_t res = (cpu->X & 0xff) - _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.N = (res & 0x80) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            uint8_t res = (cpu->X & 0xff) - _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, res);
             cpu->P.C = ((cpu->X & 0xff) < res) ? 0 : 1;
             
         }
         else // 16-bit
         {
-            uint16_t res = cpu->X - _get_mem_word(mem, addr, cpu->setacc);
-            cpu->P.N = (res & 0x8000) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            uint16_t res = cpu->X - _get_mem_word(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, res);
             cpu->P.C = (cpu->X < res) ? 0 : 1;
-            cpu->cycles += 1;
         }
         break;
     default:
@@ -839,53 +691,42 @@ void i_cpx(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     cpu->cycles += cycles;
 }
 
-void i_cpy(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_cpy)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_IMMD:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit
+        if (CPU_X8(cpu)) // 8-bit
         {
-            uint8_t res = (cpu->Y & 0xff) - _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.N = (res & 0x80) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            uint8_t res = (cpu->Y & 0xff) - _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, res);
             cpu->P.C = ((cpu->Y & 0xff) < res) ? 0 : 1;
         }
         else // 16-bit
         {
-            uint16_t res = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            uint16_t res = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
             res = cpu->Y - res;
-            cpu->P.N = (res & 0x8000) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            _cpu_set_nz16(cpu, res);
             cpu->P.C = (cpu->Y < res) ? 0 : 1;
-            cpu->cycles += 1;
             if (mode == CPU_ADDR_IMMD)
             {
                 size += 1; // One extra byte in operand
             }
         }
-        // If DL != 0, add a cycle
-        if (mode == CPU_ADDR_DP && cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
-        }
         break;
     case CPU_ADDR_ABS:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit
+        if (CPU_X8(cpu)) // 8-bit
         {
-            uint8_t res = (cpu->Y & 0xff) - _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.N = (res & 0x80) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            uint8_t res = (cpu->Y & 0xff) - _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, res);
             cpu->P.C = ((cpu->Y & 0xff) < res) ? 0 : 1;
         }
         else // 16-bit
         {
-            uint16_t res = cpu->Y - _get_mem_word(mem, addr, cpu->setacc);
-            cpu->P.N = (res & 0x8000) ? 1 : 0;
-            cpu->P.Z = res ? 0 : 1;
+            uint16_t res = cpu->Y - _get_mem_word(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, res);
             cpu->P.C = (cpu->Y < res) ? 0 : 1;
-            cpu->cycles += 1;
         }
         break;
     default:
@@ -895,79 +736,58 @@ void i_cpy(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     cpu->cycles += cycles;
 }
 
-void i_dea(CPU_t *cpu)
+CPU_OP_DEF(i_dea)(CPU_t *cpu)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
         cpu->C = ((cpu->C - 1) & 0xff) | (cpu->C & 0xff00);
-        cpu->P.N = cpu->C & 0x80 ? 1 : 0;
-        cpu->P.Z = cpu->C & 0xff ? 0 : 1;
+        _cpu_set_nz8(cpu, cpu->C);
     }
     else // 16-bit
     {
         cpu->C = (cpu->C - 1) & 0xffff;
-        cpu->P.N = cpu->C & 0x8000 ? 1 : 0;
-        cpu->P.Z = cpu->C ? 0 : 1;
+        _cpu_set_nz16(cpu, cpu->C);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_dec(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_dec)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M))
+        if (CPU_M8(cpu))
         {
-            uint8_t val = _get_mem_byte(mem, addr, cpu->setacc) - 1;
-            _set_mem_byte(mem, addr, val, cpu->setacc);
-            cpu->P.N = val & 0x80 ? 1 : 0;
-            cpu->P.Z = val ? 0 : 1;
+            uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu)) - 1;
+            _set_mem_byte(mem, addr, val, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, val);
         }
         else // 16-bit
         {
             uint32_t addr_high = _addr_add_val_bank_wrap(addr, 1);
-            uint16_t val = _get_mem_byte(mem, addr, cpu->setacc);
-            val |= _get_mem_byte(mem, addr_high, cpu->setacc) << 8;
+            uint16_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            val |= _get_mem_byte(mem, addr_high, CPU_SETACC(cpu)) << 8;
             val -= 1;
-            _set_mem_word_bank_wrap(mem, addr, val, cpu->setacc);
-            cpu->P.N = val & 0x8000 ? 1 : 0;
-            cpu->P.Z = val ? 0 : 1;
-            cpu->cycles += 2;
-        }
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            _set_mem_word_bank_wrap(mem, addr, val, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, val);
         }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSX:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M))
+        if (CPU_M8(cpu))
         {
-            uint8_t val = _get_mem_byte(mem, addr, cpu->setacc) - 1;
-            _set_mem_byte(mem, addr, val, cpu->setacc);
-            cpu->P.N = val & 0x80 ? 1 : 0;
-            cpu->P.Z = val ? 0 : 1;
+            uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu)) - 1;
+            _set_mem_byte(mem, addr, val, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, val);
         }
         else // 16-bit
         {
-            uint16_t val = _get_mem_word(mem, addr, cpu->setacc) - 1;
-            _set_mem_word(mem, addr, val, cpu->setacc);
-            cpu->P.N = val & 0x8000 ? 1 : 0;
-            cpu->P.Z = val ? 0 : 1;
-            cpu->cycles += 2;
-        }
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
+            uint16_t val = _get_mem_word(mem, addr, CPU_SETACC(cpu)) - 1;
+            _set_mem_word(mem, addr, val, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, val);
         }
         break;
     default:
@@ -978,63 +798,53 @@ void i_dec(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     cpu->cycles += cycles;
 }
 
-void i_dex(CPU_t *cpu)
+CPU_OP_DEF(i_dex)(CPU_t *cpu)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.XB))
+    if (CPU_X8(cpu))
     {
         cpu->X = (cpu->X - 1) & 0xff;
-        cpu->P.N = cpu->X & 0x80 ? 1 : 0;
-        cpu->P.Z = cpu->X & 0xff ? 0 : 1;
+        _cpu_set_nz8(cpu, cpu->X);
     }
     else // 16-bit
     {
         cpu->X = (cpu->X - 1) & 0xffff;
-        cpu->P.N = cpu->X & 0x8000 ? 1 : 0;
-        cpu->P.Z = cpu->X ? 0 : 1;
+        _cpu_set_nz16(cpu, cpu->X);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_dey(CPU_t *cpu)
+CPU_OP_DEF(i_dey)(CPU_t *cpu)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.XB))
+    if (CPU_X8(cpu))
     {
         cpu->Y = (cpu->Y - 1) & 0xff;
-        cpu->P.N = cpu->Y & 0x80 ? 1 : 0;
-        cpu->P.Z = cpu->Y & 0xff ? 0 : 1;
+        _cpu_set_nz8(cpu, cpu->Y);
     }
     else // 16-bit
     {
         cpu->Y = (cpu->Y - 1) & 0xffff;
-        cpu->P.N = cpu->Y & 0x8000 ? 1 : 0;
-        cpu->P.Z = cpu->Y ? 0 : 1;
+        _cpu_set_nz16(cpu, cpu->Y);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_eor(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_eor)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) ^ _get_mem_byte(mem, addr, cpu->setacc));
+            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) ^ _get_mem_byte(mem, addr, CPU_SETACC(cpu)));
         }
         else // 16-bit
         {
-            cpu->C = cpu->C ^ _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-        }
-
-        // If DL != 0, add a cycle
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            cpu->C = cpu->C ^ _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_DPIND:
@@ -1042,55 +852,30 @@ void i_eor(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     case CPU_ADDR_DPINDX:
     case CPU_ADDR_INDDPY:
     case CPU_ADDR_INDDPLY:
-        // If DL != 0, add a cycle
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
-        }
-        /* Fallthrough */
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSX:
     case CPU_ADDR_ABSY:
     case CPU_ADDR_ABSL:
     case CPU_ADDR_ABSLX:
     case CPU_ADDR_SRINDY:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) ^ _get_mem_byte(mem, addr, cpu->setacc));
+            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) ^ _get_mem_byte(mem, addr, CPU_SETACC(cpu)));
         }
         else // 16-bit
         {
-            cpu->C = cpu->C ^ _get_mem_word(mem, addr, cpu->setacc);
-        }
-
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
-        }
-        else if (mode == CPU_ADDR_ABSY || mode == CPU_ADDR_INDDPY)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
+            cpu->C = cpu->C ^ _get_mem_word(mem, addr, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_IMMD:
     case CPU_ADDR_SR:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) ^ _get_mem_byte(mem, addr, cpu->setacc));
+            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) ^ _get_mem_byte(mem, addr, CPU_SETACC(cpu)));
         }
         else // 16-bit
         {
-            cpu->C = cpu->C ^ _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            cpu->C = cpu->C ^ _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
             if (mode == CPU_ADDR_IMMD) {
                 size += 1; // One extra byte in operand
             }
@@ -1100,94 +885,70 @@ void i_eor(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         _cpu_crash(cpu);
     }
 
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
-        cpu->P.N = (cpu->C & 0x80) ? 1 : 0;
-        cpu->P.Z = (cpu->C & 0xff) ? 0 : 1;
+        _cpu_set_nz8(cpu, cpu->C);
     }
     else // 16-bit
     {
-        cpu->P.N = (cpu->C & 0x8000) ? 1 : 0;
-        cpu->P.Z = cpu->C ? 0 : 1;
-        cpu->cycles += 1;
+        _cpu_set_nz16(cpu, cpu->C);
     }
     cpu->cycles += cycles;
     _cpu_update_pc(cpu, size);
 }
 
-void i_ina(CPU_t *cpu)
+CPU_OP_DEF(i_ina)(CPU_t *cpu)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M))
+    if (CPU_M8(cpu))
     {
         cpu->C = ((cpu->C + 1) & 0xff) | (cpu->C & 0xff00);
-        cpu->P.N = cpu->C & 0x80 ? 1 : 0;
-        cpu->P.Z = cpu->C & 0xff ? 0 : 1;
+        _cpu_set_nz8(cpu, cpu->C);
     }
     else // 16-bit
     {
         cpu->C = (cpu->C + 1) & 0xffff;
-        cpu->P.N = cpu->C & 0x8000 ? 1 : 0;
-        cpu->P.Z = cpu->C ? 0 : 1;
+        _cpu_set_nz16(cpu, cpu->C);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_inc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_inc)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            uint8_t val = _get_mem_byte(mem, addr, cpu->setacc) + 1;
-            _set_mem_byte(mem, addr, val, cpu->setacc);
-            cpu->P.N = val & 0x80 ? 1 : 0;
-            cpu->P.Z = val ? 0 : 1;
+            uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu)) + 1;
+            _set_mem_byte(mem, addr, val, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, val);
         }
         else // 16-bit
         {
             uint32_t addr_high = _addr_add_val_bank_wrap(addr, 1);
-            uint16_t val = _get_mem_byte(mem, addr, cpu->setacc);
-            val |= _get_mem_byte(mem, addr_high, cpu->setacc) << 8;
+            uint16_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            val |= _get_mem_byte(mem, addr_high, CPU_SETACC(cpu)) << 8;
             val += 1;
-            _set_mem_word_bank_wrap(mem, addr, val, cpu->setacc);
-            cpu->P.N = val & 0x8000 ? 1 : 0;
-            cpu->P.Z = val ? 0 : 1;
-            cpu->cycles += 2;
-        }
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            _set_mem_word_bank_wrap(mem, addr, val, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, val);
         }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSX:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            uint8_t val = _get_mem_byte(mem, addr, cpu->setacc) + 1;
-            _set_mem_byte(mem, addr, val, cpu->setacc);
-            cpu->P.N = val & 0x80 ? 1 : 0;
-            cpu->P.Z = val ? 0 : 1;
+            uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu)) + 1;
+            _set_mem_byte(mem, addr, val, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, val);
         }
         else // 16-bit
         {
-            uint16_t val = _get_mem_word(mem, addr, cpu->setacc) + 1;
-            _set_mem_word(mem, addr, val, cpu->setacc);
-            cpu->P.N = val & 0x8000 ? 1 : 0;
-            cpu->P.Z = val ? 0 : 1;
-            cpu->cycles += 2;
-        }
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
+            uint16_t val = _get_mem_word(mem, addr, CPU_SETACC(cpu)) + 1;
+            _set_mem_word(mem, addr, val, CPU_SETACC(cpu));
+            _cpu_set_nz16(cpu, val);
         }
         break;
     default:
@@ -1198,45 +959,41 @@ void i_inc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     cpu->cycles += cycles;
 }
 
-void i_inx(CPU_t *cpu)
+CPU_OP_DEF(i_inx)(CPU_t *cpu)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit
+    if (CPU_X8(cpu)) // 8-bit
     {
         cpu->X = (cpu->X + 1) & 0xff;
-        cpu->P.N = cpu->X & 0x80 ? 1 : 0;
-        cpu->P.Z = cpu->X & 0xff ? 0 : 1;
+        _cpu_set_nz8(cpu, cpu->X);
     }
     else // 16-bit
     {
         cpu->X = (cpu->X + 1) & 0xffff;
-        cpu->P.N = cpu->X & 0x8000 ? 1 : 0;
-        cpu->P.Z = cpu->X ? 0 : 1;
+        _cpu_set_nz16(cpu, cpu->X);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_iny(CPU_t *cpu)
+CPU_OP_DEF(i_iny)(CPU_t *cpu)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit
+    if (CPU_X8(cpu)) // 8-bit
     {
         cpu->Y = (cpu->Y + 1) & 0xff;
-        cpu->P.N = cpu->Y & 0x80 ? 1 : 0;
-        cpu->P.Z = cpu->Y & 0xff ? 0 : 1;
+        _cpu_set_nz8(cpu, cpu->Y);
     }
     else // 16-bit
     {
         cpu->Y = (cpu->Y + 1) & 0xffff;
-        cpu->P.N = cpu->Y & 0x8000 ? 1 : 0;
-        cpu->P.Z = cpu->Y ? 0 : 1;
+        _cpu_set_nz16(cpu, cpu->Y);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_jmp(CPU_t *cpu, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_jmp)(CPU_t *cpu, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     if (mode == CPU_ADDR_ABSL)
     {
@@ -1246,31 +1003,31 @@ void i_jmp(CPU_t *cpu, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
     cpu->cycles += cycles;
 }
 
-void i_jsr(CPU_t *cpu, memory_t *mem, uint8_t cycles, uint32_t addr)
+CPU_OP_DEF(i_jsr)(CPU_t *cpu, memory_t *mem, uint8_t cycles, uint32_t addr)
 {
     _stackCPU_pushWord(
         cpu,
         mem,
         _addr_add_val_bank_wrap(cpu->PC, 2),
         CPU_ESTACK_ENABLE,
-        cpu->setacc
+        CPU_SETACC(cpu)
         );
     cpu->PC = addr;
     cpu->cycles += cycles;
 }
 
-void i_jsl(CPU_t *cpu, memory_t *mem, uint8_t cycles, uint32_t addr)
+CPU_OP_DEF(i_jsl)(CPU_t *cpu, memory_t *mem, uint8_t cycles, uint32_t addr)
 {
     uint32_t ret_addr = _addr_add_val_bank_wrap(_cpu_get_effective_pc(cpu), 3);
-    _stackCPU_push24(cpu, mem, ret_addr, cpu->setacc);
+    _stackCPU_push24(cpu, mem, ret_addr, CPU_SETACC(cpu));
     cpu->PBR = (addr >> 16) & 0xff;
     cpu->PC = addr & 0xffff;
     cpu->cycles += cycles;
 }
 
-void i_lda(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_lda)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
-    if (mode == CPU_ADDR_IMMD && !cpu->P.E && !cpu->P.M) // 16-bit immediate, add a byte
+    if (mode == CPU_ADDR_IMMD && !CPU_M8(cpu)) // 16-bit immediate, add a byte
     {
         size += 1;
     }
@@ -1279,20 +1036,15 @@ void i_lda(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
-        }
-        /* Fallthrough! */
     case CPU_ADDR_IMMD:
     case CPU_ADDR_SR:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M))
+        if (CPU_M8(cpu))
         {
-            cpu->C = (cpu->C & 0xff00) | _get_mem_byte(mem, addr, cpu->setacc);
+            cpu->C = (cpu->C & 0xff00) | _get_mem_byte(mem, addr, CPU_SETACC(cpu));
         }
         else
         {
-            cpu->C = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            cpu->C = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
         }
         break;
 
@@ -1301,43 +1053,19 @@ void i_lda(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     case CPU_ADDR_DPINDL:
     case CPU_ADDR_DPINDX:
     case CPU_ADDR_INDDPLY:
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
-        }
-        /* Fallthrough! */
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSL:
     case CPU_ADDR_ABSLX:
     case CPU_ADDR_SRINDY:
     case CPU_ADDR_ABSX:
     case CPU_ADDR_ABSY:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M))
+        if (CPU_M8(cpu))
         {
-            cpu->C = (cpu->C & 0xff00) | _get_mem_byte(mem, addr, cpu->setacc);
+            cpu->C = (cpu->C & 0xff00) | _get_mem_byte(mem, addr, CPU_SETACC(cpu));
         }
         else
         {
-            cpu->C = _get_mem_word(mem, addr, cpu->setacc);
-        }
-        
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
-        }
-        else if (mode == CPU_ADDR_ABSY || mode == CPU_ADDR_INDDPY)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
+            cpu->C = _get_mem_word(mem, addr, CPU_SETACC(cpu));
         }
         break;
     default:
@@ -1345,23 +1073,20 @@ void i_lda(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         break;
     }
 
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M))
+    if (CPU_M8(cpu))
     {
-        cpu->P.Z = ((cpu->C & 0xff) == 0);
-        cpu->P.N = ((cpu->C & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->C);
     }
     else // 16-bit
     {
-        cpu->P.Z = (cpu->C == 0);
-        cpu->P.N = ((cpu->C & 0x8000) == 0x8000);
-        cpu->cycles += 1;
+        _cpu_set_nz16(cpu, cpu->C);
     }
 
     _cpu_update_pc(cpu, size);
     cpu->cycles += cycles;
 }
 
-void i_ldx(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_ldx)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
@@ -1369,85 +1094,62 @@ void i_ldx(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     case CPU_ADDR_DPY:
         if (cpu->P.E)
         {
-            cpu->X = _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.Z = ((cpu->X & 0xff) == 0);
-            cpu->P.N = ((cpu->X & 0x80) == 0x80);
+            cpu->X = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, cpu->X);
         }
         else
         {
             if (cpu->P.XB)
             {
-                cpu->X = _get_mem_byte(mem, addr, cpu->setacc);
-                cpu->P.Z = ((cpu->X & 0xff) == 0);
-                cpu->P.N = ((cpu->X & 0x80) == 0x80);
+                cpu->X = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz8(cpu, cpu->X);
             }
             else
             {
-                cpu->X = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-                cpu->P.Z = (cpu->X == 0);
-                cpu->P.N = ((cpu->X & 0x8000) == 0x8000);
-                cpu->cycles += 1;
+                cpu->X = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz16(cpu, cpu->X);
             }
         }
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
-        }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSY:
         if (cpu->P.E)
         {
-            cpu->X = _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.Z = ((cpu->X & 0xff) == 0);
-            cpu->P.N = ((cpu->X & 0x80) == 0x80);
+            cpu->X = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, cpu->X);
         }
         else
         {
             if (cpu->P.XB)
             {
-                cpu->X = _get_mem_byte(mem, addr, cpu->setacc);
-                cpu->P.Z = ((cpu->X & 0xff) == 0);
-                cpu->P.N = ((cpu->X & 0x80) == 0x80);
+                cpu->X = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz8(cpu, cpu->X);
             }
             else
             {
-                cpu->X = _get_mem_word(mem, addr, cpu->setacc);
-                cpu->P.Z = (cpu->X == 0);
-                cpu->P.N = ((cpu->X & 0x8000) == 0x8000);
-                cpu->cycles += 1;
+                cpu->X = _get_mem_word(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz16(cpu, cpu->X);
             }
         }
-
-        // Check if index crosses a page boundary
-        if ((addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00) ||
-            (!cpu->P.E && !cpu->P.XB))
-        {
-            cpu->cycles += 1;
-        }
         break;
     case CPU_ADDR_IMMD:
         if (cpu->P.E)
         {
-            cpu->X = _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.Z = ((cpu->X & 0xff) == 0);
-            cpu->P.N = ((cpu->X & 0x80) == 0x80);
+            cpu->X = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, cpu->X);
         }
         else
         {
             if (cpu->P.XB)
             {
-                cpu->X = _get_mem_byte(mem, addr, cpu->setacc);
-                cpu->P.Z = ((cpu->X & 0xff) == 0);
-                cpu->P.N = ((cpu->X & 0x80) == 0x80);
+                cpu->X = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz8(cpu, cpu->X);
             }
             else
             {
-                cpu->X = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-                cpu->P.Z = (cpu->X == 0);
-                cpu->P.N = ((cpu->X & 0x8000) == 0x8000);
+                cpu->X = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz16(cpu, cpu->X);
                 size += 1;
-                cpu->cycles += 1;
             }
         }
         break;
@@ -1458,7 +1160,7 @@ void i_ldx(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     _cpu_update_pc(cpu, size);
 }
 
-void i_ldy(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_ldy)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
@@ -1466,85 +1168,62 @@ void i_ldy(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     case CPU_ADDR_DPX:
         if (cpu->P.E)
         {
-            cpu->Y = _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.Z = ((cpu->Y & 0xff) == 0);
-            cpu->P.N = ((cpu->Y & 0x80) == 0x80);
+            cpu->Y = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, cpu->Y);
         }
         else
         {
             if (cpu->P.XB)
             {
-                cpu->Y = _get_mem_byte(mem, addr, cpu->setacc);
-                cpu->P.Z = ((cpu->Y & 0xff) == 0);
-                cpu->P.N = ((cpu->Y & 0x80) == 0x80);
+                cpu->Y = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz8(cpu, cpu->Y);
             }
             else
             {
-                cpu->Y = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-                cpu->P.Z = (cpu->Y == 0);
-                cpu->P.N = ((cpu->Y & 0x8000) == 0x8000);
-                cpu->cycles += 1;
+                cpu->Y = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz16(cpu, cpu->Y);
             }
         }
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
-        }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSX:
         if (cpu->P.E)
         {
-            cpu->Y = _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.Z = ((cpu->Y & 0xff) == 0);
-            cpu->P.N = ((cpu->Y & 0x80) == 0x80);
+            cpu->Y = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, cpu->Y);
         }
         else
         {
             if (cpu->P.XB)
             {
-                cpu->Y = _get_mem_byte(mem, addr, cpu->setacc);
-                cpu->P.Z = ((cpu->Y & 0xff) == 0);
-                cpu->P.N = ((cpu->Y & 0x80) == 0x80);
+                cpu->Y = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz8(cpu, cpu->Y);
             }
             else
             {
-                cpu->Y = _get_mem_word(mem, addr, cpu->setacc);
-                cpu->P.Z = (cpu->Y == 0);
-                cpu->P.N = ((cpu->Y & 0x8000) == 0x8000);
-                cpu->cycles += 1;
+                cpu->Y = _get_mem_word(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz16(cpu, cpu->Y);
             }
         }
-
-        // Check if index crosses a page boundary
-        if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-            (!cpu->P.E && !cpu->P.XB))
-        {
-            cpu->cycles += 1;
-        }
         break;
     case CPU_ADDR_IMMD:
         if (cpu->P.E)
         {
-            cpu->Y = _get_mem_byte(mem, addr, cpu->setacc);
-            cpu->P.Z = ((cpu->Y & 0xff) == 0);
-            cpu->P.N = ((cpu->Y & 0x80) == 0x80);
+            cpu->Y = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+            _cpu_set_nz8(cpu, cpu->Y);
         }
         else
         {
             if (cpu->P.XB)
             {
-                cpu->Y = _get_mem_byte(mem, addr, cpu->setacc);
-                cpu->P.Z = ((cpu->Y & 0xff) == 0);
-                cpu->P.N = ((cpu->Y & 0x80) == 0x80);
+                cpu->Y = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz8(cpu, cpu->Y);
             }
             else
             {
-                cpu->Y =  _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-                cpu->P.Z = (cpu->Y == 0);
-                cpu->P.N = ((cpu->Y & 0x8000) == 0x8000);
+                cpu->Y =  _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
+                _cpu_set_nz16(cpu, cpu->Y);
                 size += 1;
-                cpu->cycles += 1;
             }
         }
         break;
@@ -1555,7 +1234,7 @@ void i_ldy(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     _cpu_update_pc(cpu, size);
 }
 
-void i_lsr(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_lsr)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     uint16_t post_data = 0;
     uint16_t pre_data = 0;
@@ -1563,46 +1242,38 @@ void i_lsr(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        pre_data = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+        pre_data = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data >> 1) & 0x7f);
-            _set_mem_byte(mem, addr, (uint8_t)post_data, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)post_data, CPU_SETACC(cpu));
         }
         else // 16-bit
         {
             post_data = pre_data >> 1;
-            _set_mem_word_bank_wrap(mem, addr, post_data, cpu->setacc);
-            cpu->cycles += 2;
-        }
-
-        // If DL != 0, add a cycle
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            _set_mem_word_bank_wrap(mem, addr, post_data, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSX:
-        pre_data = _get_mem_word(mem, addr, cpu->setacc);
+        pre_data = _get_mem_word(mem, addr, CPU_SETACC(cpu));
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data >> 1) & 0x7f);
-            _set_mem_byte(mem, addr, (uint8_t)post_data, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)post_data, CPU_SETACC(cpu));
         }
         else // 16-bit
         {
             post_data = pre_data >> 1;
-            _set_mem_word(mem, addr, post_data, cpu->setacc);
-            cpu->cycles += 2;
+            _set_mem_word(mem, addr, post_data, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_IMPD:
         pre_data = cpu->C;
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data >> 1) & 0x7f);
             cpu->C = (cpu->C & 0xff00) | post_data;
@@ -1618,38 +1289,36 @@ void i_lsr(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         break;
     }
 
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
         cpu->P.C = (pre_data & 0x01) ? 1 : 0;
-        cpu->P.N = 0;
-        cpu->P.Z = (post_data & 0xff) ? 0 : 1;
+        _cpu_set_nz8(cpu, post_data); // N is always clear
     }
     else // 16-bit
     {
         cpu->P.C = (pre_data & 0x0001) ? 1 : 0;
-        cpu->P.N = 0;
-        cpu->P.Z = post_data ? 0 : 1;
+        _cpu_set_nz16(cpu, post_data); // N is always clear
     }
 
     cpu->cycles += cycles;
     _cpu_update_pc(cpu, size);
 }
 
-void i_mvn(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_mvn)(CPU_t *cpu, memory_t *mem)
 {
-    uint32_t operand_addr = _addrCPU_getImmediate(cpu, mem, cpu->setacc);
+    uint32_t operand_addr = _addrCPU_getImmediate(cpu, mem, CPU_SETACC(cpu));
 
     // Read operands to get banks
-    uint8_t dst_bank = _get_mem_byte(mem, operand_addr, cpu->setacc);
-    uint8_t src_bank = _get_mem_byte(mem, _addr_add_val_bank_wrap(operand_addr, 1), cpu->setacc);
+    uint8_t dst_bank = _get_mem_byte(mem, operand_addr, CPU_SETACC(cpu));
+    uint8_t src_bank = _get_mem_byte(mem, _addr_add_val_bank_wrap(operand_addr, 1), CPU_SETACC(cpu));
 
     // Calculate full addresses
     uint32_t dst_addr = (dst_bank << 16) | cpu->Y;
     uint32_t src_addr = (src_bank << 16) | cpu->X;
 
     // Perform copy
-    uint8_t tmp = _get_mem_byte(mem, src_addr, cpu->setacc);
-    _set_mem_byte(mem, dst_addr, tmp, cpu->setacc);
+    uint8_t tmp = _get_mem_byte(mem, src_addr, CPU_SETACC(cpu));
+    _set_mem_byte(mem, dst_addr, tmp, CPU_SETACC(cpu));
 
     // Update regs for next byte
     cpu->Y += 1;
@@ -1667,21 +1336,21 @@ void i_mvn(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 7; // 7 cycles per byte moved
 }
 
-void i_mvp(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_mvp)(CPU_t *cpu, memory_t *mem)
 {
-    uint32_t operand_addr = _addrCPU_getImmediate(cpu, mem, cpu->setacc);
+    uint32_t operand_addr = _addrCPU_getImmediate(cpu, mem, CPU_SETACC(cpu));
 
     // Read operands to get banks
-    uint8_t dst_bank = _get_mem_byte(mem, operand_addr, cpu->setacc);
-    uint8_t src_bank = _get_mem_byte(mem, _addr_add_val_bank_wrap(operand_addr, 1), cpu->setacc);
+    uint8_t dst_bank = _get_mem_byte(mem, operand_addr, CPU_SETACC(cpu));
+    uint8_t src_bank = _get_mem_byte(mem, _addr_add_val_bank_wrap(operand_addr, 1), CPU_SETACC(cpu));
 
     // Calculate full addresses
     uint32_t dst_addr = (dst_bank << 16) | cpu->Y;
     uint32_t src_addr = (src_bank << 16) | cpu->X;
 
     // Perform copy
-    uint8_t tmp = _get_mem_byte(mem, src_addr, cpu->setacc);
-    _set_mem_byte(mem, dst_addr, tmp, cpu->setacc);
+    uint8_t tmp = _get_mem_byte(mem, src_addr, CPU_SETACC(cpu));
+    _set_mem_byte(mem, dst_addr, tmp, CPU_SETACC(cpu));
 
     // Update regs for next byte
     cpu->Y -= 1;
@@ -1699,31 +1368,25 @@ void i_mvp(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 7; // 7 cycles per byte moved
 }
 
-void i_nop(CPU_t *cpu)
+CPU_OP_DEF(i_nop)(CPU_t *cpu)
 {
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_ora(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_ora)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) | _get_mem_byte(mem, addr, cpu->setacc));
+            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) | _get_mem_byte(mem, addr, CPU_SETACC(cpu)));
         }
         else // 16-bit
         {
-            cpu->C = cpu->C | _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
-        }
-
-        // If DL != 0, add a cycle
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            cpu->C = cpu->C | _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_DPIND:
@@ -1737,53 +1400,24 @@ void i_ora(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     case CPU_ADDR_INDDPY:
     case CPU_ADDR_INDDPLY:
     case CPU_ADDR_SRINDY:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) | _get_mem_byte(mem, addr, cpu->setacc));
+            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) | _get_mem_byte(mem, addr, CPU_SETACC(cpu)));
         }
         else // 16-bit
         {
-            cpu->C = cpu->C | _get_mem_word(mem, addr, cpu->setacc);
-        }
-
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
-        }
-        else if (mode == CPU_ADDR_ABSY || mode == CPU_ADDR_INDDPY)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
-        }
-        if (mode == CPU_ADDR_DPIND || mode == CPU_ADDR_DPINDL ||
-            mode == CPU_ADDR_DPINDX || mode == CPU_ADDR_INDDPY ||
-            mode == CPU_ADDR_INDDPLY)
-        {
-            // If DL != 0, add a cycle
-            if (cpu->D & 0xff)
-            {
-                cpu->cycles += 1;
-            }
+            cpu->C = cpu->C | _get_mem_word(mem, addr, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_IMMD:
     case CPU_ADDR_SR:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
-            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) | _get_mem_byte(mem, addr, cpu->setacc));
+            cpu->C = (cpu->C & 0xff00) | ((cpu->C & 0xff) | _get_mem_byte(mem, addr, CPU_SETACC(cpu)));
         }
         else // 16-bit
         {
-            cpu->C = cpu->C | _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            cpu->C = cpu->C | _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
             if (mode == CPU_ADDR_IMMD) {
                 size += 1; // One extra byte in operand
             }
@@ -1793,43 +1427,40 @@ void i_ora(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         _cpu_crash(cpu);
     }
 
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
-        cpu->P.N = (cpu->C & 0x80) ? 1 : 0;
-        cpu->P.Z = (cpu->C & 0xff) ? 0 : 1;
+        _cpu_set_nz8(cpu, cpu->C);
     }
     else // 16-bit
     {
-        cpu->P.N = (cpu->C & 0x8000) ? 1 : 0;
-        cpu->P.Z = cpu->C ? 0 : 1;
-        cpu->cycles += 1;
+        _cpu_set_nz16(cpu, cpu->C);
     }
     cpu->cycles += cycles;
     _cpu_update_pc(cpu, size);
 }
 
-void i_pea(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_pea)(CPU_t *cpu, memory_t *mem)
 {
     _stackCPU_pushWord(
         cpu,
         mem,
-        _cpu_get_immd_word(cpu, mem, cpu->setacc),
+        _cpu_get_immd_word(cpu, mem, CPU_SETACC(cpu)),
         CPU_ESTACK_DISABLE,
-        cpu->setacc
+        CPU_SETACC(cpu)
         );
     cpu->cycles += 5;
     _cpu_update_pc(cpu, 3);
 }
 
-void i_pei(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_pei)(CPU_t *cpu, memory_t *mem)
 {
     uint32_t addr_dp = _addr_add_val_bank_wrap(
         (cpu->D & 0xffff),
-        _cpu_get_immd_byte(cpu, mem, cpu->setacc)
+        _cpu_get_immd_byte(cpu, mem, CPU_SETACC(cpu))
         );
-    uint16_t addr_ind = _get_mem_byte(mem, addr_dp, cpu->setacc);
-    addr_ind |= _get_mem_byte(mem, _addr_add_val_bank_wrap(addr_dp, 1), cpu->setacc) << 8;
-    _stackCPU_pushWord(cpu, mem, addr_ind, CPU_ESTACK_DISABLE, cpu->setacc);
+    uint16_t addr_ind = _get_mem_byte(mem, addr_dp, CPU_SETACC(cpu));
+    addr_ind |= _get_mem_byte(mem, _addr_add_val_bank_wrap(addr_dp, 1), CPU_SETACC(cpu)) << 8;
+    _stackCPU_pushWord(cpu, mem, addr_ind, CPU_ESTACK_DISABLE, CPU_SETACC(cpu));
 
     _cpu_update_pc(cpu, 2);
     cpu->cycles += 6;
@@ -1839,140 +1470,136 @@ void i_pei(CPU_t *cpu, memory_t *mem)
     }
 }
 
-void i_per(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_per)(CPU_t *cpu, memory_t *mem)
 {
-    int16_t displacement = _cpu_get_immd_word(cpu, mem, cpu->setacc);
+    int16_t displacement = _cpu_get_immd_word(cpu, mem, CPU_SETACC(cpu));
     _cpu_update_pc(cpu, 3);
     _stackCPU_pushWord(
         cpu,
         mem,
         _addr_add_val_bank_wrap(cpu->PC, displacement),
         CPU_ESTACK_DISABLE,
-        cpu->setacc
+        CPU_SETACC(cpu)
         );
 
     cpu->cycles += 6;
 }
 
-void i_pha(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_pha)(CPU_t *cpu, memory_t *mem)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit A
+    if (CPU_M8(cpu)) // 8-bit A
     {
-        _stackCPU_pushByte(cpu, mem, cpu->C, cpu->setacc);
+        _stackCPU_pushByte(cpu, mem, cpu->C, CPU_SETACC(cpu));
         cpu->cycles += 3;
     }
     else // 16-bit A
     {
-        _stackCPU_pushWord(cpu, mem, cpu->C, CPU_ESTACK_ENABLE, cpu->setacc);
+        _stackCPU_pushWord(cpu, mem, cpu->C, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 4;
     }
 
     _cpu_update_pc(cpu, 1);
 }
 
-void i_phb(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_phb)(CPU_t *cpu, memory_t *mem)
 {
-    _stackCPU_pushByte(cpu, mem, cpu->DBR, cpu->setacc);
+    _stackCPU_pushByte(cpu, mem, cpu->DBR, CPU_SETACC(cpu));
     cpu->cycles += 3;
     _cpu_update_pc(cpu, 1);
 }
 
-void i_phk(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_phk)(CPU_t *cpu, memory_t *mem)
 {
-    _stackCPU_pushByte(cpu, mem, cpu->PBR, cpu->setacc);
+    _stackCPU_pushByte(cpu, mem, cpu->PBR, CPU_SETACC(cpu));
     cpu->cycles += 3;
     _cpu_update_pc(cpu, 1);
 }
 
-void i_phd(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_phd)(CPU_t *cpu, memory_t *mem)
 {
-    _stackCPU_pushWord(cpu, mem, cpu->D, CPU_ESTACK_DISABLE, cpu->setacc);
+    _stackCPU_pushWord(cpu, mem, cpu->D, CPU_ESTACK_DISABLE, CPU_SETACC(cpu));
     cpu->cycles += 4;
     _cpu_update_pc(cpu, 1);
 }
 
-void i_php(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_php)(CPU_t *cpu, memory_t *mem)
 {
-    _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu), cpu->setacc);
+    _stackCPU_pushByte(cpu, mem, _cpu_get_sr(cpu), CPU_SETACC(cpu));
     cpu->cycles += 3;
     _cpu_update_pc(cpu, 1);
 }
 
-void i_phx(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_phx)(CPU_t *cpu, memory_t *mem)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit X
+    if (CPU_X8(cpu)) // 8-bit X
     {
-        _stackCPU_pushByte(cpu, mem, cpu->X, cpu->setacc);
+        _stackCPU_pushByte(cpu, mem, cpu->X, CPU_SETACC(cpu));
         cpu->cycles += 3;
     }
     else // 16-bit X
     {
-        _stackCPU_pushWord(cpu, mem, cpu->X, CPU_ESTACK_ENABLE, cpu->setacc);
+        _stackCPU_pushWord(cpu, mem, cpu->X, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 4;
     }
 
     _cpu_update_pc(cpu, 1);
 }
 
-void i_phy(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_phy)(CPU_t *cpu, memory_t *mem)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit X
+    if (CPU_X8(cpu)) // 8-bit X
     {
-        _stackCPU_pushByte(cpu, mem, cpu->Y, cpu->setacc);
+        _stackCPU_pushByte(cpu, mem, cpu->Y, CPU_SETACC(cpu));
         cpu->cycles += 3;
     }
     else // 16-bit X
     {
-        _stackCPU_pushWord(cpu, mem, cpu->Y, CPU_ESTACK_ENABLE, cpu->setacc);
+        _stackCPU_pushWord(cpu, mem, cpu->Y, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 4;
     }
 
     _cpu_update_pc(cpu, 1);
 }
 
-void i_pla(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_pla)(CPU_t *cpu, memory_t *mem)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit A
+    if (CPU_M8(cpu)) // 8-bit A
     {
-        cpu->C = (cpu->C & 0xff00) | _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc);
+        cpu->C = (cpu->C & 0xff00) | _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 4;
-        cpu->P.Z = ((cpu->C & 0xff) == 0);
-        cpu->P.N = ((cpu->C & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->C);
     }
     else // 16-bit A
     {
-        cpu->C = _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc);
+        cpu->C = _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 5;
-        cpu->P.Z = (cpu->C == 0);
-        cpu->P.N = ((cpu->C & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->C);
     }
 
     _cpu_update_pc(cpu, 1);
 }
 
-void i_plb(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_plb)(CPU_t *cpu, memory_t *mem)
 {
-    cpu->DBR = _stackCPU_popByte(cpu, mem, CPU_ESTACK_DISABLE, cpu->setacc);
+    cpu->DBR = _stackCPU_popByte(cpu, mem, CPU_ESTACK_DISABLE, CPU_SETACC(cpu));
     cpu->cycles += 4;
-    cpu->P.Z = (cpu->DBR == 0);
-    cpu->P.N = ((cpu->DBR & 0x80) == 0x80);
+    _cpu_set_nz8(cpu, cpu->DBR);
 
     _cpu_update_pc(cpu, 1);
 }
 
-void i_pld(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_pld)(CPU_t *cpu, memory_t *mem)
 {
-    cpu->D = _stackCPU_popWord(cpu, mem, CPU_ESTACK_DISABLE, cpu->setacc);
+    cpu->D = _stackCPU_popWord(cpu, mem, CPU_ESTACK_DISABLE, CPU_SETACC(cpu));
     cpu->cycles += 5;
-    cpu->P.Z = (cpu->D == 0);
-    cpu->P.N = ((cpu->D & 0x8000) == 0x8000);
+    _cpu_set_nz16(cpu, cpu->D);
 
     _cpu_update_pc(cpu, 1);
 }
 
-void i_plp(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_plp)(CPU_t *cpu, memory_t *mem)
 {
-    uint8_t val = _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc);
+    uint8_t val = _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
     if (cpu->P.E)
     {
         _cpu_set_sr(cpu, 0x30 | val); // M and XB are forced to 1 <= http://6502.org/tutorials/65c816opcodes.html#6.8.3
@@ -1992,51 +1619,47 @@ void i_plp(CPU_t *cpu, memory_t *mem)
     _cpu_update_pc(cpu, 1);
 }
 
-void i_plx(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_plx)(CPU_t *cpu, memory_t *mem)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit X
+    if (CPU_X8(cpu)) // 8-bit X
     {
-        cpu->X = _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc);
+        cpu->X = _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 4;
-        cpu->P.Z = ((cpu->X & 0xff) == 0);
-        cpu->P.N = ((cpu->X & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->X);
     }
     else // 16-bit X
     {
 
-        cpu->X = _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc);
+        cpu->X = _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 5;
-        cpu->P.Z = (cpu->X == 0);
-        cpu->P.N = ((cpu->X & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->X);
     }
 
     _cpu_update_pc(cpu, 1);
 }
 
-void i_ply(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_ply)(CPU_t *cpu, memory_t *mem)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.XB)) // 8-bit X
+    if (CPU_X8(cpu)) // 8-bit X
     {
-        cpu->Y = _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc);
+        cpu->Y = _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 4;
-        cpu->P.Z = ((cpu->Y & 0xff) == 0);
-        cpu->P.N = ((cpu->Y & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->Y);
     }
     else // 16-bit X
     {
-        cpu->Y = _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc);
+        cpu->Y = _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 5;
-        cpu->P.Z = (cpu->Y == 0);
-        cpu->P.N = ((cpu->Y & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->Y);
     }
 
     _cpu_update_pc(cpu, 1);
 }
 
-void i_rep(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_rep)(CPU_t *cpu, memory_t *mem)
 {
     uint8_t sr = _cpu_get_sr(cpu);
-    uint8_t val = _cpu_get_immd_byte(cpu, mem, cpu->setacc);
+    uint8_t val = _cpu_get_immd_byte(cpu, mem, CPU_SETACC(cpu));
 
     if (cpu->P.E)
     {
@@ -2057,7 +1680,7 @@ void i_rep(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 3;
 }
 
-void i_rol(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_rol)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     uint16_t post_data = 0;
     uint16_t pre_data = 0;
@@ -2065,46 +1688,38 @@ void i_rol(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        pre_data = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+        pre_data = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data << 1) & 0xff) | cpu->P.C;
-            _set_mem_byte(mem, addr, (uint8_t)post_data, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)post_data, CPU_SETACC(cpu));
         }
         else // 16-bit
         {
             post_data = (pre_data << 1) | cpu->P.C;
-            _set_mem_word_bank_wrap(mem, addr, post_data, cpu->setacc);
-            cpu->cycles += 2;
-        }
-
-        // If DL != 0, add a cycle
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            _set_mem_word_bank_wrap(mem, addr, post_data, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSX:
-        pre_data = _get_mem_word(mem, addr, cpu->setacc);
+        pre_data = _get_mem_word(mem, addr, CPU_SETACC(cpu));
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data << 1) & 0xff) | cpu->P.C;
-            _set_mem_byte(mem, addr, (uint8_t)post_data, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)post_data, CPU_SETACC(cpu));
         }
         else // 16-bit
         {
             post_data = (pre_data << 1) | cpu->P.C;
-            _set_mem_word(mem, addr, post_data, cpu->setacc);
-            cpu->cycles += 2;
+            _set_mem_word(mem, addr, post_data, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_IMPD:
         pre_data = cpu->C;
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data << 1) & 0xff) | cpu->P.C;
             cpu->C = (cpu->C & 0xff00) | post_data;
@@ -2120,24 +1735,22 @@ void i_rol(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         break;
     }
 
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
         cpu->P.C = (pre_data & 0x80) ? 1 : 0;
-        cpu->P.N = (post_data & 0x80) ? 1 : 0;
-        cpu->P.Z = (post_data & 0xff) ? 0 : 1;
+        _cpu_set_nz8(cpu, post_data);
     }
     else // 16-bit
     {
         cpu->P.C = (pre_data & 0x8000) ? 1 : 0;
-        cpu->P.N = (post_data & 0x8000) ? 1 : 0;
-        cpu->P.Z = post_data ? 0 : 1;
+        _cpu_set_nz16(cpu, post_data);
     }
 
     cpu->cycles += cycles;
     _cpu_update_pc(cpu, size);
 }
 
-void i_ror(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_ror)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     uint16_t post_data = 0;
     uint16_t pre_data = 0;
@@ -2145,46 +1758,38 @@ void i_ror(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        pre_data = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+        pre_data = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data >> 1) & 0x7f) | (cpu->P.C << 7);
-            _set_mem_byte(mem, addr, (uint8_t)post_data, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)post_data, CPU_SETACC(cpu));
         }
         else // 16-bit
         {
             post_data = (pre_data >> 1) | (cpu->P.C << 15);
-            _set_mem_word_bank_wrap(mem, addr, post_data, cpu->setacc);
-            cpu->cycles += 2;
-        }
-
-        // If DL != 0, add a cycle
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            _set_mem_word_bank_wrap(mem, addr, post_data, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSX:
-        pre_data = _get_mem_word(mem, addr, cpu->setacc);
+        pre_data = _get_mem_word(mem, addr, CPU_SETACC(cpu));
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data >> 1) & 0x7f) | (cpu->P.C << 7);
-            _set_mem_byte(mem, addr, (uint8_t)post_data, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)post_data, CPU_SETACC(cpu));
         }
         else // 16-bit
         {
             post_data = (pre_data >> 1) | (cpu->P.C << 15);
-            _set_mem_word(mem, addr, post_data, cpu->setacc);
-            cpu->cycles += 2;
+            _set_mem_word(mem, addr, post_data, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_IMPD:
         pre_data = cpu->C;
 
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+        if (CPU_M8(cpu)) // 8-bit
         {
             post_data = ((pre_data >> 1) & 0x7f) | (cpu->P.C << 7);
             cpu->C = (cpu->C & 0xff00) | post_data;
@@ -2200,32 +1805,30 @@ void i_ror(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         break;
     }
 
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
         cpu->P.C = (pre_data & 0x01) ? 1 : 0;
-        cpu->P.N = (post_data & 0x80) ? 1 : 0;
-        cpu->P.Z = (post_data & 0xff) ? 0 : 1;
+        _cpu_set_nz8(cpu, post_data);
     }
     else // 16-bit
     {
         cpu->P.C = (pre_data & 0x0001) ? 1 : 0;
-        cpu->P.N = (post_data & 0x8000) ? 1 : 0;
-        cpu->P.Z = post_data ? 0 : 1;
+        _cpu_set_nz16(cpu, post_data);
     }
 
     cpu->cycles += cycles;
     _cpu_update_pc(cpu, size);
 }
 
-void i_rti(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_rti)(CPU_t *cpu, memory_t *mem)
 {
     uint8_t sr = _cpu_get_sr(cpu);
-    uint8_t val = _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc);
+    uint8_t val = _stackCPU_popByte(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
 
     if (cpu->P.E)
     {
         _cpu_set_sr(cpu, (sr & 0x30) | (val & 0xcf)); // Bits 4 and 5 are unaffected by operation in emulation mode
-        cpu->PC = _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc);
+        cpu->PC = _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu));
         cpu->cycles += 6;
     }
     else
@@ -2238,33 +1841,33 @@ void i_rti(CPU_t *cpu, memory_t *mem)
             cpu->Y &= 0xff;
         }
         
-        uint32_t data = _stackCPU_pop24(cpu, mem, cpu->setacc);
+        uint32_t data = _stackCPU_pop24(cpu, mem, CPU_SETACC(cpu));
         cpu->PBR = (data & 0xff0000) >> 16;
         cpu->PC = data & 0xffff;
         cpu->cycles += 7;
     }
 }
 
-void i_rtl(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_rtl)(CPU_t *cpu, memory_t *mem)
 {
-    uint32_t addr = _stackCPU_pop24(cpu, mem, cpu->setacc);
+    uint32_t addr = _stackCPU_pop24(cpu, mem, CPU_SETACC(cpu));
     cpu->PC = _addr_add_val_bank_wrap(addr & 0xffff, 1);
     cpu->PBR = (addr >> 16) & 0xff;
     cpu->cycles += 6;
 }
 
-void i_rts(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_rts)(CPU_t *cpu, memory_t *mem)
 {
     cpu->PC = _addr_add_val_bank_wrap(
-        _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, cpu->setacc), 1);
+        _stackCPU_popWord(cpu, mem, CPU_ESTACK_ENABLE, CPU_SETACC(cpu)), 1);
     cpu->cycles += 6;
 }
 
-void i_sbc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_sbc)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
-        uint8_t val = _get_mem_byte(mem, addr, cpu->setacc);
+        uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
         uint16_t al, alb;
 
         // Binary mode calculation
@@ -2295,8 +1898,7 @@ void i_sbc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
 
         // Update flags
         cpu->C = (cpu->C & 0xff00) | (al & 0xff);
-        cpu->P.N = (al & 0x80) ? 1 : 0;
-        cpu->P.Z = ((al & 0xff) == 0) ? 1 : 0;
+        _cpu_set_nz8(cpu, al);
 
         // C and V are based on the binary result
         cpu->P.V = ((int16_t)alb < -128 || (int16_t)alb > 127) ? 1 : 0;
@@ -2311,11 +1913,11 @@ void i_sbc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         if (mode == CPU_ADDR_DP || mode == CPU_ADDR_DPX ||
             mode == CPU_ADDR_IMMD || mode == CPU_ADDR_SR)
         {
-            val = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            val = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
         }
         else
         {
-            val = _get_mem_word(mem, addr, cpu->setacc);
+            val = _get_mem_word(mem, addr, CPU_SETACC(cpu));
         }
 
         // Binary arithmetic value
@@ -2360,78 +1962,47 @@ void i_sbc(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
 
         // Update flags
         cpu->C = al & 0xffff;
-        cpu->P.N = (al & 0x8000) ? 1 : 0;
-        cpu->P.Z = ((al & 0xffff) == 0) ? 1 : 0;
+        _cpu_set_nz16(cpu, al);
 
         // C and V are based on the binary result
         cpu->P.V = ((int32_t)alb < -32768 || (int32_t)alb > 32767) ? 1 : 0;
         cpu->P.C = (alb >= 0x10000) ? 1 : 0;
 
-        cpu->cycles += 1;
         if (mode == CPU_ADDR_IMMD)
         {
             size += 1; // One extra byte in operand
         }
     }
 
-    if (mode == CPU_ADDR_ABSX)
-    {
-        // Check if index crosses a page boundary
-        if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-            (!cpu->P.E && !cpu->P.XB))
-        {
-            cpu->cycles += 1;
-        }
-    }
-    else if (mode == CPU_ADDR_ABSY || mode == CPU_ADDR_INDDPY)
-    {
-        // Check if index crosses a page boundary
-        if ((addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00) ||
-            (!cpu->P.E && !cpu->P.XB))
-        {
-            cpu->cycles += 1;
-        }
-    }
-
-    // If DL != 0, add a cycle
-    if ((mode == CPU_ADDR_DPIND || mode == CPU_ADDR_DPINDL ||
-         mode == CPU_ADDR_INDDPY || mode == CPU_ADDR_DPINDX ||
-         mode == CPU_ADDR_DP || mode == CPU_ADDR_DPX ||
-         mode == CPU_ADDR_INDDPLY) &&
-        (cpu->D & 0xff) != 0)
-    {
-        cpu->cycles += 1;
-    }
-
     _cpu_update_pc(cpu, size);
     cpu->cycles += cycles;
 }
 
-void i_sec(CPU_t *cpu)
+CPU_OP_DEF(i_sec)(CPU_t *cpu)
 {
     cpu->P.C = 1;
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_sed(CPU_t *cpu)
+CPU_OP_DEF(i_sed)(CPU_t *cpu)
 {
     cpu->P.D = 1;
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_sei(CPU_t *cpu)
+CPU_OP_DEF(i_sei)(CPU_t *cpu)
 {
     cpu->P.I = 1;
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_sep(CPU_t *cpu, memory_t *mem)
+CPU_OP_DEF(i_sep)(CPU_t *cpu, memory_t *mem)
 {
     uint8_t sr = _cpu_get_sr(cpu);
-    uint8_t val = _get_mem_byte(mem, _addr_add_val_bank_wrap(cpu->PC, 1), cpu->setacc);
+    uint8_t val = _get_mem_byte(mem, _addr_add_val_bank_wrap(cpu->PC, 1), CPU_SETACC(cpu));
 
     if (cpu->P.E)
     {
@@ -2452,33 +2023,28 @@ void i_sep(CPU_t *cpu, memory_t *mem)
     cpu->cycles += 3;
 }
 
-void i_stp(CPU_t *cpu)
+CPU_OP_DEF(i_stp)(CPU_t *cpu)
 {
     //_cpu_update_pc(cpu, 1); // ???
     cpu->cycles += 3;
     cpu->P.STP = 1;
 }
 
-void i_sta(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_sta)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
-        }
-        /* Fallthrough! */
     case CPU_ADDR_IMMD:
     case CPU_ADDR_SR:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M))
+        if (CPU_M8(cpu))
         {
-            _set_mem_byte(mem, addr, (uint8_t)cpu->C, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)cpu->C, CPU_SETACC(cpu));
         }
         else
         {
-            _set_mem_word_bank_wrap(mem, addr, cpu->C, cpu->setacc);
+            _set_mem_word_bank_wrap(mem, addr, cpu->C, CPU_SETACC(cpu));
         }
         break;
     case CPU_ADDR_INDDPY:
@@ -2486,43 +2052,19 @@ void i_sta(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     case CPU_ADDR_DPINDL:
     case CPU_ADDR_DPINDX:
     case CPU_ADDR_INDDPLY:
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
-        }
-        /* Fallthrough! */
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSL:
     case CPU_ADDR_ABSLX:
     case CPU_ADDR_SRINDY:
     case CPU_ADDR_ABSX:
     case CPU_ADDR_ABSY:
-        if (cpu->P.E || (!cpu->P.E && cpu->P.M))
+        if (CPU_M8(cpu))
         {
-            _set_mem_byte(mem, addr, (uint8_t)cpu->C, cpu->setacc);
+            _set_mem_byte(mem, addr, (uint8_t)cpu->C, CPU_SETACC(cpu));
         }
         else
         {
-            _set_mem_word(mem, addr, cpu->C, cpu->setacc);
-        }
-
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
-        }
-        else if (mode == CPU_ADDR_ABSY || mode == CPU_ADDR_INDDPY)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
+            _set_mem_word(mem, addr, cpu->C, CPU_SETACC(cpu));
         }
         break;
     default:
@@ -2530,38 +2072,27 @@ void i_sta(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         break;
     }
 
-    if (!(cpu->P.E || (!cpu->P.E && cpu->P.M)))
-    {
-        cpu->cycles += 1;
-    }
-
     _cpu_update_pc(cpu, size);
     cpu->cycles += cycles;
 }
 
-void i_stx(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_stx)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPY:
-        _set_mem_byte(mem, addr, cpu->X & 0xff, cpu->setacc);
-        if (!cpu->P.E && !cpu->P.XB) // 16-bit
+        _set_mem_byte(mem, addr, cpu->X & 0xff, CPU_SETACC(cpu));
+        if (!CPU_X8(cpu)) // 16-bit
         {
-            _set_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), (cpu->X >> 8) & 0xff, cpu->setacc); // Bank wrapping
-            cpu->cycles += 1;
-        }
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            _set_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), (cpu->X >> 8) & 0xff, CPU_SETACC(cpu)); // Bank wrapping
         }
         break;
     case CPU_ADDR_ABS:
-        _set_mem_byte(mem, addr, cpu->X & 0xff, cpu->setacc);
-        if (!cpu->P.E && !cpu->P.XB) // 16-bit
+        _set_mem_byte(mem, addr, cpu->X & 0xff, CPU_SETACC(cpu));
+        if (!CPU_X8(cpu)) // 16-bit
         {
-            _set_mem_byte(mem, addr + 1, (cpu->X >> 8) & 0xff, cpu->setacc); // No bank wrapping
-            cpu->cycles += 1;
+            _set_mem_byte(mem, addr + 1, (cpu->X >> 8) & 0xff, CPU_SETACC(cpu)); // No bank wrapping
         }
         break;
     default:
@@ -2572,29 +2103,23 @@ void i_stx(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     _cpu_update_pc(cpu, size);
 }
 
-void i_sty(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_sty)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        _set_mem_byte(mem, addr, cpu->Y & 0xff, cpu->setacc);
-        if (!cpu->P.E && !cpu->P.XB) // 16-bit
+        _set_mem_byte(mem, addr, cpu->Y & 0xff, CPU_SETACC(cpu));
+        if (!CPU_X8(cpu)) // 16-bit
         {
-            _set_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), (cpu->Y >> 8) & 0xff, cpu->setacc); // Bank wrapping
-            cpu->cycles += 1;
-        }
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            _set_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), (cpu->Y >> 8) & 0xff, CPU_SETACC(cpu)); // Bank wrapping
         }
         break;
     case CPU_ADDR_ABS:
-        _set_mem_byte(mem, addr, cpu->Y & 0xff, cpu->setacc);
-        if (!cpu->P.E && !cpu->P.XB) // 16-bit
+        _set_mem_byte(mem, addr, cpu->Y & 0xff, CPU_SETACC(cpu));
+        if (!CPU_X8(cpu)) // 16-bit
         {
-            _set_mem_byte(mem, addr + 1, (cpu->Y >> 8) & 0xff, cpu->setacc); // No bank wrapping
-            cpu->cycles += 1;
+            _set_mem_byte(mem, addr + 1, (cpu->Y >> 8) & 0xff, CPU_SETACC(cpu)); // No bank wrapping
         }
         break;
     default:
@@ -2605,39 +2130,24 @@ void i_sty(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     _cpu_update_pc(cpu, size);
 }
 
-void i_stz(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_stz)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
     switch (mode)
     {
     case CPU_ADDR_DP:
     case CPU_ADDR_DPX:
-        _set_mem_byte(mem, addr, 0, cpu->setacc);
+        _set_mem_byte(mem, addr, 0, CPU_SETACC(cpu));
         if (!cpu->P.M) // 16-bit
         {
-            _set_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), 0, cpu->setacc); // Bank wrapping
-            cpu->cycles += 1;
-        }
-        if (cpu->D & 0xff)
-        {
-            cpu->cycles += 1;
+            _set_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), 0, CPU_SETACC(cpu)); // Bank wrapping
         }
         break;
     case CPU_ADDR_ABS:
     case CPU_ADDR_ABSX:
-        _set_mem_byte(mem, addr, 0, cpu->setacc);
+        _set_mem_byte(mem, addr, 0, CPU_SETACC(cpu));
         if (!cpu->P.M) // 16-bit
         {
-            _set_mem_byte(mem, addr + 1, 0, cpu->setacc); // No bank wrapping
-            cpu->cycles += 1;
-        }
-        if (mode == CPU_ADDR_ABSX)
-        {
-            // Check if index crosses a page boundary
-            if ((addr & 0xffff00) != ((addr - cpu->X) & 0xffff00) ||
-                (!cpu->P.E && !cpu->P.XB))
-            {
-                cpu->cycles += 1;
-            }
+            _set_mem_byte(mem, addr + 1, 0, CPU_SETACC(cpu)); // No bank wrapping
         }
         break;
     default:
@@ -2648,45 +2158,41 @@ void i_stz(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
     _cpu_update_pc(cpu, size);
 }
 
-void i_tax(CPU_t *cpu)
+CPU_OP_DEF(i_tax)(CPU_t *cpu)
 {
-    if (cpu->P.XB || cpu->P.E)
+    if (CPU_X8(cpu))
     {
         cpu->X = cpu->C & 0xff;
-        cpu->P.Z = ((cpu->X & 0xff) == 0);
-        cpu->P.N = ((cpu->X & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->X);
     }
     else // 16-bit X
     {
         cpu->X = cpu->C;
-        cpu->P.Z = (cpu->X == 0);
-        cpu->P.N = ((cpu->X & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->X);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_tay(CPU_t *cpu)
+CPU_OP_DEF(i_tay)(CPU_t *cpu)
 {
-    if (cpu->P.XB || cpu->P.E)
+    if (CPU_X8(cpu))
     {
         cpu->Y = cpu->C & 0xff;
-        cpu->P.Z = ((cpu->Y & 0xff) == 0);
-        cpu->P.N = ((cpu->Y & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->Y);
     }
     else // 16-bit X
     {
         cpu->Y = cpu->C;
-        cpu->P.Z = (cpu->Y == 0);
-        cpu->P.N = ((cpu->Y & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->Y);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_tcs(CPU_t *cpu)
+CPU_OP_DEF(i_tcs)(CPU_t *cpu)
 {
     if (cpu->P.E)
     {
@@ -2701,37 +2207,35 @@ void i_tcs(CPU_t *cpu)
     cpu->cycles += 2;
 }
 
-void i_tcd(CPU_t *cpu)
+CPU_OP_DEF(i_tcd)(CPU_t *cpu)
 {
     // 16-bit transfer
     cpu->D = cpu->C;
-    cpu->P.Z = (cpu->D == 0);
-    cpu->P.N = ((cpu->D & 0x8000) == 0x8000);
+    _cpu_set_nz16(cpu, cpu->D);
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_tdc(CPU_t *cpu)
+CPU_OP_DEF(i_tdc)(CPU_t *cpu)
 {
     // 16-bit transfer
     cpu->C = cpu->D;
-    cpu->P.Z = (cpu->C == 0);
-    cpu->P.N = ((cpu->C & 0x8000) == 0x8000);
+    _cpu_set_nz16(cpu, cpu->C);
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_trb(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_trb)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
-        uint8_t val = _get_mem_byte(mem, addr, cpu->setacc);
+        uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
 
-        _set_mem_byte(mem, addr, val & (cpu->C ^ 0xff), cpu->setacc);
+        _set_mem_byte(mem, addr, val & (cpu->C ^ 0xff), CPU_SETACC(cpu));
 
-        cpu->P.Z = ((cpu->C & 0xff) & val) ? 0 : 1;
+        cpu->P.NZ_Z = (cpu->C & 0xff) & val;
     }
     else // 16-bit
     {
@@ -2739,41 +2243,33 @@ void i_trb(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         
         if (mode == CPU_ADDR_DP)
         {
-            val = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            val = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
 
-            _set_mem_word_bank_wrap(mem, addr, val & (cpu->C ^ 0xffff), cpu->setacc);
+            _set_mem_word_bank_wrap(mem, addr, val & (cpu->C ^ 0xffff), CPU_SETACC(cpu));
         }
         else
         {
-            val = _get_mem_word(mem, addr, cpu->setacc);
+            val = _get_mem_word(mem, addr, CPU_SETACC(cpu));
             
-            _set_mem_word(mem, addr, val & (cpu->C ^ 0xffff), cpu->setacc);
+            _set_mem_word(mem, addr, val & (cpu->C ^ 0xffff), CPU_SETACC(cpu));
         }
 
-        cpu->P.Z = (cpu->C & val) ? 0 : 1;
-
-        cpu->cycles += 2;  // Two! (read + write op)
-    }
-
-    // If DL != 0, add a cycle
-    if (mode == CPU_ADDR_DP && (cpu->D & 0xff) != 0)
-    {
-        cpu->cycles += 1;
+        cpu->P.NZ_Z = cpu->C & val;
     }
 
     _cpu_update_pc(cpu, size);
     cpu->cycles += cycles;
 }
 
-void i_tsb(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
+CPU_OP_DEF(i_tsb)(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mode_t mode, uint32_t addr)
 {
-    if (cpu->P.E || (!cpu->P.E && cpu->P.M)) // 8-bit
+    if (CPU_M8(cpu)) // 8-bit
     {
-        uint8_t val = _get_mem_byte(mem, addr, cpu->setacc);
+        uint8_t val = _get_mem_byte(mem, addr, CPU_SETACC(cpu));
 
-        _set_mem_byte(mem, addr, val | (cpu->C & 0xff), cpu->setacc);
+        _set_mem_byte(mem, addr, val | (cpu->C & 0xff), CPU_SETACC(cpu));
 
-        cpu->P.Z = ((cpu->C & 0xff) & val) ? 0 : 1;
+        cpu->P.NZ_Z = (cpu->C & 0xff) & val;
     }
     else // 16-bit
     {
@@ -2781,33 +2277,25 @@ void i_tsb(CPU_t *cpu, memory_t *mem, uint8_t size, uint8_t cycles, CPU_Addr_Mod
         
         if (mode == CPU_ADDR_DP)
         {
-            val = _get_mem_word_bank_wrap(mem, addr, cpu->setacc);
+            val = _get_mem_word_bank_wrap(mem, addr, CPU_SETACC(cpu));
 
-            _set_mem_word_bank_wrap(mem, addr, val | cpu->C, cpu->setacc);
+            _set_mem_word_bank_wrap(mem, addr, val | cpu->C, CPU_SETACC(cpu));
         }
         else
         {
-            val = _get_mem_word(mem, addr, cpu->setacc);
+            val = _get_mem_word(mem, addr, CPU_SETACC(cpu));
             
-            _set_mem_word(mem, addr, val | cpu->C, cpu->setacc);
+            _set_mem_word(mem, addr, val | cpu->C, CPU_SETACC(cpu));
         }
 
-        cpu->P.Z = (cpu->C & val) ? 0 : 1;
-
-        cpu->cycles += 2; // Two! (read + write op)
-    }
-
-    // If DL != 0, add a cycle
-    if (mode == CPU_ADDR_DP && (cpu->D & 0xff) != 0)
-    {
-        cpu->cycles += 1;
+        cpu->P.NZ_Z = cpu->C & val;
     }
 
     _cpu_update_pc(cpu, size);
     cpu->cycles += cycles;
 }
 
-void i_tsc(CPU_t *cpu)
+CPU_OP_DEF(i_tsc)(CPU_t *cpu)
 {
     if (cpu->P.E)
     {
@@ -2818,58 +2306,52 @@ void i_tsc(CPU_t *cpu)
         cpu->C = cpu->SP;
     }
 
-    cpu->P.N = ((cpu->C & 0x8000) == 0x8000);
-    cpu->P.Z = (cpu->C == 0);
+    _cpu_set_nz16(cpu, cpu->C);
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_tsx(CPU_t *cpu)
+CPU_OP_DEF(i_tsx)(CPU_t *cpu)
 {
-    if (cpu->P.XB || cpu->P.E)
+    if (CPU_X8(cpu))
     {
         cpu->X = cpu->SP & 0xff;
-        cpu->P.Z = ((cpu->X & 0xff) == 0);
-        cpu->P.N = ((cpu->X & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->X);
     }
     else
     {
         cpu->X = cpu->SP & 0xffff;
-        cpu->P.Z = (cpu->X == 0);
-        cpu->P.N = ((cpu->X & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->X);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_txa(CPU_t *cpu)
+CPU_OP_DEF(i_txa)(CPU_t *cpu)
 {
-    if (cpu->P.M || cpu->P.E) // 8-bit A and 8/16-bit X
+    if (CPU_M8(cpu)) // 8-bit A and 8/16-bit X
     {
         cpu->C = (cpu->X & 0xff) | (cpu->C & 0xff00);
-        cpu->P.Z = ((cpu->C & 0xff) == 0);
-        cpu->P.N = ((cpu->C & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->C);
     }
     else if (cpu->P.XB && !cpu->P.M) // 8-bit X, 16-bit A
     {
         cpu->C = cpu->X & 0xff;
-        cpu->P.Z = (cpu->C == 0);
-        cpu->P.N = ((cpu->C & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->C);
     }
     else // 16-bit A and X
     {
         cpu->C = cpu->X;
-        cpu->P.Z = (cpu->C == 0);
-        cpu->P.N = ((cpu->C & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->C);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_txs(CPU_t *cpu)
+CPU_OP_DEF(i_txs)(CPU_t *cpu)
 {
     if (cpu->P.E)
     {
@@ -2890,70 +2372,63 @@ void i_txs(CPU_t *cpu)
     cpu->cycles += 2;
 }
 
-void i_txy(CPU_t *cpu)
+CPU_OP_DEF(i_txy)(CPU_t *cpu)
 {
-    if (cpu->P.XB || cpu->P.E)
+    if (CPU_X8(cpu))
     {
         cpu->Y = cpu->X & 0xff;
-        cpu->P.Z = ((cpu->Y & 0xff) == 0);
-        cpu->P.N = ((cpu->Y & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->Y);
     }
     else // 16-bit
     {
         cpu->Y = cpu->X;
-        cpu->P.Z = (cpu->Y == 0);
-        cpu->P.N = ((cpu->Y & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->Y);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_tya(CPU_t *cpu)
+CPU_OP_DEF(i_tya)(CPU_t *cpu)
 {
-    if (cpu->P.M || cpu->P.E) // 8-bit A and 8/16-bit X
+    if (CPU_M8(cpu)) // 8-bit A and 8/16-bit X
     {
         cpu->C = (cpu->Y & 0xff) | (cpu->C & 0xff00);
-        cpu->P.Z = ((cpu->C & 0xff) == 0);
-        cpu->P.N = ((cpu->C & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->C);
     }
     else if (cpu->P.XB && !cpu->P.M) // 8-bit X, 16-bit A
     {
         cpu->C = cpu->Y & 0xff;
-        cpu->P.Z = (cpu->C == 0);
-        cpu->P.N = ((cpu->C & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->C);
     }
     else // 16-bit A and X
     {
         cpu->C = cpu->Y;
-        cpu->P.Z = (cpu->C == 0);
-        cpu->P.N = ((cpu->C & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->C);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_tyx(CPU_t *cpu)
+CPU_OP_DEF(i_tyx)(CPU_t *cpu)
 {
-    if (cpu->P.XB || cpu->P.E)
+    if (CPU_X8(cpu))
     {
         cpu->X = cpu->Y & 0xff;
-        cpu->P.Z = ((cpu->X & 0xff) == 0);
-        cpu->P.N = ((cpu->X & 0x80) == 0x80);
+        _cpu_set_nz8(cpu, cpu->X);
     }
     else // 16-bit
     {
         cpu->X = cpu->Y;
-        cpu->P.Z = (cpu->X == 0);
-        cpu->P.N = ((cpu->X & 0x8000) == 0x8000);
+        _cpu_set_nz16(cpu, cpu->X);
     }
 
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 2;
 }
 
-void i_wai(CPU_t *cpu)
+CPU_OP_DEF(i_wai)(CPU_t *cpu)
 {
     if (cpu->P.NMI || cpu->P.IRQ)
     {
@@ -2963,22 +2438,21 @@ void i_wai(CPU_t *cpu)
     }
 }
 
-void i_wdm(CPU_t *cpu)
+CPU_OP_DEF(i_wdm)(CPU_t *cpu)
 {
     _cpu_update_pc(cpu, 2);
     cpu->cycles += 2; // http://www.6502.org/tutorials/65c816opcodes.html#6.7
 }
 
-void i_xba(CPU_t *cpu)
+CPU_OP_DEF(i_xba)(CPU_t *cpu)
 {
     cpu->C = ((cpu->C << 8) | ((cpu->C >> 8) & 0xff)) & 0xffff;
-    cpu->P.N = cpu->C & 0x80 ? 1 : 0;
-    cpu->P.Z = cpu->C & 0xff ? 0 : 1;
+    _cpu_set_nz8(cpu, cpu->C);
     _cpu_update_pc(cpu, 1);
     cpu->cycles += 3;
 }
 
-void i_xce(CPU_t *cpu)
+CPU_OP_DEF(i_xce)(CPU_t *cpu)
 {
     unsigned char temp = cpu->P.E;
     cpu->P.E = cpu->P.C;
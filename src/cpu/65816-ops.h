@@ -8,6 +8,64 @@
 
 #include "65816.h"
 #include "65816-util.h"
+#include "65816-opcodes.h"
+
+// Register width tests, access flag test and handler definition used
+// by 65816-ops.c. The dispatcher redefines these to instantiate a copy
+// of every handler for each combination of register widths, with and
+// without memory access flag tracking (see 65816-dispatch.c)
+#define CPU_M8(cpu) ((cpu)->P.E || (cpu)->P.M)  // 8-bit accumulator/memory
+#define CPU_X8(cpu) ((cpu)->P.E || (cpu)->P.XB) // 8-bit index registers
+#define CPU_SETACC(cpu) ((cpu)->setacc)         // Set memory access flags
+#define CPU_OP_DEF(name) void name
+
+/**
+ * Determine the number of cycles an ALU instruction takes on top of its
+ * base cycle count, before it is executed. The width arguments are
+ * passed in (rather than tested here) so that a caller which knows the
+ * register widths can have the width checks compiled out.
+ *
+ * @param *cpu The CPU which is about to execute the instruction
+ * @param penalties The CPU_CYC_* penalties which apply to the instruction
+ *                  (see CPU_OP_PENALTIES())
+ * @param addr The effective address of the instruction's operand
+ * @param m8 True if the accumulator is 8 bits wide
+ * @param x8 True if the index registers are 8 bits wide
+ * @return The number of extra cycles
+ */
+static inline uint8_t _cpu_penalty_cycles(CPU_t *cpu, uint8_t penalties, uint32_t addr, bool m8, bool x8)
+{
+    uint8_t n = 0;
+
+    if ((penalties & CPU_CYC_DL) && (cpu->D & 0xff))
+    {
+        n += 1;
+    }
+    if ((penalties & CPU_CYC_M) && !m8)
+    {
+        n += 1;
+    }
+    if ((penalties & CPU_CYC_M2) && !m8)
+    {
+        n += 2;
+    }
+    if ((penalties & CPU_CYC_X) && !x8)
+    {
+        n += 1;
+    }
+    // Check if index crosses a page boundary
+    if ((penalties & CPU_CYC_IX) &&
+        (!x8 || (addr & 0xffff00) != ((addr - cpu->X) & 0xffff00)))
+    {
+        n += 1;
+    }
+    if ((penalties & CPU_CYC_IY) &&
+        (!x8 || (addr & 0xffff00) != ((addr - cpu->Y) & 0xffff00)))
+    {
+        n += 1;
+    }
+    return n;
+}
 
 void i_adc(CPU_t *, memory_t *, uint8_t, uint8_t, CPU_Addr_Mode_t, uint32_t);
 void i_and(CPU_t *, memory_t *, uint8_t, uint8_t, CPU_Addr_Mode_t, uint32_t);
@@ -3,10 +3,39 @@
  * Copyright (C) 2023 Ray Clemens
  */
 
+#define _DEFAULT_SOURCE // MAP_ANONYMOUS, MADV_HUGEPAGE
+
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "65816-util.h"
 
+#ifdef CPU_MEM_SPARSE
+// Initial size of a sparse memory's list of allocated pages
+#define MEM_USED_INIT 64
+
+const mem_page_t _mem_zero_page;
+#elif defined(__unix__) || defined(__APPLE__)
+// Flat memory is mapped from the OS instead of the heap, which only
+// backs the pages that are written to
+#define MEM_MMAP
+#include <sys/mman.h>
+
+// Size and alignment of a huge page (x86-64 and AArch64 with 4 KiB pages)
+#define MEM_HUGE_PAGE_SIZE 0x200000u
+// Size of the mapping which holds a memory_t
+#define MEM_MAP_SIZE ((sizeof(memory_t) + MEM_HUGE_PAGE_SIZE - 1) & ~(size_t) (MEM_HUGE_PAGE_SIZE - 1))
+#endif
+
+#ifndef CPU_MEM_SPARSE
+// Bytes which _init_mem_arr() and _copy_mem() copy at a time (a host
+// page), so that they can leave out the ones which would only write zeros
+// over zeros and keep the host from having to back them
+#define MEM_COPY_CHUNK 0x1000u
+#endif
+
 /**
  * Add a value to the given CPU's PC (Bank wraps)
  * @param cpu The CPU to have its PC updated
@@ -24,7 +53,8 @@ void _cpu_update_pc(CPU_t *cpu, uint16_t offset)
  */
 uint8_t _cpu_get_sr(CPU_t *cpu)
 {
-    return *(uint8_t *) &(cpu->P);
+    return cpu->P.C | (_cpu_get_z(cpu) << 1) | (cpu->P.I << 2) | (cpu->P.D << 3) |
+        (cpu->P.XB << 4) | (cpu->P.M << 5) | (cpu->P.V << 6) | (_cpu_get_n(cpu) << 7);
 }
 
 /**
@@ -34,7 +64,14 @@ uint8_t _cpu_get_sr(CPU_t *cpu)
  */
 void _cpu_set_sr(CPU_t *cpu, uint8_t sr)
 {
-    *(uint8_t *) &(cpu->P) = sr;
+    cpu->P.C = sr & 1;
+    _cpu_set_z(cpu, sr & 0x02);
+    cpu->P.I = (sr >> 2) & 1;
+    cpu->P.D = (sr >> 3) & 1;
+    cpu->P.XB = (sr >> 4) & 1;
+    cpu->P.M = (sr >> 5) & 1;
+    cpu->P.V = (sr >> 6) & 1;
+    cpu->P.NZ_N = sr; // N is bit 7
 }
 
 /**
@@ -56,16 +93,6 @@ void _cpu_set_sp(CPU_t *cpu, uint16_t addr)
    
 }
 
-/**
- * Get the CPU's PROGRAM BANK, shifted to be bits 16..23 of the value
- * @param cpu A pointer to the CPU struct from which the PBR will be retrieved
- * @return The PBR of the given cpu, placed in bits 23..16
- */
-uint32_t _cpu_get_pbr(CPU_t *cpu)
-{
-    return (uint32_t)cpu->PBR << 16;
-}
-
 /**
  * Get the CPU's DATA BANK, shifted to be bits 16..23 of the value
  * @param cpu A pointer to the CPU struct from which the DBR will be retrieved
@@ -77,159 +104,691 @@ uint32_t _cpu_get_dbr(CPU_t *cpu)
 }
 
 /**
- * Get a CPU's 24 bit PC address
- * @param cpu A pointer to the CPU struct from which to retrieve the 24-bit PC address
- * @return The cpu's PC concatenated with the PBR
+ * Add a value to an address, PAGE WRAPPING
+ * @param addr The base address of the operation
+ * @param offset The amount to add to the base address
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return The addr plus offset, page wrapped
  */
-uint32_t _cpu_get_effective_pc(CPU_t *cpu)
+uint32_t _addr_add_val_page_wrap(uint32_t addr, uint32_t offset)
 {
-    return _cpu_get_pbr(cpu) | cpu->PC;
+    return (addr & 0x00ffff00) | ((addr + offset) & 0x000000ff);
 }
 
 /**
- * Get the byte in memory at the address CPU PC+1
- * @note This will BANK WRAP
- * @param cpu The CPU from which to retrieve the PC
- * @param mem The memory from which to pull the value
- * @param setacc True to set the "accessed flag" on used memory data
- * @return The value of the byte in memory at the CPU's PC+1
+ * Set the flag in a specified cpu to indicate that an invalid
+ * internal sim error/state was reached
+ * @param cpu The CPU which should have its error flag set
  */
-uint8_t _cpu_get_immd_byte(CPU_t *cpu, memory_t *mem, bool setacc)
+void _cpu_crash(CPU_t *cpu)
 {
-    uint32_t addr = _cpu_get_effective_pc(cpu);
-    addr = _addr_add_val_bank_wrap(addr, 1);
-    return _get_mem_byte(mem, addr, setacc);
+    cpu->P.CRASH = 1;
 }
 
 /**
- * Get the word in memory at the address CPU PC+1 (high byte @ PC+2)
- * @note This will BANK WRAP
- * @param cpu The CPU from which to retrieve the PC
- * @param mem The memory from which to pull the value
- * @param setacc True to set the "accessed flag" on used memory data
- * @return The value of the word in memory at the CPU's PC+1
+ * Drop any decoded blocks which include addr. Only the addresses which
+ * could hold the start of such a block (CPU_DECODE_BLOCK_BYTES back,
+ * blocks BANK WRAP) need their X flag cleared. This forces any CPU which
+ * has one of those blocks in its predecoded instruction cache to decode
+ * it again.
+ * @param mem The memory array to use as system memory
+ * @param addr The address in memory which is being modified
  */
-uint16_t _cpu_get_immd_word(CPU_t *cpu, memory_t *mem, bool setacc)
+static inline void _mem_drop_decoded(memory_t *mem, uint32_t addr)
 {
-    uint32_t addr = _cpu_get_effective_pc(cpu);
-    addr = _addr_add_val_bank_wrap(addr, 1);
-    uint16_t val = _get_mem_byte(mem, addr, setacc);
-    addr = _addr_add_val_bank_wrap(addr, 1);
-    return val | (_get_mem_byte(mem, addr, setacc) << 8);
+    if (_mem_get_flag(mem, MEM_PLANE_C, addr)) {
+        _mem_clear_flag(mem, MEM_PLANE_C, addr);
+
+#ifndef CPU_MEM_SPARSE
+        if ((addr & 0xffff) >= CPU_DECODE_BLOCK_BYTES - 1) {
+            // Clear the range a plane byte at a time (it always
+            // spans more than one of them)
+            uint8_t *x = mem->flag[MEM_PLANE_X];
+            uint32_t first = addr - (CPU_DECODE_BLOCK_BYTES - 1);
+            uint32_t lo = first >> 3;
+            uint32_t hi = addr >> 3;
+            x[lo] &= ~(0xff << (first & 7));
+            for (uint32_t i = lo + 1; i < hi; ++i) {
+                x[i] = 0;
+            }
+            x[hi] &= ~(0xff >> (7 - (addr & 7)));
+            return;
+        }
+#endif
+
+        // The range wraps around the start of the bank (or, with sparse
+        // memory, may span two pages which are not next to each other)
+        for (uint32_t i = 0; i < CPU_DECODE_BLOCK_BYTES; ++i) {
+            _mem_clear_flag(mem, MEM_PLANE_X, _addr_add_val_bank_wrap(addr, -i));
+        }
+    }
 }
 
 /**
- * Get the long in memory at the address CPU PC+1 (high byte @ PC+3)
- * @note This will BANK WRAP
- * @param cpu The CPU from which to retrieve the PC
- * @param mem The memory from which to pull the value
- * @param setacc True to set the "accessed flag" on used memory data
- * @return The value of the long in memory at the CPU's PC+1
+ * Get the device which an address on a device page is mapped to
+ * @param mem The memory array to use as system memory
+ * @param addr An address on a MEM_PAGE_IO page
+ * @return The device, or NULL if addr is on the device's page(s)
+ *         but outside of its registers
  */
-uint32_t _cpu_get_immd_long(CPU_t *cpu, memory_t *mem, bool setacc)
+static inline mem_device_t *_mem_get_device(memory_t *mem, uint32_t addr)
 {
-    uint32_t addr = _cpu_get_effective_pc(cpu);
-    addr = _addr_add_val_bank_wrap(addr, 1);
-    uint32_t val = _get_mem_byte(mem, addr, setacc);
-    addr = _addr_add_val_bank_wrap(addr, 1);
-    val |= _get_mem_byte(mem, addr, setacc) << 8;
-    addr = _addr_add_val_bank_wrap(addr, 1);
-    return val | (_get_mem_byte(mem, addr, setacc) << 16);
+    mem_device_t *dev = &mem->device[mem->page[addr >> MEM_PAGE_BITS] - MEM_PAGE_IO];
+    return (addr - dev->base < dev->size) ? dev : NULL;
 }
 
 /**
- * Add a value to an address, PAGE WRAPPING
- * @param addr The base address of the operation
- * @param offset The amount to add to the base address
- * @param setacc True to set the "accessed flag" on used memory data
- * @return The addr plus offset, page wrapped
+ * Note that a value on a page of memory has been written to
+ * (see _cmp_mem_dirty())
+ * @param mem The memory which was written to
+ * @param addr The address which was written
  */
-uint32_t _addr_add_val_page_wrap(uint32_t addr, uint32_t offset)
+static inline void _mem_mark_dirty(memory_t *mem, uint32_t addr)
 {
-    return (addr & 0x00ffff00) | ((addr + offset) & 0x000000ff);
+    uint32_t page = addr >> MEM_PAGE_BITS;
+    uint8_t bit = 1u << (page & 7);
+
+    if (!(mem->dirty[page >> 3] & bit)) {
+        mem->dirty[page >> 3] |= bit;
+        mem->dirty_pages[mem->dirty_count++] = page;
+    }
 }
 
 /**
- * Add a value to an address, BANK WRAPPING
- * @param addr The base address of the operation
- * @param offset The amount to add to the base address
- * @return The addr plus offset, bank wrapped
+ * Note that every page of a range of memory has been written to
+ * @param mem The memory which was written to
+ * @param base_addr The first address of the range
+ * @param count The number of bytes in the range (> 0)
  */
-uint32_t _addr_add_val_bank_wrap(uint32_t addr, uint32_t offset)
+static void _mem_mark_dirty_range(memory_t *mem, uint32_t base_addr, uint32_t count)
 {
-    return (addr & 0x00ff0000) | ((addr + offset) & 0x0000ffff);
+    for (uint32_t p = base_addr >> MEM_PAGE_BITS; p <= (base_addr + count - 1) >> MEM_PAGE_BITS; ++p) {
+        _mem_mark_dirty(mem, p << MEM_PAGE_BITS);
+    }
 }
 
 /**
- * Set the flag in a specified cpu to indicate that an invalid
- * internal sim error/state was reached
- * @param cpu The CPU which should have its error flag set
+ * Store a value in memory (no flags, devices or decoded blocks are
+ * looked at). With sparse memory, the address's page is allocated
+ * if the value is not zero, and the value is dropped if the page
+ * can not be allocated.
+ * @param mem The memory array to use as system memory
+ * @param addr The address in memory to write
+ * @param val The data value to store
  */
-void _cpu_crash(CPU_t *cpu)
+static inline void _mem_put_val(memory_t *mem, uint32_t addr, uint8_t val)
 {
-    cpu->P.CRASH = 1;
+#ifdef CPU_MEM_SPARSE
+    mem_page_t *pg = _mem_find_page(mem, addr);
+    if (!pg) {
+        // Pages which have not been allocated already read as zero
+        if (!val || !(pg = _mem_alloc_page(mem, addr))) {
+            return;
+        }
+    }
+    pg->val[addr & (MEM_PAGE_SIZE - 1)] = val;
+#else
+    mem->val[addr] = val;
+#endif
+    _mem_mark_dirty(mem, addr);
+}
+
+/**
+ * Allocate a new system memory. All of it is zeroed RAM with no flags set.
+ * @note With sparse memory, only the page table is allocated here
+ *       and the rest is allocated as it is written to. Otherwise, the
+ *       memory is an anonymous mapping (aligned to a huge page) where
+ *       the OS supports it, so the host only backs the pages which are
+ *       written to (reading the others does not take up any space).
+ * @return The memory, or NULL if it could not be allocated
+ */
+memory_t *_alloc_mem(void)
+{
+#ifdef MEM_MMAP
+    // Map a huge page more than is needed and trim it down to an aligned
+    // mapping (only the first part of the mapping's last huge page is used)
+    size_t len = MEM_MAP_SIZE + MEM_HUGE_PAGE_SIZE;
+    uint8_t *base = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    uint8_t *mem = (uint8_t *) (((uintptr_t) base + MEM_HUGE_PAGE_SIZE - 1) & ~(uintptr_t) (MEM_HUGE_PAGE_SIZE - 1));
+    if (mem > base) {
+        munmap(base, mem - base);
+    }
+    if (mem + MEM_MAP_SIZE < base + len) {
+        munmap(mem + MEM_MAP_SIZE, base + len - (mem + MEM_MAP_SIZE));
+    }
+    return (memory_t *) mem;
+#else
+    return calloc(1, sizeof(memory_t));
+#endif
+}
+
+/**
+ * Free a system memory allocated with _alloc_mem()
+ * @param mem The memory to free
+ */
+void _free_mem(memory_t *mem)
+{
+#ifdef CPU_MEM_SPARSE
+    if (mem) {
+        for (uint32_t i = 0; i < mem->used_count; ++i) {
+            free(_mem_find_page(mem, mem->used[i] << MEM_PAGE_BITS));
+        }
+        for (uint32_t b = 0; b < MEMORY_SIZE >> 16; ++b) {
+            free(mem->bank[b]);
+        }
+        free(mem->used);
+    }
+#endif
+#ifdef MEM_MMAP
+    if (mem) {
+        munmap(mem, MEM_MAP_SIZE);
+    }
+#else
+    free(mem);
+#endif
+}
+
+/**
+ * Tell the OS that a range of memory will be used densely, so that it
+ * backs the range with huge pages (which takes fewer TLB entries to
+ * run through) where it supports them
+ * @note Only the huge pages which are entirely inside the range are
+ *       affected (on Linux, with transparent huge pages enabled). With
+ *       sparse memory, or without mmap(), this does nothing.
+ * @param mem The memory to advise
+ * @param base_addr The first address of the range
+ * @param count The number of bytes in the range
+ */
+void _advise_mem_dense(memory_t *mem, uint32_t base_addr, uint32_t count)
+{
+#if defined(MEM_MMAP) && defined(MADV_HUGEPAGE)
+    if (base_addr >= MEMORY_SIZE || count > MEMORY_SIZE - base_addr) {
+        return;
+    }
+
+    uint32_t first = (base_addr + MEM_HUGE_PAGE_SIZE - 1) & ~(MEM_HUGE_PAGE_SIZE - 1);
+    uint32_t end = (base_addr + count) & ~(MEM_HUGE_PAGE_SIZE - 1);
+    if (first < end) {
+        madvise(mem->val + first, end - first, MADV_HUGEPAGE);
+    }
+
+    // A huge page of a flag plane covers 8 of the values
+    first = ((base_addr >> 3) + MEM_HUGE_PAGE_SIZE - 1) & ~(MEM_HUGE_PAGE_SIZE - 1);
+    end = ((base_addr + count) >> 3) & ~(MEM_HUGE_PAGE_SIZE - 1);
+    for (int plane = 0; first < end && plane < MEM_PLANES; ++plane) {
+        madvise(mem->flag[plane] + first, end - first, MADV_HUGEPAGE);
+    }
+#else
+    (void) mem;
+    (void) base_addr;
+    (void) count;
+#endif
 }
 
+#ifdef CPU_MEM_SPARSE
 /**
- * Get a byte from memory
+ * Allocate the (zeroed) page of sparse memory which holds an address
+ * (see _mem_write_page())
+ * @param mem The memory to add the page to
+ * @param addr An address on a page which has not been allocated yet
+ * @return The page, or NULL if it could not be allocated
+ */
+mem_page_t *_mem_alloc_page(memory_t *mem, uint32_t addr)
+{
+    mem_page_t ***bank = &mem->bank[addr >> 16];
+    mem_page_t *pg;
+
+    if (!*bank) {
+        *bank = calloc(MEM_BANK_PAGES, sizeof(mem_page_t *));
+        if (!*bank) {
+            return NULL;
+        }
+    }
+    if (mem->used_count == mem->used_max) {
+        uint32_t max = mem->used_max ? mem->used_max * 2 : MEM_USED_INIT;
+        uint32_t *used = realloc(mem->used, max * sizeof(uint32_t));
+        if (!used) {
+            return NULL;
+        }
+        mem->used = used;
+        mem->used_max = max;
+    }
+    pg = calloc(1, sizeof(mem_page_t));
+    if (!pg) {
+        return NULL;
+    }
+
+    (*bank)[(addr >> MEM_PAGE_BITS) & (MEM_BANK_PAGES - 1)] = pg;
+    mem->used[mem->used_count++] = addr >> MEM_PAGE_BITS;
+    return pg;
+}
+#endif
+
+/**
+ * Zero every byte of a system memory and clear all of its flags (which
+ * drops every decoded block). The page types and devices stay as they are.
+ * @note With sparse memory, this only takes as long as the number of
+ *       pages which have been written to. They stay allocated, so
+ *       running the same program again does not allocate anything.
+ *       On Linux, a flat memory's pages are instead given back to the
+ *       OS (which maps them back in as zeros the next time they are
+ *       written to) rather than written over.
+ * @param mem The memory to reset
+ */
+void _reset_mem(memory_t *mem)
+{
+    _mem_mark_dirty_range(mem, 0, MEMORY_SIZE);
+#ifdef CPU_MEM_SPARSE
+    for (uint32_t i = 0; i < mem->used_count; ++i) {
+        memset(_mem_find_page(mem, mem->used[i] << MEM_PAGE_BITS), 0, sizeof(mem_page_t));
+    }
+#else
+#if defined(MEM_MMAP) && defined(__linux__)
+    // Anonymous pages read back as zeros once they have been dropped
+    if (madvise(mem->val, sizeof(mem->val), MADV_DONTNEED) == 0 &&
+        madvise(mem->flag, sizeof(mem->flag), MADV_DONTNEED) == 0) {
+        return;
+    }
+#endif
+    memset(mem->val, 0, sizeof(mem->val));
+    memset(mem->flag, 0, sizeof(mem->flag));
+#endif
+}
+
+#ifndef CPU_MEM_SPARSE
+/**
+ * Copy bytes into a flat memory a chunk at a time, leaving out the
+ * chunks which are zero in both the source and the destination
+ * (reading them does not make the host back them)
+ * @param dst Where to copy to
+ * @param src Where to copy from
+ * @param count The number of bytes to copy
+ */
+static void _mem_copy_nonzero(uint8_t *dst, const uint8_t *src, size_t count)
+{
+    static const uint8_t zero[MEM_COPY_CHUNK];
+
+    for (size_t i = 0; i < count;) {
+        // Chunks end on the host's pages
+        size_t n = MEM_COPY_CHUNK - ((uintptr_t) (dst + i) & (MEM_COPY_CHUNK - 1));
+        n = (n < count - i) ? n : count - i;
+        if (memcmp(src + i, zero, n) != 0 || memcmp(dst + i, zero, n) != 0) {
+            memcpy(dst + i, src + i, n);
+        }
+        i += n;
+    }
+}
+#endif
+
+/**
+ * List the pages of a system memory which have been written to (their
+ * addresses >> MEM_PAGE_BITS). Every other page is zero with no flags set.
+ * @note Only sparse memory keeps track of this, so without it every
+ *       page is listed
+ * @param mem The memory to look at
+ * @param pages Filled in with the page numbers, in no particular order (may be NULL)
+ * @param max The most page numbers to put in pages
+ * @return The number of pages which have been written to (can be more than max)
+ */
+uint32_t _get_mem_pages(memory_t *mem, uint32_t *pages, uint32_t max)
+{
+#ifdef CPU_MEM_SPARSE
+    uint32_t count = mem->used_count;
+    for (uint32_t i = 0; pages && i < count && i < max; ++i) {
+        pages[i] = mem->used[i];
+    }
+#else
+    uint32_t count = MEM_PAGES;
+    (void) mem;
+    for (uint32_t i = 0; pages && i < count && i < max; ++i) {
+        pages[i] = i;
+    }
+#endif
+    return count;
+}
+
+/**
+ * Make one system memory a copy of another: the values, the page types,
+ * and the R, W and B flags. No blocks are left decoded in the copy.
+ * Devices are not copied: their pages are RAM in the copy, which should
+ * not have any devices mapped itself.
+ * @param dst The memory to overwrite
+ * @param src The memory to copy
+ * @return True if the memory was copied, false if a sparse memory
+ *         page could not be allocated
+ */
+bool _copy_mem(memory_t *dst, memory_t *src)
+{
+    for (uint32_t p = 0; p < MEM_PAGES; ++p) {
+        dst->page[p] = (src->page[p] >= MEM_PAGE_IO) ? MEM_PAGE_RAM : src->page[p];
+    }
+
+#ifdef CPU_MEM_SPARSE
+    _reset_mem(dst);
+    for (uint32_t i = 0; i < src->used_count; ++i) {
+        uint32_t addr = src->used[i] << MEM_PAGE_BITS;
+        mem_page_t *pg = _mem_write_page(dst, addr);
+        if (!pg) {
+            return false;
+        }
+        *pg = *_mem_find_page(src, addr);
+        memset(pg->flag[MEM_PLANE_X], 0, sizeof(pg->flag[MEM_PLANE_X]));
+        memset(pg->flag[MEM_PLANE_C], 0, sizeof(pg->flag[MEM_PLANE_C]));
+    }
+#else
+    _reset_mem(dst);
+    _mem_copy_nonzero(dst->val, src->val, sizeof(dst->val));
+    _mem_copy_nonzero(dst->flag[MEM_PLANE_R], src->flag[MEM_PLANE_R], sizeof(dst->flag[MEM_PLANE_R]));
+    _mem_copy_nonzero(dst->flag[MEM_PLANE_W], src->flag[MEM_PLANE_W], sizeof(dst->flag[MEM_PLANE_W]));
+    _mem_copy_nonzero(dst->flag[MEM_PLANE_B], src->flag[MEM_PLANE_B], sizeof(dst->flag[MEM_PLANE_B]));
+#endif
+    return true;
+}
+
+/**
+ * Find the lowest address in one page whose value differs between
+ * two system memories
+ * @param a One memory
+ * @param b The other memory
+ * @param page The page to compare (address >> MEM_PAGE_BITS)
+ * @return The address, or 0xffffffff if the pages match
+ */
+static uint32_t _cmp_mem_page(memory_t *a, memory_t *b, uint32_t page)
+{
+    uint32_t addr = page << MEM_PAGE_BITS;
+    const uint8_t *va = _mem_val_rptr(a, addr);
+    const uint8_t *vb = _mem_val_rptr(b, addr);
+
+    if (memcmp(va, vb, MEM_PAGE_SIZE) == 0) {
+        return 0xffffffff;
+    }
+    for (uint32_t i = 0; ; ++i) {
+        if (va[i] != vb[i]) {
+            return addr + i;
+        }
+    }
+}
+
+/**
+ * Find the lowest address whose value differs between two system
+ * memories (flags, page types and devices are not compared)
+ * @note With sparse memory, this only takes as long as the number of
+ *       pages which have been written to in the two memories
+ * @param a One memory
+ * @param b The other memory
+ * @return The address, or 0xffffffff if every value matches
+ */
+uint32_t _cmp_mem(memory_t *a, memory_t *b)
+{
+    uint32_t first = 0xffffffff;
+
+#ifdef CPU_MEM_SPARSE
+    // A page which has only been written to in one of them
+    // still has to match the other's zero page
+    for (uint32_t i = 0; i < a->used_count; ++i) {
+        uint32_t addr = _cmp_mem_page(a, b, a->used[i]);
+        first = (addr < first) ? addr : first;
+    }
+    for (uint32_t i = 0; i < b->used_count; ++i) {
+        uint32_t addr = _cmp_mem_page(a, b, b->used[i]);
+        first = (addr < first) ? addr : first;
+    }
+#else
+    if (memcmp(a->val, b->val, sizeof(a->val)) == 0) {
+        return first;
+    }
+    for (uint32_t p = 0; p < MEM_PAGES && first == 0xffffffff; ++p) {
+        first = _cmp_mem_page(a, b, p);
+    }
+#endif
+    return first;
+}
+
+/**
+ * Find the lowest address whose value differs between two system
+ * memories, only looking at the pages which have been written to in
+ * either of them since the last time this was called for them. Writes
+ * are then tracked from here on again.
+ * @note This only finds every difference if the memories matched the
+ *       last time they were compared (or were both reset)
+ * @param a One memory
+ * @param b The other memory
+ * @return The address, or 0xffffffff if every page which was written matches
+ */
+uint32_t _cmp_mem_dirty(memory_t *a, memory_t *b)
+{
+    uint32_t first = 0xffffffff;
+
+    for (uint32_t i = 0; i < a->dirty_count; ++i) {
+        uint32_t addr = _cmp_mem_page(a, b, a->dirty_pages[i]);
+        first = (addr < first) ? addr : first;
+    }
+    for (uint32_t i = 0; i < b->dirty_count; ++i) {
+        uint32_t page = b->dirty_pages[i];
+        if (!(a->dirty[page >> 3] & (1u << (page & 7)))) {
+            uint32_t addr = _cmp_mem_page(a, b, page);
+            first = (addr < first) ? addr : first;
+        }
+    }
+    _clear_mem_dirty(a);
+    _clear_mem_dirty(b);
+    return first;
+}
+
+/**
+ * Forget which pages of a system memory have been written to
+ * (see _cmp_mem_dirty())
+ * @param mem The memory to clear
+ */
+void _clear_mem_dirty(memory_t *mem)
+{
+    for (uint32_t i = 0; i < mem->dirty_count; ++i) {
+        mem->dirty[mem->dirty_pages[i] >> 3] = 0;
+    }
+    mem->dirty_count = 0;
+}
+
+/**
+ * Make a range of memory read-only. CPU writes to any page which
+ * overlaps the range are dropped.
+ * @note The contents can still be changed with _init_mem_arr()
+ * @param mem The memory array to modify
+ * @param base_addr The first address of the ROM
+ * @param count The number of bytes of ROM
+ * @return True if the pages were mapped, false if one of them
+ *         already belongs to a device
+ */
+bool _map_mem_rom(memory_t *mem, uint32_t base_addr, uint32_t count)
+{
+    uint32_t first = base_addr >> MEM_PAGE_BITS;
+    uint32_t last = (base_addr + count - 1) >> MEM_PAGE_BITS;
+
+    if (count == 0 || last >= MEM_PAGES) {
+        return false;
+    }
+    for (uint32_t p = first; p <= last; ++p) {
+        if (mem->page[p] >= MEM_PAGE_IO) {
+            return false;
+        }
+    }
+    for (uint32_t p = first; p <= last; ++p) {
+        mem->page[p] = MEM_PAGE_ROM;
+    }
+    return true;
+}
+
+/**
+ * Map a device's registers into memory. Every CPU access to the
+ * registers is passed on to the device's callbacks as it happens.
+ * The rest of the pages the registers are on keep working like RAM.
+ * @note Instructions are never cached from device pages
+ * @param mem The memory array to map the device into
+ * @param dev The device (copied into the memory's device table)
+ * @return True if the device was mapped, false if there are too
+ *         many devices or one of the pages is already mapped to a device
+ */
+bool _map_mem_io(memory_t *mem, const mem_device_t *dev)
+{
+    uint32_t first = dev->base >> MEM_PAGE_BITS;
+    uint32_t last = (dev->base + dev->size - 1) >> MEM_PAGE_BITS;
+    int slot = -1;
+
+    if (dev->size == 0 || last >= MEM_PAGES) {
+        return false;
+    }
+    for (uint32_t p = first; p <= last; ++p) {
+        if (mem->page[p] >= MEM_PAGE_IO) {
+            return false;
+        }
+    }
+
+    // Free slots have no registers
+    for (int i = 0; i < MEM_DEVICES_MAX; ++i) {
+        if (mem->device[i].size == 0) {
+            slot = i;
+            break;
+        }
+    }
+    if (slot < 0) {
+        return false;
+    }
+
+    mem->device[slot] = *dev;
+    for (uint32_t p = first; p <= last; ++p) {
+        // Bytes on the page may be part of a decoded block
+        for (uint32_t i = 0; i < MEM_PAGE_SIZE; ++i) {
+            _mem_drop_decoded(mem, (p << MEM_PAGE_BITS) | i);
+        }
+        mem->page[p] = MEM_PAGE_IO + slot;
+    }
+    return true;
+}
+
+/**
+ * Turn a range of memory back into RAM. Devices on any of the
+ * pages which overlap the range are removed.
+ * @param mem The memory array to modify
+ * @param base_addr The first address of the range
+ * @param count The number of bytes in the range
+ */
+void _unmap_mem(memory_t *mem, uint32_t base_addr, uint32_t count)
+{
+    uint32_t first = base_addr >> MEM_PAGE_BITS;
+    uint32_t last = (base_addr + count - 1) >> MEM_PAGE_BITS;
+
+    if (count == 0 || last >= MEM_PAGES) {
+        return;
+    }
+    for (uint32_t p = first; p <= last; ++p) {
+        if (mem->page[p] >= MEM_PAGE_IO) {
+            mem_device_t *dev = &mem->device[mem->page[p] - MEM_PAGE_IO];
+            uint32_t dev_first = dev->base >> MEM_PAGE_BITS;
+            uint32_t dev_last = (dev->base + dev->size - 1) >> MEM_PAGE_BITS;
+            for (uint32_t q = dev_first; q <= dev_last; ++q) {
+                mem->page[q] = MEM_PAGE_RAM;
+            }
+            dev->size = 0; // Free the slot
+        }
+        mem->page[p] = MEM_PAGE_RAM;
+    }
+}
+
+/**
+ * Get a byte from a device page (the slow path of _get_mem_byte())
  * @param mem The memory array to use as system memory
  * @param addr The address in memory to read
- * @param setacc True to set the "accessed flag" on used memory data
- * @return The byte in memory at the specified address
+ * @return The byte read from the device
  */
-uint8_t _get_mem_byte(memory_t *mem, uint32_t addr, bool setacc)
+uint8_t _get_mem_byte_io(memory_t *mem, uint32_t addr)
 {
-    if (setacc) {
-        mem[addr].acc.R = 1;
+    mem_device_t *dev = _mem_get_device(mem, addr);
+
+    if (dev && dev->read) {
+        return dev->read(dev->ctx, addr - dev->base);
     }
-    return mem[addr].val; // Yes, this is simple...
+    return *_mem_val_rptr(mem, addr);
 }
 
 /**
- * Get a word from memory
- * @note This WILL NOT perform wrapping under most circumstances.
- *       The only case where wrapping will be performed is when
- *       the low byte is located at address 0x00ffffff. In this case,
- *       the high byte will be read from address 0x00000000.
+ * Get a byte from memory without any side effects. Devices are
+ * asked for the value their register would read as, but they do
+ * not see the access. Use this for displaying memory.
  * @param mem The memory array to use as system memory
  * @param addr The address in memory to read
- * @param setacc True to set the "accessed flag" on used memory data
- * @return The word in memory at the specified address and address+1
+ * @return The byte in memory at the specified address
  */
-uint16_t _get_mem_word(memory_t *mem, uint32_t addr, bool setacc)
+uint8_t _peek_mem_byte(memory_t *mem, uint32_t addr)
 {
-    if (setacc) {
-        mem[addr].acc.R = 1;
-        mem[(addr+1) & 0x00ffffff].acc.R = 1;
+    if (_test_mem_io(mem, addr)) {
+        mem_device_t *dev = _mem_get_device(mem, addr);
+        if (dev && dev->peek) {
+            return dev->peek(dev->ctx, addr - dev->base);
+        }
     }
-    return mem[addr].val | (mem[(addr+1) & 0x00ffffff].val << 8);
+    return *_mem_val_rptr(mem, addr);
 }
 
 /**
- * Get a word from memory, PAGE WRAPPING
+ * Determine if the CPU can read an address without any side effects:
+ * it is not a device register, or the device marks the register as
+ * pure (see mem_device_t).
  * @param mem The memory array to use as system memory
- * @param addr The address in memory to read
- * @param setacc True to set the "accessed flag" on used memory data
- * @return The word in memory at the specified address and address+1, page wrapped
+ * @param addr The address in memory to check
+ * @return True if reading the address has no side effects
  */
-uint16_t _get_mem_word_page_wrap(memory_t *mem, uint32_t addr, bool setacc)
+bool _test_mem_pure(memory_t *mem, uint32_t addr)
 {
-    uint16_t val = _get_mem_byte(mem, addr, setacc);
-    val |= _get_mem_byte(mem, _addr_add_val_page_wrap(addr, 1), setacc) << 8;
-    return val;
+    mem_device_t *dev;
+    uint32_t offs;
+
+    if (!_test_mem_io(mem, addr)) {
+        return true;
+    }
+    dev = _mem_get_device(mem, addr);
+    if (!dev || !dev->read) {
+        return true;
+    }
+    offs = addr - dev->base;
+    return offs < 32 && ((dev->pure >> offs) & 1);
+}
+
+/**
+ * Write a byte to a page which is not RAM (the slow path of _set_mem_byte())
+ * @param mem The memory array to use as system memory
+ * @param addr The address in memory to write
+ * @param val The data value to store
+ */
+static void _set_mem_byte_mapped(memory_t *mem, uint32_t addr, uint8_t val)
+{
+    if (mem->page[addr >> MEM_PAGE_BITS] == MEM_PAGE_ROM) {
+        return; // Read-only
+    }
+
+    mem_device_t *dev = _mem_get_device(mem, addr);
+    if (dev && dev->write) {
+        dev->write(dev->ctx, addr - dev->base, val);
+    }
+    else {
+        _mem_drop_decoded(mem, addr);
+        _mem_put_val(mem, addr, val);
+    }
 }
 
 /**
- * Get a word from memory, BANK WRAPPING
+ * Get a word from memory, PAGE WRAPPING
  * @param mem The memory array to use as system memory
  * @param addr The address in memory to read
  * @param setacc True to set the "accessed flag" on used memory data
- * @return The word in memory at the specified address and address+1, bank wrapped
+ * @return The word in memory at the specified address and address+1, page wrapped
  */
-uint16_t _get_mem_word_bank_wrap(memory_t *mem, uint32_t addr, bool setacc)
+uint16_t _get_mem_word_page_wrap(memory_t *mem, uint32_t addr, bool setacc)
 {
     uint16_t val = _get_mem_byte(mem, addr, setacc);
-    val |= _get_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), setacc) << 8;
+    val |= _get_mem_byte(mem, _addr_add_val_page_wrap(addr, 1), setacc) << 8;
     return val;
 }
 
@@ -242,6 +801,11 @@ uint16_t _get_mem_word_bank_wrap(memory_t *mem, uint32_t addr, bool setacc)
  */
 uint32_t _get_mem_long_bank_wrap(memory_t *mem, uint32_t addr, bool setacc)
 {
+    // All three bytes on the same RAM or ROM page: a single (unaligned) load
+    if (!setacc && (addr & 0xff) < 0xfe && !MEM_SLOW_PATH(_test_mem_io(mem, addr))) {
+        const uint8_t *v = _mem_val_rptr(mem, addr);
+        return v[0] | (v[1] << 8) | ((uint32_t)v[2] << 16);
+    }
     uint32_t val = _get_mem_byte(mem, addr, setacc);
     val |= _get_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), setacc) << 8;
     val |= _get_mem_byte(mem, _addr_add_val_bank_wrap(addr, 2), setacc) << 16;
@@ -258,9 +822,39 @@ uint32_t _get_mem_long_bank_wrap(memory_t *mem, uint32_t addr, bool setacc)
 void _set_mem_byte(memory_t *mem, uint32_t addr, uint8_t val, bool setacc)
 {
     if (setacc) {
-        mem[addr].acc.W = 1;
+        _mem_set_flag(mem, MEM_PLANE_W, addr);
+    }
+    if (MEM_SLOW_PATH(mem->page[addr >> MEM_PAGE_BITS] != MEM_PAGE_RAM)) {
+        _set_mem_byte_mapped(mem, addr, val);
+        return;
+    }
+    _mem_drop_decoded(mem, addr);
+    _mem_put_val(mem, addr, val);
+}
+
+/**
+ * Store a word if both of its bytes are on the same RAM page
+ * (the fast path of the word setters)
+ * @param mem The memory array to use as system memory
+ * @param addr The address in memory to write
+ * @param val The data value to store
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return True if the word was stored
+ */
+static inline bool _set_mem_word_direct(memory_t *mem, uint32_t addr, uint16_t val, bool setacc)
+{
+    if ((addr & 0xff) == 0xff || MEM_SLOW_PATH(mem->page[addr >> MEM_PAGE_BITS] != MEM_PAGE_RAM)) {
+        return false;
+    }
+    if (setacc) {
+        _mem_set_flag(mem, MEM_PLANE_W, addr);
+        _mem_set_flag(mem, MEM_PLANE_W, addr + 1);
     }
-    mem[addr].val = val; // Yes, this is simple...
+    _mem_drop_decoded(mem, addr);
+    _mem_drop_decoded(mem, addr + 1);
+    _mem_put_val(mem, addr, val & 0xff);
+    _mem_put_val(mem, addr + 1, val >> 8);
+    return true;
 }
 
 /**
@@ -276,12 +870,11 @@ void _set_mem_byte(memory_t *mem, uint32_t addr, uint8_t val, bool setacc)
  */
 void _set_mem_word(memory_t *mem, uint32_t addr, uint16_t val, bool setacc)
 {
-    if (setacc) {
-        mem[addr].acc.W = 1;
-        mem[(addr + 1) & 0x00ffffff].acc.W = 1;
+    if (_set_mem_word_direct(mem, addr, val, setacc)) {
+        return;
     }
-    mem[addr].val = val & 0xff;
-    mem[(addr + 1) & 0x00ffffff].val = val >> 8;
+    _set_mem_byte(mem, addr, val & 0xff, setacc);
+    _set_mem_byte(mem, (addr + 1) & 0x00ffffff, val >> 8, setacc);
 }
 
 /**
@@ -293,6 +886,9 @@ void _set_mem_word(memory_t *mem, uint32_t addr, uint16_t val, bool setacc)
  */
 void _set_mem_word_bank_wrap(memory_t *mem, uint32_t addr, uint16_t val, bool setacc)
 {
+    if (_set_mem_word_direct(mem, addr, val, setacc)) {
+        return;
+    }
     _set_mem_byte(mem, addr, val, setacc);
     _set_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), val >> 8, setacc);
 }
@@ -300,7 +896,10 @@ void _set_mem_word_bank_wrap(memory_t *mem, uint32_t addr, uint16_t val, bool se
 /**
  * Initialize the memory array with a source array
  * 
- * @note This does not modify flag data
+ * @note This does not modify flag data (other than dropping
+ *       any decoded instructions which overlap the copied data).
+ *       The data is copied straight into memory, so this can be
+ *       used to load ROMs. Devices do not see the writes.
  * @param *mem The memory array to save the source data in
  * @param *src The source data to copy into system memory
  * @param base_addr The starting address to copy (for system memory)
@@ -309,14 +908,39 @@ void _set_mem_word_bank_wrap(memory_t *mem, uint32_t addr, uint16_t val, bool se
 void _init_mem_arr(memory_t *mem, uint8_t *src, uint32_t base_addr, uint32_t count)
 {
     for (uint32_t i = base_addr, j = 0; j < count; ++i, ++j) {
-        mem[i].val = src[j];
+        _mem_drop_decoded(mem, i);
+    }
+#ifdef CPU_MEM_SPARSE
+    // A page at a time, leaving out the pages which would only be zeroed
+    for (uint32_t j = 0; j < count;) {
+        uint32_t addr = base_addr + j;
+        uint32_t n = MEM_PAGE_SIZE - (addr & (MEM_PAGE_SIZE - 1));
+        n = (n < count - j) ? n : count - j;
+
+        mem_page_t *pg = _mem_find_page(mem, addr);
+        for (uint32_t k = 0; !pg && k < n; ++k) {
+            if (src[j + k]) {
+                pg = _mem_alloc_page(mem, addr);
+                break;
+            }
+        }
+        if (pg) {
+            memcpy(&pg->val[addr & (MEM_PAGE_SIZE - 1)], src + j, n);
+        }
+        j += n;
+    }
+#else
+    _mem_copy_nonzero(mem->val + base_addr, src, count);
+#endif
+    if (count > 0) {
+        _mem_mark_dirty_range(mem, base_addr, count);
     }
 }
 
 /**
  * Copy data from memory into a destination buffer
  * 
- * @note this does not copy flag data
+ * @note this does not copy flag data or read from devices
  * @param *mem The memory to copy from
  * @param *dst The destination buffer
  * @param base_addr The starting address to copy
@@ -325,21 +949,116 @@ void _init_mem_arr(memory_t *mem, uint8_t *src, uint32_t base_addr, uint32_t cou
  */
 void _save_mem_arr(memory_t *mem, uint8_t *dst, uint32_t base_addr, uint32_t count)
 {
-    for (uint32_t i = base_addr, j = 0; j < count; ++i, ++j) {
-        dst[i] = mem[i].val;
+#ifdef CPU_MEM_SPARSE
+    for (uint32_t j = 0; j < count;) {
+        uint32_t addr = base_addr + j;
+        uint32_t n = MEM_PAGE_SIZE - (addr & (MEM_PAGE_SIZE - 1));
+        n = (n < count - j) ? n : count - j;
+        memcpy(dst + j, _mem_val_rptr(mem, addr), n);
+        j += n;
     }
+#else
+    memcpy(dst, mem->val + base_addr, count);
+#endif
 }
 
 /**
- * Get the values of the flags on an address without modifying them
- * 
- * @param *mem The memory to read
- * @param addr The address in memory to access
- * @return The flag data present at address
+ * Check if a range of memory can be accessed directly in bulk
+ * (no device pages, no breakpoints and, for writes, no ROM)
+ * @note Breakpoints are checked a flag plane byte at a time, so
+ *       one on an address next to the range also counts
+ * @param mem The memory to check
+ * @param base_addr The first address of the range
+ * @param count The number of addresses in the range (> 0)
+ * @param write True if the range is going to be written to
+ * @return True if the range is all plain memory
+ */
+static bool _mem_range_plain(memory_t *mem, uint32_t base_addr, uint32_t count, bool write)
+{
+    uint32_t last = base_addr + count - 1;
+
+    for (uint32_t p = base_addr >> MEM_PAGE_BITS; p <= last >> MEM_PAGE_BITS; ++p) {
+        if (mem->page[p] >= MEM_PAGE_IO || (write && mem->page[p] != MEM_PAGE_RAM)) {
+            return false;
+        }
+    }
+    for (uint32_t i = base_addr >> 3; i <= last >> 3; ++i) {
+        if (*_mem_flag_rptr(mem, MEM_PLANE_B, i << 3)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Move a range of memory to another one with the same result as moving
+ * it one byte at a time (so an overlapping move can repeat a pattern,
+ * the same way MVN/MVP do). Neither range may cross the end of memory.
+ * @note Nothing is moved if either range has a device page or a
+ *       breakpoint on it or the destination has ROM on it
+ * @param mem The memory array to use as system memory
+ * @param dst The first (lowest) address of the destination range
+ * @param src The first (lowest) address of the source range
+ * @param count The number of bytes to move (> 0)
+ * @param down True to move the highest byte first, false to move the lowest first
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return True if the bytes were moved
  */
-mem_flag_t _test_mem_flags(memory_t *mem, uint32_t addr)
+bool _move_mem_block(memory_t *mem, uint32_t dst, uint32_t src, uint32_t count, bool down, bool setacc)
 {
-    return mem[addr].acc;
+    if (!_mem_range_plain(mem, src, count, false) || !_mem_range_plain(mem, dst, count, true)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < count; ++i) {
+        if (setacc) {
+            _mem_set_flag(mem, MEM_PLANE_R, src + i);
+            _mem_set_flag(mem, MEM_PLANE_W, dst + i);
+        }
+        _mem_drop_decoded(mem, dst + i);
+    }
+
+#ifdef CPU_MEM_SPARSE
+    // The pages are not next to each other, so move a byte at
+    // a time in the same order as the instruction would
+    for (uint32_t i = 0; i < count; ++i) {
+        uint32_t j = down ? count - 1 - i : i;
+        _mem_put_val(mem, dst + j, *_mem_val_rptr(mem, src + j));
+    }
+#else
+    uint8_t *v = mem->val;
+    _mem_mark_dirty_range(mem, dst, count);
+
+    if (!down && dst > src && dst - src < count) {
+        // Each byte is read after the one (dst - src) below it was written,
+        // so the first (dst - src) bytes repeat through the destination
+        uint32_t step = dst - src;
+        if (step == 1) {
+            memset(v + dst, v[src], count);
+            return true;
+        }
+        for (uint32_t i = 0; i < count; i += step) {
+            memcpy(v + dst + i, v + src + i, (count - i < step) ? count - i : step);
+        }
+    }
+    else if (down && src > dst && src - dst < count) {
+        // Same as above, from the top down
+        uint32_t step = src - dst;
+        if (step == 1) {
+            memset(v + dst, v[src + count - 1], count);
+            return true;
+        }
+        for (uint32_t i = count; i > 0;) {
+            uint32_t n = (i < step) ? i : step;
+            i -= n;
+            memcpy(v + dst + i, v + src + i, n);
+        }
+    }
+    else {
+        memmove(v + dst, v + src, count);
+    }
+#endif
+    return true;
 }
 
 /**
@@ -351,11 +1070,13 @@ mem_flag_t _test_mem_flags(memory_t *mem, uint32_t addr)
  *             bit 0: Read flag
  *             bit 1: Write flag
  *             bit 2: Break flag
- *             bit 3..7: Unused
+ *             bit 3: Decoded block start flag
+ *             bit 4: Decoded block byte flag
+ *             bit 5..7: Unused
  */
 mem_flag_t _test_and_reset_mem_flags(memory_t *mem, uint32_t addr, uint8_t mask)
 {
-    mem_flag_t t = mem[addr].acc;
+    mem_flag_t t = _test_mem_flags(mem, addr);
 
     // Flag resetting
     _reset_mem_flags(mem, addr, mask);
@@ -372,12 +1093,18 @@ mem_flag_t _test_and_reset_mem_flags(memory_t *mem, uint32_t addr, uint8_t mask)
  *             bit 0: Read flag
  *             bit 1: Write flag
  *             bit 2: Break flag
- *             bit 3..7: Unused
+ *             bit 3: Decoded block start flag
+ *             bit 4: Decoded block byte flag
+ *             bit 5..7: Unused
  */
 void _reset_mem_flags(memory_t *mem, uint32_t addr, uint8_t mask)
 {
     // Flag resetting
-    *(uint8_t *)&(mem[addr].acc) = (~mask) & *(uint8_t *) &(mem[addr].acc);
+    for (int plane = 0; plane < MEM_PLANES; ++plane) {
+        if (mask & (1u << plane)) {
+            _mem_clear_flag(mem, plane, addr);
+        }
+    }
 }
 
 /**
@@ -389,13 +1116,24 @@ void _reset_mem_flags(memory_t *mem, uint32_t addr, uint8_t mask)
  *             bit 0: Read flag
  *             bit 1: Write flag
  *             bit 2: Break flag
- *             bit 3..7: Unused
+ *             bit 3: Decoded block start flag
+ *             bit 4: Decoded block byte flag
+ *             bit 5..7: Unused
  * @return The flag data present at address prior to calling this function
  */
 void _set_mem_flags(memory_t *mem, uint32_t addr, uint8_t mask)
 {
-    // Flag resetting
-    *(uint8_t *)&(mem[addr].acc) = (mask) | *(uint8_t *) &(mem[addr].acc);
+    // Decoded blocks end before breakpoints, so setting one splits any block containing it
+    if (mask & MEM_FLAG_B) {
+        _mem_drop_decoded(mem, addr);
+    }
+
+    // Flag setting
+    for (int plane = 0; plane < MEM_PLANES; ++plane) {
+        if (mask & (1u << plane)) {
+            _mem_set_flag(mem, plane, addr);
+        }
+    }
 }
 
 
@@ -533,13 +1271,13 @@ uint32_t _stackCPU_pop24(CPU_t *cpu, memory_t *mem, bool setacc)
  * This will BANK WRAP when reading the word from memory
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the indirect address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The word in memory at the indirect address (in the current PRB bank)
  */
-uint16_t _addrCPU_getAbsoluteIndexedIndirectX(CPU_t *cpu, memory_t *mem, bool setacc)
+uint16_t _addrCPU_resolveAbsoluteIndexedIndirectX(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction
-    uint32_t address = _cpu_get_immd_word(cpu, mem, setacc);
+    uint32_t address = operand;
     address += cpu->X;
     address &= 0xffff; // Wraparound
     address |= _cpu_get_pbr(cpu);
@@ -549,6 +1287,19 @@ uint16_t _addrCPU_getAbsoluteIndexedIndirectX(CPU_t *cpu, memory_t *mem, bool se
     return data;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveAbsoluteIndexedIndirectX()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveAbsoluteIndexedIndirectX()
+ */
+uint16_t _addrCPU_getAbsoluteIndexedIndirectX(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveAbsoluteIndexedIndirectX(cpu, mem, _cpu_get_immd_word(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 16-bit word in memory stored at the addr
  * from the current instruction. (i.e. the PC part of the resultant
@@ -556,13 +1307,15 @@ uint16_t _addrCPU_getAbsoluteIndexedIndirectX(CPU_t *cpu, memory_t *mem, bool se
  * This will BANK WRAP when reading the word from memory
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the indirect address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The word in memory at the indirect address (in bank 0)
  */
-uint16_t _addrCPU_getAbsoluteIndirect(CPU_t *cpu, memory_t *mem, bool setacc)
+uint16_t _addrCPU_resolveAbsoluteIndirect(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction
-    uint32_t address = _cpu_get_immd_word(cpu, mem, setacc);
+    (void)cpu;
+
+    uint32_t address = operand;
 
     // Find and return the resultant indirect address value
     // (from Bank 0)
@@ -570,6 +1323,19 @@ uint16_t _addrCPU_getAbsoluteIndirect(CPU_t *cpu, memory_t *mem, bool setacc)
     return data;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveAbsoluteIndirect()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveAbsoluteIndirect()
+ */
+uint16_t _addrCPU_getAbsoluteIndirect(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveAbsoluteIndirect(cpu, mem, _cpu_get_immd_word(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit word in memory stored at the addr
  * from the current instruction. (i.e. the PC part of the resultant
@@ -577,13 +1343,15 @@ uint16_t _addrCPU_getAbsoluteIndirect(CPU_t *cpu, memory_t *mem, bool setacc)
  * This will BANK WRAP when reading the word from memory
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the indirect address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The word and byte in memory at the indirect address (in bank 0)
  */
-uint32_t _addrCPU_getAbsoluteIndirectLong(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveAbsoluteIndirectLong(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction
-    uint32_t address = _cpu_get_immd_word(cpu, mem, setacc);
+    (void)cpu;
+
+    uint32_t address = operand;
 
     // Find and return the resultant indirect address value
     // (from Bank 0)
@@ -591,83 +1359,179 @@ uint32_t _addrCPU_getAbsoluteIndirectLong(CPU_t *cpu, memory_t *mem, bool setacc
     return data;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveAbsoluteIndirectLong()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveAbsoluteIndirectLong()
+ */
+uint32_t _addrCPU_getAbsoluteIndirectLong(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveAbsoluteIndirectLong(cpu, mem, _cpu_get_immd_word(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to the absolute address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getAbsolute(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveAbsolute(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction
-    uint32_t address = _cpu_get_immd_word(cpu, mem, setacc);
+    (void)mem;
+    (void)setacc;
+
+    uint32_t address = operand;
 
     // Find and return the resultant address value
     return _cpu_get_dbr(cpu) | address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveAbsolute()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveAbsolute()
+ */
+uint32_t _addrCPU_getAbsolute(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveAbsolute(cpu, mem, _cpu_get_immd_word(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to the absolute, X-indexed address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getAbsoluteIndexedX(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveAbsoluteIndexedX(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction and the current data bank
-    uint32_t address = _cpu_get_immd_word(cpu, mem, setacc) | _cpu_get_dbr(cpu);
+    (void)mem;
+    (void)setacc;
+
+    // Add the current data bank
+    uint32_t address = operand | _cpu_get_dbr(cpu);
     address += cpu->X; // No wraparound
     return address & 0xffffff;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveAbsoluteIndexedX()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveAbsoluteIndexedX()
+ */
+uint32_t _addrCPU_getAbsoluteIndexedX(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveAbsoluteIndexedX(cpu, mem, _cpu_get_immd_word(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to the absolute, Y-indexed address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getAbsoluteIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveAbsoluteIndexedY(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction and the current data bank
-    uint32_t address = _cpu_get_immd_word(cpu, mem, setacc) | _cpu_get_dbr(cpu);
+    (void)mem;
+    (void)setacc;
+
+    // Add the current data bank
+    uint32_t address = operand | _cpu_get_dbr(cpu);
     address += cpu->Y; // No wraparound
     return address & 0xffffff;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveAbsoluteIndexedY()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveAbsoluteIndexedY()
+ */
+uint32_t _addrCPU_getAbsoluteIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveAbsoluteIndexedY(cpu, mem, _cpu_get_immd_word(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to the long, X-indexed address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction's operand
  */
-uint32_t _addrCPU_getLongIndexedX(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveLongIndexedX(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction and the current data bank
-    uint32_t address = _cpu_get_immd_long(cpu, mem, setacc);
+    (void)mem;
+    (void)setacc;
+
+    uint32_t address = operand;
     address += cpu->X; // No wraparound
     return address & 0xffffff;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveLongIndexedX()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveLongIndexedX()
+ */
+uint32_t _addrCPU_getLongIndexedX(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveLongIndexedX(cpu, mem, _cpu_get_immd_long(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to by the direct page address of
  * the current instruction's operand (always bank 0)
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getDirectPage(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveDirectPage(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
+    (void)mem;
+    (void)setacc;
+
     // Find and return the resultant address value
-    return _addr_add_val_bank_wrap(cpu->D, _cpu_get_immd_byte(cpu, mem, setacc));
+    return _addr_add_val_bank_wrap(cpu->D, operand);
+}
+
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveDirectPage()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveDirectPage()
+ */
+uint32_t _addrCPU_getDirectPage(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveDirectPage(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
 }
 
 /**
@@ -675,13 +1539,13 @@ uint32_t _addrCPU_getDirectPage(CPU_t *cpu, memory_t *mem, bool setacc)
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getDirectPageIndirect(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveDirectPageIndirect(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand byte of the current instruction and bank 0
-    uint32_t address = _cpu_get_immd_byte(cpu, mem, setacc);
+    uint32_t address = operand;
 
     if (cpu->P.E && ((cpu->D & 0xff) == 0))
     {
@@ -698,18 +1562,31 @@ uint32_t _addrCPU_getDirectPageIndirect(CPU_t *cpu, memory_t *mem, bool setacc)
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveDirectPageIndirect()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveDirectPageIndirect()
+ */
+uint32_t _addrCPU_getDirectPageIndirect(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveDirectPageIndirect(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to by the [dp] address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getDirectPageIndirectLong(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveDirectPageIndirectLong(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction and bank 0
-    uint32_t address = _cpu_get_immd_byte(cpu, mem, setacc);
+    uint32_t address = operand;
 
     address = _addr_add_val_bank_wrap(cpu->D, address);
     address = _get_mem_long_bank_wrap(mem, address, setacc); // 24-bit pointer
@@ -717,18 +1594,34 @@ uint32_t _addrCPU_getDirectPageIndirectLong(CPU_t *cpu, memory_t *mem, bool seta
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveDirectPageIndirectLong()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveDirectPageIndirectLong()
+ */
+uint32_t _addrCPU_getDirectPageIndirectLong(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveDirectPageIndirectLong(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to by the dp, X-indexed address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getDirectPageIndexedX(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveDirectPageIndexedX(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction and bank 0
-    uint32_t address = _cpu_get_immd_byte(cpu, mem, setacc);
+    (void)mem;
+    (void)setacc;
+
+    uint32_t address = operand;
 
     if (cpu->P.E && ((cpu->D & 0xff) == 0))
     {
@@ -743,18 +1636,31 @@ uint32_t _addrCPU_getDirectPageIndexedX(CPU_t *cpu, memory_t *mem, bool setacc)
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveDirectPageIndexedX()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveDirectPageIndexedX()
+ */
+uint32_t _addrCPU_getDirectPageIndexedX(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveDirectPageIndexedX(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to by the (dp,X) address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getDirectPageIndexedIndirectX(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveDirectPageIndexedIndirectX(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction and bank 0
-    uint32_t address = _cpu_get_immd_byte(cpu, mem, setacc);
+    uint32_t address = operand;
 
     if (cpu->P.E && ((cpu->D & 0xff) == 0))
     {
@@ -772,18 +1678,34 @@ uint32_t _addrCPU_getDirectPageIndexedIndirectX(CPU_t *cpu, memory_t *mem, bool
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveDirectPageIndexedIndirectX()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveDirectPageIndexedIndirectX()
+ */
+uint32_t _addrCPU_getDirectPageIndexedIndirectX(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveDirectPageIndexedIndirectX(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to by the dp, Y-indexed address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getDirectPageIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveDirectPageIndexedY(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction and bank 0
-    uint32_t address = _cpu_get_immd_byte(cpu, mem, setacc);
+    (void)mem;
+    (void)setacc;
+
+    uint32_t address = operand;
 
     if (cpu->P.E && ((cpu->D & 0xff) == 0))
     {
@@ -798,18 +1720,31 @@ uint32_t _addrCPU_getDirectPageIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveDirectPageIndexedY()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveDirectPageIndexedY()
+ */
+uint32_t _addrCPU_getDirectPageIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveDirectPageIndexedY(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to by the (dp),Y address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getDirectPageIndirectIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveDirectPageIndirectIndexedY(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction and bank 0
-    uint32_t address = _cpu_get_immd_byte(cpu, mem, setacc);
+    uint32_t address = operand;
 
     address = _addr_add_val_bank_wrap(cpu->D, address);
 
@@ -829,18 +1764,31 @@ uint32_t _addrCPU_getDirectPageIndirectIndexedY(CPU_t *cpu, memory_t *mem, bool
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveDirectPageIndirectIndexedY()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveDirectPageIndirectIndexedY()
+ */
+uint32_t _addrCPU_getDirectPageIndirectIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveDirectPageIndirectIndexedY(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to by the [dp],Y address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
-uint32_t _addrCPU_getDirectPageIndirectLongIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveDirectPageIndirectLongIndexedY(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction and bank 0
-    uint32_t address = _cpu_get_immd_byte(cpu, mem, setacc);
+    uint32_t address = operand;
 
     address = _addr_add_val_bank_wrap(cpu->D, address);
 
@@ -853,18 +1801,35 @@ uint32_t _addrCPU_getDirectPageIndirectLongIndexedY(CPU_t *cpu, memory_t *mem, b
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveDirectPageIndirectLongIndexedY()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveDirectPageIndirectLongIndexedY()
+ */
+uint32_t _addrCPU_getDirectPageIndirectLongIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveDirectPageIndirectLongIndexedY(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 16-bit PC value of a relative-8 branch at the
  * current CPU's PC is taken.
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the relative offset
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 16-bit PC address as a result of adding the signed
  *         8-bit relative offset
  */
-uint32_t _addrCPU_getRelative8(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveRelative8(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    uint32_t offset = _cpu_get_immd_byte(cpu, mem, setacc);
+    (void)mem;
+    (void)setacc;
+
+    uint32_t offset = operand;
     if (offset & 0x80)
     {
         offset |= 0xffffff00; // Sign extension
@@ -875,18 +1840,35 @@ uint32_t _addrCPU_getRelative8(CPU_t *cpu, memory_t *mem, bool setacc)
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveRelative8()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveRelative8()
+ */
+uint32_t _addrCPU_getRelative8(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveRelative8(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 16-bit PC value of a relative-16 branch at the
  * current CPU's PC is taken.
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the relative offset
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 16-bit PC address as a result of adding the signed
  *         16-bit relative offset
  */
-uint32_t _addrCPU_getRelative16(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveRelative16(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    uint32_t offset = _cpu_get_immd_word(cpu, mem, setacc);
+    (void)mem;
+    (void)setacc;
+
+    uint32_t offset = operand;
     if (offset & 0x8000)
     {
         offset |= 0xffff0000; // Sign extension
@@ -897,19 +1879,48 @@ uint32_t _addrCPU_getRelative16(CPU_t *cpu, memory_t *mem, bool setacc)
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveRelative16()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveRelative16()
+ */
+uint32_t _addrCPU_getRelative16(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveRelative16(cpu, mem, _cpu_get_immd_word(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the 24-bit address pointed to the long address of
  * the current instruction's operand
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The 24-bit effective address of the current instruction
  */
+uint32_t _addrCPU_resolveLong(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
+{
+    (void)cpu;
+    (void)mem;
+    (void)setacc;
+
+    return operand;
+}
+
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveLong()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveLong()
+ */
 uint32_t _addrCPU_getLong(CPU_t *cpu, memory_t *mem, bool setacc)
 {
-    // Get the immediate operand word of the current instruction
-    uint32_t address = _cpu_get_immd_long(cpu, mem, setacc);
-    return address;
+    return _addrCPU_resolveLong(cpu, mem, _cpu_get_immd_long(cpu, mem, setacc), setacc);
 }
 
 /**
@@ -917,11 +1928,13 @@ uint32_t _addrCPU_getLong(CPU_t *cpu, memory_t *mem, bool setacc)
  * (PC+1)
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address (UNUSED)
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The address of the immediate operand of the current instruction
  */
-uint32_t _addrCPU_getImmediate(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveImmediate(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
+    (void)operand;
     (void)mem;
     (void)setacc;
     
@@ -931,31 +1944,60 @@ uint32_t _addrCPU_getImmediate(CPU_t *cpu, memory_t *mem, bool setacc)
     return address;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveImmediate()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveImmediate()
+ */
+uint32_t _addrCPU_getImmediate(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveImmediate(cpu, mem, 0, setacc);
+}
+
 /**
  * Returns the effective stack relative address of the current instruction
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The SR address of the current instruction
  */
-uint32_t _addrCPU_getStackRelative(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveStackRelative(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction
-    uint32_t address = _cpu_get_immd_byte(cpu, mem, setacc);
+    (void)mem;
+    (void)setacc;
+
+    uint32_t address = operand;
     return _addr_add_val_bank_wrap(cpu->SP, address);
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveStackRelative()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveStackRelative()
+ */
+uint32_t _addrCPU_getStackRelative(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveStackRelative(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 /**
  * Returns the effective stack relative y-indexed address of the current instruction
  * @param cpu The cpu to use for the operation
  * @param mem The memory which will provide the operand address
+ * @param operand The operand bytes of the current instruction
  * @param setacc True to set the "accessed flag" on used memory data
  * @return The SRINDY address of the current instruction
  */
-uint32_t _addrCPU_getStackRelativeIndirectIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+uint32_t _addrCPU_resolveStackRelativeIndirectIndexedY(CPU_t *cpu, memory_t *mem, uint32_t operand, bool setacc)
 {
-    // Get the immediate operand word of the current instruction
-    uint32_t address = _cpu_get_immd_byte(cpu, mem, setacc);
+    uint32_t address = operand;
     address = _addr_add_val_bank_wrap(cpu->SP, address); // Calculate pointer offset
     address = _get_mem_word_bank_wrap(mem, address, setacc); // Get pointer
     address |= _cpu_get_dbr(cpu);
@@ -963,4 +2005,17 @@ uint32_t _addrCPU_getStackRelativeIndirectIndexedY(CPU_t *cpu, memory_t *mem, bo
     return  address & 0xffffff;
 }
 
+/**
+ * Fetches the operand of the current instruction and resolves it
+ * with _addrCPU_resolveStackRelativeIndirectIndexedY()
+ * @param cpu The cpu to use for the operation
+ * @param mem The memory which will provide the operand
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return See _addrCPU_resolveStackRelativeIndirectIndexedY()
+ */
+uint32_t _addrCPU_getStackRelativeIndirectIndexedY(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    return _addrCPU_resolveStackRelativeIndirectIndexedY(cpu, mem, _cpu_get_immd_byte(cpu, mem, setacc), setacc);
+}
+
 
@@ -9,38 +9,429 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stddef.h>
 
 #include "65816.h"
 
+// Helpers which are used for every instruction (inlined)
+// Note: _test_mem_flags() and _get_mem_byte() are memory functions (see below)
+/**
+ * Get the CPU's PROGRAM BANK, shifted to be bits 16..23 of the value
+ * @param cpu A pointer to the CPU struct from which the PBR will be retrieved
+ * @return The PBR of the given cpu, placed in bits 23..16
+ */
+static inline uint32_t _cpu_get_pbr(CPU_t *cpu)
+{
+    return (uint32_t)cpu->PBR << 16;
+}
+
+/**
+ * Get a CPU's 24 bit PC address
+ * @param cpu A pointer to the CPU struct from which to retrieve the 24-bit PC address
+ * @return The cpu's PC concatenated with the PBR
+ */
+static inline uint32_t _cpu_get_effective_pc(CPU_t *cpu)
+{
+    return _cpu_get_pbr(cpu) | cpu->PC;
+}
+
+/**
+ * Add a value to an address, BANK WRAPPING
+ * @param addr The base address of the operation
+ * @param offset The amount to add to the base address
+ * @return The addr plus offset, bank wrapped
+ */
+static inline uint32_t _addr_add_val_bank_wrap(uint32_t addr, uint32_t offset)
+{
+    return (addr & 0x00ff0000) | ((addr + offset) & 0x0000ffff);
+}
+
+/**
+ * Get the CPU's N flag (worked out from the last result which set it)
+ * @param cpu The CPU to check
+ * @return True if N is set
+ */
+static inline bool _cpu_get_n(CPU_t *cpu)
+{
+    return cpu->P.NZ_N >> 7;
+}
+
+/**
+ * Get the CPU's Z flag (worked out from the last result which set it)
+ * @param cpu The CPU to check
+ * @return True if Z is set
+ */
+static inline bool _cpu_get_z(CPU_t *cpu)
+{
+    return cpu->P.NZ_Z == 0;
+}
+
+/**
+ * Set or clear the CPU's N flag
+ * @param cpu The CPU to modify
+ * @param n The new state of the flag
+ */
+static inline void _cpu_set_n(CPU_t *cpu, bool n)
+{
+    cpu->P.NZ_N = n ? 0x80 : 0;
+}
+
+/**
+ * Set or clear the CPU's Z flag
+ * @param cpu The CPU to modify
+ * @param z The new state of the flag
+ */
+static inline void _cpu_set_z(CPU_t *cpu, bool z)
+{
+    cpu->P.NZ_Z = z ? 0 : 1;
+}
+
+/**
+ * Set the CPU's N and Z flags from an 8-bit result
+ * @param cpu The CPU to modify
+ * @param val The result
+ */
+static inline void _cpu_set_nz8(CPU_t *cpu, uint8_t val)
+{
+    cpu->P.NZ_N = val;
+    cpu->P.NZ_Z = val;
+}
+
+/**
+ * Set the CPU's N and Z flags from a 16-bit result
+ * @param cpu The CPU to modify
+ * @param val The result
+ */
+static inline void _cpu_set_nz16(CPU_t *cpu, uint16_t val)
+{
+    cpu->P.NZ_N = val >> 8;
+    cpu->P.NZ_Z = val;
+}
+
+#ifdef CPU_MEM_SPARSE
+// What every page which has not been allocated reads as
+extern const mem_page_t _mem_zero_page;
+
+mem_page_t *_mem_alloc_page(memory_t *, uint32_t);
+
+/**
+ * Find the page of sparse memory which holds an address
+ * 
+ * @param *mem The memory to look in
+ * @param addr The address in memory
+ * @return The page, or NULL if it has not been allocated
+ */
+static inline mem_page_t *_mem_find_page(memory_t *mem, uint32_t addr)
+{
+    mem_page_t **bank = mem->bank[addr >> 16];
+    return bank ? bank[(addr >> MEM_PAGE_BITS) & (MEM_BANK_PAGES - 1)] : NULL;
+}
+
+/**
+ * Get the page of sparse memory which holds an address for reading
+ * 
+ * @param *mem The memory to look in
+ * @param addr The address in memory
+ * @return The page, or the zero page if it has not been allocated
+ */
+static inline const mem_page_t *_mem_read_page(memory_t *mem, uint32_t addr)
+{
+    mem_page_t *pg = _mem_find_page(mem, addr);
+    return pg ? pg : &_mem_zero_page;
+}
+
+/**
+ * Get the page of sparse memory which holds an address for writing,
+ * allocating it if this is the first write to it
+ * 
+ * @param *mem The memory to look in
+ * @param addr The address in memory
+ * @return The page, or NULL if it could not be allocated
+ */
+static inline mem_page_t *_mem_write_page(memory_t *mem, uint32_t addr)
+{
+    mem_page_t *pg = _mem_find_page(mem, addr);
+    return pg ? pg : _mem_alloc_page(mem, addr);
+}
+#endif
+
+/**
+ * Get a pointer to the value of an address for reading. The bytes
+ * after it can be read through the pointer up to the end of its page.
+ * 
+ * @param *mem The memory to read
+ * @param addr The address in memory to access
+ * @return The address's value
+ */
+static inline const uint8_t *_mem_val_rptr(memory_t *mem, uint32_t addr)
+{
+#ifdef CPU_MEM_SPARSE
+    return &_mem_read_page(mem, addr)->val[addr & (MEM_PAGE_SIZE - 1)];
+#else
+    return &mem->val[addr];
+#endif
+}
+
+/**
+ * Get a pointer to the byte of a flag's bit-plane which holds an
+ * address's flag (bit (addr & 7) of the byte) for reading
+ * 
+ * @param *mem The memory to read
+ * @param plane The flag's bit-plane (MEM_PLANE_*)
+ * @param addr The address in memory to access
+ * @return The byte of the bit-plane
+ */
+static inline const uint8_t *_mem_flag_rptr(memory_t *mem, int plane, uint32_t addr)
+{
+#ifdef CPU_MEM_SPARSE
+    return &_mem_read_page(mem, addr)->flag[plane][(addr & (MEM_PAGE_SIZE - 1)) >> 3];
+#else
+    return &mem->flag[plane][addr >> 3];
+#endif
+}
+
+/**
+ * Get one of the flags on an address
+ * 
+ * @param *mem The memory to read
+ * @param plane The flag's bit-plane (MEM_PLANE_*)
+ * @param addr The address in memory to access
+ * @return True if the flag is set
+ */
+static inline bool _mem_get_flag(memory_t *mem, int plane, uint32_t addr)
+{
+    return (*_mem_flag_rptr(mem, plane, addr) >> (addr & 7)) & 1;
+}
+
+/**
+ * Set one of the flags on an address
+ * @note With sparse memory, the flag is not set if its
+ *       page can not be allocated
+ * 
+ * @param *mem The memory to modify
+ * @param plane The flag's bit-plane (MEM_PLANE_*)
+ * @param addr The address in memory to access
+ */
+static inline void _mem_set_flag(memory_t *mem, int plane, uint32_t addr)
+{
+#ifdef CPU_MEM_SPARSE
+    mem_page_t *pg = _mem_write_page(mem, addr);
+    if (pg) {
+        pg->flag[plane][(addr & (MEM_PAGE_SIZE - 1)) >> 3] |= 1u << (addr & 7);
+    }
+#else
+    mem->flag[plane][addr >> 3] |= 1u << (addr & 7);
+#endif
+}
+
+/**
+ * Clear one of the flags on an address
+ * 
+ * @param *mem The memory to modify
+ * @param plane The flag's bit-plane (MEM_PLANE_*)
+ * @param addr The address in memory to access
+ */
+static inline void _mem_clear_flag(memory_t *mem, int plane, uint32_t addr)
+{
+#ifdef CPU_MEM_SPARSE
+    // Pages which have not been allocated have no flags set
+    mem_page_t *pg = _mem_find_page(mem, addr);
+    if (pg) {
+        pg->flag[plane][(addr & (MEM_PAGE_SIZE - 1)) >> 3] &= ~(1u << (addr & 7));
+    }
+#else
+    mem->flag[plane][addr >> 3] &= ~(1u << (addr & 7));
+#endif
+}
+
+/**
+ * Get the values of the flags on an address without modifying them
+ * @note Only the planes of the flags which the caller looks at
+ *       are read once this is inlined
+ * 
+ * @param *mem The memory to read
+ * @param addr The address in memory to access
+ * @return The flag data present at address
+ */
+static inline mem_flag_t _test_mem_flags(memory_t *mem, uint32_t addr)
+{
+    mem_flag_t f;
+    f.R = _mem_get_flag(mem, MEM_PLANE_R, addr);
+    f.W = _mem_get_flag(mem, MEM_PLANE_W, addr);
+    f.B = _mem_get_flag(mem, MEM_PLANE_B, addr);
+    f.X = _mem_get_flag(mem, MEM_PLANE_X, addr);
+    f.C = _mem_get_flag(mem, MEM_PLANE_C, addr);
+    return f;
+}
+
+/**
+ * Check if an address is on a page which belongs to a memory-mapped device
+ * 
+ * @param *mem The memory to check
+ * @param addr The address in memory to check
+ * @return True if accesses to the address can go to a device
+ */
+static inline bool _test_mem_io(memory_t *mem, uint32_t addr)
+{
+    return mem->page[addr >> MEM_PAGE_BITS] >= MEM_PAGE_IO;
+}
+
+uint8_t _get_mem_byte_io(memory_t *, uint32_t);
+
+// Device (and ROM) pages are rare, so keep the compiler's
+// code layout in favor of the direct RAM path
+#ifdef __GNUC__
+#define MEM_SLOW_PATH(cond) __builtin_expect(!!(cond), 0)
+#else
+#define MEM_SLOW_PATH(cond) (cond)
+#endif
+
+/**
+ * Get a byte from memory
+ * @note RAM and ROM pages are read directly, only device pages
+ *       take the slower path through the page table
+ * @param mem The memory array to use as system memory
+ * @param addr The address in memory to read
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return The byte in memory at the specified address
+ */
+static inline uint8_t _get_mem_byte(memory_t *mem, uint32_t addr, bool setacc)
+{
+    if (setacc) {
+        _mem_set_flag(mem, MEM_PLANE_R, addr);
+    }
+    if (MEM_SLOW_PATH(_test_mem_io(mem, addr))) {
+        return _get_mem_byte_io(mem, addr);
+    }
+    return *_mem_val_rptr(mem, addr);
+}
+
+/**
+ * Get a word from memory
+ * @note This WILL NOT perform wrapping under most circumstances.
+ *       The only case where wrapping will be performed is when
+ *       the low byte is located at address 0x00ffffff. In this case,
+ *       the high byte will be read from address 0x00000000.
+ * @param mem The memory array to use as system memory
+ * @param addr The address in memory to read
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return The word in memory at the specified address and address+1
+ */
+static inline uint16_t _get_mem_word(memory_t *mem, uint32_t addr, bool setacc)
+{
+    // Both bytes on the same RAM or ROM page: a single (unaligned) load
+    if (!setacc && (addr & 0xff) != 0xff && !MEM_SLOW_PATH(_test_mem_io(mem, addr))) {
+        const uint8_t *v = _mem_val_rptr(mem, addr);
+        return v[0] | (v[1] << 8);
+    }
+    uint16_t val = _get_mem_byte(mem, addr, setacc);
+    return val | (_get_mem_byte(mem, (addr + 1) & 0x00ffffff, setacc) << 8);
+}
+
+/**
+ * Get a word from memory, BANK WRAPPING
+ * @param mem The memory array to use as system memory
+ * @param addr The address in memory to read
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return The word in memory at the specified address and address+1, bank wrapped
+ */
+static inline uint16_t _get_mem_word_bank_wrap(memory_t *mem, uint32_t addr, bool setacc)
+{
+    // Both bytes on the same RAM or ROM page: a single (unaligned) load
+    if (!setacc && (addr & 0xff) != 0xff && !MEM_SLOW_PATH(_test_mem_io(mem, addr))) {
+        const uint8_t *v = _mem_val_rptr(mem, addr);
+        return v[0] | (v[1] << 8);
+    }
+    uint16_t val = _get_mem_byte(mem, addr, setacc);
+    return val | (_get_mem_byte(mem, _addr_add_val_bank_wrap(addr, 1), setacc) << 8);
+}
+
+/**
+ * Get the byte in memory at the address CPU PC+1
+ * @note This will BANK WRAP
+ * @param cpu The CPU from which to retrieve the PC
+ * @param mem The memory from which to pull the value
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return The value of the byte in memory at the CPU's PC+1
+ */
+static inline uint8_t _cpu_get_immd_byte(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    uint32_t addr = _cpu_get_effective_pc(cpu);
+    addr = _addr_add_val_bank_wrap(addr, 1);
+    return _get_mem_byte(mem, addr, setacc);
+}
+
+/**
+ * Get the word in memory at the address CPU PC+1 (high byte @ PC+2)
+ * @note This will BANK WRAP
+ * @param cpu The CPU from which to retrieve the PC
+ * @param mem The memory from which to pull the value
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return The value of the word in memory at the CPU's PC+1
+ */
+static inline uint16_t _cpu_get_immd_word(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    uint32_t addr = _cpu_get_effective_pc(cpu);
+    addr = _addr_add_val_bank_wrap(addr, 1);
+    uint16_t val = _get_mem_byte(mem, addr, setacc);
+    addr = _addr_add_val_bank_wrap(addr, 1);
+    return val | (_get_mem_byte(mem, addr, setacc) << 8);
+}
+
+/**
+ * Get the long in memory at the address CPU PC+1 (high byte @ PC+3)
+ * @note This will BANK WRAP
+ * @param cpu The CPU from which to retrieve the PC
+ * @param mem The memory from which to pull the value
+ * @param setacc True to set the "accessed flag" on used memory data
+ * @return The value of the long in memory at the CPU's PC+1
+ */
+static inline uint32_t _cpu_get_immd_long(CPU_t *cpu, memory_t *mem, bool setacc)
+{
+    uint32_t addr = _cpu_get_effective_pc(cpu);
+    addr = _addr_add_val_bank_wrap(addr, 1);
+    uint32_t val = _get_mem_byte(mem, addr, setacc);
+    addr = _addr_add_val_bank_wrap(addr, 1);
+    val |= _get_mem_byte(mem, addr, setacc) << 8;
+    addr = _addr_add_val_bank_wrap(addr, 1);
+    return val | (_get_mem_byte(mem, addr, setacc) << 16);
+}
+
 // CPU-related helper functions
 void _cpu_update_pc(CPU_t *, uint16_t);
 uint8_t _cpu_get_sr(CPU_t *);
 void _cpu_set_sr(CPU_t *, uint8_t);
 void _cpu_set_sp(CPU_t *, uint16_t);
-uint32_t _cpu_get_pbr(CPU_t *);
 uint32_t _cpu_get_dbr(CPU_t *);
-uint32_t _cpu_get_effective_pc(CPU_t *);
 void _cpu_update_pc(CPU_t *, uint16_t);
-uint8_t _cpu_get_immd_byte(CPU_t *, memory_t *, bool);
-uint16_t _cpu_get_immd_word(CPU_t *, memory_t *, bool);
-uint32_t _cpu_get_immd_long(CPU_t *, memory_t *, bool);
 uint32_t _addr_add_val_page_wrap(uint32_t, uint32_t);
-uint32_t _addr_add_val_bank_wrap(uint32_t, uint32_t);
 void _cpu_crash(CPU_t *);
 
 // Memory-related functions
-// These are THE ONLY functions which should directly
-// access data within the memory_t datastructure
-uint8_t _get_mem_byte(memory_t *, uint32_t, bool);
-uint16_t _get_mem_word(memory_t *, uint32_t, bool);
-uint16_t _get_mem_word_bank_wrap(memory_t *, uint32_t, bool);
+// These (and the inline memory functions above) are THE ONLY
+// functions which should directly access data within the
+// memory_t datastructure
+memory_t *_alloc_mem(void);
+void _free_mem(memory_t *);
+void _advise_mem_dense(memory_t *, uint32_t, uint32_t);
+void _reset_mem(memory_t *);
+uint32_t _get_mem_pages(memory_t *, uint32_t *, uint32_t);
+bool _copy_mem(memory_t *, memory_t *);
+uint32_t _cmp_mem(memory_t *, memory_t *);
+uint32_t _cmp_mem_dirty(memory_t *, memory_t *);
+void _clear_mem_dirty(memory_t *);
+bool _map_mem_rom(memory_t *, uint32_t, uint32_t);
+bool _map_mem_io(memory_t *, const mem_device_t *);
+void _unmap_mem(memory_t *, uint32_t, uint32_t);
+uint8_t _peek_mem_byte(memory_t *, uint32_t);
+bool _test_mem_pure(memory_t *, uint32_t);
 uint32_t _get_mem_long_bank_wrap(memory_t *, uint32_t, bool);
 void _set_mem_byte(memory_t *, uint32_t, uint8_t, bool);
 void _set_mem_word(memory_t *, uint32_t, uint16_t, bool);
 void _set_mem_word_bank_wrap(memory_t *, uint32_t, uint16_t, bool);
 void _init_mem_arr(memory_t *, uint8_t *, uint32_t, uint32_t);
 void _save_mem_arr(memory_t *, uint8_t *, uint32_t, uint32_t);
-mem_flag_t _test_mem_flags(memory_t *, uint32_t);
+bool _move_mem_block(memory_t *, uint32_t, uint32_t, uint32_t, bool, bool);
 mem_flag_t _test_and_reset_mem_flags(memory_t *, uint32_t, uint8_t);
 void _reset_mem_flags(memory_t *, uint32_t, uint8_t);
 void _set_mem_flags(memory_t *, uint32_t, uint8_t);
@@ -78,4 +469,27 @@ uint32_t _addrCPU_getImmediate(CPU_t *, memory_t *, bool);
 uint32_t _addrCPU_getStackRelative(CPU_t *, memory_t *, bool);
 uint32_t _addrCPU_getStackRelativeIndirectIndexedY(CPU_t *, memory_t *, bool);
 
+// Resolve an already fetched operand (used by the predecoded instruction cache)
+uint16_t _addrCPU_resolveAbsoluteIndexedIndirectX(CPU_t *, memory_t *, uint32_t, bool);
+uint16_t _addrCPU_resolveAbsoluteIndirect(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveAbsoluteIndirectLong(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveAbsolute(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveAbsoluteIndexedX(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveAbsoluteIndexedY(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveLongIndexedX(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveDirectPage(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveDirectPageIndirect(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveDirectPageIndirectLong(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveDirectPageIndexedX(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveDirectPageIndexedIndirectX(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveDirectPageIndexedY(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveDirectPageIndirectIndexedY(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveDirectPageIndirectLongIndexedY(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveRelative8(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveRelative16(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveLong(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveImmediate(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveStackRelative(CPU_t *, memory_t *, uint32_t, bool);
+uint32_t _addrCPU_resolveStackRelativeIndirectIndexedY(CPU_t *, memory_t *, uint32_t, bool);
+
 #endif
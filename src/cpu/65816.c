@@ -6,11 +6,14 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <stddef.h>
+#include <string.h>
 #include <inttypes.h>
 
 #include "65816.h"
 #include "65816-ops.h"
 #include "65816-util.h"
+#include "65816-dispatch.h"
+#include "65816-jit.h"
 
 
 /**
@@ -33,8 +36,8 @@ CPU_Error_Code_t tostrCPU(CPU_t *cpu, char *buf)
     sprintf(buf, "{C:%04x,X:%04x,Y:%04x,SP:%04x,D:%04x,DBR:%02x,PBR:%02x,PC:%04x,RST:%d,IRQ:%d,NMI:%d,STP:%d,CRASH:%d,PSC:%d,PSZ:%d,PSI:%d,PSD:%d,PSXB:%d,PSM:%d,PSV:%d,PSN:%d,PSE:%d,cycles:%" PRIu64 "}",
             cpu->C, cpu->X, cpu->Y, cpu->SP, cpu->D, cpu->DBR, cpu->PBR,
             cpu->PC, cpu->P.RST, cpu->P.IRQ, cpu->P.NMI, cpu->P.STP,
-            cpu->P.CRASH, cpu->P.C, cpu->P.Z, cpu->P.I, cpu->P.D,
-            cpu->P.XB, cpu->P.M, cpu->P.V, cpu->P.N, cpu->P.E,
+            cpu->P.CRASH, cpu->P.C, _cpu_get_z(cpu), cpu->P.I, cpu->P.D,
+            cpu->P.XB, cpu->P.M, cpu->P.V, _cpu_get_n(cpu), cpu->P.E,
             cpu->cycles);
 
     return CPU_ERR_OK;
@@ -65,20 +68,21 @@ CPU_Error_Code_t fromstrCPU(CPU_t *cpu, char *buf)
                         &(cpu->PC), &rst, &irq, &nmi, &stp, &crash, &prc, &prz, &pri, &prd, &prxb, &prm, &prv, &prn, &pre,
                         &(cpu->cycles));
 
-    cpu->P.RST = rst;
-    cpu->P.IRQ = irq;
-    cpu->P.NMI = nmi;
-    cpu->P.STP = stp;
-    cpu->P.CRASH = crash;
-    cpu->P.C = prc;
-    cpu->P.Z = prz;
-    cpu->P.I = pri;
-    cpu->P.D = prd;
-    cpu->P.XB = prxb;
-    cpu->P.M = prm;
-    cpu->P.V = prv;
-    cpu->P.N = prn;
-    cpu->P.E = pre;
+    // Only the low bit of each flag is used
+    cpu->P.RST = rst & 1;
+    cpu->P.IRQ = irq & 1;
+    cpu->P.NMI = nmi & 1;
+    cpu->P.STP = stp & 1;
+    cpu->P.CRASH = crash & 1;
+    cpu->P.C = prc & 1;
+    _cpu_set_z(cpu, prz & 1);
+    cpu->P.I = pri & 1;
+    cpu->P.D = prd & 1;
+    cpu->P.XB = prxb & 1;
+    cpu->P.M = prm & 1;
+    cpu->P.V = prv & 1;
+    _cpu_set_n(cpu, prn & 1);
+    cpu->P.E = pre & 1;
 
     // Make sure all elements were scanned
     if (num != 23) {
@@ -107,6 +111,11 @@ CPU_Error_Code_t initCPU(CPU_t *cpu)
 #endif
 
     cpu->cop_vect_enable = false;
+    cpu->dcache = NULL;
+    cpu->jit = NULL;
+    cpu->idle.skipped = 0;
+    cpu->events.count = 0;
+    cpu->events.now = 0;
     
     return resetCPU(cpu);
 }
@@ -151,308 +160,484 @@ CPU_Error_Code_t resetCPU(CPU_t *cpu)
     return CPU_ERR_OK;
 }
 
+
 /**
- * Steps a CPU by one machine cycle
- * @param cpu The CPU to be stepped
- * @param mem The memory array which is to be connected to the CPU
+ * Run the next byte moves of the block move (MVN/MVP) at the CPU's PC
+ * in bulk. The registers, DBR, cycles and PC are left exactly as that
+ * many single byte moves would leave them. Moves stop early (and are
+ * left to the execution engine) once the count or cycle budget runs
+ * out, an index register is about to wrap, the move would write over
+ * its own instruction, or the memory involved is not plain memory
+ * (see _move_mem_block()).
+ *
+ * @note The caller has to check for pending interrupts and stop
+ *       conditions first, since the bytes are moved without any checks
+ *       in between them.
+ * @param *cpu The CPU which is running the block move
+ * @param *mem The memory array which is connected to the CPU
+ * @param count The maximum number of bytes (instructions) to move
+ * @param cycle_end Stop once the CPU's cycle count reaches this
+ * @return The number of bytes which were moved
  */
-CPU_Error_Code_t stepCPU(CPU_t *cpu, memory_t *mem)
+uint64_t _cpu_move_block(CPU_t *cpu, memory_t *mem, uint64_t count, uint64_t cycle_end)
 {
-#ifdef CPU_DEBUG_CHECK_NULL
-    if (cpu == NULL)
+    uint32_t pc = _cpu_get_effective_pc(cpu);
+    uint64_t n = 0;
+
+    // Instruction bytes on a device page can change between moves
+    for (uint32_t i = 0; i < 3; ++i)
     {
-        return CPU_ERR_NULL_CPU;
+        if (_test_mem_io(mem, _addr_add_val_bank_wrap(pc, i)))
+        {
+            return 0;
+        }
     }
+
+    // The previous move could have changed the instruction
+    uint8_t op = _get_mem_byte(mem, pc, false);
+    if (op != CPU_OP_MVN && op != CPU_OP_MVP)
+    {
+        return 0;
+    }
+    bool down = (op == CPU_OP_MVP);
+    uint32_t dst_bank = _get_mem_byte(mem, _addr_add_val_bank_wrap(pc, 1), false);
+    uint32_t src_bank = _get_mem_byte(mem, _addr_add_val_bank_wrap(pc, 2), false);
+
+    while (n < count && cpu->C != 0xffff && cpu->cycles < cycle_end)
+    {
+        // Move as much as possible without wrapping X or Y
+        uint32_t len = (uint32_t)cpu->C + 1;
+        uint32_t x_room = down ? (uint32_t)cpu->X + 1 : 0x10000u - cpu->X;
+        uint32_t y_room = down ? (uint32_t)cpu->Y + 1 : 0x10000u - cpu->Y;
+        uint64_t cycles_left = (cycle_end - cpu->cycles - 1) / 7 + 1; // 7 cycles per byte moved
+        len = (x_room < len) ? x_room : len;
+        len = (y_room < len) ? y_room : len;
+        len = (count - n < len) ? count - n : len;
+        len = (cycles_left < len) ? cycles_left : len;
+
+        uint32_t src_lo = (uint16_t)(down ? cpu->X - (len - 1) : cpu->X);
+        uint32_t dst_lo = (uint16_t)(down ? cpu->Y - (len - 1) : cpu->Y);
+
+        // Leave moves which write over their own instruction to the engine
+        if (dst_bank == cpu->PBR)
+        {
+            for (uint32_t i = 0; i < 3; ++i)
+            {
+                if ((uint16_t)(cpu->PC + i - dst_lo) < len)
+                {
+                    return n;
+                }
+            }
+        }
+
+        if (!_move_mem_block(mem, (dst_bank << 16) | dst_lo, (src_bank << 16) | src_lo, len, down, cpu->setacc))
+        {
+            return n;
+        }
+
+        if (down)
+        {
+            cpu->X -= len;
+            cpu->Y -= len;
+        }
+        else
+        {
+            cpu->X += len;
+            cpu->Y += len;
+        }
+        cpu->DBR = dst_bank;
+        cpu->C -= len;
+        cpu->cycles += 7 * (uint64_t)len;
+        n += len;
+    }
+
+    if (n && cpu->C == 0xffff)
+    {
+        // Done, move to next instruction
+        _cpu_update_pc(cpu, 3);
+    }
+    return n;
+}
+
+/**
+ * Determine if the code at the CPU's PC is a loop which only reads
+ * memory: a run of loads, compares, logic operations and register
+ * transfers which ends in a branch back to the PC. Every address the
+ * loop reads must be readable without side effects (see
+ * _test_mem_pure()) and none of its instructions can be on a device
+ * page or have a breakpoint set.
+ *
+ * @param *cpu The CPU to check
+ * @param *mem The memory array which is connected to the CPU
+ * @return The number of instructions in one pass of the loop
+ *         (including the branch), or 0 if it is not such a loop
+ */
+static uint32_t _cpu_idle_loop_len(CPU_t *cpu, memory_t *mem)
+{
+    uint32_t pc = _cpu_get_effective_pc(cpu);
+    uint32_t bytes = 0;
+    uint32_t len = 0;
+
+    while (bytes < CPU_IDLE_LOOP_BYTES)
+    {
+        uint32_t addr = _addr_add_val_bank_wrap(pc, bytes);
+        uint32_t operand = 0;
+        uint32_t size;
+        uint32_t read = CPU_IDLE_NONE;
+        bool wide;
+
+        for (uint32_t i = 0; i < 4; ++i)
+        {
+            uint32_t a = _addr_add_val_bank_wrap(addr, i);
+            if (_test_mem_io(mem, a) || (i == 0 && _test_mem_flags(mem, a).B))
+            {
+                return 0;
+            }
+            if (i > 0)
+            {
+                operand |= (uint32_t)_get_mem_byte(mem, a, false) << (8 * (i - 1));
+            }
+        }
+
+        switch (_get_mem_byte(mem, addr, false))
+        {
+        // Accumulator width: LDA, AND, ORA, EOR, BIT, CMP
+        case 0xa9: case 0x29: case 0x09: case 0x49: case 0x89: case 0xc9: // Immediate
+            wide = !cpu->P.M;
+            size = wide ? 3 : 2;
+            break;
+        case 0xad: case 0x2d: case 0x0d: case 0x4d: case 0x2c: case 0xcd: // Absolute
+            wide = !cpu->P.M;
+            size = 3;
+            read = _cpu_get_dbr(cpu) | (operand & 0xffff);
+            break;
+        case 0xaf: case 0x2f: case 0x0f: case 0x4f: case 0xcf: // Long
+            wide = !cpu->P.M;
+            size = 4;
+            read = operand & 0xffffff;
+            break;
+        case 0xa5: case 0x25: case 0x05: case 0x45: case 0x24: case 0xc5: // Direct page
+            wide = !cpu->P.M;
+            size = 2;
+            read = (uint16_t)(cpu->D + (operand & 0xff));
+            break;
+        // Index width: LDX, LDY, CPX, CPY
+        case 0xa2: case 0xa0: case 0xe0: case 0xc0: // Immediate
+            wide = !cpu->P.XB;
+            size = wide ? 3 : 2;
+            break;
+        case 0xae: case 0xac: case 0xec: case 0xcc: // Absolute
+            wide = !cpu->P.XB;
+            size = 3;
+            read = _cpu_get_dbr(cpu) | (operand & 0xffff);
+            break;
+        case 0xa6: case 0xa4: case 0xe4: case 0xc4: // Direct page
+            wide = !cpu->P.XB;
+            size = 2;
+            read = (uint16_t)(cpu->D + (operand & 0xff));
+            break;
+        // NOP, CLC, SEC, CLV, TAX, TAY, TXA, TYA, TXY, TYX
+        case 0xea: case 0x18: case 0x38: case 0xb8: case 0xaa:
+        case 0xa8: case 0x8a: case 0x98: case 0x9b: case 0xbb:
+            wide = false;
+            size = 1;
+            break;
+        // BPL, BMI, BVC, BVS, BCC, BCS, BNE, BEQ, BRA
+        case 0x10: case 0x30: case 0x50: case 0x70: case 0x90:
+        case 0xb0: case 0xd0: case 0xf0: case CPU_OP_BRA:
+            if (_addr_add_val_bank_wrap(addr, 2 + (int8_t)(operand & 0xff)) == pc)
+            {
+                return len + 1;
+            }
+            return 0;
+        default:
+            return 0;
+        }
+
+        // (The second byte of a word may or may not wrap around the bank)
+        if (read != CPU_IDLE_NONE &&
+            (!_test_mem_pure(mem, read) ||
+             (wide && (!_test_mem_pure(mem, _addr_add_val_bank_wrap(read, 1)) ||
+                       !_test_mem_pure(mem, (read + 1) & 0xffffff)))))
+        {
+            return 0;
+        }
+        bytes += size;
+        ++len;
+    }
+    return 0;
+}
+
+
+/**
+ * Skip ahead through a loop which only reads memory, such as one which
+ * polls a device's status register. Memory and the devices cannot change
+ * while an execution engine runs except through the CPU's own writes, so
+ * once one pass of such a loop leaves the CPU in the same state it started
+ * in, every following pass will do the same. The first time the CPU
+ * branches back to the start of the loop, its state is saved. If the next
+ * branch back comes exactly one pass later with the same state, as many
+ * further passes as fit in the count and cycle budgets are accounted for
+ * in one go (the cycle count moves on, the registers stay the same).
+ * Code which is not such a loop is remembered (with a len of 0) until
+ * the CPU branches somewhere else, so that _cpu_dispatch_idle() does not
+ * look at a tight loop again on every pass.
+ *
+ * @note The caller has to check for pending interrupts and stop
+ *       conditions first. runCPU() has to clear the saved state
+ *       (CPU_IDLE_NONE) before each run of the execution engine.
+ * @param *cpu The CPU which just ran a branch
+ * @param *mem The memory array which is connected to the CPU
+ * @param done The number of instructions the engine has executed so far
+ *             (including the branch)
+ * @param count The maximum number of instructions the engine can execute
+ * @param cycle_end Stop once the CPU's cycle count reaches this
+ * @return The number of instructions which were skipped
+ */
+uint64_t _cpu_skip_idle(CPU_t *cpu, memory_t *mem, uint64_t done, uint64_t count, uint64_t cycle_end)
+{
+    uint32_t pc = _cpu_get_effective_pc(cpu);
+
+    if (cpu->idle.pc == pc && cpu->idle.len && done - cpu->idle.done == cpu->idle.len &&
+        cpu->idle.C == cpu->C && cpu->idle.X == cpu->X && cpu->idle.Y == cpu->Y &&
+        cpu->idle.SP == cpu->SP && cpu->idle.D == cpu->D && cpu->idle.DBR == cpu->DBR &&
+        cpu->idle.SR == _cpu_get_sr(cpu) && cpu->idle.E == cpu->P.E)
+    {
+        // Only whole passes, with the budget checks in between them passing
+        uint64_t pass_cycles = cpu->cycles - cpu->idle.cycles;
+        uint64_t passes = (cycle_end - cpu->cycles - 1) / pass_cycles;
+        if ((count - done) / cpu->idle.len < passes)
+        {
+            passes = (count - done) / cpu->idle.len;
+        }
+
+        cpu->cycles += passes * pass_cycles;
+        cpu->idle.done = done + passes * cpu->idle.len;
+        cpu->idle.cycles = cpu->cycles;
+        cpu->idle.skipped += passes * cpu->idle.len;
+        return passes * cpu->idle.len;
+    }
+
+    cpu->idle.pc = pc;
+    if ((cpu->idle.len = _cpu_idle_loop_len(cpu, mem)) != 0)
+    {
+        cpu->idle.done = done;
+        cpu->idle.cycles = cpu->cycles;
+        cpu->idle.C = cpu->C;
+        cpu->idle.X = cpu->X;
+        cpu->idle.Y = cpu->Y;
+        cpu->idle.SP = cpu->SP;
+        cpu->idle.D = cpu->D;
+        cpu->idle.DBR = cpu->DBR;
+        cpu->idle.SR = _cpu_get_sr(cpu);
+        cpu->idle.E = cpu->P.E;
+    }
+    return 0;
+}
+
+// Handler call for each opcode kind in the switch below (see
+// CPU_OPCODE_TABLE), with the resolvers fetching their own operands.
+// The switch is always built, since it is also the reference engine
+// for stepRefCPU() when the table dispatcher is used
+#define _addrCPU_getNone(cpu, mem, setacc) 0
+#define CPU_SWITCH_ALU(fn, size, base, mode, res, pen)                            \
+    addr = _addrCPU_get##res(cpu, mem, cpu->setacc);                              \
+    cpu->cycles += _cpu_penalty_cycles(cpu, pen, addr, CPU_M8(cpu), CPU_X8(cpu)); \
+    fn(cpu, mem, size, base, CPU_ADDR_##mode, addr)
+#define CPU_SWITCH_JMP(fn, size, cycles, mode, res, pen) \
+    fn(cpu, cycles, CPU_ADDR_##mode, _addrCPU_get##res(cpu, mem, cpu->setacc))
+#define CPU_SWITCH_JSR(fn, size, cycles, mode, res, pen) \
+    fn(cpu, mem, cycles, _addrCPU_get##res(cpu, mem, cpu->setacc))
+#define CPU_SWITCH_REL(fn, size, cycles, mode, res, pen)                                     \
+    pc = cpu->PC;                                                                            \
+    fn(cpu, mem);                                                                            \
+    n += _cpu_dispatch_idle(cpu, mem, op, (uint16_t)(pc - cpu->PC), n + 1, count, cycle_end, \
+                            stop_mask)
+#define CPU_SWITCH_MEM(fn, size, cycles, mode, res, pen) fn(cpu, mem)
+#define CPU_SWITCH_IMP(fn, size, cycles, mode, res, pen) fn(cpu)
+#define CPU_SWITCH_CASE(op, fn, kind, size, cycles, mode, res, mn, reg, acc) \
+    case op:                                                                  \
+        CPU_SWITCH_##kind(i_##fn, size, cycles, mode, res,                    \
+                          CPU_OP_PENALTIES(mode, reg, acc));                  \
+        break;
+
+/**
+ * Execute instructions with the switch-based decoder until either
+ * the count is reached, the CPU enters a state which requires handling
+ * by stepCPU()/runCPU() or a stop condition is hit.
+ * (Same behavior as _cpu_dispatch_run())
+ *
+ * @param *cpu The CPU to run
+ * @param *mem The memory array which is connected to the CPU
+ * @param count The maximum number of instructions to execute
+ * @param cycle_end Stop once the CPU's cycle count reaches this
+ * @param stop_mask The runCPU() stop conditions to check for
+ * @return The number of instructions which were executed
+ */
+static uint64_t _cpu_switch_run(CPU_t *cpu, memory_t *mem, uint64_t count, uint64_t cycle_end, uint32_t stop_mask)
+{
+    uint64_t n = 0;
+    uint8_t op;
+    uint16_t pc;   // Address of a branch (for _cpu_dispatch_idle())
+    uint32_t addr; // Effective address of an ALU instruction's operand
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    do
+    {
+        // Fetch, decode, execute instruction
+        op = _get_mem_byte(mem, _cpu_get_effective_pc(cpu), cpu->setacc);
+        switch (op)
+        {
+            CPU_OPCODE_TABLE(CPU_SWITCH_CASE)
+        }
+
+        // Run the rest of a block move in bulk where possible
+        n += _cpu_dispatch_move(cpu, mem, op, count - n - 1, cycle_end, stop_mask);
+    } while (++n < count && !_cpu_dispatch_stop(cpu, mem, op, cycle_end, stop_mask));
+
+    return n;
+}
+
+#undef CPU_SWITCH_CASE
+#undef CPU_SWITCH_IMP
+#undef CPU_SWITCH_MEM
+#undef CPU_SWITCH_REL
+#undef CPU_SWITCH_JSR
+#undef CPU_SWITCH_JMP
+#undef CPU_SWITCH_ALU
+#undef _addrCPU_getNone
+
+#ifndef CPU_DISPATCH_TABLE
+#define _cpu_engine_run _cpu_switch_run
+#else
+#define _cpu_engine_run _cpu_dispatch_run
 #endif
 
-    if (cpu->P.CRASH == 1)
+
+/**
+ * Move the event at index i of a CPU's event heap up towards the root
+ * until its parent is not due after it
+ *
+ * @param *cpu The CPU whose events to reorder
+ * @param i The index of the event to move
+ */
+static void _cpu_event_sift_up(CPU_t *cpu, uint8_t i)
+{
+    CPU_Event_t *heap = cpu->events.heap;
+    CPU_Event_t ev = heap[i];
+
+    while (i > 0 && heap[(i - 1) / 2].when > ev.when)
     {
-        return CPU_ERR_CRASH;
+        heap[i] = heap[(i - 1) / 2];
+        i = (i - 1) / 2;
     }
+    heap[i] = ev;
+}
 
-    // Handle CPU reset (does not perform a full CPU reset)
-    if (cpu->P.RST)
+
+/**
+ * Move the event at index i of a CPU's event heap down towards the
+ * leaves until neither of its children is due before it
+ *
+ * @param *cpu The CPU whose events to reorder
+ * @param i The index of the event to move
+ */
+static void _cpu_event_sift_down(CPU_t *cpu, uint8_t i)
+{
+    CPU_Event_t *heap = cpu->events.heap;
+    CPU_Event_t ev = heap[i];
+    uint8_t child;
+
+    while ((child = 2 * i + 1) < cpu->events.count)
     {
-        cpu->P.RST = 0;
-        cpu->PC = _get_mem_word(mem, CPU_VEC_RESET, cpu->setacc);
-        return CPU_ERR_OK;
+        if (child + 1 < cpu->events.count && heap[child + 1].when < heap[child].when)
+        {
+            child += 1;
+        }
+        if (heap[child].when >= ev.when)
+        {
+            break;
+        }
+        heap[i] = heap[child];
+        i = child;
     }
+    heap[i] = ev;
+}
 
-    if (cpu->P.STP)
+
+/**
+ * Remove the event at index i from a CPU's event heap
+ *
+ * @param *cpu The CPU to remove the event from
+ * @param i The index of the event to remove
+ */
+static void _cpu_event_remove(CPU_t *cpu, uint8_t i)
+{
+    if (i == --cpu->events.count)
     {
-        return CPU_ERR_STP;
+        return;
     }
+    cpu->events.heap[i] = cpu->events.heap[cpu->events.count];
+    _cpu_event_sift_up(cpu, i);
+    _cpu_event_sift_down(cpu, i);
+}
+
 
-    // Fetch, decode, execute instruction
-    switch (_get_mem_byte(mem, _cpu_get_effective_pc(cpu), cpu->setacc))
-    {
-    case 0x00: i_brk(cpu, mem); break;
-    case 0x01: i_ora(cpu, mem, 2, 6, CPU_ADDR_DPINDX, _addrCPU_getDirectPageIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0x02: i_cop(cpu, mem); break;
-    case 0x03: i_ora(cpu, mem, 2, 4, CPU_ADDR_SR, _addrCPU_getStackRelative(cpu, mem, cpu->setacc)); break;
-    case 0x04: i_tsb(cpu, mem, 2, 5, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x05: i_ora(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x06: i_asl(cpu, mem, 2, 5, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x07: i_ora(cpu, mem, 2, 6, CPU_ADDR_DPINDL, _addrCPU_getDirectPageIndirectLong(cpu, mem, cpu->setacc)); break;
-    case 0x08: i_php(cpu, mem); break;
-    case 0x09: i_ora(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0x0a: i_asl(cpu, mem, 1, 2, CPU_ADDR_IMPD, 0); break;
-    case 0x0b: i_phd(cpu, mem); break;
-    case 0x0c: i_tsb(cpu, mem, 3, 6, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x0d: i_ora(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x0e: i_asl(cpu, mem, 3, 6, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x0f: i_ora(cpu, mem, 4, 5, CPU_ADDR_ABSL, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0x10: i_bpl(cpu, mem); break;
-    case 0x11: i_ora(cpu, mem, 2, 5, CPU_ADDR_INDDPY, _addrCPU_getDirectPageIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x12: i_ora(cpu, mem, 2, 5, CPU_ADDR_DPIND, _addrCPU_getDirectPageIndirect(cpu, mem, cpu->setacc)); break;
-    case 0x13: i_ora(cpu, mem, 2, 7, CPU_ADDR_SRINDY, _addrCPU_getStackRelativeIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x14: i_trb(cpu, mem, 2, 5, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x15: i_ora(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x16: i_asl(cpu, mem, 2, 6, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x17: i_ora(cpu, mem, 2, 6, CPU_ADDR_INDDPLY, _addrCPU_getDirectPageIndirectLongIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x18: i_clc(cpu); break;
-    case 0x19: i_ora(cpu, mem, 3, 4, CPU_ADDR_ABSY, _addrCPU_getAbsoluteIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x1a: i_ina(cpu); break;
-    case 0x1b: i_tcs(cpu); break;
-    case 0x1c: i_trb(cpu, mem, 3, 6, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x1d: i_ora(cpu, mem, 3, 4, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x1e: i_asl(cpu, mem, 3, 7, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x1f: i_ora(cpu, mem, 4, 5, CPU_ADDR_ABSLX, _addrCPU_getLongIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x20: i_jsr(cpu, mem, 6, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x21: i_and(cpu, mem, 2, 6, CPU_ADDR_DPINDX, _addrCPU_getDirectPageIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0x22: i_jsl(cpu, mem, 8, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0x23: i_and(cpu, mem, 2, 4, CPU_ADDR_SR, _addrCPU_getStackRelative(cpu, mem, cpu->setacc)); break;
-    case 0x24: i_bit(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x25: i_and(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x26: i_rol(cpu, mem, 2, 5, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x27: i_and(cpu, mem, 2, 6, CPU_ADDR_DPINDL, _addrCPU_getDirectPageIndirectLong(cpu, mem, cpu->setacc)); break;
-    case 0x28: i_plp(cpu, mem); break;
-    case 0x29: i_and(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0x2a: i_rol(cpu, mem, 1, 2, CPU_ADDR_IMPD, 0); break;
-    case 0x2b: i_pld(cpu, mem); break;
-    case 0x2c: i_bit(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x2d: i_and(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x2e: i_rol(cpu, mem, 3, 6, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x2f: i_and(cpu, mem, 4, 5, CPU_ADDR_ABSL, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0x30: i_bmi(cpu, mem); break;
-    case 0x31: i_and(cpu, mem, 2, 5, CPU_ADDR_INDDPY, _addrCPU_getDirectPageIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x32: i_and(cpu, mem, 2, 5, CPU_ADDR_DPIND, _addrCPU_getDirectPageIndirect(cpu, mem, cpu->setacc)); break;
-    case 0x33: i_and(cpu, mem, 2, 7, CPU_ADDR_SRINDY, _addrCPU_getStackRelativeIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x34: i_bit(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x35: i_and(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x36: i_rol(cpu, mem, 2, 6, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x37: i_and(cpu, mem, 2, 6, CPU_ADDR_INDDPLY, _addrCPU_getDirectPageIndirectLongIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x38: i_sec(cpu); break;
-    case 0x39: i_and(cpu, mem, 3, 4, CPU_ADDR_ABSY, _addrCPU_getAbsoluteIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x3a: i_dea(cpu); break;
-    case 0x3b: i_tsc(cpu); break;
-    case 0x3c: i_bit(cpu, mem, 3, 4, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x3d: i_and(cpu, mem, 3, 4, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x3e: i_rol(cpu, mem, 3, 7, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x3f: i_and(cpu, mem, 4, 5, CPU_ADDR_ABSLX, _addrCPU_getLongIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x40: i_rti(cpu, mem); break;
-    case 0x41: i_eor(cpu, mem, 2, 6, CPU_ADDR_DPINDX, _addrCPU_getDirectPageIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0x42: i_wdm(cpu); break;
-    case 0x43: i_eor(cpu, mem, 2, 4, CPU_ADDR_SR, _addrCPU_getStackRelative(cpu, mem, cpu->setacc)); break;
-    case 0x44: i_mvp(cpu, mem); break;
-    case 0x45: i_eor(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x46: i_lsr(cpu, mem, 2, 5, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x47: i_eor(cpu, mem, 2, 6, CPU_ADDR_DPINDL, _addrCPU_getDirectPageIndirectLong(cpu, mem, cpu->setacc)); break;
-    case 0x48: i_pha(cpu, mem); break;
-    case 0x49: i_eor(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0x4a: i_lsr(cpu, mem, 1, 2, CPU_ADDR_IMPD, 0); break;
-    case 0x4b: i_phk(cpu, mem); break;
-    case 0x4c: i_jmp(cpu, 3, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x4d: i_eor(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x4e: i_lsr(cpu, mem, 3, 6, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x4f: i_eor(cpu, mem, 4, 5, CPU_ADDR_ABSL, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0x50: i_bvc(cpu, mem); break;
-    case 0x51: i_eor(cpu, mem, 2, 5, CPU_ADDR_INDDPY, _addrCPU_getDirectPageIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x52: i_eor(cpu, mem, 2, 5, CPU_ADDR_DPIND, _addrCPU_getDirectPageIndirect(cpu, mem, cpu->setacc)); break;
-    case 0x53: i_eor(cpu, mem, 2, 7, CPU_ADDR_SRINDY, _addrCPU_getStackRelativeIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x54: i_mvn(cpu, mem); break;
-    case 0x55: i_eor(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x56: i_lsr(cpu, mem, 2, 6, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x57: i_eor(cpu, mem, 2, 6, CPU_ADDR_INDDPLY, _addrCPU_getDirectPageIndirectLongIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x58: i_cli(cpu); break;
-    case 0x59: i_eor(cpu, mem, 3, 4, CPU_ADDR_ABSY, _addrCPU_getAbsoluteIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x5a: i_phy(cpu, mem); break;
-    case 0x5b: i_tcd(cpu); break;
-    case 0x5c: i_jmp(cpu, 4, CPU_ADDR_ABSL, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0x5d: i_eor(cpu, mem, 3, 4, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x5e: i_lsr(cpu, mem, 3, 7, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x5f: i_eor(cpu, mem, 4, 5, CPU_ADDR_ABSLX, _addrCPU_getLongIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x60: i_rts(cpu, mem); break;
-    case 0x61: i_adc(cpu, mem, 2, 6, CPU_ADDR_DPINDX, _addrCPU_getDirectPageIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0x62: i_per(cpu, mem); break;
-    case 0x63: i_adc(cpu, mem, 2, 4, CPU_ADDR_SR, _addrCPU_getStackRelative(cpu, mem, cpu->setacc)); break;
-    case 0x64: i_stz(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x65: i_adc(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x66: i_ror(cpu, mem, 2, 5, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x67: i_adc(cpu, mem, 2, 6, CPU_ADDR_DPINDL, _addrCPU_getDirectPageIndirectLong(cpu, mem, cpu->setacc)); break;
-    case 0x68: i_pla(cpu, mem); break;
-    case 0x69: i_adc(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0x6a: i_ror(cpu, mem, 1, 2, CPU_ADDR_IMPD, 0); break;
-    case 0x6b: i_rtl(cpu, mem); break;
-    case 0x6c: i_jmp(cpu, 5, CPU_ADDR_INDABS, _addrCPU_getAbsoluteIndirect(cpu, mem, cpu->setacc)); break;
-    case 0x6d: i_adc(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x6e: i_ror(cpu, mem, 3, 6, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x6f: i_adc(cpu, mem, 4, 5, CPU_ADDR_ABSL, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0x70: i_bvs(cpu, mem); break;
-    case 0x71: i_adc(cpu, mem, 2, 5, CPU_ADDR_INDDPY, _addrCPU_getDirectPageIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x72: i_adc(cpu, mem, 2, 5, CPU_ADDR_DPIND, _addrCPU_getDirectPageIndirect(cpu, mem, cpu->setacc)); break;
-    case 0x73: i_adc(cpu, mem, 2, 7, CPU_ADDR_SRINDY, _addrCPU_getStackRelativeIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x74: i_stz(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x75: i_adc(cpu, mem, 2, 4, CPU_ADDR_DPINDX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x76: i_ror(cpu, mem, 2, 6, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x77: i_adc(cpu, mem, 2, 6, CPU_ADDR_INDDPLY, _addrCPU_getDirectPageIndirectLongIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x78: i_sei(cpu); break;
-    case 0x79: i_adc(cpu, mem, 3, 4, CPU_ADDR_ABSY, _addrCPU_getAbsoluteIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x7a: i_ply(cpu, mem); break;
-    case 0x7b: i_tdc(cpu); break;
-    case 0x7c: i_jmp(cpu, 6, CPU_ADDR_ABSINDX, _addrCPU_getAbsoluteIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0x7d: i_adc(cpu, mem, 3, 4, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x7e: i_ror(cpu, mem, 3, 7, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x7f: i_adc(cpu, mem, 4, 5, CPU_ADDR_ABSLX, _addrCPU_getLongIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x80: i_bra(cpu, mem); break;
-    case 0x81: i_sta(cpu, mem, 2, 6, CPU_ADDR_DPINDX, _addrCPU_getDirectPageIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0x82: i_brl(cpu, mem); break;
-    case 0x83: i_sta(cpu, mem, 2, 4, CPU_ADDR_SR, _addrCPU_getStackRelative(cpu, mem, cpu->setacc)); break;
-    case 0x84: i_sty(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x85: i_sta(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x86: i_stx(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0x87: i_sta(cpu, mem, 2, 6, CPU_ADDR_DPINDL, _addrCPU_getDirectPageIndirectLong(cpu, mem, cpu->setacc)); break;
-    case 0x88: i_dey(cpu); break;
-    case 0x89: i_bit(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0x8a: i_txa(cpu); break;
-    case 0x8b: i_phb(cpu, mem); break;
-    case 0x8c: i_sty(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x8d: i_sta(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x8e: i_stx(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x8f: i_sta(cpu, mem, 4, 5, CPU_ADDR_ABSL, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0x90: i_bcc(cpu, mem); break;
-    case 0x91: i_sta(cpu, mem, 2, 6, CPU_ADDR_INDDPY, _addrCPU_getDirectPageIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x92: i_sta(cpu, mem, 2, 5, CPU_ADDR_DPIND, _addrCPU_getDirectPageIndirect(cpu, mem, cpu->setacc)); break;
-    case 0x93: i_sta(cpu, mem, 2, 7, CPU_ADDR_SRINDY, _addrCPU_getStackRelativeIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x94: i_sty(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x95: i_sta(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x96: i_stx(cpu, mem, 2, 4, CPU_ADDR_DPY, _addrCPU_getDirectPageIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x97: i_sta(cpu, mem, 2, 6, CPU_ADDR_INDDPLY, _addrCPU_getDirectPageIndirectLongIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x98: i_tya(cpu); break;
-    case 0x99: i_sta(cpu, mem, 3, 5, CPU_ADDR_ABSY, _addrCPU_getAbsoluteIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0x9a: i_txs(cpu); break;
-    case 0x9b: i_txy(cpu); break;
-    case 0x9c: i_stz(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0x9d: i_sta(cpu, mem, 3, 5, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x9e: i_stz(cpu, mem, 3, 5, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0x9f: i_sta(cpu, mem, 4, 5, CPU_ADDR_ABSLX, _addrCPU_getLongIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xa0: i_ldy(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0xa1: i_lda(cpu, mem, 2, 6, CPU_ADDR_DPINDX, _addrCPU_getDirectPageIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0xa2: i_ldx(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0xa3: i_lda(cpu, mem, 2, 4, CPU_ADDR_SR, _addrCPU_getStackRelative(cpu, mem, cpu->setacc)); break;
-    case 0xa4: i_ldy(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0xa5: i_lda(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0xa6: i_ldx(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0xa7: i_lda(cpu, mem, 2, 6, CPU_ADDR_DPINDL, _addrCPU_getDirectPageIndirectLong(cpu, mem, cpu->setacc)); break;
-    case 0xa8: i_tay(cpu); break;
-    case 0xa9: i_lda(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0xaa: i_tax(cpu); break;
-    case 0xab: i_plb(cpu, mem); break;
-    case 0xac: i_ldy(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0xad: i_lda(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0xae: i_ldx(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0xaf: i_lda(cpu, mem, 4, 5, CPU_ADDR_ABSL, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0xb0: i_bcs(cpu, mem); break;
-    case 0xb1: i_lda(cpu, mem, 2, 5, CPU_ADDR_INDDPY, _addrCPU_getDirectPageIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xb2: i_lda(cpu, mem, 2, 5, CPU_ADDR_DPIND, _addrCPU_getDirectPageIndirect(cpu, mem, cpu->setacc)); break;
-    case 0xb3: i_lda(cpu, mem, 2, 7, CPU_ADDR_SRINDY, _addrCPU_getStackRelativeIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xb4: i_ldy(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xb5: i_lda(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xb6: i_ldx(cpu, mem, 2, 4, CPU_ADDR_DPY, _addrCPU_getDirectPageIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xb7: i_lda(cpu, mem, 2, 6, CPU_ADDR_INDDPLY, _addrCPU_getDirectPageIndirectLongIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xb8: i_clv(cpu); break;
-    case 0xb9: i_lda(cpu, mem, 3, 4, CPU_ADDR_ABSY, _addrCPU_getAbsoluteIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xba: i_tsx(cpu); break;
-    case 0xbb: i_tyx(cpu); break;
-    case 0xbc: i_ldy(cpu, mem, 3, 4, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xbd: i_lda(cpu, mem, 3, 4, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xbe: i_ldx(cpu, mem, 3, 4, CPU_ADDR_ABSY, _addrCPU_getAbsoluteIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xbf: i_lda(cpu, mem, 4, 5, CPU_ADDR_ABSLX, _addrCPU_getLongIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xc0: i_cpy(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0xc1: i_cmp(cpu, mem, 2, 6, CPU_ADDR_DPINDX, _addrCPU_getDirectPageIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0xc2: i_rep(cpu, mem); break;
-    case 0xc3: i_cmp(cpu, mem, 2, 4, CPU_ADDR_SR, _addrCPU_getStackRelative(cpu, mem, cpu->setacc)); break;
-    case 0xc4: i_cpy(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0xc5: i_cmp(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0xc6: i_dec(cpu, mem, 2, 5, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0xc7: i_cmp(cpu, mem, 2, 6, CPU_ADDR_DPINDL, _addrCPU_getDirectPageIndirectLong(cpu, mem, cpu->setacc)); break;
-    case 0xc8: i_iny(cpu); break;
-    case 0xc9: i_cmp(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0xca: i_dex(cpu); break;
-    case 0xcb: i_wai(cpu); break;
-    case 0xcc: i_cpy(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0xcd: i_cmp(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0xce: i_dec(cpu, mem, 3, 6, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0xcf: i_cmp(cpu, mem, 4, 5, CPU_ADDR_ABSL, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0xd0: i_bne(cpu, mem); break;
-    case 0xd1: i_cmp(cpu, mem, 2, 5, CPU_ADDR_INDDPY, _addrCPU_getDirectPageIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xd2: i_cmp(cpu, mem, 2, 5, CPU_ADDR_DPIND, _addrCPU_getDirectPageIndirect(cpu, mem, cpu->setacc)); break;
-    case 0xd3: i_cmp(cpu, mem, 2, 7, CPU_ADDR_SRINDY, _addrCPU_getStackRelativeIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xd4: i_pei(cpu, mem); break;
-    case 0xd5: i_cmp(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xd6: i_dec(cpu, mem, 2, 6, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xd7: i_cmp(cpu, mem, 2, 6, CPU_ADDR_INDDPLY, _addrCPU_getDirectPageIndirectLongIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xd8: i_cld(cpu); break;
-    case 0xd9: i_cmp(cpu, mem, 3, 4, CPU_ADDR_ABSY, _addrCPU_getAbsoluteIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xda: i_phx(cpu, mem); break;
-    case 0xdb: i_stp(cpu); break;
-    case 0xdc: i_jmp(cpu, 6, CPU_ADDR_ABSINDL, _addrCPU_getAbsoluteIndirectLong(cpu, mem, cpu->setacc)); break;
-    case 0xdd: i_cmp(cpu, mem, 3, 4, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xde: i_dec(cpu, mem, 3, 7, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xdf: i_cmp(cpu, mem, 4, 5, CPU_ADDR_ABSLX, _addrCPU_getLongIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xe0: i_cpx(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0xe1: i_sbc(cpu, mem, 2, 6, CPU_ADDR_DPINDX, _addrCPU_getDirectPageIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0xe2: i_sep(cpu, mem); break;
-    case 0xe3: i_sbc(cpu, mem, 2, 4, CPU_ADDR_SR, _addrCPU_getStackRelative(cpu, mem, cpu->setacc)); break;
-    case 0xe4: i_cpx(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0xe5: i_sbc(cpu, mem, 2, 3, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0xe6: i_inc(cpu, mem, 2, 5, CPU_ADDR_DP, _addrCPU_getDirectPage(cpu, mem, cpu->setacc)); break;
-    case 0xe7: i_sbc(cpu, mem, 2, 6, CPU_ADDR_DPINDL, _addrCPU_getDirectPageIndirectLong(cpu, mem, cpu->setacc)); break;
-    case 0xe8: i_inx(cpu); break;
-    case 0xe9: i_sbc(cpu, mem, 2, 2, CPU_ADDR_IMMD, _addrCPU_getImmediate(cpu, mem, cpu->setacc)); break;
-    case 0xea: i_nop(cpu); break;
-    case 0xeb: i_xba(cpu); break;
-    case 0xec: i_cpx(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0xed: i_sbc(cpu, mem, 3, 4, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0xee: i_inc(cpu, mem, 3, 6, CPU_ADDR_ABS, _addrCPU_getAbsolute(cpu, mem, cpu->setacc)); break;
-    case 0xef: i_sbc(cpu, mem, 4, 5, CPU_ADDR_ABSL, _addrCPU_getLong(cpu, mem, cpu->setacc)); break;
-    case 0xf0: i_beq(cpu, mem); break;
-    case 0xf1: i_sbc(cpu, mem, 2, 5, CPU_ADDR_INDDPY, _addrCPU_getDirectPageIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xf2: i_sbc(cpu, mem, 2, 5, CPU_ADDR_DPIND, _addrCPU_getDirectPageIndirect(cpu, mem, cpu->setacc)); break;
-    case 0xf3: i_sbc(cpu, mem, 2, 7, CPU_ADDR_SRINDY, _addrCPU_getStackRelativeIndirectIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xf4: i_pea(cpu, mem); break;
-    case 0xf5: i_sbc(cpu, mem, 2, 4, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xf6: i_inc(cpu, mem, 2, 6, CPU_ADDR_DPX, _addrCPU_getDirectPageIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xf7: i_sbc(cpu, mem, 2, 6, CPU_ADDR_INDDPLY, _addrCPU_getDirectPageIndirectLongIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xf8: i_sed(cpu); break;
-    case 0xf9: i_sbc(cpu, mem, 3, 4, CPU_ADDR_ABSY, _addrCPU_getAbsoluteIndexedY(cpu, mem, cpu->setacc)); break;
-    case 0xfa: i_plx(cpu, mem); break;
-    case 0xfb: i_xce(cpu); break;
-    case 0xfc: i_jsr(cpu, mem, 8, _addrCPU_getAbsoluteIndexedIndirectX(cpu, mem, cpu->setacc)); break;
-    case 0xfd: i_sbc(cpu, mem, 3, 4, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xfe: i_inc(cpu, mem, 3, 7, CPU_ADDR_ABSX, _addrCPU_getAbsoluteIndexedX(cpu, mem, cpu->setacc)); break;
-    case 0xff: i_sbc(cpu, mem, 4, 5, CPU_ADDR_ABSLX, _addrCPU_getLongIndexedX(cpu, mem, cpu->setacc)); break;
-    default:
-        return CPU_ERR_UNKNOWN_OPCODE;
+/**
+ * Bring a CPU's events up to date with its cycle count. If the cycle
+ * count was moved back since the events were last checked (by
+ * resetCPU(), fromstrCPU() or the host setting it), the events are moved
+ * back by the same amount so that they stay as far away as they were.
+ *
+ * @param *cpu The CPU whose events to update
+ */
+static void _cpu_sync_events(CPU_t *cpu)
+{
+    if (cpu->cycles < cpu->events.now)
+    {
+        uint64_t back = cpu->events.now - cpu->cycles;
+        for (uint8_t i = 0; i < cpu->events.count; ++i)
+        {
+            // The same shift for every event keeps the heap in order
+            cpu->events.heap[i].when -= (cpu->events.heap[i].when < back) ? cpu->events.heap[i].when : back;
+        }
     }
+    cpu->events.now = cpu->cycles;
+}
 
-    // Make sure opcode handling did not result in an invalid state
-    if (cpu->P.CRASH == 1)
+
+/**
+ * Run every event which is due at the CPU's current cycle count, in
+ * the order they are due. Events can schedule events of their own
+ * (including themselves), which are run as well if they are due.
+ *
+ * @param *cpu The CPU whose events to run
+ */
+static void _cpu_run_events(CPU_t *cpu)
+{
+    _cpu_sync_events(cpu);
+    while (cpu->events.count > 0 && cpu->events.heap[0].when <= cpu->cycles)
     {
-        return CPU_ERR_CRASH;
+        CPU_Event_t ev = cpu->events.heap[0];
+        _cpu_event_remove(cpu, 0);
+        ev.fn(cpu, ev.ctx);
     }
+}
+
 
-    // Handle any interrupts that are pending
+/**
+ * Handle any interrupts that are pending after an instruction
+ *
+ * @param *cpu The CPU to interrupt
+ * @param *mem The memory array which is connected to the CPU
+ * @return True if an interrupt was taken
+ */
+static bool _cpu_service_interrupts(CPU_t *cpu, memory_t *mem)
+{
     if (cpu->P.NMI)
     {
         cpu->P.NMI = 0;
@@ -479,7 +664,7 @@ CPU_Error_Code_t stepCPU(CPU_t *cpu, memory_t *mem)
         cpu->P.D = 0; // Binary mode (65C02)
         // cpu->P.I = 1; // IRQ flag is not set: https://softpixel.com/~cwright/sianse/docs/65816NFO.HTM#7.00
 
-        return CPU_ERR_OK;
+        return true;
     }
     if (cpu->P.IRQ && !cpu->P.I)
     {
@@ -507,9 +692,440 @@ CPU_Error_Code_t stepCPU(CPU_t *cpu, memory_t *mem)
         cpu->P.D = 0; // Binary mode (65C02)
         cpu->P.I = 1;
 
+        return true;
+    }
+
+    return false;
+}
+
+
+// An execution engine (see _cpu_switch_run())
+typedef uint64_t (*CPU_Engine_Fn)(CPU_t *, memory_t *, uint64_t, uint64_t, uint32_t);
+
+/**
+ * Step a CPU by one instruction with the given execution engine
+ * (see stepCPU())
+ *
+ * @param *cpu The CPU to be stepped
+ * @param *mem The memory array which is to be connected to the CPU
+ * @param engine The execution engine to run the instruction with
+ * @return Error code
+ */
+static inline CPU_Error_Code_t _cpu_step(CPU_t *cpu, memory_t *mem, CPU_Engine_Fn engine)
+{
+    if (cpu->P.CRASH == 1)
+    {
+        return CPU_ERR_CRASH;
+    }
+
+    // Handle CPU reset (does not perform a full CPU reset)
+    if (cpu->P.RST)
+    {
+        cpu->P.RST = 0;
+        cpu->PC = _get_mem_word(mem, CPU_VEC_RESET, cpu->setacc);
         return CPU_ERR_OK;
     }
 
+    if (cpu->P.STP)
+    {
+        return CPU_ERR_STP;
+    }
+
+    _cpu_sync_events(cpu);
+    engine(cpu, mem, 1, UINT64_MAX, 0);
+
+    // Make sure opcode handling did not result in an invalid state
+    if (cpu->P.CRASH == 1)
+    {
+        return CPU_ERR_CRASH;
+    }
+
+    _cpu_run_events(cpu);
+    _cpu_service_interrupts(cpu, mem);
+
+    return CPU_ERR_OK;
+}
+
+
+/**
+ * Steps a CPU by one machine cycle
+ * @param cpu The CPU to be stepped
+ * @param mem The memory array which is to be connected to the CPU
+ */
+CPU_Error_Code_t stepCPU(CPU_t *cpu, memory_t *mem)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (cpu == NULL)
+    {
+        return CPU_ERR_NULL_CPU;
+    }
+#endif
+
+    return _cpu_step(cpu, mem, _cpu_engine_run);
+}
+
+
+/**
+ * Steps a CPU by one instruction with the switch decoder, whichever
+ * execution engine the core was built with. The predecoded instruction
+ * cache and the JIT are not used, and a block move only moves one byte.
+ * This is the reference the other engines are checked against (see
+ * 65816-lockstep.h).
+ *
+ * @param *cpu The CPU to be stepped
+ * @param *mem The memory array which is to be connected to the CPU
+ * @return Error code (as for stepCPU())
+ */
+CPU_Error_Code_t stepRefCPU(CPU_t *cpu, memory_t *mem)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (cpu == NULL)
+    {
+        return CPU_ERR_NULL_CPU;
+    }
+#endif
+
+    return _cpu_step(cpu, mem, _cpu_switch_run);
+}
+
+
+/**
+ * Check if a CPU is waiting in a WAI with no interrupt pending. The
+ * opcode is peeked at, so a PC on a device page has no side effects.
+ *
+ * @param *cpu The CPU to check
+ * @param *mem The memory array which is connected to the CPU
+ * @return True if the CPU is waiting
+ */
+static inline bool _cpu_waiting(CPU_t *cpu, memory_t *mem)
+{
+    return !cpu->P.NMI && !cpu->P.IRQ &&
+        _peek_mem_byte(mem, _cpu_get_effective_pc(cpu)) == CPU_OP_WAI;
+}
+
+
+/**
+ * Runs a CPU until its budget is used up or a stop condition is reached.
+ * CRASH and STP always stop the CPU. Breakpoints, WAI and taken interrupts
+ * only stop the CPU if their CPU_RUN_* bit is set in the stop mask.
+ *
+ * Scheduled events (see scheduleEventCPU()) are run as soon as the
+ * instruction which reaches their cycle count has finished, before any
+ * interrupt they raise is taken.
+ *
+ * A CPU which is waiting in a WAI with no interrupt pending can only be
+ * woken by an event, so its cycle count moves straight on to the next
+ * one (or to the end of a cycle budget) and the event is run. Waiting
+ * does not use up any of an instruction budget, so if CPU_RUN_WAI is set
+ * or the budget counts instructions, the CPU stops (with CPU_RUN_WAI)
+ * after the first event which does not raise an interrupt. Once no events
+ * are left to wait for, the WAI stops the CPU if CPU_RUN_WAI is set, and a
+ * cycle budgeted run always stops there.
+ *
+ * @note The budget is checked between instructions, so a cycle budget
+ *       may be overrun by the last instruction. A CPU which reaches a
+ *       WAI with its instruction budget used up stops with
+ *       CPU_RUN_BUDGET before it waits for anything.
+ * @param *cpu The CPU to be run
+ * @param *mem The memory array which is to be connected to the CPU
+ * @param budget The maximum number of instructions (or cycles if
+ *               CPU_RUN_BUDGET_CYCLES is set in stop_mask) to run for
+ * @param stop_mask CPU_RUN_BREAK, CPU_RUN_WAI and/or CPU_RUN_INT to stop on
+ *                  (plus CPU_RUN_BUDGET_CYCLES)
+ * @return The reason for stopping
+ */
+CPU_Run_Status_t runCPU(CPU_t *cpu, memory_t *mem, uint64_t budget, uint32_t stop_mask)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (cpu == NULL)
+    {
+        return CPU_RUN_NULL_CPU;
+    }
+#endif
+
+    uint64_t count = UINT64_MAX;
+    uint64_t cycle_end = UINT64_MAX;
+    uint32_t wait_mask = stop_mask; // Before a cycle budget adds CPU_RUN_WAI
+
+    if (stop_mask & CPU_RUN_BUDGET_CYCLES)
+    {
+        if (budget < UINT64_MAX - cpu->cycles)
+        {
+            cycle_end = cpu->cycles + budget;
+        }
+        stop_mask |= CPU_RUN_WAI;
+    }
+    else
+    {
+        count = budget;
+    }
+
+    // Handle CPU reset (does not perform a full CPU reset)
+    if (cpu->P.RST && !cpu->P.CRASH)
+    {
+        cpu->P.RST = 0;
+        cpu->PC = _get_mem_word(mem, CPU_VEC_RESET, cpu->setacc);
+    }
+
+    // Catch up on anything that came due since the last run
+    _cpu_run_events(cpu);
+
+    while (true)
+    {
+        if (cpu->P.CRASH)
+        {
+            return CPU_RUN_CRASH;
+        }
+        if (cpu->P.STP)
+        {
+            return CPU_RUN_STP;
+        }
+        if (count == 0 || cpu->cycles >= cycle_end)
+        {
+            return CPU_RUN_BUDGET;
+        }
+
+        // A CPU which is already waiting goes straight back to waiting
+        // for the next event, since running the WAI again would only use
+        // up the instruction budget
+        bool waiting = cpu->events.count > 0 && _cpu_waiting(cpu, mem);
+        if (!waiting)
+        {
+            // The engine only runs up to the next event, so that nothing
+            // (a skipped idle loop, a block move) runs past it, and stops
+            // on a WAI so that the CPU can wait for the event below
+            uint64_t run_end = cycle_end;
+            uint32_t run_mask = stop_mask;
+            if (cpu->events.count > 0)
+            {
+                run_mask |= CPU_RUN_WAI;
+                if (cpu->events.heap[0].when < run_end)
+                {
+                    run_end = cpu->events.heap[0].when;
+                }
+            }
+
+            cpu->idle.pc = CPU_IDLE_NONE;
+            count -= _cpu_engine_run(cpu, mem, count, run_end, run_mask);
+
+            if (cpu->P.CRASH)
+            {
+                return CPU_RUN_CRASH;
+            }
+            _cpu_run_events(cpu);
+            if (_cpu_service_interrupts(cpu, mem) && (stop_mask & CPU_RUN_INT))
+            {
+                return CPU_RUN_INT;
+            }
+            if ((stop_mask & CPU_RUN_BREAK) &&
+                _mem_get_flag(mem, MEM_PLANE_B, _cpu_get_effective_pc(cpu)))
+            {
+                return CPU_RUN_BREAK;
+            }
+
+            // Waiting does not start once the budget is used up
+            waiting = count > 0 && _cpu_waiting(cpu, mem);
+        }
+
+        if (waiting)
+        {
+            // Nothing else happens until an event raises an interrupt.
+            // Waiting does not use up any of an instruction budget, so
+            // an instruction budgeted run stops after one event.
+            while (cpu->events.count > 0 && cpu->cycles < cycle_end)
+            {
+                uint64_t when = cpu->events.heap[0].when;
+                when = (when < cycle_end) ? when : cycle_end;
+                if (cpu->cycles < when)
+                {
+                    cpu->cycles = when;
+                }
+                _cpu_run_events(cpu);
+
+                if (cpu->P.NMI || cpu->P.IRQ || cpu->cycles >= cycle_end)
+                {
+                    break;
+                }
+                if ((wait_mask & CPU_RUN_WAI) || !(wait_mask & CPU_RUN_BUDGET_CYCLES))
+                {
+                    return CPU_RUN_WAI;
+                }
+            }
+            if (!cpu->P.NMI && !cpu->P.IRQ && cpu->events.count == 0 &&
+                (stop_mask & CPU_RUN_WAI))
+            {
+                return CPU_RUN_WAI;
+            }
+        }
+    }
+}
+
+
+/**
+ * Attach a predecoded instruction cache to a CPU. Once attached, the
+ * table dispatcher (CPU_DISPATCH_TABLE) decodes the code it runs into
+ * basic blocks, keeps them in the cache and only decodes them again
+ * after they are written to. The switch in stepCPU() does not use it.
+ * 
+ * @note The cache is owned by the caller and must stay allocated for
+ *       as long as it is attached. Any previous contents are discarded.
+ * @param *cpu The CPU to attach the cache to
+ * @param *cache The cache to attach (NULL to detach the current one)
+ * @return CPU_ERR_OK
+ */
+CPU_Error_Code_t setDecodeCacheCPU(CPU_t *cpu, CPU_Decode_Cache_t *cache)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (cpu == NULL)
+    {
+        return CPU_ERR_NULL_CPU;
+    }
+#endif
+
+    if (cache)
+    {
+        memset(cache, 0, sizeof(*cache));
+    }
+    cpu->dcache = cache;
+
+    return CPU_ERR_OK;
+}
+
+
+/**
+ * Attach a native code compiler (JIT) to a CPU. Once attached, the
+ * table dispatcher compiles each block in the CPU's predecoded
+ * instruction cache (see setDecodeCacheCPU()) to native code after
+ * it has been entered `threshold` times and runs the compiled code from
+ * then on. Compiled code is dropped along with its decoded block (when
+ * the block is written to or a breakpoint is set in it). Blocks are only
+ * run as native code while the CPU is not setting memory access flags
+ * (setacc), the rest of the time they are interpreted as usual.
+ * If a JIT is already attached, only its threshold is changed.
+ *
+ * @note The JIT is only available when built with CPU_JIT (which needs
+ *       CPU_DISPATCH_TABLE) on x86-64 hosts.
+ * @param *cpu The CPU to attach the JIT to
+ * @param threshold Times a block is entered before it is compiled
+ * @return CPU_ERR_OK or CPU_ERR_NO_JIT if the JIT is not available
+ */
+CPU_Error_Code_t enableJITCPU(CPU_t *cpu, uint16_t threshold)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (cpu == NULL)
+    {
+        return CPU_ERR_NULL_CPU;
+    }
+#endif
+
+    if (cpu->jit)
+    {
+        cpu->jit->threshold = threshold;
+        return CPU_ERR_OK;
+    }
+
+    cpu->jit = _cpu_jit_create(threshold);
+    return cpu->jit ? CPU_ERR_OK : CPU_ERR_NO_JIT;
+}
+
+
+/**
+ * Detach and free a CPU's JIT (see enableJITCPU()). This must be
+ * called before a CPU with a JIT is discarded.
+ * 
+ * @param *cpu The CPU to detach the JIT from
+ * @return CPU_ERR_OK
+ */
+CPU_Error_Code_t disableJITCPU(CPU_t *cpu)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (cpu == NULL)
+    {
+        return CPU_ERR_NULL_CPU;
+    }
+#endif
+
+    if (cpu->jit)
+    {
+        _cpu_jit_flush(cpu->jit, cpu->dcache);
+        _cpu_jit_destroy(cpu->jit);
+        cpu->jit = NULL;
+    }
+
+    return CPU_ERR_OK;
+}
+
+
+/**
+ * Schedule a device callback to run once the CPU has run for another
+ * `delay` cycles. This lets devices with timed behavior (a character
+ * being shifted out, a timer underflowing) update their state and
+ * raise interrupts when that time comes, instead of being polled after
+ * every instruction. runCPU() never runs the CPU past the next event
+ * without running it. Each callback/context pair can only be scheduled
+ * once: scheduling it again moves it to the new time.
+ *
+ * @note Events are run from runCPU() and stepCPU() between instructions,
+ *       so they can run up to one instruction late. An event which
+ *       schedules itself again should do so with a delay above 0.
+ * @param *cpu The CPU whose cycle count the event is timed by
+ * @param delay Cycles from the CPU's current cycle count until the event
+ * @param fn The callback to run
+ * @param *ctx Passed on to the callback
+ * @return CPU_ERR_OK or CPU_ERR_EVENTS_FULL if CPU_EVENTS_MAX events
+ *         are already scheduled
+ */
+CPU_Error_Code_t scheduleEventCPU(CPU_t *cpu, uint64_t delay, CPU_Event_Fn fn, void *ctx)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (cpu == NULL)
+    {
+        return CPU_ERR_NULL_CPU;
+    }
+#endif
+
+    uint64_t when = (delay < UINT64_MAX - cpu->cycles) ? cpu->cycles + delay : UINT64_MAX;
+
+    _cpu_sync_events(cpu);
+    cancelEventCPU(cpu, fn, ctx);
+    if (cpu->events.count == CPU_EVENTS_MAX)
+    {
+        return CPU_ERR_EVENTS_FULL;
+    }
+
+    cpu->events.heap[cpu->events.count] = (CPU_Event_t){ .when = when, .fn = fn, .ctx = ctx };
+    _cpu_event_sift_up(cpu, cpu->events.count++);
+
+    return CPU_ERR_OK;
+}
+
+
+/**
+ * Remove a scheduled device callback (see scheduleEventCPU()), if it
+ * is scheduled.
+ *
+ * @param *cpu The CPU the event was scheduled on
+ * @param fn The callback which was scheduled
+ * @param *ctx The context it was scheduled with
+ * @return CPU_ERR_OK
+ */
+CPU_Error_Code_t cancelEventCPU(CPU_t *cpu, CPU_Event_Fn fn, void *ctx)
+{
+#ifdef CPU_DEBUG_CHECK_NULL
+    if (cpu == NULL)
+    {
+        return CPU_ERR_NULL_CPU;
+    }
+#endif
+
+    for (uint8_t i = 0; i < cpu->events.count; ++i)
+    {
+        if (cpu->events.heap[i].fn == fn && cpu->events.heap[i].ctx == ctx)
+        {
+            _cpu_event_remove(cpu, i);
+            break;
+        }
+    }
 
     return CPU_ERR_OK;
 }
@@ -24,35 +24,55 @@
 
 // CPU "Class"
 typedef struct CPU_t CPU_t;
+typedef struct CPU_Decode_Cache_t CPU_Decode_Cache_t;
+typedef struct CPU_JIT_t CPU_JIT_t;
+
+// A device callback which runCPU()/stepCPU() calls once the CPU's cycle
+// count reaches the time it was scheduled for (see scheduleEventCPU())
+typedef void (*CPU_Event_Fn)(CPU_t *cpu, void *ctx);
+
+typedef struct CPU_Event_t {
+    uint64_t when; // Cycle count the event is due at
+    CPU_Event_Fn fn;
+    void *ctx;
+} CPU_Event_t;
+
+// Max events which can be scheduled on a CPU at the same time
+#define CPU_EVENTS_MAX 16
 
 struct CPU_t 
 {
+    // Registers (16-bit ones first so that there is no padding between them)
     uint16_t C;
-    uint8_t  DBR;
     uint16_t X;
     uint16_t Y;
     uint16_t D;
     uint16_t SP;
-    uint8_t  PBR;
     uint16_t PC;
+    uint8_t  DBR;
+    uint8_t  PBR;
     struct {
-        // Order matters (keep in sync with SR in CPU):
-        unsigned char C : 1;   
-        unsigned char Z : 1;
-        unsigned char I : 1;
-        unsigned char D : 1;
-        unsigned char XB : 1; // B in emulation
-        unsigned char M : 1;
-        unsigned char V : 1;
-        unsigned char N : 1;
-        // Order no longer matters:
-        unsigned char E : 1;
-        unsigned char RST : 1; // 1 if the CPU was reset, 0 if reset vector has been jumped to
-        unsigned char IRQ : 1; // 1 if IRQ input is asserted, 0 else
-        unsigned char NMI : 1; // 1 if NMI input is asserted, 0 else
-        unsigned char STP : 1; // 1 if CPU has executed a STP instruction, 0 else
-        // unsigned char ABT : 1; // 1 if ABORT input is asserted, 0 else
-        unsigned char CRASH : 1; // 1 if invalid sim state reached (CRASH flag)
+        // Status register, one byte per flag (0 or 1).
+        // Use _cpu_get_sr()/_cpu_set_sr() for the packed byte.
+        uint8_t C;
+        uint8_t I;
+        uint8_t D;
+        uint8_t XB; // B in emulation
+        uint8_t M;
+        uint8_t V;
+        uint8_t E;
+        // N and Z are only worked out when they are read (see _cpu_get_n()
+        // and _cpu_get_z() in 65816-util.h) from the last result which
+        // set them: N is bit 7 of NZ_N and Z is set if NZ_Z is 0
+        uint8_t NZ_N;
+        uint16_t NZ_Z;
+        // CPU state:
+        uint8_t RST; // 1 if the CPU was reset, 0 if reset vector has been jumped to
+        uint8_t IRQ; // 1 if IRQ input is asserted, 0 else
+        uint8_t NMI; // 1 if NMI input is asserted, 0 else
+        uint8_t STP; // 1 if CPU has executed a STP instruction, 0 else
+        // uint8_t ABT; // 1 if ABORT input is asserted, 0 else
+        uint8_t CRASH; // 1 if invalid sim state reached (CRASH flag)
 
     } P;
 
@@ -63,6 +83,37 @@ struct CPU_t
     // Enables this CPU to update access flags on memory addresses
     bool setacc;
 
+    // Predecoded instruction cache (NULL if not in use)
+    // See setDecodeCacheCPU()
+    CPU_Decode_Cache_t *dcache;
+
+    // Native code compiler for hot decoded blocks (NULL if not in use)
+    // See enableJITCPU()
+    CPU_JIT_t *jit;
+
+    // The CPU's state the last time it branched back to the start of a loop
+    // which only reads memory (see _cpu_skip_idle()). runCPU() clears it
+    // before each run of the execution engine.
+    struct {
+        uint32_t pc;     // 24-bit address of the loop (CPU_IDLE_NONE if none)
+        uint32_t len;    // Instructions in one pass of the loop (0 if pc is not one)
+        uint64_t done;   // Instructions the engine had executed at that point
+        uint64_t cycles;
+        uint16_t C, X, Y, SP, D;
+        uint8_t DBR, SR, E;
+        uint64_t skipped; // Instructions skipped over in total (never cleared)
+    } idle;
+
+    // Scheduled events, kept as a binary min-heap on the cycle count they
+    // are due at (see scheduleEventCPU()). now is the cycle count the
+    // events were last checked at, so that they can be moved back along
+    // with the cycle count (by resetCPU() for example).
+    struct {
+        CPU_Event_t heap[CPU_EVENTS_MAX];
+        uint8_t count;
+        uint64_t now;
+    } events;
+
     // ******** Special features ********
     // Set true to use the immediate value of a COP
     // instruction as an offset from the address placed at
@@ -83,8 +134,28 @@ typedef enum CPU_Error_Code_t
      CPU_ERR_NULL_CPU, // Only used if `CPU_DEBUG_CHECK_NULL` is defined
      CPU_ERR_CRASH, // Returned if stepCPU() is called on a CPU which has reached an unhandled sim state
      CPU_ERR_STR_PARSE, // Returned in fromstrCPU() if scanning of the input string fails
+     CPU_ERR_NO_JIT, // Returned by enableJITCPU() if the JIT is not available (see enableJITCPU())
+     CPU_ERR_EVENTS_FULL, // Returned by scheduleEventCPU() if CPU_EVENTS_MAX events are already scheduled
  } CPU_Error_Code_t;
 
+// Reasons for runCPU() to return. The optional conditions are only
+// checked if their bit is set in the stop mask passed to runCPU()
+typedef enum CPU_Run_Status_t
+ {
+     CPU_RUN_BUDGET = 0x00,   // The instruction (or cycle) budget has been used up
+     CPU_RUN_CRASH = 0x01,    // The CPU has reached an unhandled sim state (CRASH flag)
+     CPU_RUN_STP = 0x02,      // The CPU is in the SToPped state due to a STP instruction
+     CPU_RUN_BREAK = 0x04,    // Optional: PC is at an address with its breakpoint (B) flag set
+     CPU_RUN_WAI = 0x08,      // Optional: the CPU is executing a WAI with no interrupt pending
+     CPU_RUN_INT = 0x10,      // Optional: the CPU has just taken an NMI or IRQ
+     CPU_RUN_NULL_CPU = 0x20, // Only used if `CPU_DEBUG_CHECK_NULL` is defined
+     CPU_RUN_DIVERGED = 0x40, // Only from runLockstepCPU(): the CPU no longer matches its reference
+ } CPU_Run_Status_t;
+
+// Not a stop condition: set in the stop mask passed to runCPU()
+// to count the budget in cycles instead of instructions
+#define CPU_RUN_BUDGET_CYCLES 0x100
+
 // Used to specify if the call to stack operations should allow
 // keeping the stack within page 1 while a CPU is in emulation mode
 typedef enum Emul_Stack_Mod_t
@@ -122,29 +193,170 @@ typedef enum CPU_Addr_Mode_t
 } CPU_Addr_Mode_t;
 
 // Note: keep the ordering of bits consistent with the
-// mask used in the flag test functions in 65816-util
+// MEM_PLANE_* indices below
 typedef struct mem_flag_t {
     uint8_t R : 1; // Set if address read by CPU
     uint8_t W : 1; // Set if address written by CPU
     uint8_t B : 1; // Set if breakpoint active on address
                    // (UNUSED by CPU CORE but used by debugger)
+    uint8_t X : 1; // Set if a block starting at this address is in
+                   // a CPU's predecoded instruction cache (CPU CORE only)
+    uint8_t C : 1; // Set if this address is part of a decoded block
+                   // (CPU CORE only)
 } mem_flag_t;
 
-#define MEM_FLAG_R 0x01
-#define MEM_FLAG_W 0x02
-#define MEM_FLAG_B 0x04
+// Each flag is kept in its own bit-plane (one bit per address)
+enum {
+    MEM_PLANE_R = 0,
+    MEM_PLANE_W,
+    MEM_PLANE_B,
+    MEM_PLANE_X,
+    MEM_PLANE_C,
+    MEM_PLANES
+};
+
+#define MEM_FLAG_R (1u << MEM_PLANE_R)
+#define MEM_FLAG_W (1u << MEM_PLANE_W)
+#define MEM_FLAG_B (1u << MEM_PLANE_B)
+#define MEM_FLAG_X (1u << MEM_PLANE_X)
+#define MEM_FLAG_C (1u << MEM_PLANE_C)
+
+// Size of the 24-bit address space
+#define MEMORY_SIZE 0x1000000 // 16MiB
+
+// The address space is split into 256-byte pages. Each page is
+// plain RAM, read-only ROM or belongs to a memory-mapped device.
+#define MEM_PAGE_BITS 8
+#define MEM_PAGE_SIZE (1u << MEM_PAGE_BITS)
+#define MEM_PAGES (MEMORY_SIZE >> MEM_PAGE_BITS)
+
+// Page types. Anything from MEM_PAGE_IO up maps the page to
+// device (type - MEM_PAGE_IO) of the memory's device table
+#define MEM_PAGE_RAM 0
+#define MEM_PAGE_ROM 1
+#define MEM_PAGE_IO 2
+#define MEM_DEVICES_MAX 16
+
+// A memory-mapped device (see _map_mem_io()). The callbacks are
+// given the device's ctx and the offset of the access from base.
+// Any callback can be NULL, in which case the access goes to the
+// memory's own bytes as if the device were not there.
+typedef struct mem_device_t {
+    uint32_t base; // First address of the device's registers
+    uint32_t size; // Number of bytes taken up by the registers
+    uint8_t (*read)(void *ctx, uint32_t offs);            // CPU read (can have side effects)
+    void (*write)(void *ctx, uint32_t offs, uint8_t val); // CPU write
+    uint8_t (*peek)(void *ctx, uint32_t offs);            // Debugger read (no side effects)
+    void *ctx;
+    // Bit n set if CPU reads of register n (< 32) have no side effects, which
+    // lets the CPU skip over loops that poll the register (see _cpu_skip_idle())
+    uint32_t pure;
+} mem_device_t;
 
+#ifdef CPU_MEM_SPARSE
+// Pages of a bank (the sparse memory's second level)
+#define MEM_BANK_PAGES (0x10000u >> MEM_PAGE_BITS)
+
+// The values and flags of one page of sparse memory
+typedef struct mem_page_t {
+    uint8_t val[MEM_PAGE_SIZE];
+    uint8_t flag[MEM_PLANES][MEM_PAGE_SIZE / 8]; // Bit (addr & 7) of byte ((addr & 0xff) >> 3)
+} mem_page_t;
+#endif
+
+// System memory: the page table which routes every access, the mapped
+// devices, the values of the address space (one contiguous plane, so
+// data reads do not pull flags into the cache) and the flag bit-planes.
+// When built with CPU_MEM_SPARSE, the values and flags are instead kept
+// in pages which are allocated the first time anything is written to
+// them (reads of the others see zeros), so a memory only takes up space
+// for the pages its program uses. Otherwise, the memory is mapped from
+// the OS (see _alloc_mem()) so that the host only backs the parts of it
+// which are written to; the values and the planes come first to keep
+// them aligned to huge pages.
+// Create one with _alloc_mem() (all RAM) and only touch it through the
+// memory functions in 65816-util.
 typedef struct memory_t {
-    uint8_t val;
-    mem_flag_t acc;
+#ifdef CPU_MEM_SPARSE
+    mem_page_t **bank[MEMORY_SIZE >> 16]; // MEM_BANK_PAGES pages of each bank, NULL until used
+    uint32_t *used;     // Numbers of the allocated pages, in the order they were allocated
+    uint32_t used_count;
+    uint32_t used_max;  // Size of used
+#else
+    uint8_t val[MEMORY_SIZE];
+    uint8_t flag[MEM_PLANES][MEMORY_SIZE / 8]; // Bit (addr & 7) of byte (addr >> 3)
+#endif
+    uint8_t page[MEM_PAGES]; // MEM_PAGE_* type of each page
+    mem_device_t device[MEM_DEVICES_MAX];
+
+    // Pages whose values have been written to since _cmp_mem_dirty()
+    // last looked at them (a bit per page, and a list of the set bits)
+    uint8_t dirty[MEM_PAGES / 8];
+    uint16_t dirty_pages[MEM_PAGES];
+    uint32_t dirty_count;
 } memory_t;
 
+// Marks CPU_t's idle loop state as unused
+#define CPU_IDLE_NONE 0xffffffffu
+// Max bytes spanned by a loop which can be skipped (see _cpu_skip_idle())
+#define CPU_IDLE_LOOP_BYTES 16
+
+// Predecoded instruction cache dimensions
+#define CPU_DECODE_CACHE_BLOCKS 0x400 // Number of blocks (power of 2)
+#define CPU_DECODE_BLOCK_LEN 16       // Max instructions per block
+#define CPU_DECODE_BLOCK_BYTES 64     // Max bytes spanned by a block
+
+// A decoded instruction
+typedef struct CPU_Decode_Entry_t {
+    uint32_t operand; // Operand bytes (little endian), or the offset of an 8-bit branch
+    uint8_t opcode;   // Selects the handler (for the width in the block's key)
+    uint8_t len;      // Bytes fetched to decode it (opcode + operand bytes)
+    uint8_t size;     // Instruction length in bytes
+} CPU_Decode_Entry_t;
+
+// Native code for a decoded block: runs up to (budget) instructions of the
+// block and returns the number which were executed (see enableJITCPU())
+typedef uint64_t (*CPU_JIT_Block_Fn)(CPU_t *cpu, memory_t *mem, uint64_t budget, uint64_t cycle_end);
+
+// A basic block: a run of instructions which are always executed in
+// order. A block ends at anything which does not step the PC over the
+// instruction (branches, jumps, calls, returns, BRK/COP, MVN/MVP, WAI
+// and STP), which can change the register widths (REP, SEP, XCE, PLP)
+// or which can unmask an interrupt (CLI), and just before an address
+// with a breakpoint set or on a device page. The key is the block's
+// 24-bit start address with the register width state (M/X/E) in bits
+// 24..25 and bit 31 set once the block has been decoded.
+typedef struct CPU_Decode_Block_t {
+    uint32_t key;
+    uint8_t count; // Number of instructions in the block
+    uint16_t hits; // Number of times the block has been entered (JIT only)
+    CPU_JIT_Block_Fn native; // Compiled block (NULL if not compiled)
+    CPU_Decode_Entry_t insn[CPU_DECODE_BLOCK_LEN];
+} CPU_Decode_Block_t;
+
+// Direct-mapped cache of decoded blocks. Blocks are dropped when
+// anything writes to their bytes or sets a breakpoint in them through
+// the memory functions (this clears the X flag on the block's first
+// byte), so a cache must only be attached to one CPU and no other cache
+// should be used with the same memory array at the same time.
+struct CPU_Decode_Cache_t {
+    memory_t *mem; // The memory array the blocks were decoded from
+    CPU_Decode_Block_t blocks[CPU_DECODE_CACHE_BLOCKS];
+};
+
 
 CPU_Error_Code_t tostrCPU(CPU_t *, char *);
 CPU_Error_Code_t fromstrCPU(CPU_t *, char *);
 CPU_Error_Code_t initCPU(CPU_t *);
 CPU_Error_Code_t resetCPU(CPU_t *);
 CPU_Error_Code_t stepCPU(CPU_t *, memory_t *);
+CPU_Error_Code_t stepRefCPU(CPU_t *, memory_t *);
+CPU_Run_Status_t runCPU(CPU_t *, memory_t *, uint64_t, uint32_t);
+CPU_Error_Code_t setDecodeCacheCPU(CPU_t *, CPU_Decode_Cache_t *);
+CPU_Error_Code_t enableJITCPU(CPU_t *, uint16_t);
+CPU_Error_Code_t disableJITCPU(CPU_t *);
+CPU_Error_Code_t scheduleEventCPU(CPU_t *, uint64_t, CPU_Event_Fn, void *);
+CPU_Error_Code_t cancelEventCPU(CPU_t *, CPU_Event_Fn, void *);
 
 
 #endif
@@ -3,12 +3,9 @@
  * Copyright (C) 2023 Ray Clemens
  */
 
-// For sys/stat operations
-#define _FILE_OFFSET_BITS 64
-
-// Needed for sigaction and strtok_r
+// Needed for sigaction, strtok_r and clock_nanosleep
 // TODO: Figure out a "correct" number for this
-#define _POSIX_C_SOURCE 200000L
+#define _POSIX_C_SOURCE 200112L
 
 #include <stdint.h>
 #include <stdlib.h>
@@ -20,12 +17,14 @@
 #include <ncurses.h>
 #include <limits.h>
 
-#include <sys/stat.h> // For getting file sizes
 #include <signal.h> // For ^Z support
 #include <errno.h>
+#include <poll.h> // For sleeping while the CPU waits
+#include <time.h> // For running at a throttled clock rate
 
 #include "disassembler.h"
 #include "symbols.h"
+#include "loader.h"
 #include "../cpu/65816.h"
 #include "../cpu/65816-util.h"
 #include "../hw/16C750.h"
@@ -48,62 +47,25 @@ static char *status_msgs[] = {
 };
 
 
-// Global error message buffer. Used in conjunction
-// with the cmd_err_msgs return values.
-// To signal use of this buffer, return
-// cmd_err_t = CMD_SPECIAL
-char global_err_msg_buf[1024];
-
-// Error messages for command parsing/execution
-// Keep in sync with the cmd_err_t enum in debugger.h
-cmd_err_msg cmd_err_msgs[] = {
-    {"",0,0,""}, // OK
-    {"ERROR!", 3, 4, global_err_msg_buf},
-    {"ERROR!", 3, 34, "Expected argument for command."},
-    {"ERROR!", 3, 27, "Expected register name."},
-    {"ERROR!", 3, 19, "Expected value."},
-    {"ERROR!", 3, 36, "Unknown symbol or invalid value."},
-    {"ERROR!", 3, 21, "Unknown argument."},
-    {"ERROR!", 3, 20, "Unknown command."},
-    {"HELP", 20, 45, "Available commands\n"
-     " > exit|quit ... Close simulator\n"
-     " > mw[1|2] [mem|asm|pc|addr|aaaaaa] [...]\n"
-     " > irq [set|clear]\n"
-     " > nmi [set|clear]\n"
-     " > aaaaaa: xx yy zz\n"
-     " > save [mem|cpu] filename\n"
-     " > load mem (mos) (offset) filename\n"
-     " > load cpu filename\n"
-     " > sym filename\n"
-     " > cpu [reg] xxxx\n"
-     " > cpu [option] [enable|disable|status]\n"
-     " > bp aaaaaa\n"
-     " > uart [type] aaaaaa (pppp)\n"
-     " > mouse scroll [default|reverse]\n"
-     " ? ... Help Menu\n"
-     " ^G to clear command input\n"
-     " ^P|^N to scroll through history"},
-    {"HELP?", 3, 13, "Not help."},
-    {"ERROR!", 3, 34, "Unknown character encountered."},
-    {"ERROR!", 3, 30, "Overflow in numeric value."},
-    {"ERROR!", 3, 22, "Expected filename."},
-    {"ERROR!", 3, 24, "Unable to open file."},
-    {"ERROR!", 3, 20, "File too large."},
-    {"ERROR!", 3, 41, "File will wrap due to offset address."},
-    {"ERROR!", 3, 27, "File permission denied."},
-    {"ERROR!", 3, 29, "Too many symbolic links."},
-    {"ERROR!", 3, 22, "Filename too long."},
-    {"ERROR!", 3, 24, "File does not exist."},
-    {"ERROR!", 3, 33, "Unhandled file-related error."},
-    {"ERROR!", 3, 19, "Corrupt file."},
-    {"ERROR!", 4, 40, "Corrupt data format during CPU load.\nCPU may be in an unexpected state."},
-    {"INFO",   3, 39, "CPU option cop_vect_enable ENABLED."},
-    {"INFO",   3, 40, "CPU option cop_vect_enable DISABLED."},
-    {"ERROR!", 3, 44, "Unable to allocate memory for operation."},
-    {"ERROR!", 3, 23, "Unsupported device."},
-    {"ERROR!", 3, 24, "Invalid port number."},
-    {"INFO",   3, 18, "UART disabled."}
-};
+/**
+ * Formats a clock rate with its unit (e.g. "8.000 MHz")
+ * 
+ * @param *buf The buffer to write the rate into
+ * @param len The size of the buffer
+ * @param hz The clock rate in Hz
+ */
+void format_clock_rate(char *buf, size_t len, uint64_t hz)
+{
+    if (hz >= 1000000) {
+        snprintf(buf, len, "%.3f MHz", hz / 1e6);
+    }
+    else if (hz >= 1000) {
+        snprintf(buf, len, "%.3f kHz", hz / 1e3);
+    }
+    else {
+        snprintf(buf, len, "%lu Hz", (unsigned long) hz);
+    }
+}
 
 
 /**
@@ -112,8 +74,10 @@ cmd_err_msg cmd_err_msgs[] = {
  * @param width The width in characters of the terminal
  * @param status_id The identifier of the interface status message to print
  * @param alert true if the status bar should blink
+ * @param *thr The clock throttle (the achieved and target clock rates
+ *             are shown while running with a throttled clock)
  */
-void print_header(size_t width, status_t status_id, bool alert)
+void print_header(size_t width, status_t status_id, bool alert, throttle_t *thr)
 {
     wmove(stdscr, 0, 0);
     attron(A_REVERSE);
@@ -130,6 +94,15 @@ void print_header(size_t width, status_t status_id, bool alert)
         attron(A_REVERSE);
     }
 
+    if (status_id == STATUS_RUN && thr->clock_hz) {
+        char target[16], achieved[16] = "--";
+        format_clock_rate(target, sizeof(target), thr->clock_hz);
+        if (thr->achieved_hz) {
+            format_clock_rate(achieved, sizeof(achieved), thr->achieved_hz);
+        }
+        wprintw(stdscr, " | Clock %s / %s", achieved, target);
+    }
+
     attroff(A_REVERSE);
 }
 
@@ -162,8 +135,8 @@ void print_cpu_regs(WINDOW *win, CPU_t *cpu, int y, int x)
     mvwprintw(win, y+7, x, "%d    %d    %d    %d    %d",
               cpu->P.RST, cpu->P.IRQ, cpu->P.NMI, cpu->P.STP, cpu->P.CRASH);
     mvwprintw(win, y+1, x+22, "%d%d%d%d%d%d%d%d|%d",
-              cpu->P.N, cpu->P.V, cpu->P.M, cpu->P.XB, cpu->P.D,
-              cpu->P.I, cpu->P.Z, cpu->P.C, cpu->P.E);
+              _cpu_get_n(cpu), cpu->P.V, cpu->P.M, cpu->P.XB, cpu->P.D,
+              cpu->P.I, _cpu_get_z(cpu), cpu->P.C, cpu->P.E);
     mvwprintw(win, y+4, x+22, "%010ld", cpu->cycles);
     wattroff(win, A_BOLD);
 }
@@ -182,8 +155,8 @@ void print_cpu_regs(WINDOW *win, CPU_t *cpu, int y, int x)
  */
 void update_cpu_hist(hist_t *hist, CPU_t *cpu, memory_t *mem, bool replace)
 {
-    uint32_t val;
-    size_t i;
+    uint32_t pc;
+    size_t i, j;
 
     // Clear the history list if the CPU was reset
     if (cpu->P.RST) {
@@ -222,11 +195,10 @@ void update_cpu_hist(hist_t *hist, CPU_t *cpu, memory_t *mem, bool replace)
     memcpy(hist->cpu + i, cpu, sizeof(*cpu));
 
     // Copy in memory in case there is self-modifying asm code
-    hist->mem[i][0].val = _get_mem_byte(mem, _cpu_get_effective_pc(cpu), false);
-    val = _cpu_get_immd_long(cpu, mem, false);
-    hist->mem[i][1].val = val & 0xff;
-    hist->mem[i][2].val = (val >> 8) & 0xff;
-    hist->mem[i][3].val = (val >> 16) & 0xff;
+    pc = _cpu_get_effective_pc(cpu);
+    for (j = 0; j < 4; ++j) {
+        hist->ins[i][j] = _peek_mem_byte(mem, _addr_add_val_bank_wrap(pc, j));
+    }
 }
 
 
@@ -325,7 +297,7 @@ void print_cpu_hist(hist_t *hist)
                 wclrtoeol(hist->win);
 
                 // Print the current opcode
-                get_opcode_by_addr((memory_t*)&(hist->mem[j]), &(hist->cpu[j]), buf, 0);
+                get_opcode_from_bytes(hist->ins[j], &(hist->cpu[j]), buf);
                 mvwprintw(hist->win, row, 10, "%s", buf);
             }
             else {
@@ -348,301 +320,214 @@ void print_cpu_hist(hist_t *hist)
 
 
 /**
- * Check if a string is a decimal string and parse it if so
+ * Gets the number of nanoseconds from one time to another
  * 
- * @param *str The string to parse
- * @param *val A pointer to the variable to store the parsed value in
- * @return false if the string is not decimal (val will not be modified if so)
- *         true if the string is decimal and was successfully parsed
+ * @param *to The later time
+ * @param *from The earlier time
+ * @return The time from `from` to `to` in ns (negative if `to` is earlier)
  */
-bool is_dec_do_parse(char *str, uint32_t *val)
+int64_t timespec_diff_ns(const struct timespec *to, const struct timespec *from)
 {
-    // Determine if this is actually a hex address
-    char *tmp = str;
-    while (isdigit(*tmp)) {
-        /* scan */
-        ++tmp;
-    }
-
-    // If the entire argument is hex, use it as an address
-    if (*tmp == '\0' || *tmp == '\n') {
-        *val = strtoul(str, NULL, 10);
-        return true;
-    }
-    return false;
+    return (int64_t) (to->tv_sec - from->tv_sec) * 1000000000 + (to->tv_nsec - from->tv_nsec);
 }
 
 
 /**
- * Check if a string is a hex string and parse it if so
+ * Moves a time forward
  * 
- * @param *str The string to parse
- * @param *val A pointer to the variable to store the parsed value in
- * @return false if the string is not hex (val will not be modified if so)
- *         true if the string is hex and was successfully parsed
+ * @param *t The time to move
+ * @param ns The number of nanoseconds to move it forward by
  */
-bool is_hex_do_parse(char *str, uint32_t *val)
+void timespec_add_ns(struct timespec *t, uint64_t ns)
 {
-    // Determine if this is actually a hex address
-    char *tmp = str;
-    while (isxdigit(*tmp)) {
-        /* scan */
-        ++tmp;
+    t->tv_sec += ns / 1000000000;
+    t->tv_nsec += ns % 1000000000;
+    if (t->tv_nsec >= 1000000000) {
+        t->tv_nsec -= 1000000000;
+        ++t->tv_sec;
     }
-
-    // If the entire argument is hex, use it as an address
-    if (*tmp == '\0' || *tmp == '\n') {
-        *val = strtoul(str, NULL, 16);
-        return true;
-    }
-    return false;
 }
 
 
 /**
- * Parse a string and return its corresponding numeric value
+ * Starts timing a throttled run from the current time. Call this
+ * whenever RUN mode is entered or the clock rate changes.
  * 
- * @param *str The string to parse
- * @param *val A pointer to the variable to store the parsed value in
- * @return false if the string is not a valid address (val will not be modified if so)
- *         true if the string is a valid address and was successfully parsed
+ * @param *thr The throttle to start
  */
-bool is_addr_do_parse(char *str, uint32_t *val, symbol_table_t *st)
+void throttle_start(throttle_t *thr)
 {
-    symbol_t *st_sym;
-
-    if ((st_sym = st_resolve_by_ident(st, str))) {
-        *val = st_sym->addr;
-    }
-    else if (!is_hex_do_parse(str, val)) {
-        return false;
-    }
-    return true;
+    clock_gettime(CLOCK_MONOTONIC, &thr->deadline);
+    thr->deadline_rem = 0;
+    thr->rate_start = thr->deadline;
+    thr->rate_cycles = 0;
+    thr->next_redraw = thr->deadline;
 }
 
 
 /**
- * Load a file into memory
+ * Moves a throttled run past time that the CPU spent waiting in a WAI.
+ * When the CPU starts waiting, its cycle count moves straight on to the
+ * next scheduled event, such as the UART's poll (see runCPU()), and
+ * throttle_run() has already moved the deadline on by those cycles. The
+ * cycle count does not change while the simulator sleeps after that, so
+ * only the time past the deadline is dropped, and it is not included in
+ * the catching up or the achieved clock rate.
  * 
- * @param *filename The path of the file to load
- * @param *mem The memory to store the data into
- * @param base_addr The base address to load the file at
- * @param memory_format Sets the formatting of the data file to read
- * @return A status code indicating errors if any occur
+ * @param *thr The throttle to resynchronize
  */
-cmd_err_t load_file_mem(char *filename, memory_t *mem, uint32_t base_addr, memory_fmt_t memory_format)
+void throttle_resync(throttle_t *thr)
 {
-    // Get the size of the file
-    struct stat finfo;
-
-    // Lots of error values!
-    if (stat(filename, &finfo) != 0) {
-        switch (errno) {
-        case EACCES:
-            return CMD_FILE_PERM_DENIED;
-            break;
-        case ELOOP:
-            return CMD_FILE_LOOP;
-            break;
-        case ENAMETOOLONG:
-            return CMD_FILE_NAME_TOO_LONG;
-            break;
-        case ENOTDIR:
-        case ENOENT:
-            return CMD_FILE_NOT_EXIST;
-            break;
-        default:
-            return CMD_FILE_UNKNOWN_ERROR;
-        }
-    }
-
-    size_t size = finfo.st_size;
+    struct timespec now;
+    int64_t lag;
 
-    // All good, let's open the file
-    FILE *fp = fopen(filename, "rb");
-    if (!fp) {
-        return CMD_FILE_IO_ERROR;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    lag = timespec_diff_ns(&now, &thr->deadline);
+    if (lag > 0) {
+        thr->deadline = now;
+        thr->deadline_rem = 0;
+        timespec_add_ns(&thr->rate_start, lag);
     }
+}
 
-    uint8_t *tmp = NULL;
-    
-    switch (memory_format) {
-    default:
-    case MF_BASIC_BIN_BLOCK: {
-        // Check file size
-        if (size / sizeof(*mem) > 0x1000000) {
-            return CMD_FILE_TOO_LARGE;
-        }
 
-        // Make sure the file won't wrap
-        if ((size / sizeof(*mem)) + base_addr > 0x1000000) {
-            return CMD_FILE_WILL_WRAP;
-        }
+/**
+ * Runs one slice of RUN mode at the throttled clock rate.
+ * 
+ * Each slice has a budget of 1/THROTTLE_SLICES_PER_SEC seconds worth
+ * of cycles, and moves the deadline on by the time that the cycles it
+ * actually ran take at the target clock rate (so a slice which overruns
+ * its budget is made up for by a shorter wait for the next one). Until
+ * the deadline is reached, this sleeps instead of running the CPU. If
+ * the host falls behind, slices are run back to back until the CPU has
+ * caught up, unless it is more than THROTTLE_MAX_LAG_NS behind, in which
+ * case the lost time is dropped.
+ * 
+ * @param *thr The throttle to run with
+ * @param *cpu The CPU to run
+ * @param *mem The memory connected to the CPU
+ * @param *hist The instruction history to update
+ * @param *redraw Set to true if the screen is due to be redrawn (the end
+ *                of the slice is then run one instruction at a time so
+ *                that the instruction history is filled in)
+ * @return The reason the CPU stopped (CPU_RUN_BUDGET if it was not run)
+ */
+CPU_Run_Status_t throttle_run(throttle_t *thr, CPU_t *cpu, memory_t *mem, hist_t *hist, bool *redraw)
+{
+    struct timespec now, wake;
+    uint64_t start = cpu->cycles;
+    uint64_t budget = thr->clock_hz / THROTTLE_SLICES_PER_SEC;
+    uint64_t batch, ran, ns;
+    int64_t lag, elapsed;
+    CPU_Run_Status_t stat = CPU_RUN_BUDGET;
 
-        size = size / sizeof(*tmp);
+    *redraw = false;
 
-        // We need a temporary buffer since there
-        // is a wrapper needed to access the CPU's
-        // memory structure
-        tmp = malloc(sizeof(*tmp) * size);
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    lag = timespec_diff_ns(&now, &thr->deadline);
 
-        if (!tmp) {
-            fclose(fp);
-            return CMD_OUT_OF_MEM;
+    if (lag < 0) {
+        // Ahead of time, so sleep until the deadline (but not for
+        // so long that key presses go unhandled at low clock rates)
+        wake = now;
+        timespec_add_ns(&wake, THROTTLE_MAX_SLEEP_NS);
+        if (timespec_diff_ns(&wake, &thr->deadline) > 0) {
+            wake = thr->deadline;
         }
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wake, NULL);
 
-        if (fread(tmp, sizeof(*tmp), size, fp) != size) {
-            free(tmp);
-            fclose(fp);
-            return CMD_FILE_IO_ERROR;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        if (timespec_diff_ns(&now, &thr->deadline) < 0) {
+            return CPU_RUN_BUDGET; // Interrupted, or still not time yet
         }
-
-        // Copy data into the memory
-        _init_mem_arr(mem, tmp, base_addr, size);
     }
-        break;
-
-    case MF_LLVM_MOS_SIM: {
-        uint32_t next_byte_loc = 0;
-        uint32_t max_len = 0;
-        int tmp_value = 0;
-
-        while (true) {
-            int base_addr_low, base_addr_high, len_low, len_high;
-            uint32_t base_addr, len;
-            if ((base_addr_low = fgetc(fp)) == EOF) {
-                // Done with file
-                break;
-            }
-            if ((base_addr_high = fgetc(fp)) == EOF) {
-                fclose(fp);
-                return CMD_FILE_CORRUPT;
-            }
-            base_addr = (base_addr_high << 8) | base_addr_low;
-
-            if ((len_low = fgetc(fp)) == EOF) {
-                fclose(fp);
-                return CMD_FILE_CORRUPT;
-            }
-            if ((len_high = fgetc(fp)) == EOF) {
-                fclose(fp);
-                return CMD_FILE_CORRUPT;
-            }
-            len = ((len_high & 0xff) << 8) | (len_low & 0xff);
-
-            if (len == 0) {
-                continue;
-            }
-
-            printf("\nSection base: %x Section length: %x", base_addr, len);
-            
-            if (base_addr + len > 0x1000000) {
-                fclose(fp);
-                return CMD_FILE_WILL_WRAP;
-            }
-            
-            if (max_len < len) {
-                // Force memory buffer reallocation
-                if (tmp) {
-                    free(tmp);
-                    tmp = NULL;
-                }
-                max_len = len;
-            }
-
-            if (!tmp) {
-                tmp = malloc(sizeof(*tmp) * max_len);
-                if (!tmp) {
-                    fclose(fp);
-                    return CMD_OUT_OF_MEM;
-                }
-            }
+    else if (lag > THROTTLE_MAX_LAG_NS) {
+        // Too far behind to catch up
+        thr->deadline = now;
+        thr->deadline_rem = 0;
+    }
 
-            next_byte_loc = 0;
-            while (next_byte_loc < len) {
-                tmp_value = fgetc(fp);
-                if (tmp_value == EOF) {
-                    free(tmp);
-                    fclose(fp);
-                    return CMD_FILE_CORRUPT;
-                }
-                tmp[next_byte_loc] = tmp_value;
+    if (budget == 0) {
+        budget = 1;
+    }
 
-                next_byte_loc++;
-            }
+    batch = budget;
+    if (timespec_diff_ns(&now, &thr->next_redraw) >= 0) {
+        *redraw = true;
+        thr->next_redraw = now;
+        timespec_add_ns(&thr->next_redraw, THROTTLE_DISP_UPDATE_NS);
+        batch = (budget > THROTTLE_HIST_CYCLES) ? budget - THROTTLE_HIST_CYCLES : 0;
+    }
 
-            // Copy data into the memory
-            _init_mem_arr(mem, tmp, base_addr, len);
-        }
+    if (batch > 0) {
+        stat = runCPU(cpu, mem, batch, CPU_RUN_BREAK | CPU_RUN_WAI | CPU_RUN_BUDGET_CYCLES);
+        update_cpu_hist(hist, cpu, mem, PUSH_INST);
     }
-        break;
+    while (*redraw && stat == CPU_RUN_BUDGET && cpu->cycles >= start && cpu->cycles - start < budget) {
+        stat = runCPU(cpu, mem, 1, CPU_RUN_BREAK | CPU_RUN_WAI);
+        update_cpu_hist(hist, cpu, mem, PUSH_INST);
     }
 
-    fclose(fp);
+    // Move the deadline on by the time the cycles take at the clock rate
+    ran = (cpu->cycles >= start) ? cpu->cycles - start : 0;
+    ns = ran * 1000000000 + thr->deadline_rem;
+    timespec_add_ns(&thr->deadline, ns / thr->clock_hz);
+    thr->deadline_rem = ns % thr->clock_hz;
 
-    if (tmp) {
-        free(tmp);
+    // Measure the achieved clock rate
+    thr->rate_cycles += ran;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    elapsed = timespec_diff_ns(&now, &thr->rate_start);
+    if (elapsed >= THROTTLE_RATE_WINDOW_NS) {
+        thr->achieved_hz = (uint64_t) (thr->rate_cycles * 1e9 / elapsed + 0.5);
+        thr->rate_start = now;
+        thr->rate_cycles = 0;
     }
 
-    return CMD_OK;
+    return stat;
 }
 
 
 /**
- * Load a file's contents into the CPU state
+ * Check if a string is a clock rate and parse it if so. The rate may
+ * have a fractional part and be followed by hz, khz or mhz (the default
+ * is hz). "off" parses as 0.
  * 
- * @param *filename The path of the file to load
- * @param *cpu The CPU to save the file's contents into
- * @return The error status of the load operation
+ * @param *str The (lowercase) string to parse
+ * @param *hz A pointer to the variable to store the rate in Hz in (if it is
+ *            too large to run at, THROTTLE_MAX_HZ + 1 is stored instead)
+ * @return false if the string is not a clock rate (hz will not be modified if so)
+ *         true if the string is a clock rate and was successfully parsed
  */
-cmd_err_t load_file_cpu(char *filename, CPU_t *cpu)
+bool is_clock_rate_do_parse(char *str, uint64_t *hz)
 {
-    // Get the size of the file
-    struct stat finfo;
-
-    // Lots of error values!
-    if (stat(filename, &finfo) != 0) {
-        switch (errno) {
-        case EACCES:
-            return CMD_FILE_PERM_DENIED;
-            break;
-        case ELOOP:
-            return CMD_FILE_LOOP;
-            break;
-        case ENAMETOOLONG:
-            return CMD_FILE_NAME_TOO_LONG;
-            break;
-        case ENOTDIR:
-        case ENOENT:
-            return CMD_FILE_NOT_EXIST;
-            break;
-        default:
-            return CMD_FILE_UNKNOWN_ERROR;
-        }
-    }
-    
-    size_t size = finfo.st_size;
+    char *end;
+    double val;
 
-    if (size > 1024) { // Arbitrary max file size limit (should not need to be increased!)
-        return CMD_FILE_TOO_LARGE;
+    if (strcmp(str, "off") == 0) {
+        *hz = 0;
+        return true;
     }
-
-    FILE *fp = fopen(filename, "r");
-    if (!fp) {
-        return CMD_FILE_IO_ERROR;
+    if (!isdigit(*str) && *str != '.') {
+        return false; // No signs, "inf", etc.
     }
 
-    char buf[size];
-    if (fread(&buf, sizeof(*buf), size, fp) == 0) {
-        fclose(fp);
-        return CMD_FILE_IO_ERROR;
+    val = strtod(str, &end);
+    if (end == str) {
+        return false;
     }
-
-    if (fromstrCPU(cpu, (char*)&buf) != CPU_ERR_OK) {
-        return CMD_CPU_CORRUPT_FILE;
+    if (strcmp(end, "mhz") == 0) {
+        val *= 1e6;
+    }
+    else if (strcmp(end, "khz") == 0) {
+        val *= 1e3;
+    }
+    else if (*end != '\0' && strcmp(end, "hz") != 0) {
+        return false;
     }
-    fclose(fp);
-    return CMD_OK;
+
+    *hz = (val > THROTTLE_MAX_HZ) ? THROTTLE_MAX_HZ + 1 : (uint64_t) (val + 0.5);
+    return true;
 }
 
 
@@ -799,6 +684,7 @@ bool command_entry(cmd_t *cmd_data, int c)
  * @param *symbol_table The global symbol table
  * @param *uart 16C750 UART device
  * @param *invert_mouse_scroll Controls mouse wheel scroll direction
+ * @param *throttle The clock throttle for RUN mode
  * @return True if an error occured, false otherwise
  */
 cmd_status_t command_execute( cmd_err_t *status,
@@ -810,7 +696,8 @@ cmd_status_t command_execute( cmd_err_t *status,
                               memory_t *mem,
                               symbol_table_t *symbol_table,
                               tl16c750_t *uart,
-                              bool *invert_mouse_scroll
+                              bool *invert_mouse_scroll,
+                              throttle_t *throttle
     )
 {
     watch_t *watch;
@@ -1112,41 +999,8 @@ cmd_status_t command_execute( cmd_err_t *status,
             return STAT_ERR;
         }
 
-        int linenum = 0;
-        st_status_t st_stat = st_load_file(symbol_table, tok, &linenum);
-        switch (st_stat) {
-        case ST_OK:
-            *status = CMD_OK;
-            return STAT_OK;
-            
-        case ST_ERR_NO_MEM:
-            *status = CMD_OUT_OF_MEM;
-            return STAT_ERR;
-
-        case ST_ERR_MISSING_IDENT:
-            sprintf(global_err_msg_buf, "Symbol loader: missing identifier on line %d", linenum);
-            *status = CMD_SPECIAL;
-            return STAT_ERR;
-            
-        case ST_ERR_MISSING_DELIM:
-            sprintf(global_err_msg_buf, "Symbol loader: missing delimiter on line %d", linenum);
-            *status = CMD_SPECIAL;
-            return STAT_ERR;
-            
-        case ST_ERR_MISSING_VALUE:
-            sprintf(global_err_msg_buf, "Symbol loader: missing value on line %d", linenum);
-            *status = CMD_SPECIAL;
-            return STAT_ERR;
-            
-        case ST_ERR_UNEXPECTED_CHAR:
-            sprintf(global_err_msg_buf, "Symbol loader: unexpected char on line %d", linenum);
-            *status = CMD_SPECIAL;
-            return STAT_ERR;
-
-        case ST_ERR_NO_FILE:
-            *status = CMD_FILE_UNKNOWN_ERROR;
-            return STAT_ERR;
-        }
+        *status = load_file_sym(tok, symbol_table);
+        return (*status == CMD_OK) ? STAT_OK : STAT_ERR;
     }
     else if (strcmp(tok, "cpu") == 0) {
 
@@ -1192,6 +1046,50 @@ cmd_status_t command_execute( cmd_err_t *status,
             return STAT_ERR;
         }
 
+        // Check for the RUN mode clock rate
+        if (strcmp(tok, "clock") == 0) {
+
+            tok = strtok_r(NULL, " \t\n\r", &state);
+
+            if (!tok) {
+                *status = CMD_EXPECTED_ARG;
+                return STAT_ERR;
+            }
+
+            if (strcmp(tok, "status") != 0) {
+                uint64_t hz;
+
+                if (!is_clock_rate_do_parse(tok, &hz)) {
+                    *status = CMD_UNKNOWN_SYM_OR_VALUE;
+                    return STAT_ERR;
+                }
+                if (hz > THROTTLE_MAX_HZ) {
+                    *status = CMD_VAL_OVERFLOW;
+                    return STAT_ERR;
+                }
+                throttle->clock_hz = hz;
+                throttle->achieved_hz = 0;
+                throttle_start(throttle);
+            }
+
+            // Report the clock rate
+            if (throttle->clock_hz) {
+                char target[16];
+                format_clock_rate(target, sizeof(target), throttle->clock_hz);
+                sprintf(global_err_msg_buf, "RUN mode clock rate: %s", target);
+                if (throttle->achieved_hz) {
+                    char achieved[16];
+                    format_clock_rate(achieved, sizeof(achieved), throttle->achieved_hz);
+                    sprintf(global_err_msg_buf + strlen(global_err_msg_buf), " (achieved %s)", achieved);
+                }
+            }
+            else {
+                sprintf(global_err_msg_buf, "RUN mode clock rate: unthrottled");
+            }
+            *status = CMD_CPU_CLOCK_INFO;
+            return STAT_INFO;
+        }
+
         // Else, it's a register assignment
         
         char *addrtok = strtok_r(NULL, " \t\n\r", &state);
@@ -1284,7 +1182,7 @@ cmd_status_t command_execute( cmd_err_t *status,
                 *status = CMD_VAL_OVERFLOW;
                 return STAT_ERR;
             }
-            cpu->P.N = val;
+            _cpu_set_n(cpu, val);
         }
         else if (strcmp(tok, "p.v") == 0) {
             if (val > 0x1) {
@@ -1326,7 +1224,7 @@ cmd_status_t command_execute( cmd_err_t *status,
                 *status = CMD_VAL_OVERFLOW;
                 return STAT_ERR;
             }
-            cpu->P.Z = val;
+            _cpu_set_z(cpu, val);
         }
         else if (strcmp(tok, "p.c") == 0) {
             if (val > 0x1) {
@@ -1463,6 +1361,11 @@ cmd_status_t command_execute( cmd_err_t *status,
 
         if (strcmp(tok, "c750") == 0) {
 
+            // Free up the old register addresses
+            if (uart->enabled) {
+                unmap_16c750(uart, mem);
+            }
+
             uart->addr = addr;
 
             int err;
@@ -1481,6 +1384,15 @@ cmd_status_t command_execute( cmd_err_t *status,
                 *status = CMD_UART_DISABLED;
                 return STAT_INFO;
             }
+
+            if (!map_16c750(uart, mem)) {
+                sprintf(global_err_msg_buf, "Address in use by another device ($%06x)", addr);
+                stop_16c750(uart);
+                uart->enabled = false;
+
+                *status = CMD_SPECIAL;
+                return STAT_ERR;
+            }
             
             uart->enabled = true;
             
@@ -1664,7 +1576,7 @@ void mem_watch_print(watch_t *w, memory_t *mem, CPU_t *cpu, symbol_table_t *symb
             if (bpl > 8) {
                 wmove(w->win, row, 28);
                 while (effective_pc < i) {
-                    wprintw(w->win, " %02x", _get_mem_byte(mem, effective_pc, false));
+                    wprintw(w->win, " %02x", _peek_mem_byte(mem, effective_pc));
 
                     cpu_dup.PC = _addr_add_val_bank_wrap(cpu_dup.PC, 1);
                     effective_pc = _cpu_get_effective_pc(&cpu_dup);
@@ -1707,7 +1619,7 @@ void mem_watch_print(watch_t *w, memory_t *mem, CPU_t *cpu, symbol_table_t *symb
                 if (i == pc) {
                     wattron(w->win, A_BOLD | A_UNDERLINE);
                 }
-                wprintw(w->win, "%02x", _get_mem_byte(mem, i, false));
+                wprintw(w->win, "%02x", _peek_mem_byte(mem, i));
                 if (i == pc) {
                     wattroff(w->win, A_BOLD | A_UNDERLINE);
                 }
@@ -1920,7 +1832,7 @@ void hist_init(hist_t *h)
     h->entry_count = 0;
     h->entry_start = 0;
     memset(&(h->cpu), 0, sizeof(h->cpu));
-    memset(&(h->mem), 0, sizeof(h->mem));
+    memset(&(h->ins), 0, sizeof(h->ins));
 }
 
 
@@ -2005,6 +1917,29 @@ void handle_break(int signal)
 }
 
 
+/**
+ * Sleep until there is a key press or UART network traffic. This is
+ * used while the CPU sits in a WAI with no interrupt pending, since
+ * nothing else can wake it up.
+ * 
+ * @note Signals (terminal resize, ^C) also end the wait
+ * @param *uart The UART to wait on as well (ignored if it is not enabled)
+ */
+void wait_for_input(tl16c750_t *uart)
+{
+    struct pollfd fds[2];
+    nfds_t count = 1;
+
+    fds[0].fd = STDIN_FILENO;
+    fds[0].events = POLLIN;
+    if (uart->enabled && (fds[1].fd = get_poll_fd_16c750(uart)) >= 0) {
+        fds[1].events = POLLIN;
+        count = 2;
+    }
+    poll(fds, count, -1); // Any error (EINTR) just ends the wait
+}
+
+
 int main(int argc, char *argv[])
 {
     int c, prev_c;          // User key press (c = current, prev_c = previous)
@@ -2014,11 +1949,13 @@ int main(int argc, char *argv[])
     bool cmd_exit = false;
     bool in_run_mode = false;
     int run_mode_step_count = 0;
+    CPU_Run_Status_t run_stat = CPU_RUN_BUDGET;
     WINDOW *win_cpu = NULL, *win_msg = NULL;
 #ifdef NCURSES_MOUSE_VERSION
     MEVENT mouse_event;
 #endif /* NCURSES_MOUSE_VERSION */
     bool invert_mouse_scroll = false; // Not in the #ifdef since it is used in command_execute
+    throttle_t throttle = { .clock_hz = 0 }; // Unthrottled until "cpu clock" is used
     cmd_t cmd_data;
     cmd_hist_init(&cmd_data);
     char cmdbuf_dup[CMD_BUF_LEN];
@@ -2048,14 +1985,22 @@ int main(int argc, char *argv[])
     tl16c750_t uart;
     init_16c750(&uart);
     uart.enabled = false;
+    uart.cpu = &cpu;
 
-    memory_t *memory = calloc(MEMORY_SIZE, sizeof(*memory));
+    memory_t *memory = _alloc_mem();
 
     if (!memory) {
         printf("Unable to allocate system memory!\n");
         exit(EXIT_FAILURE);
     }
 
+    // Decoded block cache (only used by the table-driven dispatcher,
+    // the simulator runs fine without it)
+    CPU_Decode_Cache_t *dcache = malloc(sizeof(*dcache));
+    if (dcache) {
+        setDecodeCacheCPU(&cpu, dcache);
+    }
+
     printf("Loading simulator...\n");
 
     // See if there's a history file available.
@@ -2144,7 +2089,8 @@ int main(int argc, char *argv[])
                     memory,
                     symbol_table,
                     &uart,
-                    &invert_mouse_scroll
+                    &invert_mouse_scroll,
+                    &throttle
                     );
 
                 if (cmd_stat != STAT_OK) {
@@ -2188,7 +2134,8 @@ int main(int argc, char *argv[])
                         memory,
                         symbol_table,
                         &uart,
-                        &invert_mouse_scroll
+                        &invert_mouse_scroll,
+                        &throttle
                         );
 
                     if (cmd_stat != STAT_OK) {
@@ -2330,6 +2277,7 @@ int main(int argc, char *argv[])
         case KEY_F(5): // Run (until BRK)
             in_run_mode = true;
             run_mode_step_count = 0;
+            throttle_start(&throttle);
             timeout(0); // Disable waiting for keypresses
             status_id = STATUS_RUN;
             break;
@@ -2466,7 +2414,8 @@ int main(int argc, char *argv[])
                     memory,
                     symbol_table,
                     &uart,
-                    &invert_mouse_scroll
+                    &invert_mouse_scroll,
+                    &throttle
                     );
 
                 if (cmd_err == CMD_EXIT) {
@@ -2491,7 +2440,7 @@ int main(int argc, char *argv[])
 
                     // For custom "special" error messages, we have to
                     // figure out the length
-                    if (cmd_err == CMD_SPECIAL) {
+                    if (cmd_err == CMD_SPECIAL || cmd_err == CMD_CPU_CLOCK_INFO) {
                         win_w = strlen(msg->msg) + 4; // 2 chars of passing on each side
                     }
 
@@ -2504,12 +2453,32 @@ int main(int argc, char *argv[])
         }
 
         // RUN mode
-        if (in_run_mode) {
-            stepCPU(&cpu, memory);
+        if (in_run_mode && throttle.clock_hz) {
+            // With a throttled clock, the CPU runs in cycle budgeted
+            // slices paced to the wall clock and the screen is redrawn
+            // at a fixed rate instead of after a number of instructions
+            bool redraw;
+            run_stat = throttle_run(&throttle, &cpu, memory, &inst_hist, &redraw);
+            run_mode_step_count = (redraw || run_stat == CPU_RUN_WAI) ? 0 : 1;
+        }
+        else if (in_run_mode) {
+            // Most of the instructions between display updates can be run
+            // in one batch (the UART sees register accesses as they happen
+            // and polls for network traffic from a CPU event). The last few
+            // are still run one at a time so that the instruction history
+            // is filled in when the screen is redrawn.
+            int run_mode_batch = 1;
+            if (run_mode_step_count < RUN_MODE_STEPS_UNTIL_DISP_UPDATE - CPU_HIST_ENTRIES) {
+                run_mode_batch = RUN_MODE_STEPS_UNTIL_DISP_UPDATE - CPU_HIST_ENTRIES - run_mode_step_count;
+            }
+
+            run_stat = runCPU(&cpu, memory, run_mode_batch, CPU_RUN_BREAK | CPU_RUN_WAI);
             update_cpu_hist(&inst_hist, &cpu, memory, PUSH_INST);
 
-            ++run_mode_step_count;
-            if (run_mode_step_count == RUN_MODE_STEPS_UNTIL_DISP_UPDATE) {
+            // Also redraw the screen when the CPU starts waiting,
+            // since it will not change until the CPU wakes up
+            run_mode_step_count += run_mode_batch;
+            if (run_mode_step_count >= RUN_MODE_STEPS_UNTIL_DISP_UPDATE || run_stat == CPU_RUN_WAI) {
                 run_mode_step_count = 0;
             }
         }
@@ -2520,13 +2489,11 @@ int main(int argc, char *argv[])
             timeout(-1); // Back to waiting for key handling
         }
 
-        // Handle UART updating & control
-        if (uart.enabled) {
-            if (step_16c750(&uart, memory)) {
-                cpu.P.IRQ = 1;
-            } else {
-                cpu.P.IRQ = 0;
-            }
+        // Poll the UART's connection (this also updates the CPU's IRQ input).
+        // While the CPU runs the UART polls itself every UART_POLL_CYCLES,
+        // which does not happen while the CPU is halted or waiting in a WAI
+        if (uart.enabled && (!in_run_mode || run_stat == CPU_RUN_WAI)) {
+            step_16c750(&uart);
         }
 
         // Handle exiting
@@ -2557,7 +2524,7 @@ int main(int argc, char *argv[])
         // getmaxyx(stdscr, scrh, scrw); // Get screen dimensions
         if (!in_run_mode || (run_mode_step_count == 0)) {
 
-            print_header(scrw, status_id, alert);
+            print_header(scrw, status_id, alert, &throttle);
             print_cpu_regs(win_cpu, &cpu, 1, 2);
             mem_watch_print(&watch1, memory, &cpu, symbol_table);
             mem_watch_print(&watch2, memory, &cpu, symbol_table);
@@ -2620,6 +2587,15 @@ int main(int argc, char *argv[])
             break_hit = false;
         }
         else if (!cmd_exit) {
+            // Instead of spinning on a waiting CPU, sleep until
+            // something comes in which could interrupt it (only once
+            // curses has no more keys buffered, see getch() == ERR)
+            if (in_run_mode && c == ERR && run_stat == CPU_RUN_WAI && !cpu.P.IRQ && !cpu.P.NMI) {
+                wait_for_input(&uart);
+                if (throttle.clock_hz) {
+                    throttle_resync(&throttle);
+                }
+            }
             c = getch();
         }
     }
@@ -2631,7 +2607,8 @@ int main(int argc, char *argv[])
     delwin(inst_hist.win);
     endwin();           // Clean up curses mode
 
-    free(memory);
+    _free_mem(memory);
+    free(dcache);
 
     if (uart.enabled) {
         stop_16c750(&uart);
@@ -7,8 +7,7 @@
 #define _DEBUGGER_H
 
 #include <ncurses.h> // WINDOW
-
-#define MEMORY_SIZE 0x1000000 // 16MiB
+#include <time.h> // struct timespec
 
 #define UART_SOCK_PORT 6501
 
@@ -34,6 +33,15 @@
 
 #define RUN_MODE_STEPS_UNTIL_DISP_UPDATE 9463 // A big number
 
+// RUN mode with a throttled clock rate (cpu clock command)
+#define THROTTLE_MAX_HZ 1000000000ULL       // Highest clock rate which can be set
+#define THROTTLE_SLICES_PER_SEC 1000        // Number of cycle budgeted slices run per second
+#define THROTTLE_HIST_CYCLES (CPU_HIST_ENTRIES * 4) // About enough cycles to fill the instruction history
+#define THROTTLE_MAX_SLEEP_NS 10000000      // Longest sleep between slices, so keys are still handled at low clock rates
+#define THROTTLE_MAX_LAG_NS 100000000       // Time the CPU may fall behind before the lost time is dropped
+#define THROTTLE_RATE_WINDOW_NS 500000000   // Time over which the achieved clock rate is measured
+#define THROTTLE_DISP_UPDATE_NS 50000000    // Time between screen updates
+
 #define REPLACE_INST true
 #define PUSH_INST false
 
@@ -46,11 +54,6 @@ typedef enum scroll_dir_t {
     SCROLL_UP
 } scroll_dir_t;
 
-typedef enum memory_fmt_t {
-    MF_BASIC_BIN_BLOCK,
-    MF_LLVM_MOS_SIM
-} memory_fmt_t;
-
 // Keep in sync with status_msgs
 typedef enum status_t {
     STATUS_NONE,
@@ -84,9 +87,20 @@ typedef struct hist_t {
     size_t entry_count;
     size_t entry_start;
     CPU_t cpu[CPU_HIST_ENTRIES];
-    memory_t mem[CPU_HIST_ENTRIES][4];
+    uint8_t ins[CPU_HIST_ENTRIES][4]; // Instruction bytes (opcode + operand)
 } hist_t;
 
+// Throttled clock state for RUN mode
+typedef struct throttle_t {
+    uint64_t clock_hz;           // Target clock rate (0 = run as fast as possible)
+    struct timespec deadline;    // Wall-clock time at which the cycles run so far are due
+    uint64_t deadline_rem;       // Remainder of (cycles * 1e9) / clock_hz not yet added to the deadline
+    struct timespec rate_start;  // Start of the current achieved rate measurement
+    uint64_t rate_cycles;        // Cycles run since rate_start
+    uint64_t achieved_hz;        // Clock rate achieved over the last measurement (0 = none yet)
+    struct timespec next_redraw; // Wall-clock time of the next screen update
+} throttle_t;
+
 // Command entry structure
 typedef struct cmd_t {
     WINDOW *win;
@@ -96,49 +110,6 @@ typedef struct cmd_t {
     histr_stack_t *stack;
 } cmd_t;
 
-// Command input error codes
-// Keep in sync with the cmd_err_msgs[] array in debugger.c
-typedef enum cmd_err_t {
-    CMD_EXIT = -1,
-    CMD_OK = 0, // Start of cmd_err_msgs index
-    CMD_SPECIAL,
-    CMD_EXPECTED_ARG,
-    CMD_EXPECTED_REG,
-    CMD_EXPECTED_VALUE,
-    CMD_UNKNOWN_SYM_OR_VALUE,
-    CMD_UNKNOWN_ARG,
-    CMD_UNKNOWN_CMD,
-    CMD_HELP_MAIN,
-    CMD_HELP_NOT,
-    CMD_INVALID_CHAR,
-    CMD_VAL_OVERFLOW,
-    CMD_EXPECTED_FILENAME,
-    CMD_FILE_IO_ERROR,
-    CMD_FILE_TOO_LARGE,
-    CMD_FILE_WILL_WRAP,
-    CMD_FILE_PERM_DENIED,
-    CMD_FILE_LOOP,
-    CMD_FILE_NAME_TOO_LONG,
-    CMD_FILE_NOT_EXIST,
-    CMD_FILE_UNKNOWN_ERROR,
-    CMD_FILE_CORRUPT,
-    CMD_CPU_CORRUPT_FILE,
-    CMD_CPU_OPTION_COP_VEC_ENABLED,
-    CMD_CPU_OPTION_COP_VEC_DISABLED,
-    CMD_OUT_OF_MEM,
-    CMD_UNSUPPORTED_DEVICE,
-    CMD_PORT_NUM_INVALID,
-    CMD_UART_DISABLED
-} cmd_err_t;
-
-// Error message box type
-typedef struct cmd_err_msg {
-    char *title;
-    int win_h;
-    int win_w;
-    char *msg;
-} cmd_err_msg;
-
 // Status values which represent that state of
 // command parsing
 typedef enum cmd_status_t {
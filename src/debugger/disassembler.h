@@ -127,6 +127,7 @@ extern opcode_t opcode_table[256];
 
 int get_opcode(memory_t *, CPU_t *, char *);
 int get_opcode_by_addr(memory_t *, CPU_t *, char *, uint32_t);
+int get_opcode_from_bytes(const uint8_t *, CPU_t *, char *);
 
 #endif
 
@@ -0,0 +1,364 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+// For sys/stat operations
+#define _FILE_OFFSET_BITS 64
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <ctype.h>
+#include <errno.h>
+
+#include <sys/stat.h> // For getting file sizes
+
+#include "../cpu/65816-util.h"
+#include "loader.h"
+
+
+/**
+ * Check if a string is a decimal string and parse it if so
+ * 
+ * @param *str The string to parse
+ * @param *val A pointer to the variable to store the parsed value in
+ * @return false if the string is not decimal (val will not be modified if so)
+ *         true if the string is decimal and was successfully parsed
+ */
+bool is_dec_do_parse(char *str, uint32_t *val)
+{
+    // Determine if this is actually a hex address
+    char *tmp = str;
+    while (isdigit(*tmp)) {
+        /* scan */
+        ++tmp;
+    }
+
+    // If the entire argument is hex, use it as an address
+    if (*tmp == '\0' || *tmp == '\n') {
+        *val = strtoul(str, NULL, 10);
+        return true;
+    }
+    return false;
+}
+
+
+/**
+ * Check if a string is a hex string and parse it if so
+ * 
+ * @param *str The string to parse
+ * @param *val A pointer to the variable to store the parsed value in
+ * @return false if the string is not hex (val will not be modified if so)
+ *         true if the string is hex and was successfully parsed
+ */
+bool is_hex_do_parse(char *str, uint32_t *val)
+{
+    // Determine if this is actually a hex address
+    char *tmp = str;
+    while (isxdigit(*tmp)) {
+        /* scan */
+        ++tmp;
+    }
+
+    // If the entire argument is hex, use it as an address
+    if (*tmp == '\0' || *tmp == '\n') {
+        *val = strtoul(str, NULL, 16);
+        return true;
+    }
+    return false;
+}
+
+
+/**
+ * Parse a string and return its corresponding numeric value
+ * 
+ * @param *str The string to parse
+ * @param *val A pointer to the variable to store the parsed value in
+ * @return false if the string is not a valid address (val will not be modified if so)
+ *         true if the string is a valid address and was successfully parsed
+ */
+bool is_addr_do_parse(char *str, uint32_t *val, symbol_table_t *st)
+{
+    symbol_t *st_sym;
+
+    if ((st_sym = st_resolve_by_ident(st, str))) {
+        *val = st_sym->addr;
+    }
+    else if (!is_hex_do_parse(str, val)) {
+        return false;
+    }
+    return true;
+}
+
+
+/**
+ * Load a file into memory
+ * 
+ * @param *filename The path of the file to load
+ * @param *mem The memory to store the data into
+ * @param base_addr The base address to load the file at
+ * @param memory_format Sets the formatting of the data file to read
+ * @return A status code indicating errors if any occur
+ */
+cmd_err_t load_file_mem(char *filename, memory_t *mem, uint32_t base_addr, memory_fmt_t memory_format)
+{
+    // Get the size of the file
+    struct stat finfo;
+
+    // Lots of error values!
+    if (stat(filename, &finfo) != 0) {
+        switch (errno) {
+        case EACCES:
+            return CMD_FILE_PERM_DENIED;
+            break;
+        case ELOOP:
+            return CMD_FILE_LOOP;
+            break;
+        case ENAMETOOLONG:
+            return CMD_FILE_NAME_TOO_LONG;
+            break;
+        case ENOTDIR:
+        case ENOENT:
+            return CMD_FILE_NOT_EXIST;
+            break;
+        default:
+            return CMD_FILE_UNKNOWN_ERROR;
+        }
+    }
+
+    size_t size = finfo.st_size;
+
+    // All good, let's open the file
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) {
+        return CMD_FILE_IO_ERROR;
+    }
+
+    uint8_t *tmp = NULL;
+    
+    switch (memory_format) {
+    default:
+    case MF_BASIC_BIN_BLOCK: {
+        // Check file size
+        if (size > MEMORY_SIZE) {
+            return CMD_FILE_TOO_LARGE;
+        }
+
+        // Make sure the file won't wrap
+        if (size + base_addr > MEMORY_SIZE) {
+            return CMD_FILE_WILL_WRAP;
+        }
+
+        size = size / sizeof(*tmp);
+
+        // We need a temporary buffer since there
+        // is a wrapper needed to access the CPU's
+        // memory structure
+        tmp = malloc(sizeof(*tmp) * size);
+
+        if (!tmp) {
+            fclose(fp);
+            return CMD_OUT_OF_MEM;
+        }
+
+        if (fread(tmp, sizeof(*tmp), size, fp) != size) {
+            free(tmp);
+            fclose(fp);
+            return CMD_FILE_IO_ERROR;
+        }
+
+        // Copy data into the memory (an image is
+        // the RAM its program runs in, so it will
+        // be used densely)
+        _advise_mem_dense(mem, base_addr, size);
+        _init_mem_arr(mem, tmp, base_addr, size);
+    }
+        break;
+
+    case MF_LLVM_MOS_SIM: {
+        uint32_t next_byte_loc = 0;
+        uint32_t max_len = 0;
+        int tmp_value = 0;
+
+        while (true) {
+            int base_addr_low, base_addr_high, len_low, len_high;
+            uint32_t base_addr, len;
+            if ((base_addr_low = fgetc(fp)) == EOF) {
+                // Done with file
+                break;
+            }
+            if ((base_addr_high = fgetc(fp)) == EOF) {
+                fclose(fp);
+                return CMD_FILE_CORRUPT;
+            }
+            base_addr = (base_addr_high << 8) | base_addr_low;
+
+            if ((len_low = fgetc(fp)) == EOF) {
+                fclose(fp);
+                return CMD_FILE_CORRUPT;
+            }
+            if ((len_high = fgetc(fp)) == EOF) {
+                fclose(fp);
+                return CMD_FILE_CORRUPT;
+            }
+            len = ((len_high & 0xff) << 8) | (len_low & 0xff);
+
+            if (len == 0) {
+                continue;
+            }
+
+            printf("\nSection base: %x Section length: %x", base_addr, len);
+            
+            if (base_addr + len > 0x1000000) {
+                fclose(fp);
+                return CMD_FILE_WILL_WRAP;
+            }
+            
+            if (max_len < len) {
+                // Force memory buffer reallocation
+                if (tmp) {
+                    free(tmp);
+                    tmp = NULL;
+                }
+                max_len = len;
+            }
+
+            if (!tmp) {
+                tmp = malloc(sizeof(*tmp) * max_len);
+                if (!tmp) {
+                    fclose(fp);
+                    return CMD_OUT_OF_MEM;
+                }
+            }
+
+            next_byte_loc = 0;
+            while (next_byte_loc < len) {
+                tmp_value = fgetc(fp);
+                if (tmp_value == EOF) {
+                    free(tmp);
+                    fclose(fp);
+                    return CMD_FILE_CORRUPT;
+                }
+                tmp[next_byte_loc] = tmp_value;
+
+                next_byte_loc++;
+            }
+
+            // Copy data into the memory
+            _init_mem_arr(mem, tmp, base_addr, len);
+        }
+    }
+        break;
+    }
+
+    fclose(fp);
+
+    if (tmp) {
+        free(tmp);
+    }
+
+    return CMD_OK;
+}
+
+
+/**
+ * Load a file's contents into the CPU state
+ * 
+ * @param *filename The path of the file to load
+ * @param *cpu The CPU to save the file's contents into
+ * @return The error status of the load operation
+ */
+cmd_err_t load_file_cpu(char *filename, CPU_t *cpu)
+{
+    // Get the size of the file
+    struct stat finfo;
+
+    // Lots of error values!
+    if (stat(filename, &finfo) != 0) {
+        switch (errno) {
+        case EACCES:
+            return CMD_FILE_PERM_DENIED;
+            break;
+        case ELOOP:
+            return CMD_FILE_LOOP;
+            break;
+        case ENAMETOOLONG:
+            return CMD_FILE_NAME_TOO_LONG;
+            break;
+        case ENOTDIR:
+        case ENOENT:
+            return CMD_FILE_NOT_EXIST;
+            break;
+        default:
+            return CMD_FILE_UNKNOWN_ERROR;
+        }
+    }
+    
+    size_t size = finfo.st_size;
+
+    if (size > 1024) { // Arbitrary max file size limit (should not need to be increased!)
+        return CMD_FILE_TOO_LARGE;
+    }
+
+    FILE *fp = fopen(filename, "r");
+    if (!fp) {
+        return CMD_FILE_IO_ERROR;
+    }
+
+    char buf[size];
+    if (fread(&buf, sizeof(*buf), size, fp) == 0) {
+        fclose(fp);
+        return CMD_FILE_IO_ERROR;
+    }
+
+    if (fromstrCPU(cpu, (char*)&buf) != CPU_ERR_OK) {
+        return CMD_CPU_CORRUPT_FILE;
+    }
+    fclose(fp);
+    return CMD_OK;
+}
+
+
+/**
+ * Load a symbol file into a symbol table
+ * 
+ * @param *filename The path of the file to load
+ * @param *symbol_table The symbol table to add the symbols to
+ * @return The error status of the load operation (CMD_SPECIAL
+ *         with the message in global_err_msg_buf for syntax errors)
+ */
+cmd_err_t load_file_sym(char *filename, symbol_table_t *symbol_table)
+{
+    int linenum = 0;
+
+    switch (st_load_file(symbol_table, filename, &linenum)) {
+    case ST_OK:
+        return CMD_OK;
+
+    case ST_ERR_NO_MEM:
+        return CMD_OUT_OF_MEM;
+
+    case ST_ERR_MISSING_IDENT:
+        sprintf(global_err_msg_buf, "Symbol loader: missing identifier on line %d", linenum);
+        return CMD_SPECIAL;
+
+    case ST_ERR_MISSING_DELIM:
+        sprintf(global_err_msg_buf, "Symbol loader: missing delimiter on line %d", linenum);
+        return CMD_SPECIAL;
+
+    case ST_ERR_MISSING_VALUE:
+        sprintf(global_err_msg_buf, "Symbol loader: missing value on line %d", linenum);
+        return CMD_SPECIAL;
+
+    case ST_ERR_UNEXPECTED_CHAR:
+        sprintf(global_err_msg_buf, "Symbol loader: unexpected char on line %d", linenum);
+        return CMD_SPECIAL;
+
+    case ST_ERR_NO_FILE:
+    default:
+        return CMD_FILE_UNKNOWN_ERROR;
+    }
+}
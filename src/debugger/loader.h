@@ -0,0 +1,28 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+#ifndef _LOADER_H
+#define _LOADER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "../cpu/65816.h"
+#include "symbols.h"
+#include "messages.h"
+
+typedef enum memory_fmt_t {
+    MF_BASIC_BIN_BLOCK,
+    MF_LLVM_MOS_SIM
+} memory_fmt_t;
+
+bool is_dec_do_parse(char *, uint32_t *);
+bool is_hex_do_parse(char *, uint32_t *);
+bool is_addr_do_parse(char *, uint32_t *, symbol_table_t *);
+cmd_err_t load_file_mem(char *, memory_t *, uint32_t, memory_fmt_t);
+cmd_err_t load_file_cpu(char *, CPU_t *);
+cmd_err_t load_file_sym(char *, symbol_table_t *);
+
+#endif
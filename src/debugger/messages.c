@@ -0,0 +1,66 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+#include "messages.h"
+
+
+// Global error message buffer. Used in conjunction
+// with the cmd_err_msgs return values.
+// To signal use of this buffer, return
+// cmd_err_t = CMD_SPECIAL
+char global_err_msg_buf[1024];
+
+// Error messages for command parsing/execution
+// Keep in sync with the cmd_err_t enum in messages.h
+cmd_err_msg cmd_err_msgs[] = {
+    {"",0,0,""}, // OK
+    {"ERROR!", 3, 4, global_err_msg_buf},
+    {"ERROR!", 3, 34, "Expected argument for command."},
+    {"ERROR!", 3, 27, "Expected register name."},
+    {"ERROR!", 3, 19, "Expected value."},
+    {"ERROR!", 3, 36, "Unknown symbol or invalid value."},
+    {"ERROR!", 3, 21, "Unknown argument."},
+    {"ERROR!", 3, 20, "Unknown command."},
+    {"HELP", 21, 45, "Available commands\n"
+     " > exit|quit ... Close simulator\n"
+     " > mw[1|2] [mem|asm|pc|addr|aaaaaa] [...]\n"
+     " > irq [set|clear]\n"
+     " > nmi [set|clear]\n"
+     " > aaaaaa: xx yy zz\n"
+     " > save [mem|cpu] filename\n"
+     " > load mem (mos) (offset) filename\n"
+     " > load cpu filename\n"
+     " > sym filename\n"
+     " > cpu [reg] xxxx\n"
+     " > cpu [option] [enable|disable|status]\n"
+     " > cpu clock [rate(hz|khz|mhz)|off|status]\n"
+     " > bp aaaaaa\n"
+     " > uart [type] aaaaaa (pppp)\n"
+     " > mouse scroll [default|reverse]\n"
+     " ? ... Help Menu\n"
+     " ^G to clear command input\n"
+     " ^P|^N to scroll through history"},
+    {"HELP?", 3, 13, "Not help."},
+    {"ERROR!", 3, 34, "Unknown character encountered."},
+    {"ERROR!", 3, 30, "Overflow in numeric value."},
+    {"ERROR!", 3, 22, "Expected filename."},
+    {"ERROR!", 3, 24, "Unable to open file."},
+    {"ERROR!", 3, 20, "File too large."},
+    {"ERROR!", 3, 41, "File will wrap due to offset address."},
+    {"ERROR!", 3, 27, "File permission denied."},
+    {"ERROR!", 3, 29, "Too many symbolic links."},
+    {"ERROR!", 3, 22, "Filename too long."},
+    {"ERROR!", 3, 24, "File does not exist."},
+    {"ERROR!", 3, 33, "Unhandled file-related error."},
+    {"ERROR!", 3, 19, "Corrupt file."},
+    {"ERROR!", 4, 40, "Corrupt data format during CPU load.\nCPU may be in an unexpected state."},
+    {"INFO",   3, 39, "CPU option cop_vect_enable ENABLED."},
+    {"INFO",   3, 40, "CPU option cop_vect_enable DISABLED."},
+    {"ERROR!", 3, 44, "Unable to allocate memory for operation."},
+    {"ERROR!", 3, 23, "Unsupported device."},
+    {"ERROR!", 3, 24, "Invalid port number."},
+    {"INFO",   3, 18, "UART disabled."},
+    {"INFO",   3, 4, global_err_msg_buf}
+};
@@ -0,0 +1,56 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+#ifndef _MESSAGES_H
+#define _MESSAGES_H
+
+// Command input error codes
+// Keep in sync with the cmd_err_msgs[] array in messages.c
+typedef enum cmd_err_t {
+    CMD_EXIT = -1,
+    CMD_OK = 0, // Start of cmd_err_msgs index
+    CMD_SPECIAL,
+    CMD_EXPECTED_ARG,
+    CMD_EXPECTED_REG,
+    CMD_EXPECTED_VALUE,
+    CMD_UNKNOWN_SYM_OR_VALUE,
+    CMD_UNKNOWN_ARG,
+    CMD_UNKNOWN_CMD,
+    CMD_HELP_MAIN,
+    CMD_HELP_NOT,
+    CMD_INVALID_CHAR,
+    CMD_VAL_OVERFLOW,
+    CMD_EXPECTED_FILENAME,
+    CMD_FILE_IO_ERROR,
+    CMD_FILE_TOO_LARGE,
+    CMD_FILE_WILL_WRAP,
+    CMD_FILE_PERM_DENIED,
+    CMD_FILE_LOOP,
+    CMD_FILE_NAME_TOO_LONG,
+    CMD_FILE_NOT_EXIST,
+    CMD_FILE_UNKNOWN_ERROR,
+    CMD_FILE_CORRUPT,
+    CMD_CPU_CORRUPT_FILE,
+    CMD_CPU_OPTION_COP_VEC_ENABLED,
+    CMD_CPU_OPTION_COP_VEC_DISABLED,
+    CMD_OUT_OF_MEM,
+    CMD_UNSUPPORTED_DEVICE,
+    CMD_PORT_NUM_INVALID,
+    CMD_UART_DISABLED,
+    CMD_CPU_CLOCK_INFO
+} cmd_err_t;
+
+// Error message box type
+typedef struct cmd_err_msg {
+    char *title;
+    int win_h;
+    int win_w;
+    char *msg;
+} cmd_err_msg;
+
+extern char global_err_msg_buf[1024];
+extern cmd_err_msg cmd_err_msgs[];
+
+#endif
@@ -25,7 +25,7 @@
 #include <math.h>
 
 #include "../cpu/65816.h" // memory_t
-#include "../cpu/65816-util.h" // memory_t access functions
+#include "../cpu/65816-util.h" // memory mapping functions
 #include "16C750.h"
 
 // Defined in datasheet
@@ -139,6 +139,7 @@ void init_16c750(tl16c750_t *uart)
     uart->sock_fd = -1;
     uart->sock_timeout = 1000; // in ms
     uart->data_socket = -1;
+    uart->cpu = NULL;
 }
 
 
@@ -239,160 +240,15 @@ void stop_16c750(tl16c750_t *uart)
 
 
 /**
- * Cycle the UART to update its memory locations.
- * @note This makes the assumption that a max of one memory location
- *       will be modified between calls to this function
+ * Recompute the UART's status registers (LSR, IIR and MSR) and drive
+ * the IRQ output of the UART into the connected CPU (if any)
  * 
  * @param *uart The UART to update
- * @param *mem The memory that the UART is shadowing
  * @return True if an interrupt is active, false if no interrupts are active.
  */
-bool step_16c750(tl16c750_t *uart, memory_t *mem)
+static bool update_16c750(tl16c750_t *uart)
 {
     bool irq = false;
-    bool sock_closed = false;
-
-    // Attempt to accept an incomming connection if one is
-    // not already established
-    if (uart->data_socket < 0) {
-        uart->data_socket = accept(uart->sock_fd, NULL, NULL);
-
-        // If the accept was successfult, attempt to set the socket
-        // into a nonblocking mode
-        if (uart->data_socket >= 0) {
-            // endwin(); fprintf(stdout, "Accepted\n"); refresh(); // THIS LINE DEBUG
-            int flags = fcntl(uart->data_socket, F_GETFL, 0);
-            if (flags != -1) {
-                fcntl(uart->data_socket, F_SETFL, flags | O_NONBLOCK);
-            }
-        }
-    }
-    
-    // Check the socket for characters
-    // But be sure to not overflow the RX buffer
-    if (uart->data_socket >= 0 && !circ_buf_is_full(&(uart->rx_buf))) {
-        char buf;
-        int read_len = read(uart->data_socket, &buf, 1);
-
-        if (read_len > 0) {
-            circ_buf_push(&(uart->rx_buf), buf);
-        }
-        else if (read_len == -1 && errno != EAGAIN && errno != EWOULDBLOCK) { // Error
-            sock_closed = true;
-        }
-    }
-        
-    // SCR is scratch reg, ignore its contents
-
-    // Keep a local copy of the IER
-    uart->regs[TL_IER] = _get_mem_byte(mem, uart->addr + TLA_IER, false);
-
-    // LCR
-    uart->regs[TL_LCR] = _get_mem_byte(mem, uart->addr + TLA_LCR, false);
-
-    // MCR
-    uart->regs[TL_MCR] = _get_mem_byte(mem, uart->addr + TLA_MCR, false);
-
-    // Disable TX empty flag if the CPU read the IIR
-    // (can be enabled if TX is written to this cycle)
-    if (_test_and_reset_mem_flags(mem, uart->addr + TLA_IIR, MEM_FLAG_R).R == 1) {
-        uart->tx_empty_edge = false;
-    }
-    
-    // Handle writing to divisor latches
-    if (uart->regs[TL_LCR] & (1u << LCR_DLAB)) {
-        if (_test_and_reset_mem_flags(mem, uart->addr + TLA_DLL, MEM_FLAG_W).W == 1) {
-            uart->regs[TL_DLL] = _get_mem_byte(mem, uart->addr + TLA_DLL, false);
-        } else {
-            _set_mem_byte(mem, uart->addr + TLA_DLL, uart->regs[TL_DLL], false);
-        }
-        if (_test_and_reset_mem_flags(mem, uart->addr + TLA_DLM, MEM_FLAG_W).W == 1) {
-            uart->regs[TL_DLM] = _get_mem_byte(mem, uart->addr + TLA_DLM, false);
-        } else {
-            _set_mem_byte(mem, uart->addr + TLA_DLM, uart->regs[TL_DLM], false);
-        }
-    }
-    // Otherwise, handle communication with the rx/tx regs
-    else {
-        // THR
-        if (_test_and_reset_mem_flags(mem, uart->addr + TLA_THR, MEM_FLAG_W).W == 1) {
-
-            uart->tx_empty_edge = false; // Write into TX reg resets IRQ for empty tx
-            
-            // Loopback
-            if (uart->regs[TL_MCR] & (1u << MCR_LOOP)) {
-                // Add value to queue
-                if (!circ_buf_is_full(&(uart->rx_buf))) {
-                    circ_buf_push(&(uart->rx_buf), _get_mem_byte(mem, uart->addr + TLA_THR, false));
-                }
-            }
-            else {
-                // SEND CHAR OVER SOCKET?
-                uint8_t val = _get_mem_byte(mem, uart->addr + TLA_THR, false);
-                if (uart->data_socket >= 0 && !sock_closed) {
-                    if (send(uart->data_socket, &val, 1, MSG_NOSIGNAL) == -1) {
-                        // If the pipe was closed, errno should be EPIPE
-                        sock_closed = true;
-                    }
-                }
-            }
-
-            // If tx buffer is empty, enable signaling of TX empty IRQ
-            if (circ_buf_is_empty(&(uart->tx_buf))) {
-                uart->tx_empty_edge = true;
-            }
-        }
-
-        // RHR
-        // Always keep the last char from the RX FIFO available
-        if (circ_buf_is_empty(&(uart->rx_buf))) {
-            // Reading the RHR after all characters have been read
-            // in will result in just reading the last char received.
-            // This is accomplished by "subtracting 1" from the index
-            // and performing wrapping on it
-            char c;
-            circ_buf_peek_prev(&(uart->rx_buf), &c);
-            _set_mem_byte(
-                mem,
-                uart->addr + TLA_RBR,
-                c,
-                false
-                );
-        } else {
-            char c;
-            circ_buf_peek(&(uart->rx_buf), &c);
-            _set_mem_byte(
-                mem,
-                uart->addr + TLA_RBR,
-                c,
-                false
-                );
-        }
-        
-        if (_test_and_reset_mem_flags(mem, uart->addr + TLA_RBR, MEM_FLAG_R).R == 1) {
-            
-            // Update read buffer pointer
-            char c;
-            circ_buf_pop(&(uart->rx_buf), &c);
-        }
-    }
-
-    // If the FIFO Control Register was updated, keep a local copy
-    if (_test_and_reset_mem_flags(mem, uart->addr + TLA_FCR, MEM_FLAG_W).W == 1) {
-        uart->regs[TL_FCR] = _get_mem_byte(mem, uart->addr + TLA_FCR, false);
-
-        // Changing the FIFO ENable bit clears the FIFOs
-        if (uart->regs[TL_FCR] & (1u << FCR_FIFOEN)) {
-            init_circ_buf(&(uart->rx_buf));
-            init_circ_buf(&(uart->tx_buf));
-        }
-        else if (uart->regs[TL_FCR] & (1u << FCR_RXFRST)) {
-            init_circ_buf(&(uart->rx_buf));
-        }
-        else if (uart->regs[TL_FCR] & (1u << FCR_TXFRST)) {
-            init_circ_buf(&(uart->tx_buf));
-        }
-    }
 
     // LSR
     // If RX FIFO is empty
@@ -410,8 +266,6 @@ bool step_16c750(tl16c750_t *uart, memory_t *mem)
     }
     uart->regs[TL_LSR] &= ~((1u << LSR_OE) | (1u << LSR_PE) | (1u << LSR_FE) | (1u << LSR_BI) | (1u << LSR_ERFIFO));
 
-    _set_mem_byte(mem, uart->addr + TLA_LSR, uart->regs[TL_LSR], false);
-
     // IIR
     // If there is received data available, set bit 2
     if (
@@ -463,9 +317,6 @@ bool step_16c750(tl16c750_t *uart, memory_t *mem)
     } else {
         uart->regs[TL_IIR] |= (1u << IIR_IPN);  // Set bit
     }
-    
-    // Update the state of the Interrupt Identification Register
-    _set_mem_byte(mem, uart->addr + TLA_IIR, uart->regs[TL_IIR], false);
 
     // MSR
     if (uart->data_socket != -1) {
@@ -473,16 +324,314 @@ bool step_16c750(tl16c750_t *uart, memory_t *mem)
     } else {
         uart->regs[TL_MSR] &= ~(1u << MSR_DCD);
     }
-    
-    _set_mem_byte(mem, uart->addr + TLA_MSR, uart->regs[TL_MSR], false);
 
-    // Allow new connections
-    if (sock_closed) {
+    if (uart->cpu) {
+        uart->cpu->P.IRQ = irq;
+    }
+
+    return irq;
+}
+
+
+/*
+ * Close the data connection (if any) so that a new one can be accepted
+ * 
+ * @param *uart The UART to disconnect
+ */
+static void disconnect_16c750(tl16c750_t *uart)
+{
+    if (uart->data_socket >= 0) {
         close(uart->data_socket);
         uart->data_socket = -1;
     }
+}
 
-    return irq;
+
+/**
+ * Get the value of one of the UART's registers without any side effects
+ * (memory-mapped device peek callback)
+ * 
+ * @param *ctx The UART
+ * @param offs The register's offset from the UART's base address
+ * @return The value the register would read as
+ */
+static uint8_t peek_16c750(void *ctx, uint32_t offs)
+{
+    tl16c750_t *uart = ctx;
+    bool dlab = uart->regs[TL_LCR] & (1u << LCR_DLAB);
+    char c;
+
+    switch (offs) {
+    case TLA_RBR:
+        if (dlab) {
+            return uart->regs[TL_DLL];
+        }
+        // Reading the RHR after all characters have been read
+        // in will result in just reading the last char received.
+        // This is accomplished by "subtracting 1" from the index
+        // and performing wrapping on it
+        if (circ_buf_is_empty(&(uart->rx_buf))) {
+            circ_buf_peek_prev(&(uart->rx_buf), &c);
+        } else {
+            circ_buf_peek(&(uart->rx_buf), &c);
+        }
+        return c;
+    case TLA_IER:
+        return dlab ? uart->regs[TL_DLM] : uart->regs[TL_IER];
+    case TLA_IIR:
+        return uart->regs[TL_IIR];
+    case TLA_LCR:
+        return uart->regs[TL_LCR];
+    case TLA_MCR:
+        return uart->regs[TL_MCR];
+    case TLA_LSR:
+        return uart->regs[TL_LSR];
+    case TLA_MSR:
+        return uart->regs[TL_MSR];
+    default: // TLA_SCR
+        return uart->regs[TL_SCR];
+    }
 }
 
 
+/**
+ * Read one of the UART's registers (memory-mapped device read callback)
+ * 
+ * @param *ctx The UART
+ * @param offs The register's offset from the UART's base address
+ * @return The value of the register
+ */
+static uint8_t read_16c750(void *ctx, uint32_t offs)
+{
+    tl16c750_t *uart = ctx;
+    uint8_t val = peek_16c750(ctx, offs);
+    char c;
+
+    switch (offs) {
+    case TLA_RBR:
+        // Reading the RHR pops the received char
+        if (!(uart->regs[TL_LCR] & (1u << LCR_DLAB))) {
+            circ_buf_pop(&(uart->rx_buf), &c);
+            update_16c750(uart);
+        }
+        break;
+    case TLA_IIR:
+        // Disable TX empty flag if the CPU read the IIR
+        uart->tx_empty_edge = false;
+        update_16c750(uart);
+        break;
+    default:
+        break;
+    }
+    return val;
+}
+
+
+/**
+ * Write one of the UART's registers (memory-mapped device write callback)
+ * 
+ * @param *ctx The UART
+ * @param offs The register's offset from the UART's base address
+ * @param val The value written to the register
+ */
+static void write_16c750(void *ctx, uint32_t offs, uint8_t val)
+{
+    tl16c750_t *uart = ctx;
+    bool dlab = uart->regs[TL_LCR] & (1u << LCR_DLAB);
+
+    switch (offs) {
+    case TLA_THR:
+        // Handle writing to divisor latches
+        if (dlab) {
+            uart->regs[TL_DLL] = val;
+            break;
+        }
+
+        uart->regs[TL_THR] = val;
+        uart->tx_empty_edge = false; // Write into TX reg resets IRQ for empty tx
+            
+        // Loopback
+        if (uart->regs[TL_MCR] & (1u << MCR_LOOP)) {
+            // Add value to queue
+            if (!circ_buf_is_full(&(uart->rx_buf))) {
+                circ_buf_push(&(uart->rx_buf), val);
+            }
+        }
+        else if (uart->data_socket >= 0) {
+            // SEND CHAR OVER SOCKET
+            if (send(uart->data_socket, &val, 1, MSG_NOSIGNAL) == -1) {
+                // If the pipe was closed, errno should be EPIPE
+                disconnect_16c750(uart);
+            }
+        }
+
+        // If tx buffer is empty, enable signaling of TX empty IRQ
+        if (circ_buf_is_empty(&(uart->tx_buf))) {
+            uart->tx_empty_edge = true;
+        }
+        break;
+    case TLA_IER:
+        if (dlab) {
+            uart->regs[TL_DLM] = val;
+        } else {
+            uart->regs[TL_IER] = val;
+        }
+        break;
+    case TLA_FCR:
+        uart->regs[TL_FCR] = val;
+
+        // Changing the FIFO ENable bit clears the FIFOs
+        if (uart->regs[TL_FCR] & (1u << FCR_FIFOEN)) {
+            init_circ_buf(&(uart->rx_buf));
+            init_circ_buf(&(uart->tx_buf));
+        }
+        else if (uart->regs[TL_FCR] & (1u << FCR_RXFRST)) {
+            init_circ_buf(&(uart->rx_buf));
+        }
+        else if (uart->regs[TL_FCR] & (1u << FCR_TXFRST)) {
+            init_circ_buf(&(uart->tx_buf));
+        }
+        break;
+    case TLA_LCR:
+        uart->regs[TL_LCR] = val;
+        break;
+    case TLA_MCR:
+        uart->regs[TL_MCR] = val;
+        break;
+    case TLA_SCR:
+        uart->regs[TL_SCR] = val;
+        break;
+    default: // LSR and MSR are read only
+        break;
+    }
+
+    update_16c750(uart);
+}
+
+
+/**
+ * Poll the UART's network connection and schedule the next poll
+ * (CPU event callback, see map_16c750())
+ * 
+ * @param *cpu The CPU the UART is connected to
+ * @param *ctx The UART
+ */
+static void poll_event_16c750(CPU_t *cpu, void *ctx)
+{
+    step_16c750(ctx);
+    scheduleEventCPU(cpu, UART_POLL_CYCLES, poll_event_16c750, ctx);
+}
+
+
+/**
+ * Map the UART's registers into memory at the UART's base address.
+ * From then on the CPU's accesses to the registers go straight to
+ * the UART, and the UART's network connection is polled every
+ * UART_POLL_CYCLES cycles of the connected CPU (if any).
+ * 
+ * @param *uart The UART to map
+ * @param *mem The memory to map the UART into
+ * @return True if the UART was mapped, false if the address is in use
+ */
+bool map_16c750(tl16c750_t *uart, memory_t *mem)
+{
+    mem_device_t dev = {
+        .base = uart->addr,
+        .size = UART_REG_COUNT,
+        .read = read_16c750,
+        .write = write_16c750,
+        .peek = peek_16c750,
+        .ctx = uart,
+        // Reading the RBR or IIR changes the UART's state
+        .pure = ~((1u << TLA_RBR) | (1u << TLA_IIR))
+    };
+
+    update_16c750(uart);
+    if (!_map_mem_io(mem, &dev)) {
+        return false;
+    }
+    if (uart->cpu) {
+        scheduleEventCPU(uart->cpu, UART_POLL_CYCLES, poll_event_16c750, uart);
+    }
+    return true;
+}
+
+
+/**
+ * Remove the UART's registers from memory (the addresses become RAM)
+ * 
+ * @param *uart The UART to unmap
+ * @param *mem The memory the UART was mapped into
+ */
+void unmap_16c750(tl16c750_t *uart, memory_t *mem)
+{
+    _unmap_mem(mem, uart->addr, UART_REG_COUNT);
+    if (uart->cpu) {
+        cancelEventCPU(uart->cpu, poll_event_16c750, uart);
+    }
+}
+
+
+/**
+ * Poll the UART's network connection. This accepts new connections
+ * and moves any received characters into the RX FIFO. Register
+ * accesses are handled as they happen and a mapped UART polls itself
+ * while the CPU runs, so this only needs to be called while the CPU
+ * is not running (or is waiting in a WAI).
+ * 
+ * @param *uart The UART to update
+ * @return True if an interrupt is active, false if no interrupts are active.
+ */
+bool step_16c750(tl16c750_t *uart)
+{
+    // Attempt to accept an incomming connection if one is
+    // not already established
+    if (uart->data_socket < 0) {
+        uart->data_socket = accept(uart->sock_fd, NULL, NULL);
+
+        // If the accept was successfult, attempt to set the socket
+        // into a nonblocking mode
+        if (uart->data_socket >= 0) {
+            int flags = fcntl(uart->data_socket, F_GETFL, 0);
+            if (flags != -1) {
+                fcntl(uart->data_socket, F_SETFL, flags | O_NONBLOCK);
+            }
+        }
+    }
+    
+    // Check the socket for characters
+    // But be sure to not overflow the RX buffer
+    if (uart->data_socket >= 0 && !circ_buf_is_full(&(uart->rx_buf))) {
+        char buf[UART_FIFO_LEN];
+        int read_len = read(uart->data_socket, buf, UART_FIFO_LEN - uart->rx_buf.count);
+
+        for (int i = 0; i < read_len; ++i) {
+            circ_buf_push(&(uart->rx_buf), buf[i]);
+        }
+        if (read_len == 0 || (read_len == -1 && errno != EAGAIN && errno != EWOULDBLOCK)) { // Closed or error
+            // Allow new connections
+            disconnect_16c750(uart);
+        }
+    }
+
+    return update_16c750(uart);
+}
+
+
+/**
+ * Get the file descriptor which the UART's next network event (a new
+ * connection or received characters) will show up on, so that the
+ * caller can sleep on it with poll() while the CPU has nothing to do.
+ * Whatever happened still has to be picked up with step_16c750().
+ * 
+ * @param *uart The UART to check
+ * @return The file descriptor, or -1 if the UART is not waiting for
+ *         anything (no port is open or the RX FIFO is full)
+ */
+int get_poll_fd_16c750(tl16c750_t *uart)
+{
+    if (uart->data_socket >= 0) {
+        return circ_buf_is_full(&(uart->rx_buf)) ? -1 : uart->data_socket;
+    }
+    return uart->sock_fd;
+}
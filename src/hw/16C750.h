@@ -14,6 +14,13 @@
 
 #define UART_FIFO_LEN 64
 
+// Number of bytes of registers the UART maps into memory
+#define UART_REG_COUNT 8
+
+// CPU cycles between checks of the UART's network connection while the
+// CPU runs (2ms at 10MHz, about two character times at 9600 baud)
+#define UART_POLL_CYCLES 20000
+
 // IER
 enum {
     IER_ERBI = 0,
@@ -153,13 +160,17 @@ typedef struct tl16c750_t {
     tl_circ_buf_t rx_buf;
     tl_circ_buf_t tx_buf;
     bool tx_empty_edge;
+    CPU_t *cpu;       // CPU whose IRQ input the UART drives (NULL if none)
 } tl16c750_t;
 
 void reset_16c750(tl16c750_t *);
 void init_16c750(tl16c750_t *);
 int init_port_16c750(tl16c750_t *, uint16_t);
 void stop_16c750(tl16c750_t *);
-bool step_16c750(tl16c750_t *, memory_t *);
+bool map_16c750(tl16c750_t *, memory_t *);
+void unmap_16c750(tl16c750_t *, memory_t *);
+bool step_16c750(tl16c750_t *);
+int get_poll_fd_16c750(tl16c750_t *);
 
 #endif
 
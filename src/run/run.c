@@ -0,0 +1,399 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ *
+ * Headless batch runner: runs a program without the debugger's
+ * interface and reports how it stopped
+ */
+
+// Needed for clock_gettime
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "../cpu/65816.h"
+#include "../cpu/65816-util.h"
+#include "../cpu/65816-core.h"
+#include "../cpu/65816-lockstep.h"
+#include "../debugger/symbols.h"
+#include "../debugger/loader.h"
+#include "run.h"
+
+
+/**
+ * Print the help menu and exit
+ */
+void print_help_and_exit()
+{
+    printf(
+        "65816 Batch Runner (C) Ray Clemens 2022-2023\n"
+        "USAGE:\n"
+        " $ 816ce-run [OPTIONS]\n"
+        "\n"
+        "Options:\n"
+        " --cpu-file filename ...... Preload the CPU with a saved state\n"
+        " --mem [offset] filename .. Load memory at offset (in hex) with a file\n"
+        " --mem-mos filename ....... Load a binary file formatted for the LLVM MOS simulator into memory\n"
+        " --sym filename ........... Load a symbol file\n"
+        " --break addr ............. Stop when the PC reaches addr (in hex, or a symbol)\n"
+        " --max-cycles n ........... Stop once n more cycles have been run\n"
+        " --max-time seconds ....... Stop once the given (wall-clock) time has passed\n"
+        " --dump addr count ........ Print count bytes of memory from addr once stopped (both in hex)\n"
+        " --save-cpu filename ...... Save the CPU state once stopped\n"
+        " --lockstep n ............. Check the CPU against the reference decoder every n instructions\n"
+        "\n"
+        "Exit status:\n"
+        " 0 - STP executed\n"
+        " 1 - Error in the arguments or loading a file\n"
+        " 2 - Breakpoint reached\n"
+        " 3 - Cycle limit reached\n"
+        " 4 - Time limit reached\n"
+        " 5 - WAI executed with no interrupt pending\n"
+        " 6 - CPU crashed (internal error)\n"
+        " 7 - CPU diverged from the reference decoder (--lockstep)\n"
+        "\n"
+        );
+    exit(RUN_EXIT_STP);
+}
+
+
+/**
+ * Print an error from loading a file and exit
+ *
+ * @param *filename The file which was being loaded
+ * @param err The error from loading it
+ */
+void load_error_exit(char *filename, cmd_err_t err)
+{
+    fprintf(stderr, "Error! (%s) %s\n", filename, cmd_err_msgs[err].msg);
+    exit(RUN_EXIT_ERROR);
+}
+
+
+/**
+ * Print a range of memory in hex, RUN_DUMP_BYTES_PER_LINE per line,
+ * without any side effects on devices
+ *
+ * @param *mem The memory to print
+ * @param addr The first address to print
+ * @param count The number of bytes to print
+ */
+void dump_mem(memory_t *mem, uint32_t addr, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; ++i) {
+        if (i % RUN_DUMP_BYTES_PER_LINE == 0) {
+            printf("%s%06x:", (i == 0) ? "" : "\n", (addr + i) & (MEMORY_SIZE - 1));
+        }
+        printf(" %02x", _peek_mem_byte(mem, (addr + i) & (MEMORY_SIZE - 1)));
+    }
+    printf("\n");
+}
+
+
+/**
+ * Get the seconds elapsed since a time
+ *
+ * @param *start The time to measure from
+ * @return The time since start in seconds
+ */
+double seconds_since(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) + (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+int main(int argc, char *argv[])
+{
+    cmd_err_t cmd_err;
+    uint64_t max_cycles = 0;
+    double max_time = 0;
+    char *save_cpu = NULL;
+    uint64_t lockstep_interval = 0;
+    struct {
+        uint32_t addr;
+        uint32_t count;
+    } dumps[RUN_DUMPS_MAX];
+    int dump_count = 0;
+    symbol_table_t *symbol_table = NULL;
+    if (st_init(&symbol_table)) {
+        fprintf(stderr, "Unable to initialize symbol table!\n");
+        exit(RUN_EXIT_ERROR);
+    }
+
+    Core816_t *core = createCore816();
+    if (!core) {
+        fprintf(stderr, "Unable to allocate system memory!\n");
+        exit(RUN_EXIT_ERROR);
+    }
+    CPU_t *cpu = getCPUCore816(core);
+    memory_t *memory = getMemCore816(core);
+
+    // Compile hot code if the JIT was built in (nothing to do otherwise)
+    enableJITCore816(core, RUN_JIT_THRESHOLD);
+
+    // Command line parsing
+    {
+        uint32_t base_addr = 0;
+        int cli_pstate = 0;
+        for (int i = 1; i < argc; ++i) {
+            switch (cli_pstate) {
+            case 0:
+                if (strcmp(argv[i], "--cpu-file") == 0) {
+                    cli_pstate = 1;
+                }
+                else if (strcmp(argv[i], "--mem") == 0) {
+                    cli_pstate = 2;
+                }
+                else if (strcmp(argv[i], "--mem-mos") == 0) {
+                    cli_pstate = 3;
+                }
+                else if (strcmp(argv[i], "--sym") == 0) {
+                    cli_pstate = 4;
+                }
+                else if (strcmp(argv[i], "--break") == 0) {
+                    cli_pstate = 5;
+                }
+                else if (strcmp(argv[i], "--max-cycles") == 0) {
+                    cli_pstate = 6;
+                }
+                else if (strcmp(argv[i], "--max-time") == 0) {
+                    cli_pstate = 7;
+                }
+                else if (strcmp(argv[i], "--dump") == 0) {
+                    cli_pstate = 8;
+                }
+                else if (strcmp(argv[i], "--save-cpu") == 0) {
+                    cli_pstate = 10;
+                }
+                else if (strcmp(argv[i], "--lockstep") == 0) {
+                    cli_pstate = 11;
+                }
+                else if (strcmp(argv[i], "--help") == 0) {
+                    print_help_and_exit();
+                }
+                else {
+                    fprintf(stderr, "Unknown argument: '%s'\n", argv[i]);
+                    exit(RUN_EXIT_ERROR);
+                }
+                break;
+            case 1: // CPU load
+                if ((cmd_err = load_file_cpu(argv[i], cpu)) > 0) {
+                    load_error_exit(argv[i], cmd_err);
+                }
+                cli_pstate = 0;
+                break;
+            case 2: // MEM load
+                // If the argument is hex, use it as an address
+                // Otherwise just load the file
+                if (!is_addr_do_parse(argv[i], &base_addr, symbol_table)) {
+                    if ((cmd_err = load_file_mem(argv[i], memory, base_addr, MF_BASIC_BIN_BLOCK)) > 0) {
+                        load_error_exit(argv[i], cmd_err);
+                    }
+                    cli_pstate = 0;
+                }
+                break;
+            case 3: // LLVM MOS simulator executable
+                if ((cmd_err = load_file_mem(argv[i], memory, base_addr, MF_LLVM_MOS_SIM)) > 0) {
+                    load_error_exit(argv[i], cmd_err);
+                }
+                cli_pstate = 0;
+                break;
+            case 4: // Symbols
+                if ((cmd_err = load_file_sym(argv[i], symbol_table)) > 0) {
+                    load_error_exit(argv[i], cmd_err);
+                }
+                cli_pstate = 0;
+                break;
+            case 5: { // Breakpoint
+                uint32_t addr;
+                if (!is_addr_do_parse(argv[i], &addr, symbol_table) || addr >= MEMORY_SIZE) {
+                    fprintf(stderr, "Invalid breakpoint address: '%s'\n", argv[i]);
+                    exit(RUN_EXIT_ERROR);
+                }
+                _set_mem_flags(memory, addr, MEM_FLAG_B);
+                cli_pstate = 0;
+            }
+                break;
+            case 6: { // Cycle limit
+                char *end;
+                max_cycles = strtoull(argv[i], &end, 10);
+                if (*end != '\0' || max_cycles == 0) {
+                    fprintf(stderr, "Invalid cycle count: '%s'\n", argv[i]);
+                    exit(RUN_EXIT_ERROR);
+                }
+                cli_pstate = 0;
+            }
+                break;
+            case 7: { // Time limit
+                char *end;
+                max_time = strtod(argv[i], &end);
+                if (*end != '\0' || !(max_time > 0)) {
+                    fprintf(stderr, "Invalid time: '%s'\n", argv[i]);
+                    exit(RUN_EXIT_ERROR);
+                }
+                cli_pstate = 0;
+            }
+                break;
+            case 8: // Memory dump address
+                if (dump_count == RUN_DUMPS_MAX) {
+                    fprintf(stderr, "Too many memory dumps (max %d)\n", RUN_DUMPS_MAX);
+                    exit(RUN_EXIT_ERROR);
+                }
+                if (!is_addr_do_parse(argv[i], &dumps[dump_count].addr, symbol_table)) {
+                    fprintf(stderr, "Invalid dump address: '%s'\n", argv[i]);
+                    exit(RUN_EXIT_ERROR);
+                }
+                cli_pstate = 9;
+                break;
+            case 9: // Memory dump length
+                if (!is_hex_do_parse(argv[i], &dumps[dump_count].count) ||
+                    dumps[dump_count].count > MEMORY_SIZE) {
+                    fprintf(stderr, "Invalid dump length: '%s'\n", argv[i]);
+                    exit(RUN_EXIT_ERROR);
+                }
+                ++dump_count;
+                cli_pstate = 0;
+                break;
+            case 10: // CPU save
+                save_cpu = argv[i];
+                cli_pstate = 0;
+                break;
+            case 11: { // Lockstep interval
+                char *end;
+                lockstep_interval = strtoull(argv[i], &end, 10);
+                if (*end != '\0' || lockstep_interval == 0) {
+                    fprintf(stderr, "Invalid instruction count: '%s'\n", argv[i]);
+                    exit(RUN_EXIT_ERROR);
+                }
+                cli_pstate = 0;
+            }
+                break;
+            }
+        }
+        if (cli_pstate != 0) {
+            fprintf(stderr, "Expected a value after '%s'\n", argv[argc - 1]);
+            exit(RUN_EXIT_ERROR);
+        }
+    }
+
+    // Run a copy of the program on the reference decoder alongside
+    // the CPU (a second instance, whose own cache and JIT go unused)
+    Core816_t *ref_core = NULL;
+    CPU_Lockstep_t lockstep;
+    if (lockstep_interval) {
+        ref_core = createCore816();
+        if (!ref_core) {
+            fprintf(stderr, "Unable to allocate system memory!\n");
+            exit(RUN_EXIT_ERROR);
+        }
+        initLockstepCPU(&lockstep, cpu, memory, getCPUCore816(ref_core), getMemCore816(ref_core),
+                        lockstep_interval);
+        if (!syncLockstepCPU(&lockstep)) {
+            fprintf(stderr, "Unable to allocate system memory!\n");
+            exit(RUN_EXIT_ERROR);
+        }
+    }
+
+    // Run in slices of cycles so that the time limit can be checked
+    // between them. The CPU runs at full speed within a slice.
+    struct timespec start_time;
+    uint64_t start_cycles = cpu->cycles;
+    run_exit_t exit_code;
+    char *reason;
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+
+    while (true) {
+        uint64_t budget = RUN_SLICE_CYCLES;
+        uint64_t ran = cpu->cycles - start_cycles;
+
+        if (max_cycles) {
+            if (ran >= max_cycles) {
+                exit_code = RUN_EXIT_CYCLES;
+                reason = "cycle limit";
+                break;
+            }
+            if (max_cycles - ran < budget) {
+                budget = max_cycles - ran;
+            }
+        }
+        if (max_time > 0 && seconds_since(&start_time) >= max_time) {
+            exit_code = RUN_EXIT_TIME;
+            reason = "time limit";
+            break;
+        }
+
+        uint32_t stop_mask = CPU_RUN_BREAK | CPU_RUN_WAI | CPU_RUN_BUDGET_CYCLES;
+        CPU_Run_Status_t stat = ref_core ? runLockstepCPU(&lockstep, budget, stop_mask)
+                                         : runCore816(core, budget, stop_mask);
+
+        if (stat == CPU_RUN_STP) {
+            exit_code = RUN_EXIT_STP;
+            reason = "STP";
+            break;
+        }
+        else if (stat == CPU_RUN_BREAK) {
+            exit_code = RUN_EXIT_BREAK;
+            reason = "breakpoint";
+            break;
+        }
+        else if (stat == CPU_RUN_WAI) {
+            // Nothing can raise an interrupt, so the CPU would wait forever
+            exit_code = RUN_EXIT_WAI;
+            reason = "WAI";
+            break;
+        }
+        else if (stat == CPU_RUN_DIVERGED) {
+            exit_code = RUN_EXIT_DIVERGED;
+            reason = "lockstep divergence";
+            break;
+        }
+        else if (stat != CPU_RUN_BUDGET) {
+            exit_code = RUN_EXIT_CRASH;
+            reason = "crash";
+            break;
+        }
+    }
+
+    double elapsed = seconds_since(&start_time);
+    uint64_t ran = cpu->cycles - start_cycles;
+    char cpu_state[RUN_CPU_STATE_LEN];
+
+    tostrCPU(cpu, cpu_state);
+    printf("Stopped: %s at %02x:%04x\n", reason, cpu->PBR, cpu->PC);
+    printf("Cycles: %" PRIu64 " in %.3fs (%.3f MHz)\n", ran, elapsed,
+           (elapsed > 0) ? ran / elapsed / 1e6 : 0.0);
+    printf("CPU: %s\n", cpu_state);
+    if (exit_code == RUN_EXIT_DIVERGED) {
+        dumpLockstepCPU(&lockstep, stdout);
+    }
+    for (int i = 0; i < dump_count; ++i) {
+        dump_mem(memory, dumps[i].addr, dumps[i].count);
+    }
+
+    if (save_cpu) {
+        FILE *fp = fopen(save_cpu, "w");
+        if (!fp || fprintf(fp, "%s", cpu_state) < 0) {
+            fprintf(stderr, "Error! (%s) %s\n", save_cpu, cmd_err_msgs[CMD_FILE_IO_ERROR].msg);
+            exit_code = RUN_EXIT_ERROR;
+        }
+        if (fp) {
+            fclose(fp);
+        }
+    }
+
+    freeCore816(ref_core);
+    freeCore816(core);
+    st_destroy(&symbol_table);
+
+    return exit_code;
+}
@@ -0,0 +1,27 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ */
+
+#ifndef _RUN_H
+#define _RUN_H
+
+#define RUN_SLICE_CYCLES 10000000 // Cycles run between checks of the time limit
+#define RUN_JIT_THRESHOLD 8       // Times a block is entered before the JIT compiles it
+#define RUN_DUMPS_MAX 32          // Max number of --dump ranges
+#define RUN_DUMP_BYTES_PER_LINE 16
+#define RUN_CPU_STATE_LEN 256     // Room for the output of tostrCPU()
+
+// Exit status of the batch runner (keep in sync with print_help_and_exit())
+typedef enum run_exit_t {
+    RUN_EXIT_STP = 0,
+    RUN_EXIT_ERROR,
+    RUN_EXIT_BREAK,
+    RUN_EXIT_CYCLES,
+    RUN_EXIT_TIME,
+    RUN_EXIT_WAI,
+    RUN_EXIT_CRASH,
+    RUN_EXIT_DIVERGED
+} run_exit_t;
+
+#endif
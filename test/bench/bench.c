@@ -0,0 +1,312 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ *
+ * Emulator throughput benchmark: runs each workload in this directory
+ * for a fixed number of instructions and prints the results as JSON
+ */
+
+// Needed for clock_gettime
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+
+#include "../../src/cpu/65816.h"
+#include "../../src/cpu/65816-core.h"
+
+// Every workload is a 4 KiB image for the top of bank 0 (it has
+// its own vectors) which loops forever
+#define BENCH_LOAD_ADDR 0xf000
+#define BENCH_IMAGE_SIZE 0x1000
+
+// Instructions timed for each workload (unless --insns is given)
+// and run beforehand to warm up the caches (and the JIT)
+#define BENCH_DEFAULT_INSNS 50000000
+#define BENCH_WARMUP_DIV 10
+
+#define BENCH_JIT_THRESHOLD 8
+
+// For irq.bin: cycles between IRQs and the acknowledge register
+// which releases the IRQ line when written
+#define BENCH_IRQ_PERIOD 200
+#define BENCH_IRQ_ACK 0xeff0
+
+#define BENCH_PATH_LEN 1024
+
+typedef struct bench_workload_t {
+    char *name;
+    char *desc;
+    bool irq;
+    bool idle; // Only loops on a read, which the execution engine has to skip
+} bench_workload_t;
+
+bench_workload_t workloads[] = {
+    {"sieve",      "Sieve of Eratosthenes (8-bit A, 16-bit X)", false, false},
+    {"crc32",      "Bitwise CRC-32 of 4 KiB",                   false, false},
+    {"memcpy",     "4 KiB copy with a load/store loop",         false, false},
+    {"memcpy_mvn", "4 KiB copy with MVN",                       false, false},
+    {"decimal",    "Decimal mode ADC/SBC",                      false, false},
+    {"width8",     "Scramble/sum loop with 8-bit registers",    false, false},
+    {"width16",    "Scramble/sum loop with 16-bit registers",   false, false},
+    {"irq",        "Busy loop with an IRQ every 200 cycles",    true,  false},
+    {"recurse",    "JSR/RTS recursion 2000 levels deep",        false, false},
+    {"idle",       "LDA/BEQ loop polling memory",               false, true},
+};
+
+#define BENCH_WORKLOADS (sizeof(workloads) / sizeof(workloads[0]))
+
+
+/**
+ * Print the help menu and exit
+ */
+void print_help_and_exit()
+{
+    printf(
+        "65816 Emulator Benchmark (C) Ray Clemens 2022-2023\n"
+        "USAGE:\n"
+        " $ 816ce-bench [OPTIONS] [workload ...]\n"
+        "\n"
+        "Options:\n"
+        " --dir path ...... Directory with the workload images (default: test/bench)\n"
+        " --insns n ....... Instructions to time each workload for (default: %d)\n"
+        " --list .......... List the workloads\n"
+        "\n"
+        "Runs every workload (or the ones given) and prints the emulated MIPS,\n"
+        "emulated MHz and host ns per instruction of each one as JSON.\n"
+        "\n",
+        BENCH_DEFAULT_INSNS
+        );
+    exit(EXIT_SUCCESS);
+}
+
+
+/**
+ * Get the name of the execution engine which the core was built with
+ *
+ * @return The engine's name
+ */
+char *engine_name()
+{
+#if defined(CPU_JIT)
+    return "jit";
+#elif defined(CPU_DISPATCH_TABLE)
+    return "table";
+#else
+    return "switch";
+#endif
+}
+
+
+/**
+ * Raise the IRQ line and schedule the next IRQ
+ *
+ * @param *cpu The CPU being benchmarked
+ * @param *ctx The core which the CPU belongs to
+ */
+void irq_event(CPU_t *cpu, void *ctx)
+{
+    setIRQCore816(ctx, true);
+    scheduleEventCPU(cpu, BENCH_IRQ_PERIOD, irq_event, ctx);
+}
+
+
+/**
+ * Read from the IRQ acknowledge register
+ *
+ * @param *ctx The core
+ * @param offs The register offset
+ * @return 0
+ */
+uint8_t irq_ack_read(void *ctx, uint32_t offs)
+{
+    (void) ctx;
+    (void) offs;
+    return 0;
+}
+
+
+/**
+ * Write to the IRQ acknowledge register, which releases the IRQ line
+ *
+ * @param *ctx The core
+ * @param offs The register offset
+ * @param val The value written (ignored)
+ */
+void irq_ack_write(void *ctx, uint32_t offs, uint8_t val)
+{
+    (void) offs;
+    (void) val;
+    setIRQCore816(ctx, false);
+}
+
+
+/**
+ * Get the seconds between two times
+ *
+ * @param *start The earlier time
+ * @param *end The later time
+ * @return The time from start to end in seconds
+ */
+double seconds_between(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) + (end->tv_nsec - start->tv_nsec) / 1e9;
+}
+
+
+/**
+ * Run a workload and print its results as a JSON object
+ *
+ * @param *w The workload to run
+ * @param *dir The directory with the workload images
+ * @param insns The number of instructions to time
+ * @param first True if this is the first result (no comma before it)
+ * @return True if the workload ran, false if it could not be loaded,
+ *         the CPU stopped before running all of its instructions or an
+ *         idle workload's loop was not skipped
+ */
+bool run_workload(bench_workload_t *w, char *dir, uint64_t insns, bool first)
+{
+    char path[BENCH_PATH_LEN];
+    uint8_t image[BENCH_IMAGE_SIZE];
+    Core816_Regs_t regs;
+    struct timespec start, end;
+    CPU_Run_Status_t stat;
+
+    snprintf(path, sizeof(path), "%s/%s.bin", dir, w->name);
+    FILE *fp = fopen(path, "rb");
+    if (!fp) {
+        fprintf(stderr, "Unable to open '%s'\n", path);
+        return false;
+    }
+    size_t len = fread(image, 1, sizeof(image), fp);
+    fclose(fp);
+    if (len != sizeof(image)) {
+        fprintf(stderr, "'%s' is not a %d byte image\n", path, BENCH_IMAGE_SIZE);
+        return false;
+    }
+
+    Core816_t *core = createCore816();
+    if (!core) {
+        fprintf(stderr, "Unable to allocate system memory!\n");
+        return false;
+    }
+    writeMemCore816(core, BENCH_LOAD_ADDR, image, sizeof(image));
+    enableJITCore816(core, BENCH_JIT_THRESHOLD);
+
+    if (w->irq) {
+        mem_device_t ack = {
+            .base = BENCH_IRQ_ACK,
+            .size = 1,
+            .read = irq_ack_read,
+            .write = irq_ack_write,
+            .peek = irq_ack_read,
+            .ctx = core,
+            .pure = 0
+        };
+        mapDeviceCore816(core, &ack);
+        scheduleEventCPU(getCPUCore816(core), BENCH_IRQ_PERIOD, irq_event, core);
+    }
+
+    // Warm up, then time a fixed number of instructions
+    stat = runCore816(core, insns / BENCH_WARMUP_DIV, 0);
+    getRegsCore816(core, &regs);
+    uint64_t start_cycles = regs.cycles;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (stat == CPU_RUN_BUDGET) {
+        stat = runCore816(core, insns, 0);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    getRegsCore816(core, &regs);
+    bool skipped = getSkippedCore816(core) != 0;
+    freeCore816(core);
+
+    if (stat != CPU_RUN_BUDGET) {
+        fprintf(stderr, "'%s' stopped early (status %d)\n", w->name, stat);
+        return false;
+    }
+    if (w->idle && !skipped) {
+        fprintf(stderr, "'%s' was not skipped by the %s engine\n", w->name, engine_name());
+        return false;
+    }
+
+    double secs = seconds_between(&start, &end);
+    uint64_t cycles = regs.cycles - start_cycles;
+
+    printf("%s\n    {\"name\": \"%s\", \"description\": \"%s\", "
+           "\"instructions\": %" PRIu64 ", \"cycles\": %" PRIu64 ", \"seconds\": %.6f, "
+           "\"mips\": %.3f, \"mhz\": %.3f, \"ns_per_insn\": %.3f}",
+           first ? "" : ",", w->name, w->desc, insns, cycles, secs,
+           insns / secs / 1e6, cycles / secs / 1e6, secs * 1e9 / insns);
+    fflush(stdout);
+    return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+    char *dir = "test/bench";
+    uint64_t insns = BENCH_DEFAULT_INSNS;
+    bool selected[BENCH_WORKLOADS] = {false};
+    bool any_selected = false;
+    bool ok = true;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+            dir = argv[++i];
+        }
+        else if (strcmp(argv[i], "--insns") == 0 && i + 1 < argc) {
+            char *end;
+            insns = strtoull(argv[++i], &end, 10);
+            if (*end != '\0' || insns == 0) {
+                fprintf(stderr, "Invalid instruction count: '%s'\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--list") == 0) {
+            for (size_t w = 0; w < BENCH_WORKLOADS; ++w) {
+                printf("%-12s %s\n", workloads[w].name, workloads[w].desc);
+            }
+            exit(EXIT_SUCCESS);
+        }
+        else if (strcmp(argv[i], "--help") == 0) {
+            print_help_and_exit();
+        }
+        else {
+            size_t w;
+            for (w = 0; w < BENCH_WORKLOADS; ++w) {
+                if (strcmp(argv[i], workloads[w].name) == 0) {
+                    selected[w] = true;
+                    any_selected = true;
+                    break;
+                }
+            }
+            if (w == BENCH_WORKLOADS) {
+                fprintf(stderr, "Unknown argument: '%s'\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+    }
+
+    printf("{\n  \"engine\": \"%s\",\n  \"results\": [", engine_name());
+    bool first = true;
+    for (size_t w = 0; w < BENCH_WORKLOADS; ++w) {
+        if (any_selected && !selected[w]) {
+            continue;
+        }
+        if (run_workload(&workloads[w], dir, insns, first)) {
+            first = false;
+        }
+        else {
+            ok = false;
+        }
+    }
+    printf("\n  ]\n}\n");
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,63 @@
+;;; BENCHMARK: CRC-32 (bit at a time)
+;;; Finds the CRC-32 (polynomial $EDB88320, reflected) of this
+;;; program's 4 KiB ($F000-$FFFF), forever. The CRC is left at
+;;; $10-$13 after each pass.
+;;;
+
+CRC .equ $00
+RESULT .equ $10
+START .equ $f000
+LEN .equ $1000
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 16-bit A/X/Y
+    xce
+    .al
+    .xl
+    rep #$30
+    ldx #$01ff
+    txs
+
+pass:
+    lda #$ffff
+    sta CRC
+    sta CRC+2
+    ldx #0
+byte:
+    .as
+    sep #$20
+    lda START,x
+    eor CRC
+    sta CRC
+    .al
+    rep #$20
+    ldy #8
+bit:
+    lsr CRC+2                   ; Shift the CRC right by one
+    ror CRC
+    bcc nopoly
+    lda CRC
+    eor #$8320
+    sta CRC
+    lda CRC+2
+    eor #$edb8
+    sta CRC+2
+nopoly:
+    dey
+    bne bit
+    inx
+    cpx #LEN
+    bne byte
+
+    lda CRC
+    eor #$ffff
+    sta RESULT
+    lda CRC+2
+    eor #$ffff
+    sta RESULT+2
+    bra pass
+
+    .org $fffc
+    .word reset
+    .word 0
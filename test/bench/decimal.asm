@@ -0,0 +1,41 @@
+;;; BENCHMARK: Decimal mode arithmetic
+;;; Adds 1234 to an 8 digit BCD counter (16-bit ADC) and counts a
+;;; 2 digit BCD value down by 7 (8-bit SBC), forever. The counter is
+;;; at $10-$13 and the 2 digit value at $14.
+;;;
+
+TOTAL .equ $10
+DOWN .equ $14
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 16-bit X/Y
+    xce
+    .al
+    .xl
+    rep #$30
+    ldx #$01ff
+    txs
+    sed
+
+loop:
+    clc                         ; TOTAL += 1234
+    lda TOTAL
+    adc #$1234
+    sta TOTAL
+    lda TOTAL+2
+    adc #0
+    sta TOTAL+2
+    .as
+    sep #$20
+    sec                         ; DOWN -= 7
+    lda DOWN
+    sbc #$07
+    sta DOWN
+    .al
+    rep #$20
+    bra loop
+
+    .org $fffc
+    .word reset
+    .word 0
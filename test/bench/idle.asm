@@ -0,0 +1,23 @@
+;;; BENCHMARK: Idle loop
+;;; Polls $10 (which stays 0) forever. The execution engines skip ahead
+;;; through a loop like this which only reads memory, so the benchmark
+;;; checks that the CPU found the loop and skipped it.
+;;;
+
+FLAG .equ $10
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 8-bit A
+    xce
+    .as
+    sep #$20
+
+wait:
+    lda FLAG
+    beq wait
+    bra reset
+
+    .org $fffc
+    .word reset
+    .word 0
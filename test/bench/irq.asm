@@ -0,0 +1,42 @@
+;;; BENCHMARK: Interrupts
+;;; Counts at $10 while servicing IRQs, forever. The interrupt
+;;; handler counts at $12 and acknowledges the IRQ by writing to ACK.
+;;; The IRQs (and the acknowledge register) come from the benchmark
+;;; runner (bench.c).
+;;;
+
+ACK .equ $eff0
+COUNT .equ $10
+TICKS .equ $12
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 16-bit A/X/Y
+    xce
+    .al
+    .xl
+    rep #$30
+    ldx #$01ff
+    txs
+    cli
+
+loop:
+    inc COUNT
+    bra loop
+
+irq:
+    .al
+    rep #$20
+    pha
+    inc TICKS
+    lda TICKS
+    sta ACK                     ; Release the IRQ line
+    pla
+    rti
+
+    .org $ffee
+    .word irq
+
+    .org $fffc
+    .word reset
+    .word irq
@@ -0,0 +1,34 @@
+;;; BENCHMARK: memcpy with a load/store loop
+;;; Copies this program's 4 KiB ($F000-$FFFF) to $2000 a word at
+;;; a time, forever. The number of passes is counted at $10.
+;;;
+
+SRC .equ $f000
+DST .equ $2000
+LEN .equ $1000
+PASSES .equ $10
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 16-bit A/X/Y
+    xce
+    .al
+    .xl
+    rep #$30
+    ldx #$01ff
+    txs
+
+pass:
+    ldx #LEN-2
+copy:
+    lda SRC,x
+    sta DST,x
+    dex
+    dex
+    bpl copy
+    inc PASSES
+    bra pass
+
+    .org $fffc
+    .word reset
+    .word 0
@@ -0,0 +1,31 @@
+;;; BENCHMARK: memcpy with MVN
+;;; Copies this program's 4 KiB ($F000-$FFFF) to $2000 with a block
+;;; move, forever. The number of passes is counted at $10.
+;;;
+
+SRC .equ $f000
+DST .equ $2000
+LEN .equ $1000
+PASSES .equ $10
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 16-bit A/X/Y
+    xce
+    .al
+    .xl
+    rep #$30
+    ldx #$01ff
+    txs
+
+pass:
+    lda #LEN-1
+    ldx #SRC
+    ldy #DST
+    mvn $00,$00
+    inc PASSES
+    bra pass
+
+    .org $fffc
+    .word reset
+    .word 0
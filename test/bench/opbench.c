@@ -0,0 +1,518 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ *
+ * Opcode microbenchmark: times stepCPU() on each opcode by itself, for
+ * each register width, and prints a table which can be sorted and
+ * compared against the table from another build
+ */
+
+// Needed for clock_gettime
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+
+#include "../../src/cpu/65816.h"
+#include "../../src/cpu/65816-core.h"
+#include "../../src/cpu/65816-opcodes.h"
+
+// Every instruction is run at OPB_PC with the operand bytes below, so
+// that direct page, absolute and long operands all point into RAM away
+// from the instruction, the stack and the (zero) vectors
+#define OPB_PC 0x8000
+#define OPB_SP 0x01ff
+#define OPB_OPERAND {0x10, 0x20, 0x00}
+
+#define OPB_DEFAULT_ITERS 20000
+#define OPB_DEFAULT_REPS 5
+
+// Repetitions for timing the harness's own overhead
+#define OPB_RESTORE_REPS 50
+
+#define OPB_WIDTHS 5
+#define OPB_LINE_LEN 256
+
+typedef enum opb_sort_t {
+    OPB_SORT_OP,
+    OPB_SORT_NS,
+    OPB_SORT_CYCLES,
+    OPB_SORT_CHANGE,
+} opb_sort_t;
+
+// Register widths which each opcode is timed with
+typedef struct opb_width_t {
+    char *name;
+    bool e;
+    bool m;
+    bool x;
+} opb_width_t;
+
+opb_width_t widths[OPB_WIDTHS] = {
+    {"emu",    true,  true,  true},
+    {"m8x8",   false, true,  true},
+    {"m8x16",  false, true,  false},
+    {"m16x8",  false, false, true},
+    {"m16x16", false, false, false},
+};
+
+// Opcode metadata (see CPU_OPCODE_TABLE in 65816-opcodes.h)
+typedef struct opb_opcode_t {
+    char *mnemonic;
+    char *mode;
+    char *handler;
+    CPU_Addr_Mode_t addr_mode;
+} opb_opcode_t;
+
+#define OPB_OPCODE(op, fn, kind, size, cycles, mode, res, mn, reg, acc) \
+    [op] = {#mn, #mode, #fn, CPU_ADDR_##mode},
+opb_opcode_t opcodes[256] = {
+    CPU_OPCODE_TABLE(OPB_OPCODE)
+};
+#undef OPB_OPCODE
+
+// One timed opcode/width
+typedef struct opb_result_t {
+    uint8_t op;
+    uint8_t width;
+    uint64_t cycles;
+    double ns;     // < 0 if the opcode was not timed
+    double old_ns; // From --diff, < 0 if there is nothing to compare with
+} opb_result_t;
+
+opb_sort_t sort_by = OPB_SORT_OP;
+
+
+/**
+ * Print the help menu and exit
+ */
+void print_help_and_exit()
+{
+    printf(
+        "65816 Opcode Microbenchmark (C) Ray Clemens 2022-2023\n"
+        "USAGE:\n"
+        " $ 816ce-opbench [OPTIONS] [opcode ...]\n"
+        "\n"
+        "Options:\n"
+        " --iters n ........ Times to step each opcode per repetition (default: %d)\n"
+        " --reps n ......... Repetitions to take the fastest of (default: %d)\n"
+        " --sort key ....... Sort by op, ns, cycles or change (default: op)\n"
+        " --by-mode ........ Print averages for each addressing mode and width instead\n"
+        " --diff filename .. Compare against the output of another run\n"
+        "\n"
+        "Times stepCPU() on each opcode (or the ones given, in hex) with each\n"
+        "register width and prints the cycles and host ns per instruction as a\n"
+        "tab separated table.\n"
+        "\n",
+        OPB_DEFAULT_ITERS, OPB_DEFAULT_REPS
+        );
+    exit(EXIT_SUCCESS);
+}
+
+
+/**
+ * Get the name of the execution engine which the core was built with
+ *
+ * @return The engine's name
+ */
+char *engine_name()
+{
+#if defined(CPU_JIT)
+    return "jit";
+#elif defined(CPU_DISPATCH_TABLE)
+    return "table";
+#else
+    return "switch";
+#endif
+}
+
+
+/**
+ * Get the nanoseconds between two times
+ *
+ * @param *start The earlier time
+ * @param *end The later time
+ * @return The time from start to end in ns
+ */
+double ns_between(const struct timespec *start, const struct timespec *end)
+{
+    return (end->tv_sec - start->tv_sec) * 1e9 + (end->tv_nsec - start->tv_nsec);
+}
+
+
+/**
+ * Put an opcode at OPB_PC and set up the CPU to run it. Every
+ * flag other than I is clear, so the branches which test for a
+ * clear flag are taken.
+ *
+ * @param *core The instance to set up
+ * @param op The opcode
+ * @param *w The register widths
+ */
+void setup_opcode(Core816_t *core, uint8_t op, opb_width_t *w)
+{
+    uint8_t ins[] = {op, 0, 0, 0};
+    uint8_t operand[] = OPB_OPERAND;
+    Core816_Regs_t regs = {
+        .C = 0x0001,
+        .X = 0x0002,
+        .Y = 0x0003,
+        .D = 0x0000,
+        .SP = OPB_SP,
+        .PC = OPB_PC,
+        .DBR = 0,
+        .PBR = 0,
+        .P = 0x04 | (w->m ? 0x20 : 0) | (w->x ? 0x10 : 0),
+        .E = w->e,
+        .cycles = 0
+    };
+
+    memcpy(ins + 1, operand, sizeof(operand));
+    writeMemCore816(core, OPB_PC, ins, sizeof(ins));
+    setRegsCore816(core, &regs);
+}
+
+
+/**
+ * Time putting the CPU back the way it was, which time_opcode() does
+ * before every step
+ *
+ * @param *core The instance to time
+ * @param iters The number of times to put the CPU back per repetition
+ * @param reps The number of repetitions to take the fastest of
+ * @return The time taken per iteration in ns
+ */
+double time_restore(Core816_t *core, uint64_t iters, int reps)
+{
+    CPU_t *cpu = getCPUCore816(core);
+    CPU_t start = *cpu;
+    struct timespec t0, t1;
+    double best = -1;
+
+    for (int r = 0; r < reps; ++r) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (uint64_t i = 0; i < iters; ++i) {
+            *cpu = start;
+            // Keep the copy from being optimized out
+            __asm__ volatile("" : : "r"(cpu) : "memory");
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        double ns = ns_between(&t0, &t1) / iters;
+        if (best < 0 || ns < best) {
+            best = ns;
+        }
+    }
+    return best;
+}
+
+
+/**
+ * Time an opcode with a register width. The CPU is put back the way it
+ * was before every step, so each step runs the same instruction from
+ * the same state.
+ *
+ * @param *core The instance to run the opcode on
+ * @param *res Set up with the opcode and width to time, filled in with the results
+ * @param iters The number of steps per repetition
+ * @param reps The number of repetitions to take the fastest of
+ * @param overhead The time to take out of each step (see time_restore())
+ */
+void time_opcode(Core816_t *core, opb_result_t *res, uint64_t iters, int reps, double overhead)
+{
+    CPU_t *cpu = getCPUCore816(core);
+    memory_t *mem = getMemCore816(core);
+    CPU_t start;
+    struct timespec t0, t1;
+    double best = -1;
+
+    setup_opcode(core, res->op, &widths[res->width]);
+    start = *cpu;
+
+    stepCPU(cpu, mem);
+    res->cycles = cpu->cycles;
+
+    for (int r = 0; r < reps; ++r) {
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        for (uint64_t i = 0; i < iters; ++i) {
+            *cpu = start;
+            stepCPU(cpu, mem);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+
+        double ns = ns_between(&t0, &t1) / iters;
+        if (best < 0 || ns < best) {
+            best = ns;
+        }
+    }
+    *cpu = start;
+    res->ns = (best > overhead) ? best - overhead : 0;
+}
+
+
+/**
+ * Find the width with a name
+ *
+ * @param *name The name of the width
+ * @return The index of the width in widths[], or -1 if there is none
+ */
+int find_width(const char *name)
+{
+    for (int i = 0; i < OPB_WIDTHS; ++i) {
+        if (strcmp(widths[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * Read the times from a previous run into the results' old_ns
+ *
+ * @param *filename The output of the previous run
+ * @param *results The results, in opcode and width order
+ * @return True if the file was read
+ */
+bool load_diff(char *filename, opb_result_t *results)
+{
+    FILE *fp = fopen(filename, "r");
+    char line[OPB_LINE_LEN];
+
+    if (!fp) {
+        return false;
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        unsigned int op;
+        char width[16];
+        double ns;
+        int w;
+
+        // Lines look like: op mnemonic mode handler width cycles ns ...
+        if (sscanf(line, "%2x %*s %*s %*s %15s %*u %lf", &op, width, &ns) == 3 &&
+            op < 256 && (w = find_width(width)) >= 0) {
+            results[op * OPB_WIDTHS + w].old_ns = ns;
+        }
+    }
+    fclose(fp);
+    return true;
+}
+
+
+/**
+ * Get the change in time of a result from the previous run
+ *
+ * @param *res The result
+ * @return The change in %, or 0 if there is nothing to compare with
+ */
+double change_pct(const opb_result_t *res)
+{
+    return (res->old_ns > 0) ? (res->ns - res->old_ns) / res->old_ns * 100 : 0;
+}
+
+
+/**
+ * Compare two results for sorting (see sort_by)
+ *
+ * @param *a The first result
+ * @param *b The second result
+ * @return < 0, 0 or > 0 if a goes before, with or after b
+ */
+int compare_results(const void *a, const void *b)
+{
+    const opb_result_t *ra = a, *rb = b;
+    double d = 0;
+
+    switch (sort_by) {
+    case OPB_SORT_NS:
+        d = rb->ns - ra->ns;
+        break;
+    case OPB_SORT_CYCLES:
+        d = (double) rb->cycles - (double) ra->cycles;
+        break;
+    case OPB_SORT_CHANGE:
+        d = change_pct(rb) - change_pct(ra);
+        break;
+    case OPB_SORT_OP:
+        break;
+    }
+    if (d != 0) {
+        return (d < 0) ? -1 : 1;
+    }
+    return (ra->op * OPB_WIDTHS + ra->width) - (rb->op * OPB_WIDTHS + rb->width);
+}
+
+
+/**
+ * Print the averages of the results for each addressing mode and width
+ *
+ * @param *results The results, in opcode and width order
+ * @param diff True if there are times from a previous run
+ */
+void print_by_mode(opb_result_t *results, bool diff)
+{
+    printf("mode\twidth\topcodes\tcycles\tns%s\n", diff ? "\told_ns\tchange" : "");
+    for (CPU_Addr_Mode_t m = CPU_ADDR_DP; m <= CPU_ADDR_PCRL; ++m) {
+        for (int w = 0; w < OPB_WIDTHS; ++w) {
+            char *mode = NULL;
+            int count = 0, old_count = 0;
+            double cycles = 0, ns = 0, old_ns = 0;
+
+            for (int op = 0; op < 256; ++op) {
+                opb_result_t *res = &results[op * OPB_WIDTHS + w];
+                if (res->ns < 0 || opcodes[op].addr_mode != m) {
+                    continue;
+                }
+                mode = opcodes[op].mode;
+                ++count;
+                cycles += res->cycles;
+                ns += res->ns;
+                if (res->old_ns > 0) {
+                    ++old_count;
+                    old_ns += res->old_ns;
+                }
+            }
+            if (!count) {
+                continue;
+            }
+            printf("%s\t%s\t%d\t%.2f\t%.2f", mode, widths[w].name, count, cycles / count, ns / count);
+            if (diff && old_count) {
+                double o = old_ns / old_count;
+                printf("\t%.2f\t%+.1f%%", o, (ns / count - o) / o * 100);
+            }
+            printf("\n");
+        }
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint64_t iters = OPB_DEFAULT_ITERS;
+    int reps = OPB_DEFAULT_REPS;
+    bool by_mode = false;
+    char *diff_file = NULL;
+    bool selected[256] = {false};
+    bool any_selected = false;
+    opb_result_t *results = malloc(256 * OPB_WIDTHS * sizeof(opb_result_t));
+
+    if (!results) {
+        fprintf(stderr, "Unable to allocate memory!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 1; i < argc; ++i) {
+        char *end;
+        if (strcmp(argv[i], "--iters") == 0 && i + 1 < argc) {
+            iters = strtoull(argv[++i], &end, 10);
+            if (*end != '\0' || iters == 0) {
+                fprintf(stderr, "Invalid iteration count: '%s'\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+            reps = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || reps <= 0) {
+                fprintf(stderr, "Invalid repetition count: '%s'\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--sort") == 0 && i + 1 < argc) {
+            ++i;
+            if (strcmp(argv[i], "op") == 0) {
+                sort_by = OPB_SORT_OP;
+            }
+            else if (strcmp(argv[i], "ns") == 0) {
+                sort_by = OPB_SORT_NS;
+            }
+            else if (strcmp(argv[i], "cycles") == 0) {
+                sort_by = OPB_SORT_CYCLES;
+            }
+            else if (strcmp(argv[i], "change") == 0) {
+                sort_by = OPB_SORT_CHANGE;
+            }
+            else {
+                fprintf(stderr, "Invalid sort key: '%s'\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--by-mode") == 0) {
+            by_mode = true;
+        }
+        else if (strcmp(argv[i], "--diff") == 0 && i + 1 < argc) {
+            diff_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--help") == 0) {
+            print_help_and_exit();
+        }
+        else {
+            unsigned long op = strtoul(argv[i], &end, 16);
+            if (*end != '\0' || end == argv[i] || op > 0xff) {
+                fprintf(stderr, "Unknown argument: '%s'\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            selected[op] = true;
+            any_selected = true;
+        }
+    }
+
+    for (int op = 0; op < 256; ++op) {
+        for (int w = 0; w < OPB_WIDTHS; ++w) {
+            results[op * OPB_WIDTHS + w] = (opb_result_t) {
+                .op = op, .width = w, .cycles = 0, .ns = -1, .old_ns = -1
+            };
+        }
+    }
+    if (diff_file && !load_diff(diff_file, results)) {
+        fprintf(stderr, "Unable to open '%s'\n", diff_file);
+        exit(EXIT_FAILURE);
+    }
+
+    Core816_t *core = createCore816();
+    if (!core) {
+        fprintf(stderr, "Unable to allocate system memory!\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double overhead = time_restore(core, iters, OPB_RESTORE_REPS);
+    for (int op = 0; op < 256; ++op) {
+        if (any_selected && !selected[op]) {
+            continue;
+        }
+        for (int w = 0; w < OPB_WIDTHS; ++w) {
+            time_opcode(core, &results[op * OPB_WIDTHS + w], iters, reps, overhead);
+        }
+    }
+    freeCore816(core);
+
+    printf("# engine: %s, %llu steps per opcode and width (fastest of %d), %.2f ns overhead taken out\n",
+           engine_name(), (unsigned long long) iters, reps, overhead);
+    if (by_mode) {
+        print_by_mode(results, diff_file != NULL);
+        free(results);
+        return EXIT_SUCCESS;
+    }
+
+    qsort(results, 256 * OPB_WIDTHS, sizeof(opb_result_t), compare_results);
+    printf("op\tmnemonic\tmode\thandler\twidth\tcycles\tns%s\n", diff_file ? "\told_ns\tchange" : "");
+    for (int i = 0; i < 256 * OPB_WIDTHS; ++i) {
+        opb_result_t *res = &results[i];
+        opb_opcode_t *opc = &opcodes[res->op];
+        if (res->ns < 0) {
+            continue;
+        }
+        printf("%02x\t%s\t%s\t%s\t%s\t%llu\t%.2f", res->op, opc->mnemonic, opc->mode,
+               opc->handler, widths[res->width].name, (unsigned long long) res->cycles, res->ns);
+        if (diff_file && res->old_ns > 0) {
+            printf("\t%.2f\t%+.1f%%", res->old_ns, change_pct(res));
+        }
+        printf("\n");
+    }
+
+    free(results);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,40 @@
+;;; BENCHMARK: Deep recursion
+;;; Works out sum(n) = n + sum(n-1) with one JSR per level, 2000
+;;; levels deep, forever. The result ($8868, the sum mod $10000) is
+;;; left at $10.
+;;;
+
+DEPTH .equ 2000
+RESULT .equ $10
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 16-bit A/X/Y
+    xce
+    .al
+    .xl
+    rep #$30
+    ldx #$7fff                  ; 4 bytes of stack per level
+    txs
+
+loop:
+    lda #DEPTH
+    jsr sum
+    sta RESULT
+    bra loop
+
+    ;; A = n (with Z set from it), returns A = sum(n)
+sum:
+    beq done
+    pha
+    dec a
+    jsr sum
+    clc
+    adc 1,s
+    plx
+done:
+    rts
+
+    .org $fffc
+    .word reset
+    .word 0
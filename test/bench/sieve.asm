@@ -0,0 +1,73 @@
+;;; BENCHMARK: Sieve of Eratosthenes (the classic BYTE version)
+;;; Finds the primes among the odd numbers 3..16383, forever.
+;;; The count (1899) is left at $10 after each pass.
+;;;
+
+FLAGS .equ $2000
+SIZE .equ 8190
+COUNT .equ $10
+PRIME .equ $12
+INDEX .equ $14
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 8-bit A, 16-bit X/Y
+    xce
+    .as
+    .xl
+    sep #$20
+    rep #$10
+    ldx #$01ff
+    txs
+
+pass:
+    lda #1                      ; Everything starts out prime
+    ldx #0
+fill:
+    sta FLAGS,x
+    inx
+    cpx #SIZE
+    bne fill
+
+    ldy #0                      ; Y = number of primes found
+    ldx #0
+scan:
+    lda FLAGS,x
+    beq next
+    iny
+    .al
+    rep #$20
+    stx INDEX
+    txa                         ; prime = 2 * i + 3
+    asl a
+    adc #3
+    sta PRIME
+    adc INDEX                   ; k = i + prime
+strike:
+    cmp #SIZE
+    bcs struck
+    tax
+    .as
+    sep #$20
+    stz FLAGS,x
+    .al
+    rep #$20
+    txa
+    clc
+    adc PRIME
+    bra strike
+struck:
+    .as
+    sep #$20
+    ldx INDEX
+next:
+    inx
+    cpx #SIZE
+    bne scan
+
+    sty COUNT
+    bra pass
+
+    .org $fffc
+    .word reset
+    .word 0
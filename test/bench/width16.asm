@@ -0,0 +1,39 @@
+;;; BENCHMARK: 16-bit registers
+;;; Scrambles and sums 4 KiB (2048 words) from this program into $2000
+;;; with 16-bit A/X/Y, forever. The sum is at $10.
+;;; (width8.asm runs the same loop with 8-bit registers.)
+;;;
+
+SRC .equ $f000
+DST .equ $2000
+LEN .equ $1000
+SUM .equ $10
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 16-bit A/X/Y
+    xce
+    .al
+    .xl
+    rep #$30
+    ldx #$01ff
+    txs
+
+pass:
+    ldx #0
+loop:
+    lda SRC,x
+    eor #$5a5a
+    asl a
+    adc SUM
+    sta SUM
+    sta DST,x
+    inx
+    inx
+    cpx #LEN
+    bne loop
+    bra pass
+
+    .org $fffc
+    .word reset
+    .word 0
@@ -0,0 +1,34 @@
+;;; BENCHMARK: 8-bit registers
+;;; Scrambles and sums 256 bytes from this program into $2100 with
+;;; 8-bit A/X/Y, forever. The sum is at $10.
+;;; (width16.asm runs the same loop with 16-bit registers.)
+;;;
+
+SRC .equ $f000
+DST .equ $2100
+SUM .equ $10
+
+    .org $f000
+reset:
+    clc                         ; Native mode, 8-bit A/X/Y
+    xce
+    .as
+    .xs
+    sep #$30
+
+pass:
+    ldx #0
+loop:
+    lda SRC,x
+    eor #$5a
+    asl a
+    adc SUM
+    sta SUM
+    sta DST,x
+    inx
+    bne loop
+    bra pass
+
+    .org $fffc
+    .word reset
+    .word 0
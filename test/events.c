@@ -0,0 +1,183 @@
+/**
+ * 65(c)816 simulator/emulator (816CE)
+ * Copyright (C) 2023 Ray Clemens
+ *
+ * Event checks: runs small programs with scheduled events through
+ * runCore816() and checks where and why the CPU stops
+ */
+
+// Needed for alarm
+#define _POSIX_C_SOURCE 200112L
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <unistd.h>
+
+#include "../src/cpu/65816.h"
+#include "../src/cpu/65816-core.h"
+
+#define EVENTS_LOAD_ADDR 0x0200
+
+// Cycles between the polls of the (never interrupting) poll event
+#define EVENTS_POLL_PERIOD 100
+
+// A check which has not returned by then has hung
+#define EVENTS_TIMEOUT_SECS 5
+
+#define CPU_OP_NOP 0xea
+#define CPU_OP_WAI 0xcb
+
+
+/**
+ * Count a poll and schedule the next one. Like the UART's poll, this
+ * never raises an interrupt when there is nothing to do.
+ *
+ * @param *cpu The CPU being checked
+ * @param *ctx The poll counter
+ */
+void poll_event(CPU_t *cpu, void *ctx)
+{
+    ++*(uint64_t *) ctx;
+    scheduleEventCPU(cpu, EVENTS_POLL_PERIOD, poll_event, ctx);
+}
+
+
+/**
+ * Create a core which runs a NOP and then waits in a WAI, with a poll
+ * event scheduled
+ *
+ * @param *polls The poll counter to give the event
+ * @return The core (exits if it can not be created)
+ */
+Core816_t *create_nop_wai(uint64_t *polls)
+{
+    static const uint8_t prog[] = {CPU_OP_NOP, CPU_OP_WAI};
+    static const uint8_t vec[] = {EVENTS_LOAD_ADDR & 0xff, EVENTS_LOAD_ADDR >> 8};
+
+    Core816_t *core = createCore816();
+    if (!core) {
+        fprintf(stderr, "Unable to allocate system memory!\n");
+        exit(EXIT_FAILURE);
+    }
+    writeMemCore816(core, EVENTS_LOAD_ADDR, prog, sizeof(prog));
+    writeMemCore816(core, CPU_VEC_RESET, vec, sizeof(vec));
+    resetCore816(core);
+
+    *polls = 0;
+    scheduleEventCPU(getCPUCore816(core), EVENTS_POLL_PERIOD, poll_event, polls);
+    return core;
+}
+
+
+/**
+ * Report the result of a check
+ *
+ * @param *name The check's name
+ * @param ok True if it passed
+ * @param *core The core it ran (its state is printed if it failed)
+ * @param stat What runCore816() returned
+ * @param polls The number of polls which were run
+ * @return ok
+ */
+bool report(char *name, bool ok, Core816_t *core, CPU_Run_Status_t stat, uint64_t polls)
+{
+    Core816_Regs_t regs;
+
+    getRegsCore816(core, &regs);
+    printf("%-24s %s\n", name, ok ? "ok" : "FAILED");
+    if (!ok) {
+        printf("    status %d, PC %04x, cycles %" PRIu64 ", polls %" PRIu64 "\n",
+               stat, regs.PC, regs.cycles, polls);
+    }
+    return ok;
+}
+
+
+/**
+ * An instruction budget which runs out on the way to a WAI
+ * stops there, without waiting for the events
+ *
+ * @return True if the check passed
+ */
+bool check_budget_before_wai(void)
+{
+    uint64_t polls;
+    Core816_Regs_t regs;
+    Core816_t *core = create_nop_wai(&polls);
+
+    CPU_Run_Status_t stat = runCore816(core, 1, 0);
+    getRegsCore816(core, &regs);
+    bool ok = stat == CPU_RUN_BUDGET && regs.PC == EVENTS_LOAD_ADDR + 1 && polls == 0;
+
+    report("budget_before_wai", ok, core, stat, polls);
+    freeCore816(core);
+    return ok;
+}
+
+
+/**
+ * An instruction budgeted run of a CPU waiting on events which never
+ * interrupt it stops after the first one, whatever its budget
+ *
+ * @return True if the check passed
+ */
+bool check_budget_wai_no_irq(void)
+{
+    uint64_t polls;
+    Core816_Regs_t regs;
+    Core816_t *core = create_nop_wai(&polls);
+    bool ok = true;
+
+    CPU_Run_Status_t stat = runCore816(core, 1, 0);
+    for (uint64_t budget = 1; ok && budget <= 1000000; budget *= 1000) {
+        uint64_t before = polls;
+        stat = runCore816(core, budget, 0);
+        getRegsCore816(core, &regs);
+        ok = stat == CPU_RUN_WAI && regs.PC == EVENTS_LOAD_ADDR + 1 && polls == before + 1;
+    }
+
+    report("budget_wai_no_irq", ok, core, stat, polls);
+    freeCore816(core);
+    return ok;
+}
+
+
+/**
+ * A cycle budgeted run of a waiting CPU runs the events up to
+ * the end of its budget
+ *
+ * @return True if the check passed
+ */
+bool check_cycles_wai_no_irq(void)
+{
+    uint64_t polls;
+    Core816_Regs_t regs;
+    Core816_t *core = create_nop_wai(&polls);
+
+    runCore816(core, 1, 0);
+    CPU_Run_Status_t stat = runCore816(core, 10 * EVENTS_POLL_PERIOD, CPU_RUN_BUDGET_CYCLES);
+    getRegsCore816(core, &regs);
+    bool ok = stat == CPU_RUN_BUDGET && regs.PC == EVENTS_LOAD_ADDR + 1 && polls == 10;
+
+    report("cycles_wai_no_irq", ok, core, stat, polls);
+    freeCore816(core);
+    return ok;
+}
+
+
+int main(void)
+{
+    bool ok = true;
+
+    // Nothing here may hang (the default action ends the process)
+    alarm(EVENTS_TIMEOUT_SECS);
+
+    ok = check_budget_before_wai() && ok;
+    ok = check_budget_wai_no_irq() && ok;
+    ok = check_cycles_wai_no_irq() && ok;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,81 @@
+#!/bin/python3
+
+# Packs JSON-encoded CPU tests (ProcessorTests' 65816 format) into the
+# binary vector file which runner.c reads. All numbers are little endian.
+#
+# Header:
+#   char     magic[4]  "816V"
+#   uint32_t version   1
+#   uint32_t tests     number of tests
+#   uint32_t rams      number of RAM entries
+#   uint32_t names     size of the name table in bytes
+# Tests (48 bytes each, in the order they were read):
+#   regs     initial   uint16_t C, X, Y, SP, D, PC; uint8_t DBR, PBR, P, E
+#   regs     final
+#   uint32_t ram       index of the test's first RAM entry
+#   uint16_t ram_i     number of initial RAM entries
+#   uint16_t ram_f     number of final RAM entries (after the initial ones)
+#   uint32_t name      offset of the test's name in the name table
+#   uint16_t cycles    number of cycles the test takes
+#   uint8_t  op        opcode being tested
+#   uint8_t  pad
+# RAM entries:
+#   uint32_t entry     address << 8 | value
+# Name table:
+#   NUL terminated names
+
+import json
+import shutil
+import struct
+import sys
+import tempfile
+
+VEC_MAGIC = b"816V"
+VEC_VERSION = 1
+
+def pack_regs(r):
+    return struct.pack("<6H4B", r['a'], r['x'], r['y'], r['s'], r['d'], r['pc'],
+                       r['dbr'], r['pbr'], r['p'], r['e'])
+
+if __name__ == "__main__":
+    if len(sys.argv) < 3:
+        print("USAGE: json2vec.py output.vec test.json ...")
+        sys.exit(1)
+
+    o = sys.argv[1]
+    test_count = ram_count = names_size = 0
+    with tempfile.TemporaryFile() as testfp, \
+         tempfile.TemporaryFile() as ramfp, \
+         tempfile.TemporaryFile() as namefp:
+        for i in sys.argv[2:]:
+            print("FILE:", i, "->", o)
+            with open(i, "r") as jsonfp:
+                data = json.loads(jsonfp.read())
+
+            for test_data in data:
+                ci = test_data['initial']
+                cf = test_data['final']
+                name = test_data['name'].encode() + b"\0"
+
+                # The opcode is the byte at the initial PC
+                pc = (ci['pbr'] << 16) | ci['pc']
+                op = next(v for a, v in ci['ram'] if a == pc)
+
+                testfp.write(pack_regs(ci) + pack_regs(cf) +
+                             struct.pack("<IHHIHBB", ram_count, len(ci['ram']), len(cf['ram']),
+                                         names_size, len(test_data['cycles']), op, 0))
+                for a, v in ci['ram'] + cf['ram']:
+                    ramfp.write(struct.pack("<I", (a << 8) | v))
+                namefp.write(name)
+
+                test_count += 1
+                ram_count += len(ci['ram']) + len(cf['ram'])
+                names_size += len(name)
+
+        with open(o, "wb") as vecfp:
+            vecfp.write(VEC_MAGIC + struct.pack("<4I", VEC_VERSION, test_count, ram_count, names_size))
+            for fp in (testfp, ramfp, namefp):
+                fp.seek(0)
+                shutil.copyfileobj(fp, vecfp)
+
+    print("Packed", test_count, "tests")
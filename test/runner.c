@@ -2,140 +2,517 @@
  * 65(c)816 simulator/emulator (816CE)
  * Copyright (C) 2023 Ray Clemens
  *
- * "Quick'NDirty" Test Runner
+ * Test Runner: runs every test in a vector file (see json2vec.py)
+ * on a pool of threads and reports the results for each opcode
  */
 
+// Needed for mmap and clock_gettime
+#define _POSIX_C_SOURCE 200112L
+
 #include <stdio.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <stdbool.h>
+#include <inttypes.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #include "../src/cpu/65816.h"
 #include "../src/cpu/65816-util.h"
+#include "../src/cpu/65816-lockstep.h"
 
-int main(int argc, char *argv[])
+#define VEC_MAGIC "816V"
+#define VEC_VERSION 1
+
+// Failed tests printed for each opcode (unless --show is given)
+#define RUNNER_DEFAULT_SHOW 5
+#define RUNNER_MAX_THREADS 256
+#define RUNNER_CPU_STATE_LEN 256
+
+// Vector file layout (see json2vec.py)
+typedef struct vec_header_t {
+    char magic[4];
+    uint32_t version;
+    uint32_t tests;
+    uint32_t rams;
+    uint32_t names;
+} vec_header_t;
+
+typedef struct vec_regs_t {
+    uint16_t C;
+    uint16_t X;
+    uint16_t Y;
+    uint16_t SP;
+    uint16_t D;
+    uint16_t PC;
+    uint8_t DBR;
+    uint8_t PBR;
+    uint8_t P;
+    uint8_t E;
+} vec_regs_t;
+
+typedef struct vec_test_t {
+    vec_regs_t initial;
+    vec_regs_t final;
+    uint32_t ram;    // First RAM entry
+    uint16_t ram_i;  // Initial RAM entries
+    uint16_t ram_f;  // Final RAM entries (after the initial ones)
+    uint32_t name;   // Offset into the name table
+    uint16_t cycles;
+    uint8_t op;
+    uint8_t pad;
+} vec_test_t;
+
+// Results for one opcode
+typedef struct op_result_t {
+    uint32_t passed;
+    uint32_t failed;
+    double seconds;
+} op_result_t;
+
+// Everything the threads share. Only next_op (and printing)
+// is guarded by the lock, each opcode's results are only
+// written by the thread which ran it.
+typedef struct runner_t {
+    const vec_test_t *tests;
+    const uint32_t *rams;
+    const char *names;
+    uint32_t *order;        // Test indices, grouped by opcode
+    uint32_t op_first[257]; // First entry in order[] for each opcode
+    bool selected[256];
+    op_result_t results[256];
+    uint32_t show;
+    bool lockstep; // Also check every test against the reference decoder
+    int next_op;
+    pthread_mutex_t lock;
+} runner_t;
+
+
+/**
+ * Set a CPU's registers from a test
+ *
+ * @param *cpu The CPU to modify
+ * @param *regs The registers
+ * @param cycles The cycle count
+ */
+void set_cpu(CPU_t *cpu, const vec_regs_t *regs, uint64_t cycles)
 {
-    if (argc != 2) {
-        printf("Single file expected.\n");
-    }
+    cpu->C = regs->C;
+    cpu->X = regs->X;
+    cpu->Y = regs->Y;
+    cpu->SP = regs->SP;
+    cpu->D = regs->D;
+    cpu->PC = regs->PC;
+    cpu->DBR = regs->DBR;
+    cpu->PBR = regs->PBR;
+    _cpu_set_sr(cpu, regs->P);
+    cpu->P.E = regs->E & 1;
+    cpu->P.RST = 0;
+    cpu->P.IRQ = 0;
+    cpu->P.NMI = 0;
+    cpu->P.STP = 0;
+    cpu->P.CRASH = 0;
+    cpu->cycles = cycles;
+}
 
-    FILE *fp = fopen(argv[1], "r");
-    if (!fp) {
-        printf("Unable to open file.\n");
-        exit(-1);
-    }
-
-    char *test_name = NULL;
-    struct {
-        uint32_t addr;
-        uint8_t data;
-    } input_data[100], output_data[100];
-    char *cpu_istr = NULL;
-    char *cpu_fstr = NULL;
-    CPU_t cpu_initial, cpu_run, cpu_final;
-    char cpu_state[1000];
-    char *str = NULL;
-
-    size_t len = 0;
-    long test_num = 0, success_count = 0;
-    size_t id_idx = 0, fd_idx = 0, i;
-    bool failed = false;
-    uint8_t byte_val;
-
-    memory_t *mem = calloc(16777216, sizeof(*mem));
-
-    printf("Running.\n");
-    
-    while (1) {
-        if (getline(&test_name, &len, fp) == -1) {
-            printf("End of file. Tests passed: %ld/%ld\n", success_count, test_num);
-            break;
+
+/**
+ * Check a CPU's state against the expected state of a test
+ *
+ * @param *cpu The CPU which ran the test
+ * @param *regs The expected registers
+ * @param cycles The expected cycle count
+ * @return True if they match
+ */
+bool check_cpu(CPU_t *cpu, const vec_regs_t *regs, uint64_t cycles)
+{
+    return cpu->C == regs->C && cpu->X == regs->X && cpu->Y == regs->Y &&
+        cpu->SP == regs->SP && cpu->D == regs->D && cpu->PC == regs->PC &&
+        cpu->DBR == regs->DBR && cpu->PBR == regs->PBR &&
+        _cpu_get_sr(cpu) == regs->P && cpu->P.E == (regs->E & 1) &&
+        !cpu->P.RST && !cpu->P.IRQ && !cpu->P.NMI && !cpu->P.STP && !cpu->P.CRASH &&
+        cpu->cycles == cycles;
+}
+
+
+/**
+ * Print the details of a failed test
+ *
+ * @param *r The runner
+ * @param *t The test
+ * @param *mem The memory the test ran with (before it was reset)
+ * @param *cpu The CPU which ran the test
+ */
+void print_failure(runner_t *r, const vec_test_t *t, memory_t *mem, CPU_t *cpu)
+{
+    CPU_t expect = *cpu;
+    char cpu_state[RUNNER_CPU_STATE_LEN];
+    const uint32_t *ram = &r->rams[t->ram];
+
+    printf("Test failed! : %s\n", &r->names[t->name]);
+    for (uint32_t i = 0; i < t->ram_i; ++i) {
+        printf("i:%06x:%02x\n", ram[i] >> 8, ram[i] & 0xff);
+    }
+    for (uint32_t i = t->ram_i; i < t->ram_i + t->ram_f; ++i) {
+        uint8_t byte_val = _get_mem_byte(mem, ram[i] >> 8, false);
+        printf("f:%06x:%02x", ram[i] >> 8, ram[i] & 0xff);
+        if ((ram[i] & 0xff) != byte_val) {
+            printf(" (actual: %02x)", byte_val);
         }
+        printf("\n");
+    }
+    set_cpu(&expect, &t->initial, 0);
+    tostrCPU(&expect, cpu_state);
+    printf("INITIAL  CPU: '%s'\n", cpu_state);
+    tostrCPU(cpu, cpu_state);
+    printf("ACTUAL   CPU: '%s'\n", cpu_state);
+    set_cpu(&expect, &t->final, t->cycles);
+    tostrCPU(&expect, cpu_state);
+    printf("EXPECTED CPU: '%s'\n", cpu_state);
+}
 
-        failed = false;
-
-        getline(&str, &len, fp);
-        id_idx = 0;
-        while (str[0] == 'i') {
-            sscanf(str, "i: %x : %hhx\n", &(input_data[id_idx].addr), &(input_data[id_idx].data));
-            _set_mem_byte(mem, input_data[id_idx].addr, input_data[id_idx].data, false);
-            ++id_idx;
-            getline(&str, &len, fp);
-        }
-        fd_idx = 0;
-        while (str[0] == 'f') {
-            sscanf(str, "f: %x : %hhx\n", &(output_data[fd_idx].addr), &(output_data[fd_idx].data));
-            ++fd_idx;
-            getline(&str, &len, fp);
-        }
-        cpu_istr = str;
-        
-        // Scan cpu expected output
-        getline(&cpu_fstr, &len, fp);
-
-        // set up CPU
-        memset(&cpu_initial, 0, sizeof(cpu_initial));
-        memset(&cpu_final, 0, sizeof(cpu_final));
-        fromstrCPU(&cpu_initial, cpu_istr);
-        memcpy(&cpu_run, &cpu_initial, sizeof(cpu_run));
-        fromstrCPU(&cpu_final, cpu_fstr);
-        stepCPU(&cpu_run, mem);
-
-        if (memcmp(&cpu_run, &cpu_final, sizeof(cpu_run)) != 0) {
-            failed = true;
+
+/**
+ * Check that a test left the CPU and the bytes it lists the same as the
+ * reference decoder did (see runLockstepCPU())
+ *
+ * @param *t The test
+ * @param *ram The test's RAM entries
+ * @param *ls The thread's lockstep state, after running the test
+ * @param stat What runLockstepCPU() returned
+ * @return True if the CPU matches its reference
+ */
+bool check_lockstep(const vec_test_t *t, const uint32_t *ram, CPU_Lockstep_t *ls, CPU_Run_Status_t stat)
+{
+    if (stat == CPU_RUN_DIVERGED) {
+        return false;
+    }
+    for (uint32_t i = 0; i < t->ram_i + t->ram_f; ++i) {
+        uint32_t addr = ram[i] >> 8;
+        if (_get_mem_byte(ls->mem, addr, false) != _get_mem_byte(ls->ref_mem, addr, false)) {
+            ls->addr = addr;
+            return false;
         }
-        else {
-            ++success_count;
+    }
+    return true;
+}
+
+
+/**
+ * Run a test's instruction on the CPU (which has been set up with the
+ * test's initial state), and also on the reference decoder when running
+ * in lockstep
+ *
+ * @param *t The test
+ * @param *ram The test's RAM entries
+ * @param *cpu The thread's CPU
+ * @param *mem The thread's memory
+ * @param *ls Runs the CPU in lockstep with a reference (NULL to run it on its own)
+ * @return True unless the CPU no longer matches its reference
+ */
+bool run_test(const vec_test_t *t, const uint32_t *ram, CPU_t *cpu, memory_t *mem, CPU_Lockstep_t *ls)
+{
+    if (!ls) {
+        runCPU(cpu, mem, 1, 0);
+        return true;
+    }
+
+    for (uint32_t i = 0; i < t->ram_i; ++i) {
+        _set_mem_byte(ls->ref_mem, ram[i] >> 8, ram[i] & 0xff, false);
+    }
+    set_cpu(ls->ref, &t->initial, 0);
+    ls->insns = 0;
+    return check_lockstep(t, ram, ls, runLockstepCPU(ls, 1, 0));
+}
+
+
+/**
+ * Run every test for an opcode
+ *
+ * @param *r The runner
+ * @param op The opcode to run the tests of
+ * @param *cpu The thread's CPU
+ * @param *mem The thread's memory (all zero, and left that way)
+ * @param *ls Runs the CPU in lockstep with a reference (NULL to run it on its own)
+ */
+void run_opcode(runner_t *r, int op, CPU_t *cpu, memory_t *mem, CPU_Lockstep_t *ls)
+{
+    op_result_t *res = &r->results[op];
+    struct timespec start, end;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (uint32_t n = r->op_first[op]; n < r->op_first[op + 1]; ++n) {
+        const vec_test_t *t = &r->tests[r->order[n]];
+        const uint32_t *ram = &r->rams[t->ram];
+        bool failed = false, diverged;
+
+        for (uint32_t i = 0; i < t->ram_i; ++i) {
+            _set_mem_byte(mem, ram[i] >> 8, ram[i] & 0xff, false);
         }
+        set_cpu(cpu, &t->initial, 0);
+        diverged = !run_test(t, ram, cpu, mem, ls);
 
-        // Check memory
-        i = fd_idx;
-        while (i-- > 0) {
-            // Check for memory modifications
-            if (output_data[i].data != _get_mem_byte(mem, output_data[i].addr, false)) {
+        if (!check_cpu(cpu, &t->final, t->cycles)) {
+            failed = true;
+        }
+        for (uint32_t i = t->ram_i; i < t->ram_i + t->ram_f; ++i) {
+            if ((ram[i] & 0xff) != _get_mem_byte(mem, ram[i] >> 8, false)) {
                 failed = true;
             }
         }
 
-        if (failed) {
-            printf("Test failed! (%ld) : %s", test_num+1, test_name);
-            for (i = 0; i < id_idx; ++i) {
-                printf("i:%06x:%02x\n", input_data[i].addr, input_data[i].data);
-            }
-            for (i = 0; i < fd_idx; ++i) {
-                printf("f:%06x:%02x", output_data[i].addr, output_data[i].data);
-                byte_val = _get_mem_byte(mem, output_data[i].addr, false);
-                if (output_data[i].data    != byte_val) {
-                    printf(" (actual: %02x)", byte_val);
+        if (failed || diverged) {
+            if (res->failed < r->show) {
+                pthread_mutex_lock(&r->lock);
+                if (failed) {
+                    print_failure(r, t, mem, cpu);
+                }
+                if (diverged) {
+                    printf("Engines diverged! : %s\n", &r->names[t->name]);
+                    dumpLockstepCPU(ls, stdout);
                 }
-                printf("\n");
+                pthread_mutex_unlock(&r->lock);
             }
-            tostrCPU(&cpu_initial, cpu_state);
-            printf("INITIAL  CPU: '%s'\n", cpu_state);
-            tostrCPU(&cpu_run, cpu_state);
-            printf("ACTUAL   CPU: '%s'\n", cpu_state);
-            tostrCPU(&cpu_final, cpu_state);
-            printf("EXPECTED CPU: '%s'\n", cpu_state);
+            ++res->failed;
+        }
+        else {
+            ++res->passed;
         }
 
         // Reset memory
-        while (fd_idx-- > 0) {
-            _set_mem_byte(mem, output_data[fd_idx].addr, 0, false);
-        }
-        while (id_idx-- > 0) {
-            _set_mem_byte(mem, input_data[id_idx].addr, 0, false);
+        for (uint32_t i = 0; i < t->ram_i + t->ram_f; ++i) {
+            _set_mem_byte(mem, ram[i] >> 8, 0, false);
+            if (ls) {
+                _set_mem_byte(ls->ref_mem, ram[i] >> 8, 0, false);
+            }
         }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    res->seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
 
-        test_num += 1;
 
-        if (test_num & 0xffff == 0) {
-            printf("%ld\n", test_num);
+/**
+ * Thread which runs opcodes until there are none left
+ *
+ * @param *arg The runner
+ * @return NULL
+ */
+void *run_thread(void *arg)
+{
+    runner_t *r = arg;
+    CPU_t cpu;
+    CPU_t ref;
+    CPU_Lockstep_t ls;
+    memory_t *mem = _alloc_mem();
+    memory_t *ref_mem = r->lockstep ? _alloc_mem() : NULL;
+
+    if (!mem || (r->lockstep && !ref_mem)) {
+        fprintf(stderr, "Unable to allocate system memory!\n");
+        exit(EXIT_FAILURE);
+    }
+    initCPU(&cpu);
+    cpu.setacc = false;
+#ifdef CPU_DISPATCH_TABLE
+    setDecodeCacheCPU(&cpu, malloc(sizeof(CPU_Decode_Cache_t)));
+#endif
+#ifdef CPU_JIT
+    // Run every test through the JIT (compile blocks the first time they are entered)
+    if (enableJITCPU(&cpu, 0) != CPU_ERR_OK) {
+        fprintf(stderr, "JIT not available.\n");
+        exit(EXIT_FAILURE);
+    }
+#endif
+    if (r->lockstep) {
+        // Only the bytes each test lists are compared (see check_lockstep())
+        initCPU(&ref);
+        ref.setacc = false;
+        initLockstepCPU(&ls, &cpu, mem, &ref, ref_mem, 1);
+        ls.check_mem = false;
+    }
+
+    while (true) {
+        int op;
+
+        pthread_mutex_lock(&r->lock);
+        while (r->next_op < 256 && !r->selected[r->next_op]) {
+            ++r->next_op;
         }
+        op = r->next_op++;
+        pthread_mutex_unlock(&r->lock);
+
+        if (op >= 256) {
+            break;
+        }
+        run_opcode(r, op, &cpu, mem, r->lockstep ? &ls : NULL);
     }
 
-    free(mem);
-    
-    fclose(fp);
+#ifdef CPU_JIT
+    disableJITCPU(&cpu);
+#endif
+    free(cpu.dcache);
+    _free_mem(mem);
+    _free_mem(ref_mem);
+    return NULL;
 }
 
+
+/**
+ * Map a vector file into memory and check its header
+ *
+ * @param *filename The file to map
+ * @param *r Set up with the file's tests, RAM entries and names
+ * @return True if the file was mapped
+ */
+bool map_vectors(char *filename, runner_t *r)
+{
+    struct stat st;
+    const vec_header_t *hdr;
+    int fd = open(filename, O_RDONLY);
+
+    if (fd < 0) {
+        printf("Unable to open file.\n");
+        return false;
+    }
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(vec_header_t)) {
+        printf("Not a vector file.\n");
+        close(fd);
+        return false;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        printf("Unable to map file.\n");
+        return false;
+    }
+
+    hdr = map;
+    if (memcmp(hdr->magic, VEC_MAGIC, sizeof(hdr->magic)) != 0 ||
+        hdr->version != VEC_VERSION ||
+        (uint64_t) st.st_size != sizeof(vec_header_t) + (uint64_t) hdr->tests * sizeof(vec_test_t) +
+                                 (uint64_t) hdr->rams * sizeof(uint32_t) + hdr->names) {
+        printf("Not a vector file (or from a different version of json2vec.py).\n");
+        munmap(map, st.st_size);
+        return false;
+    }
+    r->tests = (const vec_test_t *) (hdr + 1);
+    r->rams = (const uint32_t *) (r->tests + hdr->tests);
+    r->names = (const char *) (r->rams + hdr->rams);
+
+    // Group the tests by opcode (counting sort)
+    r->order = malloc(((size_t) hdr->tests + 1) * sizeof(uint32_t));
+    if (!r->order) {
+        printf("Unable to allocate memory.\n");
+        return false;
+    }
+    memset(r->op_first, 0, sizeof(r->op_first));
+    for (uint32_t i = 0; i < hdr->tests; ++i) {
+        ++r->op_first[r->tests[i].op + 1];
+    }
+    for (int op = 0; op < 256; ++op) {
+        r->op_first[op + 1] += r->op_first[op];
+    }
+    uint32_t next[256];
+    memcpy(next, r->op_first, sizeof(next));
+    for (uint32_t i = 0; i < hdr->tests; ++i) {
+        r->order[next[r->tests[i].op]++] = i;
+    }
+    return true;
+}
+
+
+int main(int argc, char *argv[])
+{
+    static runner_t r;
+    char *filename = NULL;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    bool any_selected = false;
+    pthread_t tids[RUNNER_MAX_THREADS];
+    struct timespec start, end;
+
+    r.show = RUNNER_DEFAULT_SHOW;
+    for (int i = 1; i < argc; ++i) {
+        char *end;
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            threads = strtol(argv[++i], &end, 10);
+            if (*end != '\0' || threads < 1) {
+                printf("Invalid thread count: '%s'\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--show") == 0 && i + 1 < argc) {
+            r.show = strtoul(argv[++i], &end, 10);
+            if (*end != '\0') {
+                printf("Invalid failure count: '%s'\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+        }
+        else if (strcmp(argv[i], "--lockstep") == 0) {
+            r.lockstep = true;
+        }
+        else if (!filename) {
+            filename = argv[i];
+        }
+        else {
+            unsigned long op = strtoul(argv[i], &end, 16);
+            if (*end != '\0' || end == argv[i] || op > 0xff) {
+                printf("Invalid opcode: '%s'\n", argv[i]);
+                exit(EXIT_FAILURE);
+            }
+            r.selected[op] = true;
+            any_selected = true;
+        }
+    }
+    if (!filename) {
+        printf("USAGE: runner [-j threads] [--show n] [--lockstep] file.vec [opcode ...]\n");
+        exit(EXIT_FAILURE);
+    }
+    if (!any_selected) {
+        memset(r.selected, true, sizeof(r.selected));
+    }
+    threads = (threads < 1) ? 1 : (threads > RUNNER_MAX_THREADS) ? RUNNER_MAX_THREADS : threads;
+
+    if (!map_vectors(filename, &r)) {
+        exit(EXIT_FAILURE);
+    }
+    pthread_mutex_init(&r.lock, NULL);
+
+    printf("Running on %ld thread%s.\n", threads, (threads == 1) ? "" : "s");
+    fflush(stdout);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (long i = 0; i < threads; ++i) {
+        if (pthread_create(&tids[i], NULL, run_thread, &r) != 0) {
+            printf("Unable to start a thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    for (long i = 0; i < threads; ++i) {
+        pthread_join(tids[i], NULL);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    uint64_t passed = 0, total = 0;
+    for (int op = 0; op < 256; ++op) {
+        op_result_t *res = &r.results[op];
+        uint32_t count = res->passed + res->failed;
+        if (!r.selected[op] || count == 0) {
+            continue;
+        }
+        printf("%02x: %" PRIu32 "/%" PRIu32 " passed%s (%.0f tests/s)\n", op, res->passed, count,
+               res->failed ? " FAILED" : "", (res->seconds > 0) ? count / res->seconds : 0.0);
+        passed += res->passed;
+        total += count;
+    }
+    printf("Tests passed: %" PRIu64 "/%" PRIu64 " in %.2fs (%.0f tests/s)\n", passed, total, seconds,
+           (seconds > 0) ? total / seconds : 0.0);
+
+    pthread_mutex_destroy(&r.lock);
+    free(r.order);
+    return (passed == total) ? EXIT_SUCCESS : EXIT_FAILURE;
+}